@@ -0,0 +1,683 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#ifdef APPARATUS_LZ4
+#include <lz4.h>
+#endif
+#ifdef APPARATUS_ZSTD
+#include <zstd.h>
+#endif
+
+#include "DebugMessenger.h"
+
+namespace
+{
+	constexpr uint64_t PENDING_SERIAL = UINT64_MAX;
+	// Keeps the memcpy into staging on aligned addresses
+	constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+	VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+AssetLoader::AssetLoader() :
+	scheduler(nullptr),
+	threadPool(nullptr),
+	settings{},
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	transferQueue(nullptr),
+	reader{},
+	nextId(1),
+	loads{},
+	queued{},
+	active{},
+	nextReadId(0),
+	reads{},
+	completions{},
+	decompressedIds{},
+	decompressing(0),
+	inFlightBytes(0),
+	stats{},
+	windowStart{},
+	windowRead(0),
+	windowUploaded(0),
+	stagingBuffer{},
+	stagingAllocations{},
+	stagingHead(0),
+	commandPool(nullptr),
+	commandBuffers{}
+{
+}
+
+void AssetLoader::init(LogicalDevice& device, SubmissionScheduler& _scheduler, ThreadPool& _threadPool,
+	const AssetLoaderSettings& _settings)
+{
+	scheduler = &_scheduler;
+	threadPool = &_threadPool;
+	settings = _settings;
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	transferQueue = device.getTransferQueue();
+
+	reader.init(*threadPool, settings.queueDepth, settings.useIoUring);
+	stats = {};
+	stats.ioUring = reader.usesIoUring();
+	windowStart = std::chrono::steady_clock::now();
+
+	stagingBuffer.init(device, settings.stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	stagingBuffer.setName("AssetLoader staging");
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = device.getTransferFamilyIndex();
+	VkResult result = dispatch->vkCreateCommandPool(deviceHandle, &poolInfo, allocator, &commandPool); VK_CHECK(result);
+}
+
+AssetLoader::~AssetLoader()
+{
+	cleanup();
+}
+
+void AssetLoader::cleanup()
+{
+	// Reads and decompression tasks write into the loads' buffers until they finish
+	reader.cleanup();
+	while (decompressing.load(std::memory_order_acquire) > 0) {
+		std::this_thread::yield();
+	}
+
+	if (deviceHandle) {
+		for (auto& [serial, commandBuffer] : commandBuffers) {
+			scheduler->wait(transferQueue, serial);
+		}
+		dispatch->vkDestroyCommandPool(deviceHandle, commandPool, allocator);
+		commandPool = nullptr;
+		deviceHandle = nullptr;
+	}
+	commandBuffers.clear();
+	stagingAllocations.clear();
+	stagingHead = 0;
+	stagingBuffer.cleanup();
+
+	for (auto& [id, load] : loads) {
+		if (load->fileOpen) {
+			AsyncFileReader::closeFile(load->file);
+		}
+	}
+	loads.clear();
+	for (std::deque<uint64_t>& ids : queued) {
+		ids.clear();
+	}
+	active.clear();
+	reads.clear();
+	decompressedIds.clear();
+	inFlightBytes = 0;
+}
+
+uint64_t AssetLoader::load(LoadRequest request)
+{
+	auto entry = std::make_unique<Load>();
+	entry->id = nextId++;
+	entry->request = std::move(request);
+	entry->stage = Stage::QUEUED;
+	entry->status = LoadStatus::COMPLETE;
+
+	uint64_t id = entry->id;
+	queued[static_cast<size_t>(entry->request.priority)].push_back(id);
+	loads.emplace(id, std::move(entry));
+	return id;
+}
+
+bool AssetLoader::cancel(uint64_t id)
+{
+	auto it = loads.find(id);
+	if (it == loads.end() || it->second->stage == Stage::DONE) {
+		return false;
+	}
+	Load& load = *it->second;
+	if (load.cancelled.load()) {
+		return true;
+	}
+	load.cancelled.store(true);
+	load.status = LoadStatus::CANCELLED;
+
+	if (load.stage == Stage::QUEUED) {
+		std::deque<uint64_t>& ids = queued[static_cast<size_t>(load.request.priority)];
+		ids.erase(std::find(ids.begin(), ids.end(), id));
+		load.stage = Stage::DONE;
+		active.push_back(id);
+	} else if (load.stage == Stage::READING) {
+		// The load finishes once every read came back, the kernel may still write into its buffer until then
+		for (auto& [readId, read] : reads) {
+			if (read.loadId == id) {
+				reader.cancel(readId);
+			}
+		}
+		if (load.readsInFlight == 0) {
+			load.stage = Stage::DONE;
+		}
+	}
+	// Decompressing loads are dropped when their task comes back, uploading ones in the next update
+
+	return true;
+}
+
+void AssetLoader::update()
+{
+	startQueued();
+	// Reads queued here go to the kernel together with the poll in readCompleted
+	queueReads();
+	readCompleted();
+	finishDecompression();
+	recordUploads();
+	finishLoads();
+	updateStats();
+}
+
+void AssetLoader::waitIdle()
+{
+	while (!isIdle()) {
+		update();
+		std::this_thread::yield();
+	}
+}
+
+bool AssetLoader::isIdle()
+{
+	return loads.empty();
+}
+
+AssetLoaderStats AssetLoader::getStats()
+{
+	return stats;
+}
+
+void AssetLoader::startQueued()
+{
+	// Highest priority first, and a load that doesn't fit the budget holds back everything behind it
+	// so big loads aren't starved by a stream of small ones
+	for (size_t priority = static_cast<size_t>(LoadPriority::COUNT); priority-- > 0;) {
+		std::deque<uint64_t>& ids = queued[priority];
+		while (!ids.empty()) {
+			Load& load = *loads.at(ids.front());
+			if (!start(load)) {
+				return;
+			}
+			active.push_back(load.id);
+			ids.pop_front();
+		}
+	}
+}
+
+bool AssetLoader::start(Load& load)
+{
+	const LoadRequest& request = load.request;
+	if (!load.fileOpen) {
+		uint64_t fileSize = 0;
+		try {
+			load.file = AsyncFileReader::openFile(request.path, fileSize);
+		} catch (const std::runtime_error& error) {
+			fail(load, error.what());
+			return true;
+		}
+		load.fileOpen = true;
+
+		if (request.offset > fileSize || request.size > fileSize - request.offset) {
+			fail(load, "load outside of file: " + request.path);
+			return true;
+		}
+		if (request.compression == Compression::LZ4 && request.uncompressedSize == 0) {
+			fail(load, "LZ4 load without uncompressed size: " + request.path);
+			return true;
+		}
+		load.readSize = request.size != 0 ? request.size : fileSize - request.offset;
+		load.dataSize = request.compression == Compression::NONE ? load.readSize : request.uncompressedSize;
+	}
+
+	uint64_t cost = load.readSize;
+	if (request.compression != Compression::NONE) {
+		cost += request.uncompressedSize;
+	}
+	if (inFlightBytes > 0 && inFlightBytes + cost > settings.memoryBudget) {
+		return false;
+	}
+	load.reserved = cost;
+	inFlightBytes += cost;
+	stats.peakInFlightBytes = std::max(stats.peakInFlightBytes, inFlightBytes);
+
+	load.readBuffer.reset(new std::byte[load.readSize]);
+	load.stage = Stage::READING;
+	if (load.readSize == 0) {
+		finishReading(load);
+	}
+	return true;
+}
+
+void AssetLoader::queueReads()
+{
+	for (uint64_t id : active) {
+		Load& load = *loads.at(id);
+		if (load.stage != Stage::READING || load.status != LoadStatus::COMPLETE) {
+			continue;
+		}
+
+		while (load.nextReadOffset < load.readSize) {
+			uint32_t size = static_cast<uint32_t>(std::min<uint64_t>(settings.readSize, load.readSize - load.nextReadOffset));
+			if (!reader.queueRead(load.file, load.request.offset + load.nextReadOffset, size,
+				load.readBuffer.get() + load.nextReadOffset, nextReadId)) {
+				return;
+			}
+			reads.emplace(nextReadId++, Read{id, load.nextReadOffset, size});
+			load.nextReadOffset += size;
+			load.readsInFlight++;
+		}
+	}
+}
+
+void AssetLoader::readCompleted()
+{
+	completions.clear();
+	reader.poll(completions);
+
+	for (const ReadCompletion& completion : completions) {
+		auto it = reads.find(completion.userData);
+		Read read = it->second;
+		reads.erase(it);
+		Load& load = *loads.at(read.loadId);
+		load.readsInFlight--;
+
+		if (completion.result > 0) {
+			stats.bytesRead += completion.result;
+			windowRead += completion.result;
+		}
+		if (load.status == LoadStatus::COMPLETE) {
+			if (completion.result < 0) {
+				fail(load, "failed to read file: " + load.request.path);
+			} else if (completion.result == 0) {
+				fail(load, "file ended early: " + load.request.path);
+			} else if (static_cast<uint64_t>(completion.result) < read.size) {
+				// Short reads are rare for regular files but allowed, read the rest.
+				// The completion freed a slot in the reader so this can't fail.
+				uint32_t done = static_cast<uint32_t>(completion.result);
+				Read rest{read.loadId, read.offset + done, read.size - done};
+				reader.queueRead(load.file, load.request.offset + rest.offset, rest.size,
+					load.readBuffer.get() + rest.offset, nextReadId);
+				reads.emplace(nextReadId++, rest);
+				load.readsInFlight++;
+				load.readDone += done;
+			} else {
+				load.readDone += read.size;
+			}
+		}
+
+		if (load.readsInFlight == 0) {
+			if (load.status != LoadStatus::COMPLETE) {
+				load.stage = Stage::DONE;
+			} else if (load.readDone == load.readSize) {
+				finishReading(load);
+			}
+		}
+	}
+}
+
+void AssetLoader::finishReading(Load& load)
+{
+	AsyncFileReader::closeFile(load.file);
+	load.fileOpen = false;
+
+	if (load.request.compression == Compression::NONE) {
+		load.stage = load.request.destination ? Stage::UPLOADING : Stage::DONE;
+		return;
+	}
+
+	load.stage = Stage::DECOMPRESSING;
+	decompressing.fetch_add(1, std::memory_order_relaxed);
+	Load* target = &load;
+	threadPool->submit([this, target]() {
+		if (!target->cancelled.load()) {
+			target->error = decompress(target->request.compression, target->readBuffer.get(), target->readSize,
+				target->decompressed, target->dataSize);
+		}
+
+		uint64_t id = target->id;
+		{
+			std::lock_guard<std::mutex> lock(decompressedMutex);
+			decompressedIds.push_back(id);
+		}
+		decompressing.fetch_sub(1, std::memory_order_release);
+	});
+}
+
+void AssetLoader::finishDecompression()
+{
+	std::vector<uint64_t> ids;
+	{
+		std::lock_guard<std::mutex> lock(decompressedMutex);
+		ids.swap(decompressedIds);
+	}
+
+	for (uint64_t id : ids) {
+		Load& load = *loads.at(id);
+		load.readBuffer.reset();
+		release(load, load.readSize);
+
+		if (load.cancelled.load()) {
+			load.stage = Stage::DONE;
+		} else if (!load.error.empty()) {
+			fail(load, load.error + ": " + load.request.path);
+		} else {
+			if (load.request.uncompressedSize == 0) {
+				// The size came from the zstd frame, so the budget only learns about it now
+				load.reserved += load.dataSize;
+				inFlightBytes += load.dataSize;
+				stats.peakInFlightBytes = std::max(stats.peakInFlightBytes, inFlightBytes);
+			}
+			stats.bytesDecompressed += load.dataSize;
+			load.stage = load.request.destination ? Stage::UPLOADING : Stage::DONE;
+		}
+	}
+}
+
+void AssetLoader::recordUploads()
+{
+	releaseStaging();
+
+	VkCommandBuffer commandBuffer = nullptr;
+	// Loads with a chunk in this submission
+	std::vector<Load*> chunked;
+	// A single copy may use half the staging buffer, so one big load can't block the ring by itself
+	VkDeviceSize maxChunk = std::max<VkDeviceSize>(stagingBuffer.getSize() / 2, STAGING_ALIGNMENT);
+	bool stagingFull = false;
+
+	for (uint64_t id : active) {
+		Load& load = *loads.at(id);
+		if (load.stage != Stage::UPLOADING) {
+			continue;
+		}
+		if (load.cancelled.load()) {
+			// Chunks submitted by earlier updates may still be copying into the destination
+			load.stage = Stage::UPLOADED;
+			continue;
+		}
+
+		const std::byte* data = load.decompressed ? load.decompressed.get() : load.readBuffer.get();
+		VkDeviceSize firstChunk = load.uploadOffset;
+		while (load.uploadOffset < load.dataSize) {
+			VkDeviceSize chunk = std::min<VkDeviceSize>(load.dataSize - load.uploadOffset, maxChunk);
+			VkDeviceSize offset = 0;
+			void* staging = allocateStaging(chunk, offset);
+			if (!staging) {
+				stagingFull = true;
+				break;
+			}
+			std::memcpy(staging, data + load.uploadOffset, chunk);
+
+			if (!commandBuffer) {
+				commandBuffer = beginCommandBuffer();
+			}
+			VkBufferCopy copy{offset, load.request.destinationOffset + load.uploadOffset, chunk};
+			dispatch->vkCmdCopyBuffer(commandBuffer, stagingBuffer.getHandle(), load.request.destination, 1, &copy);
+			load.uploadOffset += chunk;
+			stats.bytesUploaded += chunk;
+			windowUploaded += chunk;
+		}
+		if (load.uploadOffset != firstChunk) {
+			chunked.push_back(&load);
+		}
+		if (stagingFull) {
+			// Later loads wait their turn so the budget goes to the higher priority ones
+			break;
+		}
+
+		// Everything is in staging, the CPU copy isn't needed anymore
+		load.readBuffer.reset();
+		load.decompressed.reset();
+		release(load, load.reserved);
+		load.stage = Stage::UPLOADED;
+	}
+
+	if (!commandBuffer) {
+		return;
+	}
+	VkResult result = dispatch->vkEndCommandBuffer(commandBuffer); VK_CHECK(result);
+	SubmitBatch batch{};
+	batch.commandBuffers = {commandBuffer};
+	batch.label = "Asset uploads";
+	scheduler->enqueue(transferQueue, std::move(batch));
+	uint64_t serial = scheduler->flush(transferQueue);
+
+	for (StagingAllocation& allocation : stagingAllocations) {
+		if (allocation.serial == PENDING_SERIAL) {
+			allocation.serial = serial;
+		}
+	}
+	commandBuffers.emplace_back(serial, commandBuffer);
+	for (Load* load : chunked) {
+		load->lastChunkSerial = serial;
+	}
+}
+
+void AssetLoader::finishLoads()
+{
+	// Callbacks may start or cancel loads, which can add to active
+	std::vector<uint64_t> current;
+	current.swap(active);
+
+	for (uint64_t id : current) {
+		Load& load = *loads.at(id);
+		if (load.stage == Stage::UPLOADED
+			&& (load.lastChunkSerial == 0 || scheduler->isComplete(transferQueue, load.lastChunkSerial))) {
+			load.stage = Stage::DONE;
+		}
+		if (load.stage != Stage::DONE) {
+			active.push_back(id);
+			continue;
+		}
+
+		if (load.fileOpen) {
+			AsyncFileReader::closeFile(load.file);
+			load.fileOpen = false;
+		}
+		release(load, load.reserved);
+
+		LoadResult result{};
+		result.id = id;
+		result.status = load.status;
+		result.error = load.error;
+		result.size = load.dataSize;
+		if (load.status == LoadStatus::COMPLETE && !load.request.destination) {
+			result.data = load.decompressed ? load.decompressed.get() : load.readBuffer.get();
+		}
+
+		if (load.status == LoadStatus::COMPLETE) {
+			stats.completedLoads++;
+		} else if (load.status == LoadStatus::FAILED) {
+			stats.failedLoads++;
+		} else {
+			stats.cancelledLoads++;
+		}
+
+		std::function<void(const LoadResult&)> callback = std::move(load.request.callback);
+		if (callback) {
+			callback(result);
+		}
+		loads.erase(id);
+	}
+}
+
+void AssetLoader::fail(Load& load, const std::string& error)
+{
+	load.status = LoadStatus::FAILED;
+	load.error = error;
+	if (load.readsInFlight == 0) {
+		load.stage = Stage::DONE;
+	}
+}
+
+void AssetLoader::release(Load& load, uint64_t bytes)
+{
+	bytes = std::min(bytes, load.reserved);
+	load.reserved -= bytes;
+	inFlightBytes -= bytes;
+}
+
+void AssetLoader::updateStats()
+{
+	stats.queuedLoads = 0;
+	for (const std::deque<uint64_t>& ids : queued) {
+		stats.queuedLoads += static_cast<uint32_t>(ids.size());
+	}
+	stats.readingLoads = 0;
+	stats.decompressingLoads = 0;
+	stats.uploadingLoads = 0;
+	for (uint64_t id : active) {
+		Stage stage = loads.at(id)->stage;
+		if (stage == Stage::READING) {
+			stats.readingLoads++;
+		} else if (stage == Stage::DECOMPRESSING) {
+			stats.decompressingLoads++;
+		} else if (stage == Stage::UPLOADING || stage == Stage::UPLOADED) {
+			stats.uploadingLoads++;
+		}
+	}
+	stats.readsInFlight = reader.getInFlightCount();
+	stats.inFlightBytes = inFlightBytes;
+
+	auto now = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(now - windowStart).count();
+	if (seconds >= 1.0) {
+		stats.readThroughput = windowRead / seconds;
+		stats.uploadThroughput = windowUploaded / seconds;
+		windowRead = 0;
+		windowUploaded = 0;
+		windowStart = now;
+	}
+}
+
+void* AssetLoader::allocateStaging(VkDeviceSize size, VkDeviceSize& offset)
+{
+	VkDeviceSize capacity = stagingBuffer.getSize();
+	if (stagingAllocations.empty()) {
+		stagingHead = 0;
+	}
+
+	// Allocations are handed out in a ring, the oldest live allocation marks where free space ends
+	VkDeviceSize aligned = alignUp(stagingHead, STAGING_ALIGNMENT);
+	VkDeviceSize tail = stagingAllocations.empty() ? capacity : stagingAllocations.front().offset;
+	bool wrapped = !stagingAllocations.empty() && stagingHead <= tail;
+	if (wrapped) {
+		if (aligned + size > tail) {
+			return nullptr;
+		}
+	} else if (aligned + size > capacity) {
+		// Not enough room at the end, start again from the front
+		aligned = 0;
+		if (size > (stagingAllocations.empty() ? capacity : tail)) {
+			return nullptr;
+		}
+	}
+
+	offset = aligned;
+	stagingHead = aligned + size;
+	stagingAllocations.push_back({aligned, size, PENDING_SERIAL});
+	return static_cast<std::byte*>(stagingBuffer.getMapped()) + aligned;
+}
+
+void AssetLoader::releaseStaging()
+{
+	while (!stagingAllocations.empty()
+		&& stagingAllocations.front().serial != PENDING_SERIAL
+		&& scheduler->isComplete(transferQueue, stagingAllocations.front().serial)) {
+		stagingAllocations.pop_front();
+	}
+}
+
+VkCommandBuffer AssetLoader::beginCommandBuffer()
+{
+	VkCommandBuffer commandBuffer = nullptr;
+	for (auto it = commandBuffers.begin(); it != commandBuffers.end(); it++) {
+		if (scheduler->isComplete(transferQueue, it->first)) {
+			commandBuffer = it->second;
+			commandBuffers.erase(it);
+			break;
+		}
+	}
+
+	if (commandBuffer) {
+		VkResult result = dispatch->vkResetCommandBuffer(commandBuffer, 0); VK_CHECK(result);
+	} else {
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+		VkResult result = dispatch->vkAllocateCommandBuffers(deviceHandle, &allocateInfo, &commandBuffer); VK_CHECK(result);
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VkResult result = dispatch->vkBeginCommandBuffer(commandBuffer, &beginInfo); VK_CHECK(result);
+	return commandBuffer;
+}
+
+std::string AssetLoader::decompress(Compression compression, const std::byte* source, uint64_t sourceSize,
+	std::unique_ptr<std::byte[]>& destination, uint64_t& destinationSize)
+{
+	switch (compression) {
+	case Compression::LZ4:
+#ifdef APPARATUS_LZ4
+	{
+		if (sourceSize > INT_MAX || destinationSize > INT_MAX) {
+			return "LZ4 block too large";
+		}
+		destination.reset(new std::byte[destinationSize]);
+		int size = LZ4_decompress_safe(reinterpret_cast<const char*>(source), reinterpret_cast<char*>(destination.get()),
+			static_cast<int>(sourceSize), static_cast<int>(destinationSize));
+		if (size < 0 || static_cast<uint64_t>(size) != destinationSize) {
+			return "corrupt LZ4 block";
+		}
+		return {};
+	}
+#else
+		return "built without LZ4 support";
+#endif
+	case Compression::ZSTD:
+#ifdef APPARATUS_ZSTD
+	{
+		if (destinationSize == 0) {
+			unsigned long long frameSize = ZSTD_getFrameContentSize(source, sourceSize);
+			if (frameSize == ZSTD_CONTENTSIZE_UNKNOWN || frameSize == ZSTD_CONTENTSIZE_ERROR) {
+				return "zstd frame without content size";
+			}
+			destinationSize = frameSize;
+		}
+		destination.reset(new std::byte[destinationSize]);
+		size_t size = ZSTD_decompress(destination.get(), destinationSize, source, sourceSize);
+		if (ZSTD_isError(size)) {
+			return std::string("corrupt zstd frame, ") + ZSTD_getErrorName(size);
+		}
+		if (size != destinationSize) {
+			return "zstd frame size mismatch";
+		}
+		return {};
+	}
+#else
+		return "built without zstd support";
+#endif
+	default:
+		return {};
+	}
+}
@@ -0,0 +1,307 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "SubmissionScheduler.h"
+#include "Buffer.h"
+#include "ThreadPool.h"
+#include "AsyncFileReader.h"
+
+enum class LoadPriority : uint32_t
+{
+	LOW,
+	NORMAL,
+	HIGH,
+	COUNT
+};
+
+enum class Compression : uint32_t
+{
+	NONE,
+	// Raw LZ4 block, LoadRequest::uncompressedSize is required
+	LZ4,
+	// Zstandard frame
+	ZSTD
+};
+
+enum class LoadStatus : uint32_t
+{
+	COMPLETE,
+	FAILED,
+	CANCELLED
+};
+
+struct LoadResult
+{
+	uint64_t id;
+	LoadStatus status;
+	// Why the load failed
+	std::string error;
+	// The loaded bytes, only valid during the callback. nullptr when they were uploaded to a buffer.
+	const std::byte* data;
+	uint64_t size;
+};
+
+struct LoadRequest
+{
+	std::string path;
+	// Range of the file to read, a size of 0 reads to the end of the file
+	uint64_t offset = 0;
+	uint64_t size = 0;
+	Compression compression = Compression::NONE;
+	// Size after decompression. May be left 0 for zstd frames that store it,
+	// though the memory budget can only account for it once the frame was read.
+	uint64_t uncompressedSize = 0;
+	LoadPriority priority = LoadPriority::NORMAL;
+	// Buffer the data is copied into on the transfer queue, nullptr keeps it on the CPU.
+	// It needs VK_BUFFER_USAGE_TRANSFER_DST_BIT and must be shared with the transfer queue family.
+	VkBuffer destination = nullptr;
+	VkDeviceSize destinationOffset = 0;
+	// Called from update once the load completed, failed or was cancelled. Uploads are
+	// complete on the GPU by then, so the destination can be used without further waits.
+	std::function<void(const LoadResult&)> callback;
+};
+
+struct AssetLoaderSettings
+{
+	// Bytes the loads in flight may hold in read and decompression buffers. A load bigger than
+	// the budget still runs, but only once nothing else is in flight.
+	uint64_t memoryBudget = 256 * 1024 * 1024;
+	// Most file reads in flight at once
+	uint32_t queueDepth = 64;
+	// Loads are split into reads of this size so they proceed in parallel
+	uint32_t readSize = 1024 * 1024;
+	VkDeviceSize stagingSize = 32 * 1024 * 1024;
+	// false always reads on thread pool workers
+	bool useIoUring = true;
+};
+
+struct AssetLoaderStats
+{
+	// Totals since init
+	uint64_t bytesRead;
+	uint64_t bytesDecompressed;
+	uint64_t bytesUploaded;
+	uint32_t completedLoads;
+	uint32_t failedLoads;
+	uint32_t cancelledLoads;
+
+	// Bytes per second, averaged over about a second of updates
+	double readThroughput;
+	double uploadThroughput;
+
+	// Queue depth of every stage at the end of the last update
+	uint32_t queuedLoads;
+	uint32_t readingLoads;
+	uint32_t decompressingLoads;
+	uint32_t uploadingLoads;
+	uint32_t readsInFlight;
+
+	uint64_t inFlightBytes;
+	uint64_t peakInFlightBytes;
+	bool ioUring;
+};
+
+// Loads file ranges in the background through a pipeline of read, decompress and upload stages.
+// Reads go through AsyncFileReader, decompression runs on the thread pool and uploads are
+// submitted to the device's transfer queue. Not thread safe, every function is called from the same thread.
+class AssetLoader
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create any resources, must call init
+	 */
+	AssetLoader();
+
+	/**
+	 * @brief Creates the staging buffer and sets up the file reader.
+	 *
+	 * @param device - the logical device uploads are submitted to
+	 * @param scheduler - used to submit uploads and track their completion
+	 * @param threadPool - runs decompression, and reads when io_uring isn't used
+	 * @param settings - memory budget and queue sizes
+	 */
+	void init(LogicalDevice& device, SubmissionScheduler& scheduler, ThreadPool& threadPool,
+		const AssetLoaderSettings& settings = {});
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~AssetLoader();
+
+	/**
+	 * @brief Waits for the work in flight and destroys the staging buffer.
+	 * Callbacks of unfinished loads are not called.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Queues a load, it starts in a later update once higher priority loads and the memory budget allow.
+	 *
+	 * @return id identifying the load in cancel and its LoadResult
+	 */
+	uint64_t load(LoadRequest request);
+
+	/**
+	 * @brief Stops a load. Its callback is called with LoadStatus::CANCELLED in a later update.
+	 * A cancelled upload may have written part of the destination, but no copy into it is running by the callback.
+	 *
+	 * @return false if the load already finished
+	 */
+	bool cancel(uint64_t id);
+
+	/**
+	 * @brief Moves every load along the pipeline and calls the callbacks of finished loads.
+	 * Call once per frame.
+	 */
+	void update();
+
+	/**
+	 * @brief Calls update until every load finished
+	 */
+	void waitIdle();
+
+	/**
+	 * @brief Returns whether any load is queued or in flight
+	 */
+	bool isIdle();
+
+	/**
+	 * @brief Returns throughput and queue depths
+	 */
+	AssetLoaderStats getStats();
+
+private:
+	enum class Stage
+	{
+		QUEUED,
+		READING,
+		DECOMPRESSING,
+		UPLOADING,
+		// Every copy was submitted or the load was cancelled, waiting for the GPU to finish the submitted ones
+		UPLOADED,
+		DONE
+	};
+
+	struct Load
+	{
+		uint64_t id;
+		LoadRequest request;
+		Stage stage;
+		LoadStatus status;
+		std::string error;
+		FileHandle file;
+		bool fileOpen;
+
+		// Bytes read from the file, which is data itself for uncompressed loads
+		std::unique_ptr<std::byte[]> readBuffer;
+		uint64_t readSize;
+		uint64_t nextReadOffset;
+		uint64_t readDone;
+		uint32_t readsInFlight;
+
+		std::unique_ptr<std::byte[]> decompressed;
+		uint64_t dataSize;
+		// Budget bytes held by this load
+		uint64_t reserved;
+
+		VkDeviceSize uploadOffset;
+		// Submission of the load's last chunk, 0 until one was submitted. A load is only done once it completed,
+		// cancelled ones too, so the caller never gets the destination back while a copy still writes it
+		uint64_t lastChunkSerial;
+		// Set by cancel, checked by the decompression task
+		std::atomic<bool> cancelled;
+	};
+
+	// A staging range that is reused once its upload finished
+	struct StagingAllocation
+	{
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		uint64_t serial;
+	};
+
+	// One read of a load, the read's user data is the key in reads
+	struct Read
+	{
+		uint64_t loadId;
+		uint64_t offset;
+		uint32_t size;
+	};
+
+	SubmissionScheduler* scheduler;
+	ThreadPool* threadPool;
+	AssetLoaderSettings settings;
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkQueue transferQueue;
+	AsyncFileReader reader;
+
+	uint64_t nextId;
+	std::unordered_map<uint64_t, std::unique_ptr<Load>> loads;
+	// Ids waiting to start, one FIFO per priority
+	std::deque<uint64_t> queued[static_cast<size_t>(LoadPriority::COUNT)];
+	// Ids past QUEUED in the order they started, which follows priority
+	std::vector<uint64_t> active;
+
+	uint64_t nextReadId;
+	std::unordered_map<uint64_t, Read> reads;
+	std::vector<ReadCompletion> completions;
+
+	// Ids whose decompression task finished, filled from the thread pool
+	std::mutex decompressedMutex;
+	std::vector<uint64_t> decompressedIds;
+	std::atomic<uint32_t> decompressing;
+
+	uint64_t inFlightBytes;
+	AssetLoaderStats stats;
+	std::chrono::steady_clock::time_point windowStart;
+	uint64_t windowRead;
+	uint64_t windowUploaded;
+
+	Buffer stagingBuffer;
+	std::deque<StagingAllocation> stagingAllocations;
+	VkDeviceSize stagingHead;
+	VkCommandPool commandPool;
+	std::vector<std::pair<uint64_t, VkCommandBuffer>> commandBuffers;
+
+	// Stage steps, each called once per update
+	void startQueued();
+	void readCompleted();
+	void queueReads();
+	void finishDecompression();
+	void recordUploads();
+	void finishLoads();
+
+	// Opens the file and reserves budget, returns false if the budget is used up
+	bool start(Load& load);
+	// Moves a load whose reads all finished on to decompression, upload or completion
+	void finishReading(Load& load);
+	void fail(Load& load, const std::string& error);
+	void release(Load& load, uint64_t bytes);
+	void updateStats();
+
+	// Returns nullptr if there isn't enough free staging memory right now
+	void* allocateStaging(VkDeviceSize size, VkDeviceSize& offset);
+	void releaseStaging();
+	VkCommandBuffer beginCommandBuffer();
+
+	// Decompresses source into a new destination. A destinationSize of 0 is taken from the zstd frame.
+	// Returns an error message, empty on success.
+	static std::string decompress(Compression compression, const std::byte* source, uint64_t sourceSize,
+		std::unique_ptr<std::byte[]>& destination, uint64_t& destinationSize);
+};
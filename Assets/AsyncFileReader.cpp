@@ -0,0 +1,432 @@
+#include "AsyncFileReader.h"
+
+#include <cerrno>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define APPARATUS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+	// user_data of cancel requests, their completions aren't reported
+	constexpr uint64_t CANCEL_USER_DATA = UINT64_MAX;
+
+	// Blocking positional read used by the fallback, returns bytes read or a negative errno
+	int64_t readAt(FileHandle file, uint64_t offset, uint32_t size, void* destination)
+	{
+		uint32_t done = 0;
+		while (done < size) {
+#ifdef _WIN32
+			OVERLAPPED overlapped{};
+			overlapped.Offset = static_cast<DWORD>(offset + done);
+			overlapped.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+			DWORD count = 0;
+			if (!ReadFile(file, static_cast<char*>(destination) + done, size - done, &count, &overlapped)) {
+				if (GetLastError() == ERROR_HANDLE_EOF) {
+					break;
+				}
+				return -EIO;
+			}
+#else
+			ssize_t count = pread(file, static_cast<char*>(destination) + done, size - done,
+				static_cast<off_t>(offset + done));
+			if (count < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return -errno;
+			}
+#endif
+			if (count == 0) {
+				break;
+			}
+			done += static_cast<uint32_t>(count);
+		}
+		return done;
+	}
+}
+
+struct AsyncFileReader::Ring
+{
+#ifdef APPARATUS_IO_URING
+	int fd = -1;
+	void* sqMapping = nullptr;
+	size_t sqMappingSize = 0;
+	void* cqMapping = nullptr;
+	size_t cqMappingSize = 0;
+	io_uring_sqe* sqes = nullptr;
+	size_t sqesSize = 0;
+
+	// Written by us and read by the kernel
+	unsigned* sqHead = nullptr;
+	unsigned* sqTail = nullptr;
+	unsigned* sqArray = nullptr;
+	unsigned sqMask = 0;
+	unsigned sqEntries = 0;
+	// Written by the kernel and read by us
+	unsigned* cqHead = nullptr;
+	unsigned* cqTail = nullptr;
+	io_uring_cqe* cqes = nullptr;
+	unsigned cqMask = 0;
+
+	// Entries written since the last io_uring_enter
+	unsigned toSubmit = 0;
+	// Completions taken off the completion queue to make room, not yet returned by poll
+	std::vector<io_uring_cqe> reaped;
+
+	// Submits the written entries, waiting for minComplete completions
+	void enter(unsigned minComplete)
+	{
+		for (;;) {
+			unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+			long result = syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+			if (result >= 0) {
+				toSubmit -= static_cast<unsigned>(result);
+				return;
+			}
+			if (errno == EAGAIN || errno == EBUSY) {
+				// The kernel is short on resources, the entries are submitted on the next call
+				return;
+			}
+			if (errno != EINTR) {
+				throw std::runtime_error("failed to submit to io_uring");
+			}
+		}
+	}
+
+	// Moves every completion into reaped, which frees their slots for the kernel
+	void reap()
+	{
+		unsigned head = *cqHead;
+		unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; head++) {
+			reaped.push_back(cqes[head & cqMask]);
+		}
+		__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+	}
+
+	// Returns a cleared entry, submitting first if the submission queue is full
+	io_uring_sqe* nextEntry()
+	{
+		unsigned tail = *sqTail;
+		while (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+			// The kernel refuses entries with EBUSY while its completion queue is full and with EAGAIN while
+			// it's short on resources, both clear up as completions are taken off, so reap them and wait for one
+			reap();
+			enter(1);
+		}
+		unsigned index = tail & sqMask;
+		sqArray[index] = index;
+		sqes[index] = {};
+		return &sqes[index];
+	}
+
+	// Makes the entry from nextEntry visible to the kernel
+	void pushEntry()
+	{
+		__atomic_store_n(sqTail, *sqTail + 1, __ATOMIC_RELEASE);
+		toSubmit++;
+	}
+#endif
+};
+
+AsyncFileReader::AsyncFileReader() :
+	threadPool(nullptr),
+	queueDepth(0),
+	inFlight(0),
+	ring(nullptr),
+	finished{},
+	cancelled{},
+	running(0)
+{
+}
+
+void AsyncFileReader::init(ThreadPool& _threadPool, uint32_t _queueDepth, bool allowIoUring)
+{
+	threadPool = &_threadPool;
+	queueDepth = _queueDepth;
+	inFlight = 0;
+	running = 0;
+
+	if (allowIoUring) {
+		initRing();
+	}
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+	cleanup();
+}
+
+void AsyncFileReader::cleanup()
+{
+	if (ring) {
+		// The kernel writes into the destinations until the reads complete
+		std::vector<ReadCompletion> dropped;
+		while (inFlight > 0) {
+			poll(dropped, true);
+		}
+		cleanupRing();
+	} else {
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this]() { return running == 0; });
+		finished.clear();
+		cancelled.clear();
+	}
+	inFlight = 0;
+}
+
+FileHandle AsyncFileReader::openFile(const std::string& path, uint64_t& size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	size = static_cast<uint64_t>(fileSize.QuadPart);
+	return file;
+#else
+	int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0) {
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	struct stat status;
+	if (fstat(file, &status) != 0) {
+		close(file);
+		throw std::runtime_error("failed to read size of file: " + path);
+	}
+	size = static_cast<uint64_t>(status.st_size);
+	return file;
+#endif
+}
+
+void AsyncFileReader::closeFile(FileHandle file)
+{
+#ifdef _WIN32
+	CloseHandle(file);
+#else
+	close(file);
+#endif
+}
+
+bool AsyncFileReader::queueRead(FileHandle file, uint64_t offset, uint32_t size, void* destination, uint64_t userData)
+{
+	if (inFlight >= queueDepth) {
+		return false;
+	}
+	inFlight++;
+
+#ifdef APPARATUS_IO_URING
+	if (ring) {
+		io_uring_sqe* entry = ring->nextEntry();
+		entry->opcode = IORING_OP_READ;
+		entry->fd = file;
+		entry->off = offset;
+		entry->addr = reinterpret_cast<uint64_t>(destination);
+		entry->len = size;
+		entry->user_data = userData;
+		ring->pushEntry();
+		return true;
+	}
+#endif
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running++;
+	}
+	threadPool->submit([this, file, offset, size, destination, userData]() {
+		bool skip;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			skip = cancelled.count(userData) > 0;
+		}
+		int64_t result = skip ? -ECANCELED : readAt(file, offset, size, destination);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.push_back({userData, result});
+			running--;
+		}
+		condition.notify_all();
+	});
+	return true;
+}
+
+void AsyncFileReader::cancel(uint64_t userData)
+{
+#ifdef APPARATUS_IO_URING
+	if (ring) {
+		io_uring_sqe* entry = ring->nextEntry();
+		entry->opcode = IORING_OP_ASYNC_CANCEL;
+		entry->fd = -1;
+		entry->addr = userData;
+		entry->user_data = CANCEL_USER_DATA;
+		ring->pushEntry();
+		return;
+	}
+#endif
+
+	std::lock_guard<std::mutex> lock(mutex);
+	cancelled.insert(userData);
+}
+
+uint32_t AsyncFileReader::poll(std::vector<ReadCompletion>& completions, bool wait)
+{
+	uint32_t count = 0;
+
+#ifdef APPARATUS_IO_URING
+	if (ring) {
+		do {
+			// Everything queued since the last poll goes to the kernel in one call. Completions nextEntry
+			// already reaped are returned without waiting.
+			bool block = wait && inFlight > 0 && ring->reaped.empty();
+			if (ring->toSubmit > 0 || block) {
+				ring->enter(block ? 1 : 0);
+			}
+
+			ring->reap();
+			for (const io_uring_cqe& entry : ring->reaped) {
+				if (entry.user_data != CANCEL_USER_DATA) {
+					completions.push_back({entry.user_data, entry.res});
+					inFlight--;
+					count++;
+				}
+			}
+			ring->reaped.clear();
+		} while (wait && count == 0 && inFlight > 0);
+		return count;
+	}
+#endif
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (wait && inFlight > 0) {
+		condition.wait(lock, [this]() { return !finished.empty(); });
+	}
+	for (const ReadCompletion& completion : finished) {
+		cancelled.erase(completion.userData);
+		completions.push_back(completion);
+	}
+	count = static_cast<uint32_t>(finished.size());
+	inFlight -= count;
+	finished.clear();
+	return count;
+}
+
+uint32_t AsyncFileReader::getInFlightCount()
+{
+	return inFlight;
+}
+
+bool AsyncFileReader::usesIoUring()
+{
+	return ring != nullptr;
+}
+
+bool AsyncFileReader::initRing()
+{
+#ifdef APPARATUS_IO_URING
+	io_uring_params params{};
+	int fd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+	if (fd < 0) {
+		// Kernels before 5.1, or io_uring disabled through sysctl or a seccomp filter
+		return false;
+	}
+	ring = std::make_unique<Ring>();
+	ring->fd = fd;
+
+	// IORING_OP_READ arrived in 5.6 together with this flag
+	if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+		cleanupRing();
+		return false;
+	}
+
+	ring->sqMappingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cqMappingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMapping = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (singleMapping && ring->cqMappingSize > ring->sqMappingSize) {
+		ring->sqMappingSize = ring->cqMappingSize;
+	}
+
+	void* mapping = mmap(nullptr, ring->sqMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		fd, IORING_OFF_SQ_RING);
+	if (mapping == MAP_FAILED) {
+		cleanupRing();
+		return false;
+	}
+	ring->sqMapping = mapping;
+
+	if (singleMapping) {
+		ring->cqMapping = ring->sqMapping;
+	} else {
+		mapping = mmap(nullptr, ring->cqMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			fd, IORING_OFF_CQ_RING);
+		if (mapping == MAP_FAILED) {
+			cleanupRing();
+			return false;
+		}
+		ring->cqMapping = mapping;
+	}
+
+	ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	mapping = mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (mapping == MAP_FAILED) {
+		cleanupRing();
+		return false;
+	}
+	ring->sqes = static_cast<io_uring_sqe*>(mapping);
+
+	char* sq = static_cast<char*>(ring->sqMapping);
+	ring->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	ring->sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	ring->sqEntries = params.sq_entries;
+
+	char* cq = static_cast<char*>(ring->cqMapping);
+	ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+	ring->cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AsyncFileReader::cleanupRing()
+{
+#ifdef APPARATUS_IO_URING
+	if (!ring) {
+		return;
+	}
+	if (ring->sqes) {
+		munmap(ring->sqes, ring->sqesSize);
+	}
+	if (ring->cqMapping && ring->cqMapping != ring->sqMapping) {
+		munmap(ring->cqMapping, ring->cqMappingSize);
+	}
+	if (ring->sqMapping) {
+		munmap(ring->sqMapping, ring->sqMappingSize);
+	}
+	close(ring->fd);
+#endif
+	ring.reset();
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "ThreadPool.h"
+
+#ifdef _WIN32
+using FileHandle = void*;
+#else
+using FileHandle = int;
+#endif
+
+struct ReadCompletion
+{
+	// Value given to queueRead
+	uint64_t userData;
+	// Bytes read, fewer than asked for at the end of the file. A negative errno if the read failed or was cancelled.
+	int64_t result;
+};
+
+// Reads file ranges without blocking the calling thread. Uses io_uring on Linux so a whole batch of
+// reads costs one system call, and falls back to pread on thread pool workers elsewhere or when the
+// kernel doesn't allow io_uring. Not thread safe, every function is called from the same thread.
+class AsyncFileReader
+{
+public:
+	/**
+	 * @brief Default Constructor: Can't read anything, must call init
+	 */
+	AsyncFileReader();
+
+	/**
+	 * @brief Sets up an io_uring instance, or the fallback if that fails.
+	 *
+	 * @param threadPool - runs the reads of the fallback, must outlive the reader
+	 * @param queueDepth - most reads in flight at once
+	 * @param allowIoUring - false always uses the fallback
+	 */
+	void init(ThreadPool& threadPool, uint32_t queueDepth = 64, bool allowIoUring = true);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~AsyncFileReader();
+
+	/**
+	 * @brief Waits for the reads in flight and tears down the io_uring instance.
+	 * Completions that were never polled are dropped.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Opens a file for reading.
+	 *
+	 * @param path - file to open
+	 * @param size - set to the size of the file in bytes
+	 *
+	 * @return the handle, throws an error if the file can't be opened
+	 */
+	static FileHandle openFile(const std::string& path, uint64_t& size);
+	static void closeFile(FileHandle file);
+
+	/**
+	 * @brief Queues a read, it starts on the next poll. The destination must stay valid
+	 * until the read's completion was returned by poll.
+	 *
+	 * @param file - from openFile, must stay open until the read completed
+	 * @param offset - where to start reading in the file
+	 * @param size - bytes to read
+	 * @param destination - memory the bytes are read into
+	 * @param userData - returned with the completion, must not be UINT64_MAX
+	 *
+	 * @return false without queueing anything if queueDepth reads are already in flight
+	 */
+	bool queueRead(FileHandle file, uint64_t offset, uint32_t size, void* destination, uint64_t userData);
+
+	/**
+	 * @brief Asks for a queued or running read to stop. The read still shows up in poll, either
+	 * with -ECANCELED or with its result if it finished first.
+	 */
+	void cancel(uint64_t userData);
+
+	/**
+	 * @brief Starts the queued reads and appends the finished ones to completions.
+	 *
+	 * @param completions - finished reads are appended to it
+	 * @param wait - blocks until at least one read finished if any are in flight
+	 *
+	 * @return number of completions appended
+	 */
+	uint32_t poll(std::vector<ReadCompletion>& completions, bool wait = false);
+
+	/**
+	 * @brief Returns the number of reads queued or running
+	 */
+	uint32_t getInFlightCount();
+
+	/**
+	 * @brief Returns whether reads go through io_uring rather than the fallback
+	 */
+	bool usesIoUring();
+
+private:
+	// Ring buffers shared with the kernel, only used with io_uring
+	struct Ring;
+
+	ThreadPool* threadPool;
+	uint32_t queueDepth;
+	uint32_t inFlight;
+	std::unique_ptr<Ring> ring;
+
+	// Used by the fallback, the workers hand back their results through these
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector<ReadCompletion> finished;
+	std::unordered_set<uint64_t> cancelled;
+	uint32_t running;
+
+	bool initRing();
+	void cleanupRing();
+};
@@ -0,0 +1,544 @@
+#include "MeshImport.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Just enough JSON for glTF: no escapes beyond the simple ones, numbers are doubles
+	struct JsonValue
+	{
+		enum class Type { NONE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+		Type type = Type::NONE;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<JsonValue> array;
+		std::vector<std::pair<std::string, JsonValue>> object;
+
+		const JsonValue& operator[](const char* key) const
+		{
+			static const JsonValue none{};
+			for (const auto& member : object) {
+				if (member.first == key) {
+					return member.second;
+				}
+			}
+			return none;
+		}
+
+		const JsonValue& at(size_t index) const
+		{
+			static const JsonValue none{};
+			return index < array.size() ? array[index] : none;
+		}
+
+		bool has(const char* key) const
+		{
+			return (*this)[key].type != Type::NONE;
+		}
+
+		double getNumber(double fallback = 0.0) const
+		{
+			return type == Type::NUMBER ? number : fallback;
+		}
+
+		size_t getIndex() const
+		{
+			return static_cast<size_t>(number);
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+		explicit JsonParser(const char* _text, const char* _end) :
+			text(_text),
+			end(_end)
+		{
+		}
+
+		JsonValue parse()
+		{
+			JsonValue value{};
+			skipSpaces();
+			if (text >= end) {
+				fail();
+			}
+
+			if (*text == '{') {
+				value.type = JsonValue::Type::OBJECT;
+				text++;
+				skipSpaces();
+				while (text < end && *text != '}') {
+					std::string key = parseString();
+					skipSpaces();
+					expect(':');
+					value.object.emplace_back(std::move(key), parse());
+					skipSpaces();
+					if (text < end && *text == ',') {
+						text++;
+						skipSpaces();
+					}
+				}
+				expect('}');
+			} else if (*text == '[') {
+				value.type = JsonValue::Type::ARRAY;
+				text++;
+				skipSpaces();
+				while (text < end && *text != ']') {
+					value.array.push_back(parse());
+					skipSpaces();
+					if (text < end && *text == ',') {
+						text++;
+					}
+					skipSpaces();
+				}
+				expect(']');
+			} else if (*text == '"') {
+				value.type = JsonValue::Type::STRING;
+				value.string = parseString();
+			} else if (matches("true")) {
+				value.type = JsonValue::Type::BOOLEAN;
+				value.boolean = true;
+			} else if (matches("false")) {
+				value.type = JsonValue::Type::BOOLEAN;
+			} else if (matches("null")) {
+				value.type = JsonValue::Type::NONE;
+			} else {
+				char* next = nullptr;
+				value.type = JsonValue::Type::NUMBER;
+				value.number = std::strtod(text, &next);
+				if (next == text) {
+					fail();
+				}
+				text = next;
+			}
+			return value;
+		}
+
+	private:
+		const char* text;
+		const char* end;
+
+		void skipSpaces()
+		{
+			while (text < end && (*text == ' ' || *text == '\t' || *text == '\n' || *text == '\r')) {
+				text++;
+			}
+		}
+
+		void expect(char character)
+		{
+			if (text >= end || *text != character) {
+				fail();
+			}
+			text++;
+		}
+
+		bool matches(const char* word)
+		{
+			size_t length = std::strlen(word);
+			if (static_cast<size_t>(end - text) >= length && std::strncmp(text, word, length) == 0) {
+				text += length;
+				return true;
+			}
+			return false;
+		}
+
+		std::string parseString()
+		{
+			expect('"');
+			std::string string{};
+			while (text < end && *text != '"') {
+				if (*text == '\\' && text + 1 < end) {
+					text++;
+					switch (*text) {
+					case 'n': string += '\n'; break;
+					case 't': string += '\t'; break;
+					case 'r': string += '\r'; break;
+					case 'b': string += '\b'; break;
+					case 'f': string += '\f'; break;
+					// Unicode escapes only show up in names, which aren't used
+					case 'u': text += 4; string += '?'; break;
+					default: string += *text; break;
+					}
+				} else {
+					string += *text;
+				}
+				text++;
+			}
+			expect('"');
+			return string;
+		}
+
+		[[noreturn]] void fail()
+		{
+			throw std::runtime_error("invalid JSON in glTF file");
+		}
+	};
+
+	constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+	constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+	constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+	constexpr int COMPONENT_UNSIGNED_BYTE = 5121;
+	constexpr int COMPONENT_UNSIGNED_SHORT = 5123;
+	constexpr int COMPONENT_UNSIGNED_INT = 5125;
+	constexpr int COMPONENT_FLOAT = 5126;
+	constexpr int MODE_TRIANGLES = 4;
+
+	std::vector<uint8_t> decodeBase64(const std::string& text, size_t start)
+	{
+		auto decode = [](char c) -> int {
+			if (c >= 'A' && c <= 'Z') return c - 'A';
+			if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+			if (c >= '0' && c <= '9') return c - '0' + 52;
+			if (c == '+') return 62;
+			if (c == '/') return 63;
+			return -1;
+		};
+
+		std::vector<uint8_t> bytes{};
+		uint32_t bits = 0;
+		int bitCount = 0;
+		for (size_t i = start; i < text.size(); i++) {
+			int value = decode(text[i]);
+			if (value < 0) {
+				break;
+			}
+			bits = (bits << 6) | static_cast<uint32_t>(value);
+			bitCount += 6;
+			if (bitCount >= 8) {
+				bitCount -= 8;
+				bytes.push_back(static_cast<uint8_t>(bits >> bitCount));
+			}
+		}
+		return bytes;
+	}
+
+	std::vector<uint8_t> readFile(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open file: " + path);
+		}
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		std::string text = buffer.str();
+		return std::vector<uint8_t>(text.begin(), text.end());
+	}
+
+	// Column major 4x4
+	struct Transform
+	{
+		double m[16];
+	};
+
+	Transform multiply(const Transform& a, const Transform& b)
+	{
+		Transform result{};
+		for (int column = 0; column < 4; column++) {
+			for (int row = 0; row < 4; row++) {
+				double sum = 0.0;
+				for (int k = 0; k < 4; k++) {
+					sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+				}
+				result.m[column * 4 + row] = sum;
+			}
+		}
+		return result;
+	}
+
+	Transform getNodeTransform(const JsonValue& node)
+	{
+		Transform transform{};
+		if (node.has("matrix")) {
+			for (size_t i = 0; i < 16; i++) {
+				transform.m[i] = node["matrix"].at(i).getNumber();
+			}
+			return transform;
+		}
+
+		// T * R * S
+		const JsonValue& t = node["translation"];
+		const JsonValue& r = node["rotation"];
+		const JsonValue& s = node["scale"];
+		double x = r.at(0).getNumber(0.0), y = r.at(1).getNumber(0.0), z = r.at(2).getNumber(0.0), w = r.at(3).getNumber(1.0);
+		double scale[3] = {s.at(0).getNumber(1.0), s.at(1).getNumber(1.0), s.at(2).getNumber(1.0)};
+		double rotation[9] = {
+			1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w),
+			2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w),
+			2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y)
+		};
+		for (int column = 0; column < 3; column++) {
+			for (int row = 0; row < 3; row++) {
+				transform.m[column * 4 + row] = rotation[column * 3 + row] * scale[column];
+			}
+		}
+		transform.m[12] = t.at(0).getNumber(0.0);
+		transform.m[13] = t.at(1).getNumber(0.0);
+		transform.m[14] = t.at(2).getNumber(0.0);
+		transform.m[15] = 1.0;
+		return transform;
+	}
+
+	class GltfReader
+	{
+	public:
+		GltfReader(const std::string& _path, MeshData& _mesh) :
+			path(_path),
+			mesh(_mesh)
+		{
+		}
+
+		void read()
+		{
+			std::vector<uint8_t> file = readFile(path);
+			const char* jsonStart = reinterpret_cast<const char*>(file.data());
+			const char* jsonEnd = jsonStart + file.size();
+			std::vector<uint8_t> binaryChunk{};
+
+			uint32_t magic = 0;
+			if (file.size() >= 12) {
+				std::memcpy(&magic, file.data(), 4);
+			}
+			if (magic == GLB_MAGIC) {
+				// 12 byte header, then chunks of length, type and data
+				jsonStart = nullptr;
+				size_t offset = 12;
+				while (offset + 8 <= file.size()) {
+					uint32_t length, type;
+					std::memcpy(&length, &file[offset], 4);
+					std::memcpy(&type, &file[offset + 4], 4);
+					offset += 8;
+					if (offset + length > file.size()) {
+						throw std::runtime_error("invalid glb chunk in: " + path);
+					}
+					if (type == GLB_CHUNK_JSON) {
+						jsonStart = reinterpret_cast<const char*>(&file[offset]);
+						jsonEnd = jsonStart + length;
+					} else if (type == GLB_CHUNK_BIN && binaryChunk.empty()) {
+						binaryChunk.assign(file.begin() + offset, file.begin() + offset + length);
+					}
+					offset += length;
+				}
+				if (!jsonStart) {
+					throw std::runtime_error("glb file has no JSON chunk: " + path);
+				}
+			}
+
+			root = JsonParser(jsonStart, jsonEnd).parse();
+			loadBuffers(binaryChunk);
+
+			mesh = {};
+			const JsonValue& scenes = root["scenes"];
+			if (scenes.array.empty()) {
+				// Without scenes every mesh is used as is
+				Transform identity{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+				for (size_t i = 0; i < root["meshes"].array.size(); i++) {
+					addMesh(root["meshes"].at(i), identity);
+				}
+			} else {
+				const JsonValue& scene = scenes.at(static_cast<size_t>(root["scene"].getNumber(0.0)));
+				Transform identity{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+				for (const JsonValue& node : scene["nodes"].array) {
+					addNode(node.getIndex(), identity, 0);
+				}
+			}
+		}
+
+	private:
+		const std::string& path;
+		MeshData& mesh;
+		JsonValue root;
+		std::vector<std::vector<uint8_t>> buffers;
+
+		void loadBuffers(std::vector<uint8_t>& binaryChunk)
+		{
+			std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+			for (const JsonValue& buffer : root["buffers"].array) {
+				const JsonValue& uri = buffer["uri"];
+				if (uri.type != JsonValue::Type::STRING) {
+					buffers.push_back(std::move(binaryChunk));
+				} else if (uri.string.compare(0, 5, "data:") == 0) {
+					size_t comma = uri.string.find(',');
+					if (comma == std::string::npos || uri.string.find(";base64") > comma) {
+						throw std::runtime_error("unsupported data uri in: " + path);
+					}
+					buffers.push_back(decodeBase64(uri.string, comma + 1));
+				} else {
+					buffers.push_back(readFile(directory + uri.string));
+				}
+				if (buffers.back().size() < static_cast<size_t>(buffer["byteLength"].getNumber(0.0))) {
+					throw std::runtime_error("glTF buffer is smaller than its byteLength in: " + path);
+				}
+			}
+		}
+
+		// Returns the address of every element of an accessor, checking it fits its buffer
+		const uint8_t* getAccessor(size_t index, int componentType, size_t components, size_t& count, size_t& stride,
+			int& actualComponentType)
+		{
+			const JsonValue& accessor = root["accessors"].at(index);
+			if (accessor.has("sparse") || !accessor.has("bufferView")) {
+				throw std::runtime_error("sparse or empty glTF accessors are not supported: " + path);
+			}
+			const JsonValue& view = root["bufferViews"].at(accessor["bufferView"].getIndex());
+			const std::vector<uint8_t>& buffer = buffers.at(view["buffer"].getIndex());
+
+			actualComponentType = static_cast<int>(accessor["componentType"].getNumber(0.0));
+			if (componentType != 0 && actualComponentType != componentType) {
+				throw std::runtime_error("unsupported glTF accessor component type in: " + path);
+			}
+			size_t componentSize = actualComponentType == COMPONENT_UNSIGNED_BYTE ? 1
+				: actualComponentType == COMPONENT_UNSIGNED_SHORT ? 2 : 4;
+			size_t elementSize = componentSize * components;
+
+			count = static_cast<size_t>(accessor["count"].getNumber(0.0));
+			stride = static_cast<size_t>(view["byteStride"].getNumber(static_cast<double>(elementSize)));
+			size_t offset = static_cast<size_t>(view["byteOffset"].getNumber(0.0) + accessor["byteOffset"].getNumber(0.0));
+			if (count > 0 && offset + (count - 1) * stride + elementSize > buffer.size()) {
+				throw std::runtime_error("glTF accessor is out of bounds in: " + path);
+			}
+			return buffer.data() + offset;
+		}
+
+		void addNode(size_t index, const Transform& parent, int depth)
+		{
+			// Guards against cycles in broken files
+			if (depth > 64) {
+				throw std::runtime_error("glTF node hierarchy is too deep in: " + path);
+			}
+			const JsonValue& node = root["nodes"].at(index);
+			Transform transform = multiply(parent, getNodeTransform(node));
+			if (node.has("mesh")) {
+				addMesh(root["meshes"].at(node["mesh"].getIndex()), transform);
+			}
+			for (const JsonValue& child : node["children"].array) {
+				addNode(child.getIndex(), transform, depth + 1);
+			}
+		}
+
+		void addMesh(const JsonValue& gltfMesh, const Transform& transform)
+		{
+			// Normals use the inverse transpose, which is the cofactor matrix up to a scale
+			const double* m = transform.m;
+			double cofactor[9] = {
+				m[5] * m[10] - m[6] * m[9], m[6] * m[8] - m[4] * m[10], m[4] * m[9] - m[5] * m[8],
+				m[2] * m[9] - m[1] * m[10], m[0] * m[10] - m[2] * m[8], m[1] * m[8] - m[0] * m[9],
+				m[1] * m[6] - m[2] * m[5], m[2] * m[4] - m[0] * m[6], m[0] * m[5] - m[1] * m[4]
+			};
+			double determinant = m[0] * cofactor[0] + m[1] * cofactor[1] + m[2] * cofactor[2];
+			double sign = determinant < 0.0 ? -1.0 : 1.0;
+
+			for (const JsonValue& primitive : gltfMesh["primitives"].array) {
+				if (primitive["mode"].getNumber(MODE_TRIANGLES) != MODE_TRIANGLES) {
+					continue;
+				}
+				const JsonValue& attributes = primitive["attributes"];
+				if (!attributes.has("POSITION")) {
+					continue;
+				}
+
+				size_t count, stride, normalCount = 0, normalStride = 0, uvCount = 0, uvStride = 0;
+				int componentType;
+				const uint8_t* positions = getAccessor(attributes["POSITION"].getIndex(), COMPONENT_FLOAT, 3, count, stride, componentType);
+				const uint8_t* normals = nullptr;
+				const uint8_t* uvs = nullptr;
+				if (attributes.has("NORMAL")) {
+					normals = getAccessor(attributes["NORMAL"].getIndex(), COMPONENT_FLOAT, 3, normalCount, normalStride, componentType);
+				}
+				if (attributes.has("TEXCOORD_0")) {
+					uvs = getAccessor(attributes["TEXCOORD_0"].getIndex(), COMPONENT_FLOAT, 2, uvCount, uvStride, componentType);
+				}
+
+				uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+				for (size_t i = 0; i < count; i++) {
+					float position[3], normal[3] = {0.0f, 0.0f, 0.0f};
+					std::memcpy(position, positions + i * stride, sizeof(position));
+
+					MeshVertex vertex{};
+					for (int row = 0; row < 3; row++) {
+						vertex.position[row] = static_cast<float>(
+							m[row] * position[0] + m[4 + row] * position[1] + m[8 + row] * position[2] + m[12 + row]);
+					}
+					if (normals && i < normalCount) {
+						std::memcpy(normal, normals + i * normalStride, sizeof(normal));
+						double transformed[3];
+						for (int row = 0; row < 3; row++) {
+							transformed[row] = sign * (cofactor[row] * normal[0] + cofactor[3 + row] * normal[1]
+								+ cofactor[6 + row] * normal[2]);
+						}
+						double length = std::sqrt(transformed[0] * transformed[0] + transformed[1] * transformed[1] + transformed[2] * transformed[2]);
+						for (int row = 0; row < 3; row++) {
+							vertex.normal[row] = length > 0.0 ? static_cast<float>(transformed[row] / length) : 0.0f;
+						}
+					}
+					if (uvs && i < uvCount) {
+						std::memcpy(vertex.uv, uvs + i * uvStride, sizeof(vertex.uv));
+					}
+					mesh.vertices.push_back(vertex);
+				}
+
+				Submesh submesh{};
+				submesh.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+				if (primitive.has("indices")) {
+					size_t indexCount, indexStride;
+					int indexType;
+					const uint8_t* indices = getAccessor(primitive["indices"].getIndex(), 0, 1, indexCount, indexStride, indexType);
+					for (size_t i = 0; i < indexCount; i++) {
+						uint32_t index = 0;
+						if (indexType == COMPONENT_UNSIGNED_BYTE) {
+							index = indices[i * indexStride];
+						} else if (indexType == COMPONENT_UNSIGNED_SHORT) {
+							uint16_t value;
+							std::memcpy(&value, indices + i * indexStride, sizeof(value));
+							index = value;
+						} else if (indexType == COMPONENT_UNSIGNED_INT) {
+							std::memcpy(&index, indices + i * indexStride, sizeof(index));
+						} else {
+							throw std::runtime_error("unsupported glTF index type in: " + path);
+						}
+						if (index >= count) {
+							throw std::runtime_error("glTF index is out of range in: " + path);
+						}
+						mesh.indices.push_back(baseVertex + index);
+					}
+				} else {
+					for (uint32_t i = 0; i < count; i++) {
+						mesh.indices.push_back(baseVertex + i);
+					}
+				}
+				// Drop a trailing partial triangle
+				mesh.indices.resize(submesh.firstIndex + (mesh.indices.size() - submesh.firstIndex) / 3 * 3);
+				submesh.indexCount = static_cast<uint32_t>(mesh.indices.size()) - submesh.firstIndex;
+
+				// Mirroring transforms flip the winding
+				if (determinant < 0.0) {
+					for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i += 3) {
+						std::swap(mesh.indices[i + 1], mesh.indices[i + 2]);
+					}
+				}
+				if (!normals) {
+					computeNormals(mesh, submesh.firstIndex, submesh.indexCount);
+				}
+				if (submesh.indexCount > 0) {
+					mesh.submeshes.push_back(submesh);
+				}
+			}
+		}
+	};
+}
+
+void importGltf(const std::string& path, MeshData& mesh)
+{
+	GltfReader(path, mesh).read();
+}
@@ -0,0 +1,208 @@
+#include "GpuMesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iterator>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+
+namespace
+{
+	// Two halves are used in turns, so the next half is filled from the mapping while the last one is copied
+	constexpr VkDeviceSize STAGING_SIZE = 16 * 1024 * 1024;
+
+	const char* const SECTION_NAMES[] = {
+		"GpuMesh vertices",
+		"GpuMesh indices",
+		"GpuMesh submeshes",
+		"GpuMesh meshlets",
+		"GpuMesh meshlet vertices",
+		"GpuMesh meshlet triangles",
+		"GpuMesh meshlet bounds"
+	};
+	static_assert(std::size(SECTION_NAMES) == static_cast<size_t>(MeshSection::COUNT));
+
+	VkBufferUsageFlags getUsage(MeshSection section)
+	{
+		VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		if (section == MeshSection::VERTICES) {
+			usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		} else if (section == MeshSection::INDICES) {
+			usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		}
+		return usage;
+	}
+
+	// Destroys the upload command pool however init is left, since VK_CHECK throws. Copies that were
+	// already submitted are waited on first, the pool can't be destroyed while they use its command buffers.
+	struct UploadPoolGuard
+	{
+		const DeviceDispatch& dispatch;
+		VkDevice deviceHandle;
+		const VkAllocationCallbacks* allocator;
+		SubmissionScheduler& scheduler;
+		VkQueue queue;
+		const uint64_t (&serials)[2];
+		VkCommandPool commandPool = nullptr;
+
+		~UploadPoolGuard()
+		{
+			if (!commandPool) {
+				return;
+			}
+			try {
+				for (uint64_t serial : serials) {
+					if (serial != 0) {
+						scheduler.wait(queue, serial);
+					}
+				}
+			} catch (const std::exception&) {
+				// Only fails once the device is lost, when the copies won't run anymore either
+			}
+			dispatch.vkDestroyCommandPool(deviceHandle, commandPool, allocator);
+		}
+	};
+}
+
+GpuMesh::GpuMesh() :
+	buffers{},
+	counts{},
+	submeshes{}
+{
+}
+
+void GpuMesh::init(LogicalDevice& device, SubmissionScheduler& scheduler, MeshFile& file)
+{
+	VkDevice deviceHandle = device.getHandle();
+	const VkAllocationCallbacks* allocator = device.getAllocator();
+	const DeviceDispatch& dispatch = device.getDispatch();
+	VkQueue queue = device.getTransferQueue();
+	std::vector<uint32_t> queueFamilies = {device.getGraphicsFamilyIndex()};
+	if (device.getTransferFamilyIndex() != device.getGraphicsFamilyIndex()) {
+		queueFamilies.push_back(device.getTransferFamilyIndex());
+	}
+
+	uint32_t submeshCount = 0;
+	const Submesh* fileSubmeshes = file.getSubmeshes(submeshCount);
+	submeshes.assign(fileSubmeshes, fileSubmeshes + submeshCount);
+	// Start reading every page now instead of one page fault at a time during the copies
+	file.prefetch();
+
+	Buffer staging[2];
+	VkCommandBuffer commandBuffers[2];
+	uint64_t serials[2] = {0, 0};
+	for (uint32_t i = 0; i < 2; i++) {
+		staging[i].init(device, STAGING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		staging[i].setName("GpuMesh staging ", i);
+	}
+
+	UploadPoolGuard pool{dispatch, deviceHandle, allocator, scheduler, queue, serials};
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = device.getTransferFamilyIndex();
+	VkResult result = dispatch.vkCreateCommandPool(deviceHandle, &poolInfo, allocator, &pool.commandPool); VK_CHECK(result);
+	setObjectName(dispatch, deviceHandle, VK_OBJECT_TYPE_COMMAND_POOL, pool.commandPool, "GpuMesh upload");
+
+	VkCommandBufferAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = pool.commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 2;
+	result = dispatch.vkAllocateCommandBuffers(deviceHandle, &allocateInfo, commandBuffers); VK_CHECK(result);
+
+	uint32_t current = 0;
+	VkDeviceSize used = 0;
+	bool recording = false;
+	auto submit = [&]() {
+		result = dispatch.vkEndCommandBuffer(commandBuffers[current]); VK_CHECK(result);
+		SubmitBatch batch{};
+		batch.commandBuffers = {commandBuffers[current]};
+		batch.label = "Mesh upload";
+		scheduler.enqueue(queue, batch);
+		serials[current] = scheduler.flush(queue);
+		recording = false;
+
+		// Switch halves, waiting for the copies that read the other half last time
+		current ^= 1;
+		used = 0;
+		if (serials[current] != 0) {
+			scheduler.wait(queue, serials[current]);
+		}
+	};
+
+	for (uint32_t section = 0; section < static_cast<uint32_t>(MeshSection::COUNT); section++) {
+		uint64_t size = 0;
+		const std::byte* data = file.getSection(static_cast<MeshSection>(section), size);
+		if (!data || size == 0) {
+			continue;
+		}
+		buffers[section].init(device, size, getUsage(static_cast<MeshSection>(section)),
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, queueFamilies);
+		buffers[section].setName(SECTION_NAMES[section]);
+		counts[section] = file.getCount(static_cast<MeshSection>(section));
+
+		for (uint64_t offset = 0; offset < size;) {
+			if (used == STAGING_SIZE) {
+				submit();
+			}
+			if (!recording) {
+				VkCommandBufferBeginInfo beginInfo{};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				result = dispatch.vkBeginCommandBuffer(commandBuffers[current], &beginInfo); VK_CHECK(result);
+				recording = true;
+			}
+
+			// The only CPU work is this copy, which is where the file is actually read
+			VkDeviceSize chunk = std::min<VkDeviceSize>(size - offset, STAGING_SIZE - used);
+			std::memcpy(static_cast<std::byte*>(staging[current].getMapped()) + used, data + offset, chunk);
+			VkBufferCopy copy{used, offset, chunk};
+			dispatch.vkCmdCopyBuffer(commandBuffers[current], staging[current].getHandle(), buffers[section].getHandle(), 1, &copy);
+			used += chunk;
+			offset += chunk;
+		}
+	}
+	if (recording) {
+		submit();
+	}
+	for (uint64_t serial : serials) {
+		if (serial != 0) {
+			scheduler.wait(queue, serial);
+		}
+	}
+}
+
+GpuMesh::~GpuMesh()
+{
+	cleanup();
+}
+
+void GpuMesh::cleanup()
+{
+	for (Buffer& buffer : buffers) {
+		buffer.cleanup();
+	}
+	for (uint32_t& count : counts) {
+		count = 0;
+	}
+	submeshes.clear();
+}
+
+VkBuffer GpuMesh::getBuffer(MeshSection section)
+{
+	return buffers[static_cast<size_t>(section)].getHandle();
+}
+
+uint32_t GpuMesh::getCount(MeshSection section)
+{
+	return counts[static_cast<size_t>(section)];
+}
+
+const std::vector<Submesh>& GpuMesh::getSubmeshes()
+{
+	return submeshes;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "SubmissionScheduler.h"
+#include "Buffer.h"
+#include "MeshFile.h"
+
+// Device buffers holding every section of a mesh file
+class GpuMesh
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create any buffers, must call init
+	 */
+	GpuMesh();
+
+	/**
+	 * @brief Creates a device local buffer per section and copies the sections straight from the
+	 * file's mapping into them on the transfer queue. Waits for the copies before returning.
+	 *
+	 * @param device - the logical device to create the buffers under
+	 * @param scheduler - used to submit the copies
+	 * @param file - the mapped mesh file, only read during init
+	 */
+	void init(LogicalDevice& device, SubmissionScheduler& scheduler, MeshFile& file);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~GpuMesh();
+
+	/**
+	 * @brief Destroys the buffers. The device must not be using them anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Returns the buffer holding a section, nullptr if the file didn't have it.
+	 * Vertices can be bound as a vertex buffer and indices as a uint32 index buffer,
+	 * every section can be read as a storage buffer.
+	 */
+	VkBuffer getBuffer(MeshSection section);
+
+	/**
+	 * @brief Returns the number of elements in a section
+	 */
+	uint32_t getCount(MeshSection section);
+
+	/**
+	 * @brief Returns the submeshes, kept on the CPU as well for recording draws
+	 */
+	const std::vector<Submesh>& getSubmeshes();
+
+private:
+	Buffer buffers[static_cast<size_t>(MeshSection::COUNT)];
+	uint32_t counts[static_cast<size_t>(MeshSection::COUNT)];
+	std::vector<Submesh> submeshes;
+};
@@ -0,0 +1,126 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	data(nullptr),
+	size(0)
+#ifdef _WIN32
+	, fileHandle(nullptr),
+	mappingHandle(nullptr)
+#endif
+{
+}
+
+void MappedFile::init(const std::string& path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	size = static_cast<size_t>(fileSize.QuadPart);
+	fileHandle = file;
+	if (size == 0) {
+		return;
+	}
+
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle) {
+		data = static_cast<const std::byte*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!data) {
+		cleanup();
+		throw std::runtime_error("failed to map file: " + path);
+	}
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	struct stat status;
+	if (fstat(file, &status) != 0) {
+		close(file);
+		throw std::runtime_error("failed to read size of file: " + path);
+	}
+	size = static_cast<size_t>(status.st_size);
+	if (size == 0) {
+		close(file);
+		return;
+	}
+
+	// The mapping keeps its own reference to the file
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED) {
+		size = 0;
+		throw std::runtime_error("failed to map file: " + path);
+	}
+	data = static_cast<const std::byte*>(mapping);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	cleanup();
+}
+
+void MappedFile::cleanup()
+{
+#ifdef _WIN32
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle) {
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if (fileHandle) {
+		CloseHandle(fileHandle);
+		fileHandle = nullptr;
+	}
+#else
+	if (data) {
+		munmap(const_cast<std::byte*>(data), size);
+	}
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+void MappedFile::prefetch()
+{
+	if (!data) {
+		return;
+	}
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range{const_cast<std::byte*>(data), size};
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	madvise(const_cast<std::byte*>(data), size, MADV_WILLNEED);
+#endif
+}
+
+const std::byte* MappedFile::getData() const
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
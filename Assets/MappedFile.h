@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read only memory mapping of a whole file
+class MappedFile
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't map anything, must call init
+	 */
+	MappedFile();
+
+	/**
+	 * @brief Maps the file. Pages are read from disk the first time they are touched.
+	 * Throws an error if the file can't be opened or mapped.
+	 *
+	 * @param path - file to map
+	 */
+	void init(const std::string& path);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to unmap the file
+	 */
+	~MappedFile();
+
+	/**
+	 * @brief Unmaps the file, pointers into the mapping become invalid
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Asks the OS to start reading the whole file in the background, so the first accesses
+	 * don't each wait for a disk read
+	 */
+	void prefetch();
+
+	const std::byte* getData() const;
+	size_t getSize() const;
+
+private:
+	const std::byte* data;
+	size_t size;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
@@ -0,0 +1,337 @@
+#include "MeshData.h"
+
+#include <algorithm>
+#include <cmath>
+
+void computeNormals(MeshData& mesh, uint32_t firstIndex, uint32_t indexCount)
+{
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++) {
+		float* normal = mesh.vertices[mesh.indices[i]].normal;
+		normal[0] = normal[1] = normal[2] = 0.0f;
+	}
+
+	// The cross product's length is twice the triangle's area, so summing it weighs by area
+	for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3) {
+		const float* a = mesh.vertices[mesh.indices[i]].position;
+		const float* b = mesh.vertices[mesh.indices[i + 1]].position;
+		const float* c = mesh.vertices[mesh.indices[i + 2]].position;
+		float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+		float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+		float cross[3] = {
+			ab[1] * ac[2] - ab[2] * ac[1],
+			ab[2] * ac[0] - ab[0] * ac[2],
+			ab[0] * ac[1] - ab[1] * ac[0]
+		};
+		for (uint32_t j = 0; j < 3; j++) {
+			float* normal = mesh.vertices[mesh.indices[i + j]].normal;
+			normal[0] += cross[0];
+			normal[1] += cross[1];
+			normal[2] += cross[2];
+		}
+	}
+
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++) {
+		float* normal = mesh.vertices[mesh.indices[i]].normal;
+		float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		// Normalizing twice when a vertex is shared is harmless
+		if (length > 0.0f) {
+			normal[0] /= length;
+			normal[1] /= length;
+			normal[2] /= length;
+		}
+	}
+}
+
+void computeBounds(MeshData& mesh)
+{
+	for (Submesh& submesh : mesh.submeshes) {
+		float minimum[3] = {INFINITY, INFINITY, INFINITY};
+		float maximum[3] = {-INFINITY, -INFINITY, -INFINITY};
+		for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++) {
+			const float* position = mesh.vertices[mesh.indices[i]].position;
+			for (int axis = 0; axis < 3; axis++) {
+				minimum[axis] = std::min(minimum[axis], position[axis]);
+				maximum[axis] = std::max(maximum[axis], position[axis]);
+			}
+		}
+		if (submesh.indexCount == 0) {
+			std::fill_n(submesh.boundingSphere, 4, 0.0f);
+			continue;
+		}
+
+		// Centered on the box, which is close enough to the smallest sphere for culling
+		float radiusSquared = 0.0f;
+		for (int axis = 0; axis < 3; axis++) {
+			submesh.boundingSphere[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+		}
+		for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++) {
+			const float* position = mesh.vertices[mesh.indices[i]].position;
+			float dx = position[0] - submesh.boundingSphere[0];
+			float dy = position[1] - submesh.boundingSphere[1];
+			float dz = position[2] - submesh.boundingSphere[2];
+			radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+		}
+		submesh.boundingSphere[3] = std::sqrt(radiusSquared);
+	}
+}
+
+void buildMeshlets(MeshData& mesh, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	maxVertices = std::clamp(maxVertices, 3u, MAX_MESHLET_VERTICES);
+	maxTriangles = std::clamp(maxTriangles, 1u, MAX_MESHLET_TRIANGLES);
+	mesh.meshlets.clear();
+	mesh.meshletVertices.clear();
+	mesh.meshletTriangles.clear();
+
+	// Triangles using each vertex, laid out as one list per vertex
+	uint32_t triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+	std::vector<uint32_t> adjacencyOffsets(mesh.vertices.size() + 1, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; i++) {
+		adjacencyOffsets[mesh.indices[i] + 1]++;
+	}
+	for (size_t i = 1; i < adjacencyOffsets.size(); i++) {
+		adjacencyOffsets[i] += adjacencyOffsets[i - 1];
+	}
+	std::vector<uint32_t> adjacency(adjacencyOffsets.back());
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (uint32_t i = 0; i < triangleCount * 3; i++) {
+		adjacency[fill[mesh.indices[i]]++] = i / 3;
+	}
+
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	// Position of each mesh vertex in the current meshlet, UINT8_MAX when it isn't in it
+	std::vector<uint8_t> localIndices(mesh.vertices.size(), UINT8_MAX);
+	std::vector<uint32_t> candidates{};
+	std::vector<uint32_t> reordered{};
+
+	auto getCentroid = [&](uint32_t triangle, float centroid[3]) {
+		for (int axis = 0; axis < 3; axis++) {
+			centroid[axis] = (mesh.vertices[mesh.indices[triangle * 3]].position[axis]
+				+ mesh.vertices[mesh.indices[triangle * 3 + 1]].position[axis]
+				+ mesh.vertices[mesh.indices[triangle * 3 + 2]].position[axis]) / 3.0f;
+		}
+	};
+	auto countNewVertices = [&](uint32_t triangle) {
+		uint32_t count = 0;
+		for (int j = 0; j < 3; j++) {
+			count += localIndices[mesh.indices[triangle * 3 + j]] == UINT8_MAX ? 1 : 0;
+		}
+		return count;
+	};
+
+	for (Submesh& submesh : mesh.submeshes) {
+		submesh.firstMeshlet = static_cast<uint32_t>(mesh.meshlets.size());
+		uint32_t firstTriangle = submesh.firstIndex / 3;
+		uint32_t endTriangle = firstTriangle + submesh.indexCount / 3;
+		uint32_t scan = firstTriangle;
+		reordered.clear();
+
+		Meshlet meshlet{};
+		float centroidSum[3] = {0.0f, 0.0f, 0.0f};
+		auto finish = [&]() {
+			for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+				localIndices[mesh.meshletVertices[meshlet.vertexOffset + i]] = UINT8_MAX;
+			}
+			mesh.meshlets.push_back(meshlet);
+			// Triangle blocks start on 4 bytes so shaders can read them as uints
+			mesh.meshletTriangles.resize((mesh.meshletTriangles.size() + 3) & ~size_t(3));
+			meshlet = {};
+			meshlet.vertexOffset = static_cast<uint32_t>(mesh.meshletVertices.size());
+			meshlet.triangleOffset = static_cast<uint32_t>(mesh.meshletTriangles.size());
+			centroidSum[0] = centroidSum[1] = centroidSum[2] = 0.0f;
+			candidates.clear();
+		};
+		meshlet.vertexOffset = static_cast<uint32_t>(mesh.meshletVertices.size());
+		meshlet.triangleOffset = static_cast<uint32_t>(mesh.meshletTriangles.size());
+
+		while (reordered.size() < submesh.indexCount / 3) {
+			// Prefer the neighbour adding the fewest vertices, then the one closest to the meshlet's center
+			uint32_t best = UINT32_MAX;
+			uint32_t bestNewVertices = 4;
+			float bestDistance = INFINITY;
+			size_t kept = 0;
+			for (uint32_t candidate : candidates) {
+				if (emitted[candidate]) {
+					continue;
+				}
+				candidates[kept++] = candidate;
+				uint32_t newVertices = countNewVertices(candidate);
+				if (meshlet.vertexCount + newVertices > maxVertices || newVertices > bestNewVertices) {
+					continue;
+				}
+				float centroid[3];
+				getCentroid(candidate, centroid);
+				float distance = 0.0f;
+				for (int axis = 0; axis < 3; axis++) {
+					float delta = centroid[axis] - centroidSum[axis] / meshlet.triangleCount;
+					distance += delta * delta;
+				}
+				if (newVertices < bestNewVertices || distance < bestDistance) {
+					best = candidate;
+					bestNewVertices = newVertices;
+					bestDistance = distance;
+				}
+			}
+			candidates.resize(kept);
+
+			if (meshlet.triangleCount == maxTriangles) {
+				finish();
+				continue;
+			}
+			if (best == UINT32_MAX) {
+				if (!candidates.empty()) {
+					// Neighbours are left but none fits
+					finish();
+					continue;
+				}
+				// Nothing connected is left, continue with the next triangle in index order,
+				// which importers keep close to the ones before it
+				while (emitted[scan]) {
+					scan++;
+				}
+				if (meshlet.vertexCount + countNewVertices(scan) > maxVertices) {
+					finish();
+					continue;
+				}
+				best = scan;
+			}
+
+			emitted[best] = 1;
+			reordered.push_back(best);
+			for (int j = 0; j < 3; j++) {
+				uint32_t vertex = mesh.indices[best * 3 + j];
+				uint8_t& local = localIndices[vertex];
+				if (local == UINT8_MAX) {
+					local = static_cast<uint8_t>(meshlet.vertexCount++);
+					mesh.meshletVertices.push_back(vertex);
+					for (uint32_t k = adjacencyOffsets[vertex]; k < adjacencyOffsets[vertex + 1]; k++) {
+						uint32_t neighbour = adjacency[k];
+						if (!emitted[neighbour] && neighbour >= firstTriangle && neighbour < endTriangle) {
+							candidates.push_back(neighbour);
+						}
+					}
+				}
+				mesh.meshletTriangles.push_back(local);
+			}
+			float centroid[3];
+			getCentroid(best, centroid);
+			for (int axis = 0; axis < 3; axis++) {
+				centroidSum[axis] += centroid[axis];
+			}
+			meshlet.triangleCount++;
+		}
+		if (meshlet.triangleCount > 0) {
+			finish();
+		}
+		submesh.meshletCount = static_cast<uint32_t>(mesh.meshlets.size()) - submesh.firstMeshlet;
+
+		// Put the submesh's triangles in meshlet order so indexed draws can cover a range of meshlets
+		std::vector<uint32_t> indices(submesh.indexCount - submesh.indexCount % 3);
+		for (size_t i = 0; i < reordered.size(); i++) {
+			std::copy_n(&mesh.indices[reordered[i] * 3], 3, &indices[i * 3]);
+		}
+		std::copy(indices.begin(), indices.end(), mesh.indices.begin() + submesh.firstIndex);
+	}
+
+	computeMeshletBounds(mesh);
+}
+
+void computeMeshletBounds(MeshData& mesh)
+{
+	mesh.meshletBounds.resize(mesh.meshlets.size());
+	// Normal and a point on the plane of every non degenerate triangle
+	std::vector<float> planes{};
+
+	for (size_t m = 0; m < mesh.meshlets.size(); m++) {
+		const Meshlet& meshlet = mesh.meshlets[m];
+		MeshletBounds& bounds = mesh.meshletBounds[m];
+		bounds = {};
+		auto getPosition = [&](uint32_t local) {
+			return mesh.vertices[mesh.meshletVertices[meshlet.vertexOffset + local]].position;
+		};
+
+		// Sphere centered on the box like computeBounds
+		float minimum[3] = {INFINITY, INFINITY, INFINITY};
+		float maximum[3] = {-INFINITY, -INFINITY, -INFINITY};
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			for (int axis = 0; axis < 3; axis++) {
+				minimum[axis] = std::min(minimum[axis], getPosition(i)[axis]);
+				maximum[axis] = std::max(maximum[axis], getPosition(i)[axis]);
+			}
+		}
+		for (int axis = 0; axis < 3 && meshlet.vertexCount > 0; axis++) {
+			bounds.center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+		}
+		float radiusSquared = 0.0f;
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			const float* position = getPosition(i);
+			float dx = position[0] - bounds.center[0];
+			float dy = position[1] - bounds.center[1];
+			float dz = position[2] - bounds.center[2];
+			radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+		}
+		bounds.radius = std::sqrt(radiusSquared);
+
+		// The cone axis is the average face normal
+		planes.clear();
+		float axis[3] = {0.0f, 0.0f, 0.0f};
+		const uint8_t* triangles = &mesh.meshletTriangles[meshlet.triangleOffset];
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+			const float* a = getPosition(triangles[t * 3]);
+			const float* b = getPosition(triangles[t * 3 + 1]);
+			const float* c = getPosition(triangles[t * 3 + 2]);
+			float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+			float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+			float normal[3] = {
+				ab[1] * ac[2] - ab[2] * ac[1],
+				ab[2] * ac[0] - ab[0] * ac[2],
+				ab[0] * ac[1] - ab[1] * ac[0]
+			};
+			float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length == 0.0f) {
+				continue;
+			}
+			for (int i = 0; i < 3; i++) {
+				normal[i] /= length;
+				axis[i] += normal[i];
+				planes.push_back(normal[i]);
+			}
+			planes.insert(planes.end(), a, a + 3);
+		}
+
+		bounds.coneCutoff = 1.0f;
+		std::copy_n(bounds.center, 3, bounds.coneApex);
+		float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		if (planes.empty() || axisLength == 0.0f) {
+			continue;
+		}
+		for (int i = 0; i < 3; i++) {
+			bounds.coneAxis[i] = axis[i] / axisLength;
+		}
+
+		float minDot = 1.0f;
+		for (size_t i = 0; i < planes.size(); i += 6) {
+			float dotAxis = planes[i] * bounds.coneAxis[0] + planes[i + 1] * bounds.coneAxis[1] + planes[i + 2] * bounds.coneAxis[2];
+			minDot = std::min(minDot, dotAxis);
+		}
+		// Normals spread over close to a half sphere, the apex would be too far away to ever cull
+		if (minDot <= 0.1f) {
+			continue;
+		}
+
+		// Move the apex back along the axis until it's behind every triangle's plane
+		float maxDistance = 0.0f;
+		for (size_t i = 0; i < planes.size(); i += 6) {
+			const float* normal = &planes[i];
+			const float* point = &planes[i + 3];
+			float centerDistance = (bounds.center[0] - point[0]) * normal[0] + (bounds.center[1] - point[1]) * normal[1]
+				+ (bounds.center[2] - point[2]) * normal[2];
+			float axisDot = bounds.coneAxis[0] * normal[0] + bounds.coneAxis[1] * normal[1] + bounds.coneAxis[2] * normal[2];
+			maxDistance = std::max(maxDistance, centerDistance / axisDot);
+		}
+		for (int i = 0; i < 3; i++) {
+			bounds.coneApex[i] = bounds.center[i] - bounds.coneAxis[i] * maxDistance;
+		}
+		bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
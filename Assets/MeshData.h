@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MeshFormat.h"
+
+// A mesh in memory, as read by the importers and written by MeshFile::write
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<Submesh> submeshes;
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+	std::vector<MeshletBounds> meshletBounds;
+};
+
+/**
+ * @brief Sets the normals of the vertices used by a range of indices to the area weighted
+ * average of the normals of the triangles they're part of
+ */
+void computeNormals(MeshData& mesh, uint32_t firstIndex, uint32_t indexCount);
+
+/**
+ * @brief Computes the bounding sphere of every submesh
+ */
+void computeBounds(MeshData& mesh);
+
+/**
+ * @brief Splits every submesh into meshlets, replacing any existing meshlets, and computes their bounds.
+ * Triangles are grown from neighbours sharing the most vertices so meshlets stay compact, which keeps
+ * their spheres and normal cones tight. The indices of every submesh are reordered to follow its meshlets,
+ * so meshlet i covers the triangles right after those of meshlet i - 1.
+ *
+ * @param maxVertices - vertex limit per meshlet, at most MAX_MESHLET_VERTICES
+ * @param maxTriangles - triangle limit per meshlet, at most MAX_MESHLET_TRIANGLES
+ */
+void buildMeshlets(MeshData& mesh, uint32_t maxVertices = MAX_MESHLET_VERTICES,
+	uint32_t maxTriangles = MAX_MESHLET_TRIANGLES);
+
+/**
+ * @brief Computes the bounding sphere and normal cone of every meshlet
+ */
+void computeMeshletBounds(MeshData& mesh);
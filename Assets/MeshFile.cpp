@@ -0,0 +1,194 @@
+#include "MeshFile.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	uint64_t alignSectionOffset(uint64_t offset)
+	{
+		return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+	}
+}
+
+MeshFile::MeshFile() :
+	file(),
+	header(nullptr),
+	sections{}
+{
+}
+
+void MeshFile::init(const std::string& path)
+{
+	file.init(path);
+	const std::byte* data = file.getData();
+	size_t size = file.getSize();
+
+	// Only the header and the table are read, the sections are left for the caller to touch
+	header = reinterpret_cast<const MeshFileHeader*>(data);
+	if (size < sizeof(MeshFileHeader) || header->magic != MESH_FILE_MAGIC || header->version != MESH_FILE_VERSION
+		|| header->fileSize != size || sizeof(MeshFileHeader) + uint64_t(header->sectionCount) * sizeof(MeshSectionEntry) > size) {
+		cleanup();
+		throw std::runtime_error("invalid mesh file: " + path);
+	}
+
+	const MeshSectionEntry* entries = reinterpret_cast<const MeshSectionEntry*>(data + sizeof(MeshFileHeader));
+	for (uint32_t i = 0; i < header->sectionCount; i++) {
+		const MeshSectionEntry& entry = entries[i];
+		if (entry.offset % MESH_FILE_ALIGNMENT != 0 || entry.offset > size || entry.size > size - entry.offset
+			|| entry.stride == 0 || entry.size % entry.stride != 0) {
+			cleanup();
+			throw std::runtime_error("invalid mesh file section: " + path);
+		}
+		if (entry.type < static_cast<uint32_t>(MeshSection::COUNT)) {
+			sections[entry.type] = &entry;
+		}
+	}
+}
+
+void MeshFile::cleanup()
+{
+	file.cleanup();
+	header = nullptr;
+	for (auto& section : sections) {
+		section = nullptr;
+	}
+}
+
+const MeshFileHeader& MeshFile::getHeader() const
+{
+	return *header;
+}
+
+const std::byte* MeshFile::getSection(MeshSection section, uint64_t& size) const
+{
+	const MeshSectionEntry* entry = sections[static_cast<size_t>(section)];
+	if (!entry) {
+		size = 0;
+		return nullptr;
+	}
+
+	size = entry->size;
+	return file.getData() + entry->offset;
+}
+
+uint32_t MeshFile::getCount(MeshSection section) const
+{
+	const MeshSectionEntry* entry = sections[static_cast<size_t>(section)];
+	return entry ? static_cast<uint32_t>(entry->size / entry->stride) : 0;
+}
+
+const MeshVertex* MeshFile::getVertices(uint32_t& count) const
+{
+	return getArray<MeshVertex>(MeshSection::VERTICES, count);
+}
+
+const uint32_t* MeshFile::getIndices(uint32_t& count) const
+{
+	return getArray<uint32_t>(MeshSection::INDICES, count);
+}
+
+const Submesh* MeshFile::getSubmeshes(uint32_t& count) const
+{
+	return getArray<Submesh>(MeshSection::SUBMESHES, count);
+}
+
+const Meshlet* MeshFile::getMeshlets(uint32_t& count) const
+{
+	return getArray<Meshlet>(MeshSection::MESHLETS, count);
+}
+
+const MeshletBounds* MeshFile::getMeshletBounds(uint32_t& count) const
+{
+	return getArray<MeshletBounds>(MeshSection::MESHLET_BOUNDS, count);
+}
+
+void MeshFile::prefetch()
+{
+	file.prefetch();
+}
+
+template<typename T>
+const T* MeshFile::getArray(MeshSection section, uint32_t& count) const
+{
+	const MeshSectionEntry* entry = sections[static_cast<size_t>(section)];
+	if (!entry) {
+		count = 0;
+		return nullptr;
+	}
+	// Written by a build with a different layout of the type, reading it would misplace every element
+	if (entry->stride != sizeof(T)) {
+		throw std::runtime_error("mesh file section has a different element size than the type it's read as");
+	}
+
+	count = static_cast<uint32_t>(entry->size / entry->stride);
+	return reinterpret_cast<const T*>(file.getData() + entry->offset);
+}
+
+void MeshFile::write(const std::string& path, const MeshData& mesh)
+{
+	struct Source
+	{
+		MeshSection type;
+		uint32_t stride;
+		const void* data;
+		uint64_t size;
+	};
+	std::vector<Source> sources{};
+	auto addSection = [&](MeshSection type, const auto& array) {
+		using Element = typename std::decay_t<decltype(array)>::value_type;
+		if (!array.empty()) {
+			sources.push_back({type, sizeof(Element), array.data(), array.size() * sizeof(Element)});
+		}
+	};
+	addSection(MeshSection::VERTICES, mesh.vertices);
+	addSection(MeshSection::INDICES, mesh.indices);
+	addSection(MeshSection::SUBMESHES, mesh.submeshes);
+	addSection(MeshSection::MESHLETS, mesh.meshlets);
+	addSection(MeshSection::MESHLET_VERTICES, mesh.meshletVertices);
+	addSection(MeshSection::MESHLET_TRIANGLES, mesh.meshletTriangles);
+	addSection(MeshSection::MESHLET_BOUNDS, mesh.meshletBounds);
+
+	MeshFileHeader header{};
+	header.magic = MESH_FILE_MAGIC;
+	header.version = MESH_FILE_VERSION;
+	header.sectionCount = static_cast<uint32_t>(sources.size());
+	for (int axis = 0; axis < 3; axis++) {
+		header.boundsMin[axis] = mesh.vertices.empty() ? 0.0f : INFINITY;
+		header.boundsMax[axis] = mesh.vertices.empty() ? 0.0f : -INFINITY;
+	}
+	for (const MeshVertex& vertex : mesh.vertices) {
+		for (int axis = 0; axis < 3; axis++) {
+			header.boundsMin[axis] = std::fmin(header.boundsMin[axis], vertex.position[axis]);
+			header.boundsMax[axis] = std::fmax(header.boundsMax[axis], vertex.position[axis]);
+		}
+	}
+
+	std::vector<MeshSectionEntry> entries(sources.size());
+	uint64_t offset = sizeof(MeshFileHeader) + sources.size() * sizeof(MeshSectionEntry);
+	for (size_t i = 0; i < sources.size(); i++) {
+		offset = alignSectionOffset(offset);
+		entries[i] = {static_cast<uint32_t>(sources[i].type), sources[i].stride, offset, sources[i].size};
+		offset += sources[i].size;
+	}
+	header.fileSize = offset;
+
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	if (!output.is_open()) {
+		throw std::runtime_error("failed to open file for writing: " + path);
+	}
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(MeshSectionEntry));
+	const char padding[MESH_FILE_ALIGNMENT] = {};
+	for (size_t i = 0; i < sources.size(); i++) {
+		output.write(padding, static_cast<std::streamsize>(entries[i].offset - static_cast<uint64_t>(output.tellp())));
+		output.write(static_cast<const char*>(sources[i].data), static_cast<std::streamsize>(sources[i].size));
+	}
+	if (!output) {
+		throw std::runtime_error("failed to write file: " + path);
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+#include "MeshData.h"
+#include "MeshFormat.h"
+
+// A memory mapped .amesh file. Nothing is parsed or copied, every accessor points into the mapping.
+class MeshFile
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't open a file, must call init
+	 */
+	MeshFile();
+
+	/**
+	 * @brief Maps the file and checks the header and section table.
+	 * Throws an error if the file can't be mapped or isn't a valid mesh file.
+	 *
+	 * @param path - .amesh file written by MeshFile::write
+	 */
+	void init(const std::string& path);
+
+	/**
+	 * @brief Unmaps the file
+	 */
+	void cleanup();
+
+	const MeshFileHeader& getHeader() const;
+
+	/**
+	 * @brief Returns the start of a section inside the mapping
+	 *
+	 * @param section - the section to find
+	 * @param size - set to the section's size in bytes, 0 if the file doesn't have the section
+	 *
+	 * @return pointer to the section's data, nullptr if the file doesn't have it
+	 */
+	const std::byte* getSection(MeshSection section, uint64_t& size) const;
+
+	/**
+	 * @brief Returns the number of elements in a section, 0 if the file doesn't have it
+	 */
+	uint32_t getCount(MeshSection section) const;
+
+	/**
+	 * @brief Return a section as an array of its element type and set count to its length,
+	 * nullptr and 0 if the file doesn't have it. Throw an error if the file's element size doesn't match the type.
+	 */
+	const MeshVertex* getVertices(uint32_t& count) const;
+	const uint32_t* getIndices(uint32_t& count) const;
+	const Submesh* getSubmeshes(uint32_t& count) const;
+	const Meshlet* getMeshlets(uint32_t& count) const;
+	const MeshletBounds* getMeshletBounds(uint32_t& count) const;
+
+	/**
+	 * @brief Asks the OS to start reading the whole file, such as before uploading it
+	 */
+	void prefetch();
+
+	/**
+	 * @brief Writes a mesh in the .amesh format. Empty arrays are left out of the file.
+	 * Throws an error if the file can't be written.
+	 */
+	static void write(const std::string& path, const MeshData& mesh);
+
+private:
+	MappedFile file;
+	const MeshFileHeader* header;
+	const MeshSectionEntry* sections[static_cast<size_t>(MeshSection::COUNT)];
+
+	template<typename T>
+	const T* getArray(MeshSection section, uint32_t& count) const;
+};
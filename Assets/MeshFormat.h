@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of .amesh files. A file is a MeshFileHeader, followed by a table of sectionCount
+// MeshSectionEntry, followed by the sections. Every section starts on a MESH_FILE_ALIGNMENT
+// boundary so it can be used in place from a memory mapping and copied straight into a device buffer.
+// All values are little endian.
+
+constexpr uint32_t MESH_FILE_MAGIC = 0x48534D41; // "AMSH"
+constexpr uint32_t MESH_FILE_VERSION = 2;
+// Covers minStorageBufferOffsetAlignment and nonCoherentAtomSize on every common device
+constexpr uint64_t MESH_FILE_ALIGNMENT = 256;
+
+constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+enum class MeshSection : uint32_t
+{
+	// MeshVertex array
+	VERTICES,
+	// uint32_t triangle list indices
+	INDICES,
+	// Submesh array
+	SUBMESHES,
+	// Meshlet array
+	MESHLETS,
+	// uint32_t indices into VERTICES, referenced by Meshlet::vertexOffset
+	MESHLET_VERTICES,
+	// Three uint8_t indices into a meshlet's vertices per triangle, referenced by Meshlet::triangleOffset
+	MESHLET_TRIANGLES,
+	// MeshletBounds array, one per meshlet
+	MESHLET_BOUNDS,
+	COUNT
+};
+
+struct MeshFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	// Size of the whole file in bytes
+	uint64_t fileSize;
+	uint32_t sectionCount;
+	uint32_t padding;
+	// Object space bounds of every vertex
+	float boundsMin[4];
+	float boundsMax[4];
+};
+
+struct MeshSectionEntry
+{
+	// A MeshSection, readers skip types they don't know
+	uint32_t type;
+	// Size of one element in bytes
+	uint32_t stride;
+	// From the start of the file, a multiple of MESH_FILE_ALIGNMENT
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct MeshVertex
+{
+	float position[3];
+	float normal[3];
+	float uv[2];
+};
+
+// A range of the mesh drawn with one material
+struct Submesh
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+	// xyz is the center in object space, w is the radius
+	float boundingSphere[4];
+};
+
+struct Meshlet
+{
+	// First element in MESHLET_VERTICES
+	uint32_t vertexOffset;
+	// First byte in MESHLET_TRIANGLES, a multiple of 4
+	uint32_t triangleOffset;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+};
+
+// Culling data of a meshlet in object space
+struct MeshletBounds
+{
+	float center[3];
+	float radius;
+	// Every triangle faces away from a camera inside the cone, which is the case when
+	// dot(normalize(coneApex - camera), coneAxis) >= coneCutoff. A cutoff of 1 never culls.
+	float coneApex[3];
+	float coneCutoff;
+	float coneAxis[3];
+	float padding;
+};
+
+static_assert(sizeof(MeshFileHeader) == 56, "MeshFileHeader layout changed");
+static_assert(sizeof(MeshSectionEntry) == 24, "MeshSectionEntry layout changed");
+static_assert(sizeof(MeshVertex) == 32, "MeshVertex layout changed");
+static_assert(sizeof(Submesh) == 32, "Submesh layout changed");
+static_assert(sizeof(Meshlet) == 16, "Meshlet layout changed");
+static_assert(sizeof(MeshletBounds) == 48, "MeshletBounds layout changed");
@@ -0,0 +1,23 @@
+#include "MeshImport.h"
+
+#include <cctype>
+#include <stdexcept>
+
+void importMesh(const std::string& path, MeshData& mesh)
+{
+	std::string extension = path.substr(path.find_last_of('.') + 1);
+	for (char& character : extension) {
+		character = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+	}
+
+	if (extension == "obj") {
+		importObj(path, mesh);
+	} else if (extension == "gltf" || extension == "glb") {
+		importGltf(path, mesh);
+	} else {
+		throw std::runtime_error("unsupported mesh format: " + path);
+	}
+
+	computeBounds(mesh);
+	buildMeshlets(mesh);
+}
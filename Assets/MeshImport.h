@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+#include "MeshData.h"
+
+/**
+ * @brief Reads a Wavefront OBJ file. Polygons are triangulated as fans, every object, group or
+ * material change starts a new submesh, and normals are computed when the file has none.
+ * Throws an error if the file can't be read.
+ */
+void importObj(const std::string& path, MeshData& mesh);
+
+/**
+ * @brief Reads the triangle primitives of a glTF 2.0 file, either .gltf with external or
+ * base64 buffers, or .glb. Node transforms are applied and every primitive becomes a submesh.
+ * Throws an error if the file can't be read or uses features that aren't supported,
+ * such as sparse accessors or quantized positions.
+ */
+void importGltf(const std::string& path, MeshData& mesh);
+
+/**
+ * @brief Picks the importer from the file extension, then computes the bounds and meshlets
+ */
+void importMesh(const std::string& path, MeshData& mesh);
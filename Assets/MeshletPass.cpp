@@ -0,0 +1,381 @@
+#include "MeshletPass.h"
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+#include "GpuProfiler.h"
+#include "Shader.h"
+#include "Frustum.h"
+
+namespace
+{
+	// Matches the push constants in Shaders/Meshlet.task and Shaders/Meshlet.mesh,
+	// Shaders/Meshlet.vert only reads modelViewProjection
+	struct MeshletConstants
+	{
+		float modelViewProjection[16];
+		// xyz is the camera position in object space
+		float cameraPosition[4];
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+	};
+
+	// Meshlets culled by one task shader workgroup
+	constexpr uint32_t TASK_WORKGROUP_SIZE = 32;
+
+	// Descriptor bindings of the mesh shader path, in binding order
+	constexpr MeshSection MESH_SECTIONS[] = {
+		MeshSection::VERTICES,
+		MeshSection::MESHLETS,
+		MeshSection::MESHLET_VERTICES,
+		MeshSection::MESHLET_TRIANGLES,
+		MeshSection::MESHLET_BOUNDS
+	};
+	constexpr uint32_t BINDING_COUNT = sizeof(MESH_SECTIONS) / sizeof(MESH_SECTIONS[0]);
+}
+
+MeshletPass::MeshletPass() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	meshShaders(false),
+	maxMeshes(0),
+	descriptorPool(nullptr),
+	setLayout(nullptr),
+	pipelineLayout(nullptr),
+	pipeline(nullptr),
+	stats{},
+	profiler(nullptr)
+{
+}
+
+void MeshletPass::init(LogicalDevice& device, VkRenderPass renderPass, uint32_t subpass, uint32_t _maxMeshes,
+	const std::string& fragmentShader, bool allowMeshShaders)
+{
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	maxMeshes = _maxMeshes;
+	meshes.reserve(maxMeshes);
+	stats = {};
+	meshShaders = allowMeshShaders && device.supportsMeshShaders() && dispatch->vkCmdDrawMeshTasksEXT != nullptr;
+
+	VkPushConstantRange pushConstants{};
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstants;
+	if (meshShaders) {
+		createDescriptorLayout();
+		pushConstants.stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+		pushConstants.size = sizeof(MeshletConstants);
+		layoutInfo.setLayoutCount = 1;
+		layoutInfo.pSetLayouts = &setLayout;
+	} else {
+		pushConstants.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstants.size = sizeof(MeshletConstants::modelViewProjection);
+	}
+	VkResult result = dispatch->vkCreatePipelineLayout(deviceHandle, &layoutInfo, allocator, &pipelineLayout); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, pipelineLayout, "MeshletPass");
+
+	createPipeline(device, renderPass, subpass, fragmentShader);
+}
+
+MeshletPass::~MeshletPass()
+{
+	cleanup();
+}
+
+void MeshletPass::cleanup()
+{
+	if (deviceHandle) {
+		dispatch->vkDestroyPipeline(deviceHandle, pipeline, allocator);
+		dispatch->vkDestroyPipelineLayout(deviceHandle, pipelineLayout, allocator);
+		// Destroying the pool frees its sets
+		dispatch->vkDestroyDescriptorPool(deviceHandle, descriptorPool, allocator);
+		dispatch->vkDestroyDescriptorSetLayout(deviceHandle, setLayout, allocator);
+		pipeline = nullptr;
+		pipelineLayout = nullptr;
+		descriptorPool = nullptr;
+		setLayout = nullptr;
+		meshShaders = false;
+		meshes.clear();
+		deviceHandle = nullptr;
+	}
+}
+
+uint32_t MeshletPass::addMesh(GpuMesh& mesh, const MeshFile& file)
+{
+	uint32_t meshletCount = 0;
+	uint32_t boundsCount = 0;
+	const Meshlet* meshlets = file.getMeshlets(meshletCount);
+	const MeshletBounds* bounds = file.getMeshletBounds(boundsCount);
+	if (meshletCount == 0 || boundsCount != meshletCount) {
+		throw std::runtime_error("mesh has no meshlets or meshlet bounds");
+	}
+	if (meshes.size() == maxMeshes) {
+		throw std::runtime_error("meshlet pass is full");
+	}
+
+	MeshEntry entry{};
+	entry.vertexBuffer = mesh.getBuffer(MeshSection::VERTICES);
+	entry.indexBuffer = mesh.getBuffer(MeshSection::INDICES);
+	entry.submeshes = mesh.getSubmeshes();
+	entry.bounds.assign(bounds, bounds + meshletCount);
+
+	// Each submesh's triangles are stored in the order of its meshlets
+	entry.firstIndices.resize(meshletCount);
+	entry.indexCounts.resize(meshletCount);
+	for (const Submesh& submesh : entry.submeshes) {
+		uint32_t firstIndex = submesh.firstIndex;
+		for (uint32_t i = submesh.firstMeshlet; i < submesh.firstMeshlet + submesh.meshletCount; i++) {
+			entry.firstIndices[i] = firstIndex;
+			entry.indexCounts[i] = meshlets[i].triangleCount * 3;
+			firstIndex += entry.indexCounts[i];
+		}
+	}
+
+	if (meshShaders) {
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = descriptorPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &setLayout;
+		VkResult result = dispatch->vkAllocateDescriptorSets(deviceHandle, &allocateInfo, &entry.set); VK_CHECK(result);
+
+		VkDescriptorBufferInfo bufferInfos[BINDING_COUNT]{};
+		VkWriteDescriptorSet writes[BINDING_COUNT]{};
+		for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+			bufferInfos[i] = {mesh.getBuffer(MESH_SECTIONS[i]), 0, VK_WHOLE_SIZE};
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = entry.set;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+		dispatch->vkUpdateDescriptorSets(deviceHandle, BINDING_COUNT, writes, 0, nullptr);
+	}
+
+	meshes.push_back(std::move(entry));
+	return static_cast<uint32_t>(meshes.size() - 1);
+}
+
+void MeshletPass::setProfiler(GpuProfiler* _profiler)
+{
+	profiler = _profiler;
+}
+
+void MeshletPass::recordDraw(VkCommandBuffer commandBuffer, const CullView& view, uint32_t mesh, const float model[16])
+{
+	CommandLabel label(*dispatch, commandBuffer, "Meshlets");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Meshlets");
+	const MeshEntry& entry = meshes[mesh];
+
+	Mat4 modelMatrix;
+	Mat4 viewProjection;
+	std::memcpy(&modelMatrix, model, sizeof(modelMatrix));
+	std::memcpy(&viewProjection, view.viewProjection, sizeof(viewProjection));
+	Mat4 modelViewProjection = viewProjection * modelMatrix;
+	// Culling runs in object space so the bounds don't need to be transformed
+	Vec3 camera = transformPoint(inverseAffine(modelMatrix),
+		{view.cameraPosition[0], view.cameraPosition[1], view.cameraPosition[2]});
+
+	MeshletConstants constants{};
+	std::memcpy(constants.modelViewProjection, &modelViewProjection, sizeof(constants.modelViewProjection));
+	constants.cameraPosition[0] = camera.x;
+	constants.cameraPosition[1] = camera.y;
+	constants.cameraPosition[2] = camera.z;
+
+	dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+	if (meshShaders) {
+		dispatch->vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &entry.set, 0, nullptr);
+		for (const Submesh& submesh : entry.submeshes) {
+			constants.firstMeshlet = submesh.firstMeshlet;
+			constants.meshletCount = submesh.meshletCount;
+			dispatch->vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT,
+				0, sizeof(MeshletConstants), &constants);
+			dispatch->vkCmdDrawMeshTasksEXT(commandBuffer, (submesh.meshletCount + TASK_WORKGROUP_SIZE - 1) / TASK_WORKGROUP_SIZE, 1, 1);
+			stats.meshletsTested += submesh.meshletCount;
+			stats.drawCalls++;
+		}
+		return;
+	}
+
+	dispatch->vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+		0, sizeof(constants.modelViewProjection), &constants);
+	VkDeviceSize offset = 0;
+	dispatch->vkCmdBindVertexBuffers(commandBuffer, 0, 1, &entry.vertexBuffer, &offset);
+	dispatch->vkCmdBindIndexBuffer(commandBuffer, entry.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	Frustum frustum = makeFrustum(modelViewProjection);
+	for (const Submesh& submesh : entry.submeshes) {
+		// Visible meshlets next to each other in the index buffer are drawn together
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		for (uint32_t i = submesh.firstMeshlet; i < submesh.firstMeshlet + submesh.meshletCount; i++) {
+			const MeshletBounds& bounds = entry.bounds[i];
+			Vec3 center{bounds.center[0], bounds.center[1], bounds.center[2]};
+			Vec3 apex{bounds.coneApex[0], bounds.coneApex[1], bounds.coneApex[2]};
+			Vec3 axis{bounds.coneAxis[0], bounds.coneAxis[1], bounds.coneAxis[2]};
+			bool visible = isSphereVisible(frustum, center, bounds.radius)
+				&& dot(normalize(apex - camera), axis) < bounds.coneCutoff;
+			if (visible) {
+				if (indexCount == 0) {
+					firstIndex = entry.firstIndices[i];
+				}
+				indexCount += entry.indexCounts[i];
+				stats.meshletsDrawn++;
+			} else if (indexCount > 0) {
+				dispatch->vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, 0, 0);
+				stats.drawCalls++;
+				indexCount = 0;
+			}
+		}
+		if (indexCount > 0) {
+			dispatch->vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, 0, 0);
+			stats.drawCalls++;
+		}
+		stats.meshletsTested += submesh.meshletCount;
+	}
+}
+
+bool MeshletPass::usesMeshShaders()
+{
+	return meshShaders;
+}
+
+MeshletStats MeshletPass::getStats()
+{
+	return stats;
+}
+
+void MeshletPass::resetStats()
+{
+	stats = {};
+}
+
+void MeshletPass::createDescriptorLayout()
+{
+	VkDescriptorSetLayoutBinding bindings[BINDING_COUNT]{};
+	for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = MESH_SECTIONS[i] == MeshSection::MESHLET_BOUNDS
+			? VK_SHADER_STAGE_TASK_BIT_EXT : VK_SHADER_STAGE_MESH_BIT_EXT;
+	}
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = BINDING_COUNT;
+	layoutInfo.pBindings = bindings;
+	VkResult result = dispatch->vkCreateDescriptorSetLayout(deviceHandle, &layoutInfo, allocator, &setLayout); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, setLayout, "MeshletPass meshes");
+
+	VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BINDING_COUNT * maxMeshes};
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = maxMeshes;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	result = dispatch->vkCreateDescriptorPool(deviceHandle, &poolInfo, allocator, &descriptorPool); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_DESCRIPTOR_POOL, descriptorPool, "MeshletPass meshes");
+}
+
+void MeshletPass::createPipeline(LogicalDevice& device, VkRenderPass renderPass, uint32_t subpass, const std::string& fragmentShader)
+{
+	Shader taskShader, meshShader, vertexShader, fragment;
+	std::vector<VkPipelineShaderStageCreateInfo> stages{};
+	auto addStage = [&](Shader& shader, const char* name, VkShaderStageFlagBits stage) {
+		shader.init(device, name);
+		VkPipelineShaderStageCreateInfo stageInfo{};
+		stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stageInfo.stage = stage;
+		stageInfo.module = shader.getHandle();
+		stageInfo.pName = "main";
+		stages.push_back(stageInfo);
+	};
+	if (meshShaders) {
+		addStage(taskShader, "Meshlet.task.spv", VK_SHADER_STAGE_TASK_BIT_EXT);
+		addStage(meshShader, "Meshlet.mesh.spv", VK_SHADER_STAGE_MESH_BIT_EXT);
+	} else {
+		addStage(vertexShader, "Meshlet.vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
+	}
+	addStage(fragment, fragmentShader.c_str(), VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	VkVertexInputBindingDescription vertexBinding{0, sizeof(MeshVertex), VK_VERTEX_INPUT_RATE_VERTEX};
+	VkVertexInputAttributeDescription attributes[] = {
+		{0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, position)},
+		{1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, normal)},
+		{2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(MeshVertex, uv)}
+	};
+	VkPipelineVertexInputStateCreateInfo vertexInput{};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInput.vertexBindingDescriptionCount = 1;
+	vertexInput.pVertexBindingDescriptions = &vertexBinding;
+	vertexInput.vertexAttributeDescriptionCount = 3;
+	vertexInput.pVertexAttributeDescriptions = attributes;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+	VkPipelineRasterizationStateCreateInfo rasterization{};
+	rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisample{};
+	multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+	VkPipelineColorBlendAttachmentState blendAttachment{};
+	blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
+		| VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	VkPipelineColorBlendStateCreateInfo colorBlend{};
+	colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlend.attachmentCount = 1;
+	colorBlend.pAttachments = &blendAttachment;
+
+	VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
+
+	VkGraphicsPipelineCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	createInfo.stageCount = static_cast<uint32_t>(stages.size());
+	createInfo.pStages = stages.data();
+	// Mesh shader pipelines have no vertex input or input assembly
+	createInfo.pVertexInputState = meshShaders ? nullptr : &vertexInput;
+	createInfo.pInputAssemblyState = meshShaders ? nullptr : &inputAssembly;
+	createInfo.pViewportState = &viewportState;
+	createInfo.pRasterizationState = &rasterization;
+	createInfo.pMultisampleState = &multisample;
+	createInfo.pDepthStencilState = &depthStencil;
+	createInfo.pColorBlendState = &colorBlend;
+	createInfo.pDynamicState = &dynamicState;
+	createInfo.layout = pipelineLayout;
+	createInfo.renderPass = renderPass;
+	createInfo.subpass = subpass;
+	VkResult result = dispatch->vkCreateGraphicsPipelines(deviceHandle, nullptr, 1, &createInfo, allocator, &pipeline); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_PIPELINE, pipeline, meshShaders ? "Meshlets (mesh shaders)" : "Meshlets (vertex shader)");
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "IndirectDrawPass.h"
+#include "GpuMesh.h"
+#include "MeshFile.h"
+
+class GpuProfiler;
+
+struct MeshletStats
+{
+	// Meshlets of every recorded submesh
+	uint64_t meshletsTested;
+	// Meshlets left after culling. With mesh shaders culling happens on the GPU, so this stays 0.
+	uint64_t meshletsDrawn;
+	uint32_t drawCalls;
+};
+
+// Draws meshes one meshlet at a time so clusters outside the frustum or facing away from the camera are skipped.
+// With VK_EXT_mesh_shader a task shader culls the meshlets and a mesh shader emits the visible ones,
+// otherwise the meshlets are culled on the CPU and the visible ones are drawn as ranges of the index buffer.
+// Cone culling assumes the model matrix has a uniform scale.
+class MeshletPass
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create any resources, must call init
+	 */
+	MeshletPass();
+
+	/**
+	 * @brief Creates the graphics pipeline and the descriptor pool.
+	 *
+	 * @param device - the logical device to create the resources under
+	 * @param renderPass - render pass the pipeline is used in, with a depth attachment and one sample
+	 * @param subpass - index of the subpass inside renderPass
+	 * @param maxMeshes - most meshes that can be added
+	 * @param fragmentShader - file name of the fragment shader, which reads the object space normal at
+	 * location 0 and the uv at location 1
+	 * @param allowMeshShaders - false always uses the indexed draw path
+	 */
+	void init(LogicalDevice& device, VkRenderPass renderPass, uint32_t subpass, uint32_t maxMeshes,
+		const std::string& fragmentShader = "Meshlet.frag.spv", bool allowMeshShaders = true);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~MeshletPass();
+
+	/**
+	 * @brief Destroys all resources. The device must not be using them anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Registers a mesh for drawing. Throws an error if the file has no meshlets or maxMeshes were added.
+	 *
+	 * @param mesh - the uploaded mesh, must outlive the pass
+	 * @param file - the file mesh was uploaded from, only read during the call
+	 *
+	 * @return index of the mesh in recordDraw
+	 */
+	uint32_t addMesh(GpuMesh& mesh, const MeshFile& file);
+
+	/**
+	 * @brief Times every recordDraw as a GPU zone, does nothing without APPARATUS_TRACY
+	 *
+	 * @param _profiler - initialized profiler of the queue the draws are submitted to, nullptr to stop
+	 */
+	void setProfiler(GpuProfiler* _profiler);
+
+	/**
+	 * @brief Binds the pipeline and records the draws of every submesh of a mesh.
+	 *
+	 * @param commandBuffer - command buffer inside the render pass given to init,
+	 * with the viewport and scissor already set
+	 * @param view - camera used for culling, lodScale is ignored
+	 * @param mesh - index returned by addMesh
+	 * @param model - column major object to world matrix
+	 */
+	void recordDraw(VkCommandBuffer commandBuffer, const CullView& view, uint32_t mesh, const float model[16]);
+
+	/**
+	 * @brief Returns whether draws go through the task and mesh shaders
+	 */
+	bool usesMeshShaders();
+
+	/**
+	 * @brief Returns the counts since the last resetStats
+	 */
+	MeshletStats getStats();
+	void resetStats();
+
+private:
+	struct MeshEntry
+	{
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		VkDescriptorSet set;
+		std::vector<Submesh> submeshes;
+		std::vector<MeshletBounds> bounds;
+		// Range of each meshlet's triangles in the index buffer, which is in meshlet order
+		std::vector<uint32_t> firstIndices;
+		std::vector<uint32_t> indexCounts;
+	};
+
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	bool meshShaders;
+	uint32_t maxMeshes;
+
+	VkDescriptorPool descriptorPool;
+	VkDescriptorSetLayout setLayout;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+
+	std::vector<MeshEntry> meshes;
+	MeshletStats stats;
+	GpuProfiler* profiler;
+
+	void createDescriptorLayout();
+	void createPipeline(LogicalDevice& device, VkRenderPass renderPass, uint32_t subpass, const std::string& fragmentShader);
+};
@@ -0,0 +1,168 @@
+#include "MeshImport.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	// Position, uv and normal index of a face corner, 0 when the corner has none
+	struct Corner
+	{
+		int position;
+		int uv;
+		int normal;
+
+		bool operator==(const Corner& other) const
+		{
+			return position == other.position && uv == other.uv && normal == other.normal;
+		}
+	};
+
+	struct CornerHash
+	{
+		size_t operator()(const Corner& corner) const
+		{
+			size_t hash = static_cast<size_t>(corner.position) * 73856093u;
+			hash ^= static_cast<size_t>(corner.uv) * 19349663u;
+			hash ^= static_cast<size_t>(corner.normal) * 83492791u;
+			return hash;
+		}
+	};
+
+	const char* skipSpaces(const char* text)
+	{
+		while (*text == ' ' || *text == '\t') {
+			text++;
+		}
+		return text;
+	}
+
+	// Resolves a 1 based or negative relative OBJ index to a 1 based index, 0 if there is none
+	int resolveIndex(long index, size_t count)
+	{
+		if (index < 0) {
+			return static_cast<int>(static_cast<long>(count) + index + 1);
+		}
+		return static_cast<int>(index);
+	}
+}
+
+void importObj(const std::string& path, MeshData& mesh)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open mesh: " + path);
+	}
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	std::string text = buffer.str();
+
+	mesh = {};
+	std::vector<float> positions, uvs, normals;
+	std::unordered_map<Corner, uint32_t, CornerHash> vertexIndices{};
+	std::vector<uint32_t> polygon{};
+	bool hasNormals = false;
+	Submesh submesh{};
+
+	auto finishSubmesh = [&]() {
+		submesh.indexCount = static_cast<uint32_t>(mesh.indices.size()) - submesh.firstIndex;
+		if (submesh.indexCount > 0) {
+			mesh.submeshes.push_back(submesh);
+		}
+		submesh = {};
+		submesh.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+	};
+
+	const char* line = text.c_str();
+	while (*line) {
+		const char* end = std::strchr(line, '\n');
+		if (!end) {
+			end = line + std::strlen(line);
+		}
+		line = skipSpaces(line);
+
+		char* next = nullptr;
+		if (line[0] == 'v' && line[1] == ' ') {
+			const char* value = line + 2;
+			for (int i = 0; i < 3; i++) {
+				positions.push_back(std::strtof(value, &next));
+				value = next;
+			}
+		} else if (line[0] == 'v' && line[1] == 't' && line[2] == ' ') {
+			const char* value = line + 3;
+			for (int i = 0; i < 2; i++) {
+				uvs.push_back(std::strtof(value, &next));
+				value = next;
+			}
+		} else if (line[0] == 'v' && line[1] == 'n' && line[2] == ' ') {
+			const char* value = line + 3;
+			for (int i = 0; i < 3; i++) {
+				normals.push_back(std::strtof(value, &next));
+				value = next;
+			}
+		} else if (line[0] == 'f' && line[1] == ' ') {
+			polygon.clear();
+			const char* value = skipSpaces(line + 2);
+			while (value < end && *value != '\r' && *value != '\n' && *value != '\0') {
+				Corner corner{};
+				corner.position = resolveIndex(std::strtol(value, &next, 10), positions.size() / 3);
+				value = next;
+				if (*value == '/') {
+					value++;
+					if (*value != '/') {
+						corner.uv = resolveIndex(std::strtol(value, &next, 10), uvs.size() / 2);
+						value = next;
+					}
+					if (*value == '/') {
+						corner.normal = resolveIndex(std::strtol(value + 1, &next, 10), normals.size() / 3);
+						value = next;
+					}
+				}
+				if (corner.position <= 0 || static_cast<size_t>(corner.position) > positions.size() / 3) {
+					throw std::runtime_error("invalid face in mesh: " + path);
+				}
+
+				// Identical corners share a vertex
+				auto [it, inserted] = vertexIndices.emplace(corner, static_cast<uint32_t>(mesh.vertices.size()));
+				if (inserted) {
+					MeshVertex vertex{};
+					std::memcpy(vertex.position, &positions[(corner.position - 1) * 3], sizeof(vertex.position));
+					if (corner.uv > 0 && static_cast<size_t>(corner.uv) <= uvs.size() / 2) {
+						// OBJ puts v = 0 at the bottom, vulkan samples v = 0 at the top
+						vertex.uv[0] = uvs[(corner.uv - 1) * 2];
+						vertex.uv[1] = 1.0f - uvs[(corner.uv - 1) * 2 + 1];
+					}
+					if (corner.normal > 0 && static_cast<size_t>(corner.normal) <= normals.size() / 3) {
+						std::memcpy(vertex.normal, &normals[(corner.normal - 1) * 3], sizeof(vertex.normal));
+						hasNormals = true;
+					}
+					mesh.vertices.push_back(vertex);
+				}
+				polygon.push_back(it->second);
+				value = skipSpaces(value);
+			}
+
+			for (size_t i = 2; i < polygon.size(); i++) {
+				mesh.indices.push_back(polygon[0]);
+				mesh.indices.push_back(polygon[i - 1]);
+				mesh.indices.push_back(polygon[i]);
+			}
+		} else if ((line[0] == 'o' || line[0] == 'g') && (line[1] == ' ' || line[1] == '\r' || line[1] == '\n')) {
+			finishSubmesh();
+		} else if (std::strncmp(line, "usemtl", 6) == 0) {
+			finishSubmesh();
+		}
+
+		line = *end ? end + 1 : end;
+	}
+	finishSubmesh();
+
+	if (!hasNormals) {
+		computeNormals(mesh, 0, static_cast<uint32_t>(mesh.indices.size()));
+	}
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "MeshFile.h"
+#include "MeshImport.h"
+
+namespace
+{
+	void printUsage()
+	{
+		std::cout << "usage: MeshConverter <input.obj|input.gltf|input.glb> <output.amesh>\n"
+			<< "       MeshConverter --benchmark <input.obj|input.gltf|input.glb> <output.amesh> [iterations]\n";
+	}
+
+	double getSeconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Compares importing the source file against mapping the converted file and reading every byte,
+	// which is what an upload does. Both run with the files in the OS cache after the first iteration.
+	void benchmark(const std::string& input, const std::string& output, int iterations)
+	{
+		double importSeconds = 0.0;
+		for (int i = 0; i < iterations; i++) {
+			MeshData mesh;
+			auto start = std::chrono::steady_clock::now();
+			importMesh(input, mesh);
+			importSeconds += getSeconds(start);
+		}
+
+		double mapSeconds = 0.0;
+		size_t bytes = 0;
+		uint64_t checksum = 0;
+		for (int i = 0; i < iterations; i++) {
+			auto start = std::chrono::steady_clock::now();
+			MeshFile file;
+			file.init(output);
+			for (uint32_t section = 0; section < static_cast<uint32_t>(MeshSection::COUNT); section++) {
+				uint64_t size = 0;
+				const std::byte* data = file.getSection(static_cast<MeshSection>(section), size);
+				for (uint64_t offset = 0; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+					uint64_t value;
+					std::memcpy(&value, data + offset, sizeof(value));
+					checksum += value;
+				}
+			}
+			bytes = file.getHeader().fileSize;
+			mapSeconds += getSeconds(start);
+		}
+
+		std::cout << "import " << input << ": " << importSeconds / iterations * 1000.0 << " ms\n"
+			<< "map " << output << ": " << mapSeconds / iterations * 1000.0 << " ms ("
+			<< bytes / (mapSeconds / iterations) / (1024.0 * 1024.0) << " MiB/s, checksum " << checksum << ")\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool runBenchmark = argc > 1 && std::strcmp(argv[1], "--benchmark") == 0;
+	int first = runBenchmark ? 2 : 1;
+	if (argc < first + 2) {
+		printUsage();
+		return 1;
+	}
+	std::string input = argv[first];
+	std::string output = argv[first + 1];
+
+	try {
+		MeshData mesh;
+		importMesh(input, mesh);
+		MeshFile::write(output, mesh);
+		std::cout << output << ": " << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles, "
+			<< mesh.submeshes.size() << " submeshes, " << mesh.meshlets.size() << " meshlets\n";
+
+		if (runBenchmark) {
+			int iterations = argc > first + 2 ? std::atoi(argv[first + 2]) : 10;
+			benchmark(input, output, iterations > 0 ? iterations : 1);
+		}
+	} catch (std::exception& e) {
+		std::cout << e.what() << '\n';
+		return 1;
+	}
+
+	return 0;
+}
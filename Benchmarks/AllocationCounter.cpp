@@ -0,0 +1,68 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions of the whole program. The array and nothrow forms
+// forward to these by default, so every allocation through new is counted.
+
+namespace
+{
+	std::atomic<uint64_t> heapAllocations{0};
+
+	void* allocate(size_t size, size_t alignment)
+	{
+		heapAllocations.fetch_add(1, std::memory_order_relaxed);
+		if (size == 0) {
+			size = 1;
+		}
+		void* memory = nullptr;
+		if (alignment <= alignof(std::max_align_t)) {
+			memory = std::malloc(size);
+		} else {
+			// aligned_alloc requires the size to be a multiple of the alignment
+			memory = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+		}
+		if (memory == nullptr) {
+			throw std::bad_alloc();
+		}
+		return memory;
+	}
+}
+
+uint64_t getHeapAllocationCount()
+{
+	return heapAllocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	std::free(memory);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Returns the number of calls to the global operator new since the program started, from any thread.
+ * Benchmarks report the difference over their loop to show how many heap allocations an iteration makes.
+ */
+uint64_t getHeapAllocationCount();
@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "MeshFile.h"
+#include "MeshImport.h"
+
+namespace
+{
+	// Quads per side of the generated grid, 256 gives 66049 vertices and 131072 triangles
+	constexpr int GRID_SIZE = 256;
+
+	// Generates an OBJ grid and its converted .amesh in the temp directory the first time it's needed,
+	// so the benchmark doesn't depend on asset files
+	const std::filesystem::path& getGridPath()
+	{
+		static std::filesystem::path path;
+		if (path.empty()) {
+			path = std::filesystem::temp_directory_path() / "apparatus_benchmark_grid.obj";
+			std::ofstream file(path);
+			for (int y = 0; y <= GRID_SIZE; y++) {
+				for (int x = 0; x <= GRID_SIZE; x++) {
+					file << "v " << x << ' ' << ((x * 7 + y * 3) % 5) * 0.1f << ' ' << y << '\n'
+						<< "vt " << static_cast<float>(x) / GRID_SIZE << ' ' << static_cast<float>(y) / GRID_SIZE << '\n';
+				}
+			}
+			for (int y = 0; y < GRID_SIZE; y++) {
+				for (int x = 0; x < GRID_SIZE; x++) {
+					int corner = y * (GRID_SIZE + 1) + x + 1;
+					int below = corner + GRID_SIZE + 1;
+					file << "f " << corner << '/' << corner << ' ' << below << '/' << below << ' ' << corner + 1 << '/' << corner + 1 << '\n'
+						<< "f " << corner + 1 << '/' << corner + 1 << ' ' << below << '/' << below << ' ' << below + 1 << '/' << below + 1 << '\n';
+				}
+			}
+			file.close();
+
+			MeshData mesh;
+			importMesh(path.string(), mesh);
+			MeshFile::write(std::filesystem::path(path).replace_extension(".amesh").string(), mesh);
+		}
+		return path;
+	}
+
+	// Parsing the text file, including the normals and meshlets the converter would compute offline
+	void BM_ImportObj(benchmark::State& state)
+	{
+		std::string path = getGridPath().string();
+		int64_t bytes = static_cast<int64_t>(std::filesystem::file_size(path));
+		for (auto _ : state) {
+			MeshData mesh;
+			importMesh(path, mesh);
+			benchmark::DoNotOptimize(mesh.vertices.data());
+		}
+		state.SetBytesProcessed(state.iterations() * bytes);
+	}
+	BENCHMARK(BM_ImportObj)->Unit(benchmark::kMillisecond);
+
+	// Mapping the converted file and reading every section, which is what an upload does.
+	// The file is in the OS cache after the first iteration, like the OBJ.
+	void BM_MapMeshFile(benchmark::State& state)
+	{
+		std::string path = std::filesystem::path(getGridPath()).replace_extension(".amesh").string();
+		int64_t bytes = 0;
+		for (auto _ : state) {
+			MeshFile file;
+			file.init(path);
+			uint64_t checksum = 0;
+			for (uint32_t section = 0; section < static_cast<uint32_t>(MeshSection::COUNT); section++) {
+				uint64_t size = 0;
+				const std::byte* data = file.getSection(static_cast<MeshSection>(section), size);
+				for (uint64_t offset = 0; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+					uint64_t value;
+					std::memcpy(&value, data + offset, sizeof(value));
+					checksum += value;
+				}
+			}
+			benchmark::DoNotOptimize(checksum);
+			bytes = static_cast<int64_t>(file.getHeader().fileSize);
+		}
+		state.SetBytesProcessed(state.iterations() * bytes);
+	}
+	BENCHMARK(BM_MapMeshFile)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,32 @@
+#include <benchmark/benchmark.h>
+
+#include "MathBatch.h"
+
+#ifdef APPARATUS_BENCHMARK_VULKAN
+#include "HeadlessDevice.h"
+#endif
+
+// Scenarios of every module, run with --benchmark_out=<file> --benchmark_out_format=json and
+// compared against an earlier run with compare.py. Vulkan scenarios are skipped without a driver.
+// CpuBenchmarks builds this without APPARATUS_BENCHMARK_VULKAN and only has the Core and Math scenarios.
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+
+	// Stored in the JSON context so runs on different devices or instruction sets aren't compared by mistake
+#ifdef APPARATUS_BENCHMARK_VULKAN
+	HeadlessDevice* device = HeadlessDevice::getShared();
+	benchmark::AddCustomContext("vulkan_device", device != nullptr ? device->getDeviceName() : "none");
+#endif
+	benchmark::AddCustomContext("simd_level", getSimdLevelName(getSimdLevel()));
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+#ifdef APPARATUS_BENCHMARK_VULKAN
+	HeadlessDevice::destroyShared();
+#endif
+	return 0;
+}
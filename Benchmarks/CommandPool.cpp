@@ -0,0 +1,38 @@
+#include "CommandPool.h"
+
+#include "DebugMessenger.h"
+
+CommandPool::CommandPool(LogicalDevice& device, uint32_t queueFamily)
+	: deviceHandle(device.getHandle()), allocator(device.getAllocator()), dispatch(&device.getDispatch()), handle(nullptr)
+{
+	VkCommandPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	createInfo.queueFamilyIndex = queueFamily;
+	VK_CHECK(dispatch->vkCreateCommandPool(deviceHandle, &createInfo, allocator, &handle));
+}
+
+CommandPool::~CommandPool()
+{
+	dispatch->vkDestroyCommandPool(deviceHandle, handle, allocator);
+}
+
+std::vector<VkCommandBuffer> CommandPool::allocate(uint32_t count)
+{
+	std::vector<VkCommandBuffer> commandBuffers(count);
+	VkCommandBufferAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = handle;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = count;
+	VK_CHECK(dispatch->vkAllocateCommandBuffers(deviceHandle, &allocateInfo, commandBuffers.data()));
+	return commandBuffers;
+}
+
+void beginCommandBuffer(const DeviceDispatch& dispatch, VkCommandBuffer commandBuffer)
+{
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VK_CHECK(dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "LogicalDevice.h"
+
+// Command buffers of one queue family that are re-recorded every iteration
+class CommandPool
+{
+public:
+	CommandPool(LogicalDevice& device, uint32_t queueFamily);
+	~CommandPool();
+
+	CommandPool(const CommandPool&) = delete;
+	CommandPool& operator=(const CommandPool&) = delete;
+
+	std::vector<VkCommandBuffer> allocate(uint32_t count);
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkCommandPool handle;
+};
+
+/**
+ * @brief Begins a command buffer that is submitted once before it's recorded again
+ */
+void beginCommandBuffer(const DeviceDispatch& dispatch, VkCommandBuffer commandBuffer);
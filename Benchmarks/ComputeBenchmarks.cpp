@@ -0,0 +1,151 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "HeadlessDevice.h"
+#include "CommandPool.h"
+#include "Buffer.h"
+#include "DebugMessenger.h"
+#include "ParallelPrimitives.h"
+
+namespace
+{
+	enum class Primitive
+	{
+		Scan,
+		Reduce,
+		RadixSort
+	};
+
+	// One primitive over state.range(0) random elements on the compute queue, waiting for every submission.
+	// The sort copies its unsorted input back first, which is included in the time.
+	// The result of the last iteration is checked against the standard library, a mismatch fails the benchmark.
+	void runPrimitive(benchmark::State& state, Primitive primitive)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		SubmissionScheduler& scheduler = shared->getScheduler();
+		const DeviceDispatch& dispatch = device.getDispatch();
+		uint32_t count = static_cast<uint32_t>(state.range(0));
+		VkDeviceSize size = sizeof(uint32_t) * count;
+
+		// Small elements for the scan and the sum so the comparison isn't about wrapping
+		std::mt19937 random(7);
+		std::vector<uint32_t> input(count);
+		std::vector<uint32_t> values(count);
+		for (uint32_t i = 0; i < count; i++) {
+			input[i] = primitive == Primitive::RadixSort ? static_cast<uint32_t>(random()) : static_cast<uint32_t>(random() % 1024);
+			values[i] = i;
+		}
+
+		ParallelPrimitives primitives;
+		primitives.init(device, count);
+
+		VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		VkMemoryPropertyFlags hostMemory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		Buffer source;
+		source.init(device, size, usage, hostMemory);
+		std::memcpy(source.getMapped(), input.data(), size);
+		Buffer valueSource;
+		valueSource.init(device, size, usage, hostMemory);
+		std::memcpy(valueSource.getMapped(), values.data(), size);
+		Buffer keys;
+		keys.init(device, size, usage, hostMemory);
+		Buffer sortedValues;
+		sortedValues.init(device, size, usage, hostMemory);
+
+		VkMemoryBarrier copyBarrier{};
+		copyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		copyBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		copyBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		VkMemoryBarrier hostBarrier{};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		CommandPool pool(device, device.getComputeFamilyIndex());
+		VkCommandBuffer commandBuffer = pool.allocate(1)[0];
+		VkQueue queue = device.getComputeQueue();
+		for (auto _ : state) {
+			beginCommandBuffer(dispatch, commandBuffer);
+			switch (primitive) {
+			case Primitive::Scan:
+				primitives.recordExclusiveScan(commandBuffer, source.getHandle(), keys.getHandle(), count);
+				break;
+			case Primitive::Reduce:
+				primitives.recordReduce(commandBuffer, source.getHandle(), keys.getHandle(), count);
+				break;
+			case Primitive::RadixSort: {
+				VkBufferCopy region{0, 0, size};
+				dispatch.vkCmdCopyBuffer(commandBuffer, source.getHandle(), keys.getHandle(), 1, &region);
+				dispatch.vkCmdCopyBuffer(commandBuffer, valueSource.getHandle(), sortedValues.getHandle(), 1, &region);
+				dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					0, 1, &copyBarrier, 0, nullptr, 0, nullptr);
+				primitives.recordRadixSort(commandBuffer, keys.getHandle(), sortedValues.getHandle(), count);
+				break;
+			}
+			}
+			dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+				0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+
+			SubmitBatch batch;
+			batch.commandBuffers = {commandBuffer};
+			scheduler.wait(queue, scheduler.enqueue(queue, std::move(batch)));
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+		state.counters["subgroups"] = primitives.usesSubgroups() ? 1 : 0;
+
+		const uint32_t* result = static_cast<const uint32_t*>(keys.getMapped());
+		bool matches = true;
+		switch (primitive) {
+		case Primitive::Scan: {
+			std::vector<uint32_t> expected(count);
+			std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+			matches = std::equal(expected.begin(), expected.end(), result);
+			break;
+		}
+		case Primitive::Reduce:
+			matches = result[0] == std::accumulate(input.begin(), input.end(), 0u);
+			break;
+		case Primitive::RadixSort: {
+			// values holds the original index of every key, so a stable sort of them by key is the expected order
+			std::stable_sort(values.begin(), values.end(), [&input](uint32_t a, uint32_t b) { return input[a] < input[b]; });
+			const uint32_t* resultValues = static_cast<const uint32_t*>(sortedValues.getMapped());
+			for (uint32_t i = 0; i < count && matches; i++) {
+				matches = result[i] == input[values[i]] && resultValues[i] == values[i];
+			}
+			break;
+		}
+		}
+		if (!matches) {
+			state.SkipWithError("GPU result differs from the CPU reference");
+		}
+	}
+
+	void BM_Scan(benchmark::State& state)
+	{
+		runPrimitive(state, Primitive::Scan);
+	}
+	BENCHMARK(BM_Scan)->Arg(1000)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+
+	void BM_Reduce(benchmark::State& state)
+	{
+		runPrimitive(state, Primitive::Reduce);
+	}
+	BENCHMARK(BM_Reduce)->Arg(1000)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+
+	void BM_RadixSort(benchmark::State& state)
+	{
+		runPrimitive(state, Primitive::RadixSort);
+	}
+	BENCHMARK(BM_RadixSort)->Arg(1000)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+}
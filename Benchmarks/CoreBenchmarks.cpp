@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "FrameArena.h"
+
+namespace
+{
+	// Transient lists a frame builds, such as visible objects per view, grown one element at a time
+	constexpr int LIST_COUNT = 16;
+
+	template<typename List, typename... Args>
+	uint64_t buildLists(int64_t length, Args&&... args)
+	{
+		uint64_t sum = 0;
+		for (int list = 0; list < LIST_COUNT; list++) {
+			List values(args...);
+			for (int64_t i = 0; i < length; i++) {
+				values.push_back(static_cast<uint32_t>(i * list));
+			}
+			sum += values.back();
+		}
+		return sum;
+	}
+
+	void setAllocationCounter(benchmark::State& state, uint64_t startCount)
+	{
+		state.counters["heapAllocations"] = benchmark::Counter(static_cast<double>(getHeapAllocationCount() - startCount),
+			benchmark::Counter::kAvgIterations);
+	}
+
+	// The argument of every list benchmark is the length of each list
+	void BM_FrameListsHeap(benchmark::State& state)
+	{
+		uint64_t startCount = getHeapAllocationCount();
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(buildLists<std::vector<uint32_t>>(state.range(0)));
+		}
+		setAllocationCounter(state, startCount);
+	}
+	BENCHMARK(BM_FrameListsHeap)->Arg(64)->Arg(1024)->Arg(16384);
+
+	void BM_FrameListsFrameArena(benchmark::State& state)
+	{
+		FrameArena frameArena;
+		frameArena.init(64 * 1024);
+		uint64_t startCount = getHeapAllocationCount();
+		for (auto _ : state) {
+			frameArena.beginFrame();
+			benchmark::DoNotOptimize(buildLists<std::pmr::vector<uint32_t>>(state.range(0), frameArena.getResource()));
+		}
+		setAllocationCounter(state, startCount);
+	}
+	BENCHMARK(BM_FrameListsFrameArena)->Arg(64)->Arg(1024)->Arg(16384);
+
+	void BM_FrameListsScratch(benchmark::State& state)
+	{
+		uint64_t startCount = getHeapAllocationCount();
+		for (auto _ : state) {
+			ScratchScope scratch;
+			benchmark::DoNotOptimize(buildLists<std::pmr::vector<uint32_t>>(state.range(0), scratch.getResource()));
+		}
+		setAllocationCounter(state, startCount);
+	}
+	BENCHMARK(BM_FrameListsScratch)->Arg(64)->Arg(1024)->Arg(16384);
+}
@@ -0,0 +1,743 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "HeadlessDevice.h"
+#include "SkipUnavailable.h"
+#include "CommandPool.h"
+#include "Buffer.h"
+#include "DebugMessenger.h"
+#include "DepthPyramid.h"
+#include "DynamicResolution.h"
+#include "GpuDiagnostics.h"
+#include "IndirectDrawPass.h"
+#include "PresentBatch.h"
+#include "RenderTargets.h"
+#include "Shader.h"
+#include "Swapchain.h"
+
+namespace
+{
+	VkSemaphore createSemaphore(LogicalDevice& device)
+	{
+		VkSemaphoreCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		VkSemaphore semaphore;
+		VK_CHECK(device.getDispatch().vkCreateSemaphore(device.getHandle(), &createInfo, device.getAllocator(), &semaphore));
+		return semaphore;
+	}
+
+	// Creating and destroying a logical device on the shared physical device, which is what startup pays
+	// on top of the instance. Pipelines and other resources aren't included.
+	void BM_DeviceInit(benchmark::State& state)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		VkPhysicalDevice physicalDevice = shared->getDevice().getPhysicalDevice();
+		for (auto _ : state) {
+			LogicalDevice device;
+			device.init(physicalDevice, shared->getSurface(), shared->getInstance().getAllocator());
+			device.cleanup();
+		}
+	}
+	BENCHMARK(BM_DeviceInit)->Unit(benchmark::kMillisecond);
+
+	// A frame loop without rendering: acquire, an empty submit that waits on the image and signals
+	// the present, then present. Measures the swapchain and scheduler overhead every frame pays.
+	void BM_SwapchainAcquirePresent(benchmark::State& state)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		SubmissionScheduler& scheduler = shared->getScheduler();
+		Swapchain swapchain;
+		swapchain.init(device, shared->getSurface(), VkExtent2D{1280, 720});
+		PresentBatch presentBatch;
+		presentBatch.init(device, scheduler);
+
+		// One acquire semaphore more than images since the image is only known after acquiring.
+		// A semaphore is reused once the frame that waited on it finished.
+		size_t imageCount = swapchain.getImages().size();
+		std::vector<VkSemaphore> acquired(imageCount + 1);
+		std::vector<uint64_t> acquiredSerials(imageCount + 1, 0);
+		std::vector<VkSemaphore> rendered(imageCount);
+		for (VkSemaphore& semaphore : acquired) {
+			semaphore = createSemaphore(device);
+		}
+		for (VkSemaphore& semaphore : rendered) {
+			semaphore = createSemaphore(device);
+		}
+
+		VkQueue queue = device.getGraphicsQueue();
+		size_t frame = 0;
+		for (auto _ : state) {
+			size_t slot = frame % acquired.size();
+			scheduler.wait(queue, acquiredSerials[slot]);
+
+			uint32_t imageIndex = 0;
+			VkResult result = swapchain.acquireNextImage(acquired[slot], imageIndex);
+			if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+				state.SkipWithError("failed to acquire a swapchain image");
+				break;
+			}
+
+			SubmitBatch batch;
+			batch.waitSemaphores = {acquired[slot]};
+			batch.waitStages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+			batch.signalSemaphores = {rendered[imageIndex]};
+			acquiredSerials[slot] = scheduler.enqueue(queue, std::move(batch));
+
+			presentBatch.add(swapchain, imageIndex, rendered[imageIndex]);
+			presentBatch.present();
+			frame++;
+		}
+		state.SetItemsProcessed(static_cast<int64_t>(frame));
+
+		device.getDispatch().vkDeviceWaitIdle(device.getHandle());
+		for (VkSemaphore semaphore : acquired) {
+			device.getDispatch().vkDestroySemaphore(device.getHandle(), semaphore, device.getAllocator());
+		}
+		for (VkSemaphore semaphore : rendered) {
+			device.getDispatch().vkDestroySemaphore(device.getHandle(), semaphore, device.getAllocator());
+		}
+		swapchain.cleanup();
+	}
+	BENCHMARK(BM_SwapchainAcquirePresent)->Unit(benchmark::kMicrosecond);
+
+	// Writing into a persistently mapped staging buffer and copying it to a device local buffer on
+	// the transfer queue, waiting for every copy. The argument is the bytes per upload.
+	void BM_UploadThroughput(benchmark::State& state)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		SubmissionScheduler& scheduler = shared->getScheduler();
+		const DeviceDispatch& dispatch = device.getDispatch();
+		VkDeviceSize size = static_cast<VkDeviceSize>(state.range(0));
+
+		Buffer staging;
+		staging.init(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		Buffer destination;
+		destination.init(device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		std::vector<std::byte> source(size, std::byte{0x5a});
+
+		CommandPool pool(device, device.getTransferFamilyIndex());
+		VkCommandBuffer commandBuffer = pool.allocate(1)[0];
+		VkQueue queue = device.getTransferQueue();
+		for (auto _ : state) {
+			std::memcpy(staging.getMapped(), source.data(), source.size());
+
+			beginCommandBuffer(dispatch, commandBuffer);
+			VkBufferCopy region{0, 0, size};
+			dispatch.vkCmdCopyBuffer(commandBuffer, staging.getHandle(), destination.getHandle(), 1, &region);
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+
+			SubmitBatch batch;
+			batch.commandBuffers = {commandBuffer};
+			scheduler.wait(queue, scheduler.enqueue(queue, std::move(batch)));
+		}
+		state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * size));
+	}
+	BENCHMARK(BM_UploadThroughput)->Arg(64 << 10)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMicrosecond);
+
+	// CPU cost of recording: fills with a barrier after every 16 of them, nothing is submitted.
+	// The argument is the number of fills per command buffer.
+	void BM_CommandRecording(benchmark::State& state)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		const DeviceDispatch& dispatch = device.getDispatch();
+		constexpr VkDeviceSize REGION_SIZE = 4096;
+		constexpr uint32_t REGION_COUNT = 16;
+
+		Buffer buffer;
+		buffer.init(device, REGION_SIZE * REGION_COUNT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		CommandPool pool(device, device.getGraphicsFamilyIndex());
+		VkCommandBuffer commandBuffer = pool.allocate(1)[0];
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		int64_t commands = state.range(0);
+		for (auto _ : state) {
+			beginCommandBuffer(dispatch, commandBuffer);
+			for (int64_t i = 0; i < commands; i++) {
+				uint32_t region = static_cast<uint32_t>(i) % REGION_COUNT;
+				dispatch.vkCmdFillBuffer(commandBuffer, buffer.getHandle(), region * REGION_SIZE, REGION_SIZE, static_cast<uint32_t>(i));
+				if (region == REGION_COUNT - 1) {
+					dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+						0, 1, &barrier, 0, nullptr, 0, nullptr);
+				}
+			}
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+		}
+		state.SetItemsProcessed(state.iterations() * commands);
+	}
+	BENCHMARK(BM_CommandRecording)->Arg(256)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+	// A frame of 16 independent transfer passes, each filling its own 1 MiB, submitted and waited for. Argument 0
+	// records no breadcrumbs, 1 marks every pass, with buffer markers when the device has VK_AMD_buffer_marker
+	// and fills otherwise. Without markers the fills make the passes run one after another, the difference is
+	// what that costs per frame. The counter is 1 when buffer markers were used.
+	void BM_Breadcrumbs(benchmark::State& state)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		SubmissionScheduler& scheduler = shared->getScheduler();
+		const DeviceDispatch& dispatch = device.getDispatch();
+		constexpr VkDeviceSize PASS_SIZE = 1 << 20;
+		constexpr uint32_t PASS_COUNT = 16;
+		bool marked = state.range(0) != 0;
+
+		GpuDiagnostics diagnostics;
+		diagnostics.init(device);
+		diagnostics.setFillBreadcrumbs(marked);
+		Buffer buffer;
+		buffer.init(device, PASS_SIZE * PASS_COUNT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		CommandPool pool(device, device.getGraphicsFamilyIndex());
+		VkCommandBuffer commandBuffer = pool.allocate(1)[0];
+
+		VkQueue queue = device.getGraphicsQueue();
+		for (auto _ : state) {
+			beginCommandBuffer(dispatch, commandBuffer);
+			for (uint32_t i = 0; i < PASS_COUNT; i++) {
+				uint32_t id = marked ? diagnostics.recordBegin(commandBuffer, "fill pass", VK_PIPELINE_STAGE_TRANSFER_BIT) : 0;
+				dispatch.vkCmdFillBuffer(commandBuffer, buffer.getHandle(), i * PASS_SIZE, PASS_SIZE, i);
+				if (marked) {
+					diagnostics.recordEnd(commandBuffer, id);
+				}
+			}
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+
+			SubmitBatch batch;
+			batch.commandBuffers = {commandBuffer};
+			scheduler.wait(queue, scheduler.enqueue(queue, std::move(batch)));
+		}
+		state.counters["bufferMarkers"] = device.supportsBufferMarkers() ? 1 : 0;
+	}
+	BENCHMARK(BM_Breadcrumbs)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+	// A 1080p deferred frame without draws: the G-buffer subpass clears albedo, normals and depth, the lighting
+	// subpass reads them as input attachments and writes the stored color. Argument 0 stores the G-buffer as
+	// separate passes would have to, 1 keeps it transient. The counters are the memory the transient G-buffer
+	// needs, how much of it is lazily allocated and actually committed, and the bytes not written every frame.
+	void BM_DeferredTargets(benchmark::State& state)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		SubmissionScheduler& scheduler = shared->getScheduler();
+		const DeviceDispatch& dispatch = device.getDispatch();
+		bool transient = state.range(0) != 0;
+
+		std::vector<AttachmentInfo> attachments(4);
+		attachments[0].format = VK_FORMAT_R8G8B8A8_UNORM;
+		attachments[1].format = VK_FORMAT_R16G16B16A16_SFLOAT;
+		attachments[2].format = VK_FORMAT_D32_SFLOAT;
+		for (uint32_t i = 0; i < 3; i++) {
+			attachments[i].store = !transient;
+		}
+		attachments[3].format = VK_FORMAT_R8G8B8A8_UNORM;
+		attachments[3].clear = false;
+		attachments[3].store = true;
+
+		std::vector<SubpassInfo> subpasses(2);
+		subpasses[0].colorAttachments = {0, 1};
+		subpasses[0].depthAttachment = 2;
+		subpasses[1].inputAttachments = {0, 1, 2};
+		subpasses[1].colorAttachments = {3};
+
+		RenderTargets targets;
+		targets.init(device, VkExtent2D{1920, 1080}, attachments, subpasses);
+		std::vector<VkClearValue> clearValues(4);
+		clearValues[2].depthStencil = {1.0f, 0};
+
+		CommandPool pool(device, device.getGraphicsFamilyIndex());
+		VkCommandBuffer commandBuffer = pool.allocate(1)[0];
+		VkQueue queue = device.getGraphicsQueue();
+		for (auto _ : state) {
+			beginCommandBuffer(dispatch, commandBuffer);
+			targets.recordBegin(commandBuffer, 0, clearValues);
+			targets.recordNextSubpass(commandBuffer);
+			targets.recordEnd(commandBuffer);
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+
+			SubmitBatch batch;
+			batch.commandBuffers = {commandBuffer};
+			scheduler.wait(queue, scheduler.enqueue(queue, std::move(batch)));
+		}
+
+		RenderTargetStats stats = targets.getStats();
+		state.counters["transientMiB"] = static_cast<double>(stats.transientMemory) / (1 << 20);
+		state.counters["lazyMiB"] = static_cast<double>(stats.lazyMemory) / (1 << 20);
+		state.counters["committedLazyMiB"] = static_cast<double>(stats.committedLazyMemory) / (1 << 20);
+		state.counters["storeMiBSavedPerFrame"] = static_cast<double>(stats.storeBytesSaved) / (1 << 20);
+	}
+	BENCHMARK(BM_DeferredTargets)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+	// Frames that clear a 1080p target at the dynamic resolution scale and blit it to a 1080p output.
+	// The target GPU time is half of a calibration frame at full resolution, so the scale should settle near 0.7
+	// as clearing costs about the same per pixel. The counters are the settled scale and GPU times.
+	void BM_DynamicResolution(benchmark::State& state)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		SubmissionScheduler& scheduler = shared->getScheduler();
+		const DeviceDispatch& dispatch = device.getDispatch();
+		VkExtent2D extent{1920, 1080};
+
+		std::vector<AttachmentInfo> attachments(1);
+		attachments[0].format = VK_FORMAT_R8G8B8A8_UNORM;
+		attachments[0].store = true;
+		attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		std::vector<SubpassInfo> subpasses(1);
+		subpasses[0].colorAttachments = {0};
+		RenderTargets targets;
+		targets.init(device, extent, attachments, subpasses);
+		std::vector<VkClearValue> clearValues(1);
+
+		ImageInfo outputInfo{};
+		outputInfo.extent = extent;
+		outputInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+		outputInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		Image output;
+		output.init(device, outputInfo);
+
+		CommandPool pool(device, device.getGraphicsFamilyIndex());
+		VkCommandBuffer commandBuffer = pool.allocate(1)[0];
+		VkQueue queue = device.getGraphicsQueue();
+		DynamicResolution resolution;
+		auto renderFrame = [&]() {
+			beginCommandBuffer(dispatch, commandBuffer);
+			resolution.recordBeginFrame(commandBuffer, 0);
+			targets.recordBegin(commandBuffer, 0, clearValues, resolution.getRenderExtent());
+			targets.recordEnd(commandBuffer);
+			resolution.recordUpscale(commandBuffer, 0, targets.getAttachment(0).getHandle(), extent, output.getHandle(),
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+
+			SubmitBatch batch;
+			batch.commandBuffers = {commandBuffer};
+			scheduler.wait(queue, scheduler.enqueue(queue, std::move(batch)));
+		};
+
+		// The first frame of a fixed scale only measures, the ones after it read the measurement
+		DynamicResolutionSettings calibration{};
+		calibration.minScale = 1.0f;
+		resolution.init(device, extent, 1, calibration);
+		if (!resolution.canUpscale(VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, outputInfo.usage)) {
+			skipUnavailable(state, "R8G8B8A8_UNORM doesn't support linear blits");
+			return;
+		}
+		for (int i = 0; i < 4; i++) {
+			renderFrame();
+		}
+		double fullMilliseconds = resolution.getGpuMilliseconds();
+		if (fullMilliseconds <= 0.0) {
+			skipUnavailable(state, "the graphics queue doesn't support timestamps");
+			return;
+		}
+		resolution.cleanup();
+
+		DynamicResolutionSettings settings{};
+		settings.targetMilliseconds = static_cast<float>(fullMilliseconds * 0.5);
+		resolution.init(device, extent, 1, settings);
+		for (auto _ : state) {
+			renderFrame();
+		}
+		state.counters["scale"] = resolution.getScale();
+		state.counters["gpuMs"] = resolution.getGpuMilliseconds();
+		state.counters["targetMs"] = settings.targetMilliseconds;
+		state.counters["fullResolutionMs"] = fullMilliseconds;
+	}
+	BENCHMARK(BM_DynamicResolution)->Unit(benchmark::kMicrosecond);
+
+	// Draws the depth of IndirectDrawPass objects with Shaders/DepthOnly.vert, for render passes like the given one
+	class DepthOnlyPipeline
+	{
+	public:
+		DepthOnlyPipeline(LogicalDevice& device, VkRenderPass renderPass, VkBuffer objectBuffer) :
+			deviceHandle(device.getHandle()),
+			allocator(device.getAllocator()),
+			dispatch(&device.getDispatch())
+		{
+			VkDescriptorSetLayoutBinding binding{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr};
+			VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+			setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			setLayoutInfo.bindingCount = 1;
+			setLayoutInfo.pBindings = &binding;
+			VK_CHECK(dispatch->vkCreateDescriptorSetLayout(deviceHandle, &setLayoutInfo, allocator, &setLayout));
+
+			VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1};
+			VkDescriptorPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			poolInfo.maxSets = 1;
+			poolInfo.poolSizeCount = 1;
+			poolInfo.pPoolSizes = &poolSize;
+			VK_CHECK(dispatch->vkCreateDescriptorPool(deviceHandle, &poolInfo, allocator, &descriptorPool));
+
+			VkDescriptorSetAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocateInfo.descriptorPool = descriptorPool;
+			allocateInfo.descriptorSetCount = 1;
+			allocateInfo.pSetLayouts = &setLayout;
+			VK_CHECK(dispatch->vkAllocateDescriptorSets(deviceHandle, &allocateInfo, &set));
+			VkDescriptorBufferInfo bufferInfo{objectBuffer, 0, VK_WHOLE_SIZE};
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = set;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.pBufferInfo = &bufferInfo;
+			dispatch->vkUpdateDescriptorSets(deviceHandle, 1, &write, 0, nullptr);
+
+			VkPushConstantRange pushConstantRange{VK_SHADER_STAGE_VERTEX_BIT, 0, 16 * sizeof(float)};
+			VkPipelineLayoutCreateInfo layoutInfo{};
+			layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			layoutInfo.setLayoutCount = 1;
+			layoutInfo.pSetLayouts = &setLayout;
+			layoutInfo.pushConstantRangeCount = 1;
+			layoutInfo.pPushConstantRanges = &pushConstantRange;
+			VK_CHECK(dispatch->vkCreatePipelineLayout(deviceHandle, &layoutInfo, allocator, &layout));
+
+			Shader shader;
+			shader.init(device, "DepthOnly.vert.spv");
+			VkPipelineShaderStageCreateInfo stage{};
+			stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+			stage.module = shader.getHandle();
+			stage.pName = "main";
+
+			VkVertexInputBindingDescription vertexBinding{0, 3 * sizeof(float), VK_VERTEX_INPUT_RATE_VERTEX};
+			VkVertexInputAttributeDescription position{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0};
+			VkPipelineVertexInputStateCreateInfo vertexInput{};
+			vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vertexInput.vertexBindingDescriptionCount = 1;
+			vertexInput.pVertexBindingDescriptions = &vertexBinding;
+			vertexInput.vertexAttributeDescriptionCount = 1;
+			vertexInput.pVertexAttributeDescriptions = &position;
+			VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+			inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+			inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			// RenderTargets::recordBegin sets them
+			VkPipelineViewportStateCreateInfo viewport{};
+			viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			viewport.viewportCount = 1;
+			viewport.scissorCount = 1;
+			VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+			VkPipelineDynamicStateCreateInfo dynamic{};
+			dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+			dynamic.dynamicStateCount = 2;
+			dynamic.pDynamicStates = dynamicStates;
+			VkPipelineRasterizationStateCreateInfo rasterization{};
+			rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+			rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+			rasterization.cullMode = VK_CULL_MODE_NONE;
+			rasterization.lineWidth = 1.0f;
+			VkPipelineMultisampleStateCreateInfo multisample{};
+			multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+			multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+			VkPipelineDepthStencilStateCreateInfo depthStencil{};
+			depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+			depthStencil.depthTestEnable = VK_TRUE;
+			depthStencil.depthWriteEnable = VK_TRUE;
+			depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+			VkPipelineColorBlendStateCreateInfo colorBlend{};
+			colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+
+			VkGraphicsPipelineCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			createInfo.stageCount = 1;
+			createInfo.pStages = &stage;
+			createInfo.pVertexInputState = &vertexInput;
+			createInfo.pInputAssemblyState = &inputAssembly;
+			createInfo.pViewportState = &viewport;
+			createInfo.pRasterizationState = &rasterization;
+			createInfo.pMultisampleState = &multisample;
+			createInfo.pDepthStencilState = &depthStencil;
+			createInfo.pColorBlendState = &colorBlend;
+			createInfo.pDynamicState = &dynamic;
+			createInfo.layout = layout;
+			createInfo.renderPass = renderPass;
+			VK_CHECK(dispatch->vkCreateGraphicsPipelines(deviceHandle, nullptr, 1, &createInfo, allocator, &pipeline));
+		}
+
+		~DepthOnlyPipeline()
+		{
+			dispatch->vkDestroyPipeline(deviceHandle, pipeline, allocator);
+			dispatch->vkDestroyPipelineLayout(deviceHandle, layout, allocator);
+			dispatch->vkDestroyDescriptorPool(deviceHandle, descriptorPool, allocator);
+			dispatch->vkDestroyDescriptorSetLayout(deviceHandle, setLayout, allocator);
+		}
+
+		DepthOnlyPipeline(const DepthOnlyPipeline&) = delete;
+		DepthOnlyPipeline& operator=(const DepthOnlyPipeline&) = delete;
+
+		void recordBind(VkCommandBuffer commandBuffer, const float viewProjection[16])
+		{
+			dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			dispatch->vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &set, 0, nullptr);
+			dispatch->vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, 16 * sizeof(float), viewProjection);
+		}
+
+	private:
+		VkDevice deviceHandle;
+		const VkAllocationCallbacks* allocator;
+		const DeviceDispatch* dispatch;
+		VkDescriptorSetLayout setLayout = nullptr;
+		VkDescriptorPool descriptorPool = nullptr;
+		VkDescriptorSet set = nullptr;
+		VkPipelineLayout layout = nullptr;
+		VkPipeline pipeline = nullptr;
+	};
+
+	// An indoor scene drawn depth only at 1080p: a wall with a narrow doorway in front of a room of 4096 crates.
+	// Argument 0 only culls against the frustum, 1 adds two phase occlusion culling against a depth pyramid.
+	// The counters are the share of crates and walls culled and the draws of each phase.
+	void BM_OcclusionCulling(benchmark::State& state)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		SubmissionScheduler& scheduler = shared->getScheduler();
+		const DeviceDispatch& dispatch = device.getDispatch();
+		bool occlusion = state.range(0) != 0;
+		if (!device.getEnabledFeatures().drawIndirectFirstInstance
+			|| (occlusion && !device.getEnabledFeatures().shaderStorageImageArrayDynamicIndexing)) {
+			skipUnavailable(state, "the device lacks the features of occlusion culling");
+			return;
+		}
+		VkExtent2D extent{1920, 1080};
+
+		// Every object is a scaled unit cube
+		const float vertices[] = {-1, -1, -1, 1, -1, -1, 1, 1, -1, -1, 1, -1, -1, -1, 1, 1, -1, 1, 1, 1, 1, -1, 1, 1};
+		const uint32_t indices[] = {0, 1, 2, 2, 3, 0, 4, 6, 5, 6, 4, 7, 0, 4, 5, 5, 1, 0,
+			3, 2, 6, 6, 7, 3, 0, 3, 7, 7, 4, 0, 1, 5, 6, 6, 2, 1};
+		VkMemoryPropertyFlags hostMemory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		Buffer vertexBuffer, indexBuffer;
+		vertexBuffer.init(device, sizeof(vertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, hostMemory);
+		indexBuffer.init(device, sizeof(indices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, hostMemory);
+		std::memcpy(vertexBuffer.getMapped(), vertices, sizeof(vertices));
+		std::memcpy(indexBuffer.getMapped(), indices, sizeof(indices));
+
+		constexpr uint32_t GRID = 16;
+		constexpr uint32_t OBJECT_COUNT = 2 + GRID * GRID * GRID;
+		IndirectDrawPass pass;
+		pass.init(device, OBJECT_COUNT, 1);
+		MeshInfo& mesh = pass.getMeshes()[0];
+		mesh = {};
+		mesh.lods[0] = {36, 0, 0, 1e9f};
+		mesh.lodCount = 1;
+		ObjectData* objects = pass.getObjects();
+		auto placeBox = [&](uint32_t index, float x, float y, float z, float halfWidth, float halfHeight, float halfDepth) {
+			ObjectData& object = objects[index];
+			object = {};
+			object.model[0] = halfWidth;
+			object.model[5] = halfHeight;
+			object.model[10] = halfDepth;
+			object.model[12] = x;
+			object.model[13] = y;
+			object.model[14] = z;
+			object.model[15] = 1.0f;
+			object.boundingSphere[3] = std::sqrt(3.0f);
+		};
+		// The camera is at the origin looking down -z, the doorway is a unit wide gap between two walls
+		placeBox(0, -6.5f, 0.0f, -10.0f, 6.0f, 8.0f, 0.25f);
+		placeBox(1, 6.5f, 0.0f, -10.0f, 6.0f, 8.0f, 0.25f);
+		for (uint32_t i = 0; i < GRID * GRID * GRID; i++) {
+			float x = static_cast<float>(i % GRID) * 2.0f - 15.0f;
+			float y = static_cast<float>(i / GRID % GRID) - 7.5f;
+			float z = -20.0f - static_cast<float>(i / (GRID * GRID)) * 4.0f;
+			placeBox(2 + i, x, y, z, 0.4f, 0.4f, 0.4f);
+		}
+		pass.setObjectCount(OBJECT_COUNT);
+
+		// Vulkan clip space perspective with a 60 degree vertical field of view, the view is the identity
+		CullView view{};
+		float aspect = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+		float focal = 1.0f / std::tan(0.5f * 1.0471976f);
+		float zNear = 0.1f, zFar = 500.0f;
+		view.viewProjection[0] = focal / aspect;
+		view.viewProjection[5] = -focal;
+		view.viewProjection[10] = zFar / (zNear - zFar);
+		view.viewProjection[11] = -1.0f;
+		view.viewProjection[14] = zNear * zFar / (zNear - zFar);
+
+		std::vector<AttachmentInfo> attachments(1);
+		attachments[0].format = VK_FORMAT_D32_SFLOAT;
+		attachments[0].store = true;
+		std::vector<SubpassInfo> subpasses(1);
+		subpasses[0].depthAttachment = 0;
+		RenderTargets firstTargets;
+		firstTargets.init(device, extent, attachments, subpasses);
+		// The second phase draws into the depth of the first
+		attachments[0].load = true;
+		attachments[0].external = true;
+		RenderTargets secondTargets;
+		secondTargets.init(device, extent, attachments, subpasses, {firstTargets.getAttachment(0).getView()});
+		std::vector<VkClearValue> clearValues(1);
+		clearValues[0].depthStencil = {1.0f, 0};
+
+		DepthPyramid pyramid;
+		if (occlusion) {
+			pyramid.init(device, extent);
+			pyramid.setDepth(firstTargets.getAttachment(0).getView());
+			pass.setDepthPyramid(pyramid.getView(), pyramid.getSampler(), pyramid.getExtent().width, pyramid.getExtent().height);
+		}
+		DepthOnlyPipeline depthOnly(device, firstTargets.getRenderPass(), pass.getObjectBuffer());
+
+		CommandPool pool(device, device.getGraphicsFamilyIndex());
+		VkCommandBuffer commandBuffer = pool.allocate(1)[0];
+		VkQueue queue = device.getGraphicsQueue();
+		auto recordDraws = [&](RenderTargets& targets) {
+			targets.recordBegin(commandBuffer, 0, clearValues);
+			depthOnly.recordBind(commandBuffer, view.viewProjection);
+			VkDeviceSize offset = 0;
+			VkBuffer vertexHandle = vertexBuffer.getHandle();
+			dispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexHandle, &offset);
+			dispatch.vkCmdBindIndexBuffer(commandBuffer, indexBuffer.getHandle(), 0, VK_INDEX_TYPE_UINT32);
+			pass.recordDraw(commandBuffer);
+			targets.recordEnd(commandBuffer);
+		};
+		auto renderFrame = [&]() {
+			beginCommandBuffer(dispatch, commandBuffer);
+			if (occlusion) {
+				pass.recordCullFirstPhase(commandBuffer, view);
+				recordDraws(firstTargets);
+				pyramid.recordBuild(commandBuffer);
+				pass.recordCullSecondPhase(commandBuffer, view);
+				recordDraws(secondTargets);
+			} else {
+				pass.recordCull(commandBuffer, view);
+				recordDraws(firstTargets);
+			}
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+
+			SubmitBatch batch;
+			batch.commandBuffers = {commandBuffer};
+			batch.label = "Occlusion culling frame";
+			scheduler.wait(queue, scheduler.enqueue(queue, std::move(batch)));
+		};
+
+		// The first frame draws everything in the second phase, the ones after it settle
+		for (int i = 0; i < 2; i++) {
+			renderFrame();
+		}
+		for (auto _ : state) {
+			renderFrame();
+		}
+
+		// Frustum culling alone draws in the first phase only
+		CullStats stats = pass.getCullStats();
+		uint32_t drawn = stats.firstPhaseDraws + stats.secondPhaseDraws;
+		state.counters["objects"] = OBJECT_COUNT;
+		state.counters["culledPercent"] = 100.0 * (1.0 - static_cast<double>(drawn) / stats.objectCount);
+		state.counters["firstPhaseDraws"] = stats.firstPhaseDraws;
+		state.counters["secondPhaseDraws"] = stats.secondPhaseDraws;
+	}
+	BENCHMARK(BM_OcclusionCulling)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+	// Submitting many small batches of empty command buffers, as independent systems do every frame.
+	// The argument is the number of batches, submitted through the scheduler which merges them into
+	// one vkQueueSubmit, or with a vkQueueSubmit each. Both wait for the last batch.
+	void submitBatches(benchmark::State& state, bool scheduled)
+	{
+		HeadlessDevice* shared = HeadlessDevice::getShared(state);
+		if (shared == nullptr) {
+			return;
+		}
+
+		LogicalDevice& device = shared->getDevice();
+		SubmissionScheduler& scheduler = shared->getScheduler();
+		const DeviceDispatch& dispatch = device.getDispatch();
+		uint32_t batchCount = static_cast<uint32_t>(state.range(0));
+
+		CommandPool pool(device, device.getGraphicsFamilyIndex());
+		std::vector<VkCommandBuffer> commandBuffers = pool.allocate(batchCount);
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		for (VkCommandBuffer commandBuffer : commandBuffers) {
+			VK_CHECK(dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo));
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkFence fence;
+		VK_CHECK(dispatch.vkCreateFence(device.getHandle(), &fenceInfo, device.getAllocator(), &fence));
+
+		VkQueue queue = device.getGraphicsQueue();
+		for (auto _ : state) {
+			if (scheduled) {
+				uint64_t serial = 0;
+				for (VkCommandBuffer commandBuffer : commandBuffers) {
+					SubmitBatch batch;
+					batch.commandBuffers = {commandBuffer};
+					serial = scheduler.enqueue(queue, std::move(batch));
+				}
+				scheduler.wait(queue, serial);
+			} else {
+				{
+					std::unique_lock<ProfiledMutex> lock = scheduler.lockQueue(queue);
+					for (uint32_t i = 0; i < batchCount; i++) {
+						VkSubmitInfo submitInfo{};
+						submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+						submitInfo.commandBufferCount = 1;
+						submitInfo.pCommandBuffers = &commandBuffers[i];
+						VK_CHECK(dispatch.vkQueueSubmit(queue, 1, &submitInfo, i + 1 == batchCount ? fence : VK_NULL_HANDLE));
+					}
+				}
+				VK_CHECK(dispatch.vkWaitForFences(device.getHandle(), 1, &fence, VK_TRUE, UINT64_MAX));
+				VK_CHECK(dispatch.vkResetFences(device.getHandle(), 1, &fence));
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * batchCount);
+
+		dispatch.vkDestroyFence(device.getHandle(), fence, device.getAllocator());
+	}
+
+	void BM_SubmitScheduled(benchmark::State& state)
+	{
+		submitBatches(state, true);
+	}
+	BENCHMARK(BM_SubmitScheduled)->Arg(8)->Arg(64)->Unit(benchmark::kMicrosecond);
+
+	void BM_SubmitDirect(benchmark::State& state)
+	{
+		submitBatches(state, false);
+	}
+	BENCHMARK(BM_SubmitDirect)->Arg(8)->Arg(64)->Unit(benchmark::kMicrosecond);
+}
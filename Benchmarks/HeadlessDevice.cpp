@@ -0,0 +1,101 @@
+#include "HeadlessDevice.h"
+
+#include <exception>
+#include <memory>
+
+#include "SkipUnavailable.h"
+
+namespace
+{
+	std::unique_ptr<HeadlessDevice> sharedDevice;
+	std::string sharedError;
+	bool sharedCreated = false;
+}
+
+HeadlessDevice::HeadlessDevice() : properties{}
+{}
+
+void HeadlessDevice::init()
+{
+	instance.init("Benchmarks", nullptr, true);
+	surface.initHeadless(instance);
+	VkPhysicalDevice physicalDevice = LogicalDevice::findSuitablePhysicalDevice(instance, surface);
+	instance.getDispatch().vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	device.init(physicalDevice, surface, instance.getAllocator());
+	scheduler.init(device);
+}
+
+HeadlessDevice::~HeadlessDevice()
+{
+	cleanup();
+}
+
+void HeadlessDevice::cleanup()
+{
+	scheduler.cleanup();
+	if (device.getHandle() != nullptr) {
+		device.getDispatch().vkDeviceWaitIdle(device.getHandle());
+	}
+	device.cleanup();
+	surface.cleanup();
+	instance.cleanup();
+}
+
+VulkanInstance& HeadlessDevice::getInstance()
+{
+	return instance;
+}
+
+Surface& HeadlessDevice::getSurface()
+{
+	return surface;
+}
+
+LogicalDevice& HeadlessDevice::getDevice()
+{
+	return device;
+}
+
+SubmissionScheduler& HeadlessDevice::getScheduler()
+{
+	return scheduler;
+}
+
+const char* HeadlessDevice::getDeviceName()
+{
+	return properties.deviceName;
+}
+
+HeadlessDevice* HeadlessDevice::getShared()
+{
+	if (!sharedCreated) {
+		sharedCreated = true;
+		try {
+			sharedDevice = std::make_unique<HeadlessDevice>();
+			sharedDevice->init();
+		} catch (std::exception& e) {
+			sharedError = e.what();
+			sharedDevice.reset();
+		}
+	}
+	return sharedDevice.get();
+}
+
+HeadlessDevice* HeadlessDevice::getShared(benchmark::State& state)
+{
+	HeadlessDevice* device = getShared();
+	if (device == nullptr) {
+		skipUnavailable(state, "no vulkan device, " + sharedError);
+	}
+	return device;
+}
+
+const std::string& HeadlessDevice::getSharedError()
+{
+	return sharedError;
+}
+
+void HeadlessDevice::destroyShared()
+{
+	sharedDevice.reset();
+}
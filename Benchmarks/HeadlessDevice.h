@@ -0,0 +1,73 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "VulkanInstance.h"
+#include "Surface.h"
+#include "LogicalDevice.h"
+#include "SubmissionScheduler.h"
+
+// Instance, headless surface and device shared by every vulkan benchmark, so only BM_DeviceInit
+// pays for creating them. Created on first use and destroyed by destroyShared at the end of main.
+class HeadlessDevice
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create anything, must call init
+	 */
+	HeadlessDevice();
+
+	/**
+	 * @brief Creates a headless instance and surface, and a device on the first physical device
+	 * that can present to it. Throws an error if there is none, such as without a vulkan driver.
+	 */
+	void init();
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~HeadlessDevice();
+
+	/**
+	 * @brief Waits for the device to be idle and destroys everything
+	 */
+	void cleanup();
+
+	VulkanInstance& getInstance();
+	Surface& getSurface();
+	LogicalDevice& getDevice();
+	SubmissionScheduler& getScheduler();
+
+	/**
+	 * @brief Returns the name of the physical device, such as "llvmpipe (LLVM 15.0.7, 256 bits)"
+	 */
+	const char* getDeviceName();
+
+	/**
+	 * @brief Returns the shared device, creating it on the first call
+	 *
+	 * @return nullptr if it couldn't be created, with the reason in getSharedError
+	 */
+	static HeadlessDevice* getShared();
+
+	/**
+	 * @brief Returns the shared device, or marks the benchmark as skipped and returns nullptr if there is none.
+	 * The benchmark must return without entering its loop then.
+	 */
+	static HeadlessDevice* getShared(benchmark::State& state);
+
+	static const std::string& getSharedError();
+	static void destroyShared();
+
+private:
+	VulkanInstance instance;
+	Surface surface;
+	LogicalDevice device;
+	SubmissionScheduler scheduler;
+	VkPhysicalDeviceProperties properties;
+};
@@ -0,0 +1,171 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MathBatch.h"
+#include "SkipUnavailable.h"
+
+namespace
+{
+	// Inputs shared by every level, filled with the same seed so runs are comparable
+	struct MathInputs
+	{
+		std::vector<Mat4> matrices;
+		std::vector<Vec3> points;
+		std::vector<float> x, y, z, radius;
+		std::vector<float> maxX, maxY, maxZ;
+		Frustum frustum;
+
+		explicit MathInputs(size_t count) : matrices(count), points(count), x(count), y(count), z(count), radius(count),
+			maxX(count), maxY(count), maxZ(count)
+		{
+			std::mt19937 random(1234);
+			std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+			std::uniform_real_distribution<float> size(0.1f, 5.0f);
+			for (size_t i = 0; i < count; i++) {
+				Vec3 translation{position(random), position(random), position(random)};
+				matrices[i] = composeTransform(translation, Quat{0.0f, 0.0f, 0.0f, 1.0f}, Vec3{1.0f, 2.0f, 1.0f});
+				points[i] = Vec3{position(random), position(random), position(random)};
+				x[i] = position(random);
+				y[i] = position(random);
+				z[i] = position(random);
+				radius[i] = size(random);
+				maxX[i] = x[i] + size(random);
+				maxY[i] = y[i] + size(random);
+				maxZ[i] = z[i] + size(random);
+			}
+			Mat4 view = lookAt(Vec3{0.0f, 10.0f, -50.0f}, Vec3{0.0f, 0.0f, 0.0f}, Vec3{0.0f, 1.0f, 0.0f});
+			frustum = makeFrustum(perspective(1.0f, 16.0f / 9.0f, 0.1f, 200.0f) * view);
+		}
+
+		SphereArrays getSpheres() const
+		{
+			return {x.data(), y.data(), z.data(), radius.data()};
+		}
+
+		AABBArrays getBoxes() const
+		{
+			return {x.data(), y.data(), z.data(), maxX.data(), maxY.data(), maxZ.data()};
+		}
+	};
+
+	bool isNear(float a, float b)
+	{
+		return std::fabs(a - b) <= 1e-4f * std::fmax(1.0f, std::fabs(a));
+	}
+
+	bool isNear(Vec3 a, Vec3 b)
+	{
+		return isNear(a.x, b.x) && isNear(a.y, b.y) && isNear(a.z, b.z);
+	}
+
+	bool isNear(const Mat4& a, const Mat4& b)
+	{
+		for (int column = 0; column < 4; column++) {
+			Vec4 ca = a.columns[column];
+			Vec4 cb = b.columns[column];
+			if (!isNear(ca.x, cb.x) || !isNear(ca.y, cb.y) || !isNear(ca.z, cb.z) || !isNear(ca.w, cb.w)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool isNear(uint8_t a, uint8_t b)
+	{
+		return a == b;
+	}
+
+	// Runs a kernel at the benchmarked level after checking its output against the scalar reference,
+	// so a faster but wrong kernel fails instead of winning a comparison. Levels the CPU or build
+	// doesn't support are skipped. The level the program picked is restored afterwards.
+	template<typename Output, typename Kernel>
+	void runKernel(benchmark::State& state, SimdLevel level, size_t count, Kernel kernel)
+	{
+		std::vector<Output> expected(count);
+		std::vector<Output> out(count);
+		SimdLevel startLevel = getSimdLevel();
+
+		setSimdLevel(SimdLevel::SCALAR);
+		kernel(expected.data());
+		bool supported = setSimdLevel(level) == level;
+		if (supported) {
+			kernel(out.data());
+		}
+		setSimdLevel(startLevel);
+		if (!supported) {
+			skipUnavailable(state, std::string(getSimdLevelName(level)) + " isn't supported");
+			return;
+		}
+		for (size_t i = 0; i < count; i++) {
+			if (!isNear(out[i], expected[i])) {
+				state.SkipWithError("result differs from the scalar reference");
+				return;
+			}
+		}
+
+		setSimdLevel(level);
+		for (auto _ : state) {
+			kernel(out.data());
+			benchmark::ClobberMemory();
+		}
+		setSimdLevel(startLevel);
+		state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+	}
+
+	// The argument of every kernel benchmark is the batch size
+	void BM_MultiplyMatrices(benchmark::State& state, SimdLevel level)
+	{
+		size_t count = static_cast<size_t>(state.range(0));
+		MathInputs inputs(count);
+		Mat4 parent = inputs.matrices[0];
+		runKernel<Mat4>(state, level, count, [&](Mat4* out) {
+			multiplyMatrices(parent, inputs.matrices.data(), out, count);
+		});
+	}
+
+	void BM_TransformPoints(benchmark::State& state, SimdLevel level)
+	{
+		size_t count = static_cast<size_t>(state.range(0));
+		MathInputs inputs(count);
+		runKernel<Vec3>(state, level, count, [&](Vec3* out) {
+			transformPoints(inputs.matrices[0], inputs.points.data(), out, count);
+		});
+	}
+
+	void BM_CullSpheres(benchmark::State& state, SimdLevel level)
+	{
+		size_t count = static_cast<size_t>(state.range(0));
+		MathInputs inputs(count);
+		SphereArrays spheres = inputs.getSpheres();
+		runKernel<uint8_t>(state, level, count, [&](uint8_t* visible) {
+			cullSpheres(inputs.frustum, spheres, visible, count);
+		});
+	}
+
+	void BM_CullAABBs(benchmark::State& state, SimdLevel level)
+	{
+		size_t count = static_cast<size_t>(state.range(0));
+		MathInputs inputs(count);
+		AABBArrays boxes = inputs.getBoxes();
+		runKernel<uint8_t>(state, level, count, [&](uint8_t* visible) {
+			cullAABBs(inputs.frustum, boxes, visible, count);
+		});
+	}
+
+#define MATH_BENCHMARK(function) \
+	BENCHMARK_CAPTURE(function, scalar, SimdLevel::SCALAR)->Arg(1024)->Arg(65536); \
+	BENCHMARK_CAPTURE(function, sse4, SimdLevel::SSE4)->Arg(1024)->Arg(65536); \
+	BENCHMARK_CAPTURE(function, avx2, SimdLevel::AVX2)->Arg(1024)->Arg(65536);
+
+	MATH_BENCHMARK(BM_MultiplyMatrices)
+	MATH_BENCHMARK(BM_TransformPoints)
+	MATH_BENCHMARK(BM_CullSpheres)
+	MATH_BENCHMARK(BM_CullAABBs)
+
+#undef MATH_BENCHMARK
+}
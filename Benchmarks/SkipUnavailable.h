@@ -0,0 +1,20 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+// Prefix of the error of a scenario the machine can't run, such as a missing instruction set or vulkan feature.
+// compare.py lists those as skipped, any other error fails the comparison.
+constexpr const char* UNAVAILABLE_PREFIX = "unavailable: ";
+
+/**
+ * @brief Skips a scenario the machine can't run. Wrong results and failed calls must use SkipWithError instead.
+ *
+ * @param state - state of the running benchmark
+ * @param reason - what is missing
+ */
+inline void skipUnavailable(benchmark::State& state, const std::string& reason)
+{
+	state.SkipWithError((UNAVAILABLE_PREFIX + reason).c_str());
+}
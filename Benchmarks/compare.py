@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Compares two Google Benchmark JSON files and exits with 1 if any benchmark got slower.
+
+usage: compare.py baseline.json contender.json [--threshold 0.05] [--metric real_time|cpu_time]
+
+Runs with repetitions are compared by their median, single runs by their only result.
+Benchmarks that only exist in one of the files, or were skipped because the machine can't run them, are listed
+but never fail the comparison. Any other error, such as a result that differs from its reference, fails it.
+"""
+
+import argparse
+import json
+import sys
+
+# Errors starting with this mark scenarios the machine can't run, see SkipUnavailable.h
+UNAVAILABLE_PREFIX = "unavailable: "
+
+
+def load(path, metric):
+    with open(path) as file:
+        data = json.load(file)
+
+    # Times of the benchmarks that ran, None for skipped ones, and the message of the ones that failed
+    results = {}
+    medians = {}
+    errors = {}
+    for benchmark in data["benchmarks"]:
+        name = benchmark.get("run_name", benchmark["name"])
+        if benchmark.get("error_occurred"):
+            message = benchmark.get("error_message", "")
+            if message.startswith(UNAVAILABLE_PREFIX):
+                results.setdefault(name, None)
+            else:
+                errors[name] = message
+            continue
+        if benchmark.get("skipped"):
+            results.setdefault(name, None)
+            continue
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") == "median":
+                medians[name] = benchmark[metric]
+        elif name not in results or results[name] is None:
+            results[name] = benchmark[metric]
+    results.update(medians)
+    for name in errors:
+        results.pop(name, None)
+    return data.get("context", {}), results, errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flags benchmarks that got slower between two runs")
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="relative slowdown that counts as a regression, 0.05 is 5%%")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"], default="real_time")
+    args = parser.parse_args()
+
+    baseline_context, baseline, baseline_errors = load(args.baseline, args.metric)
+    contender_context, contender, contender_errors = load(args.contender, args.metric)
+
+    for key in ("vulkan_device", "simd_level"):
+        if baseline_context.get(key) != contender_context.get(key):
+            print(f"warning: {key} differs, {baseline_context.get(key)} vs {contender_context.get(key)}")
+
+    regressions = 0
+    failures = 0
+    names = baseline.keys() | contender.keys() | baseline_errors.keys() | contender_errors.keys()
+    width = max((len(name) for name in names), default=9)
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'contender':>12}  {'change':>8}")
+    for name in sorted(names):
+        if name in baseline_errors or name in contender_errors:
+            failures += 1
+            for run, errors in (("baseline", baseline_errors), ("contender", contender_errors)):
+                if name in errors:
+                    print(f"{name:<{width}}  {'':>12}  {'':>12}  {'FAILED':>8}  {run}: {errors[name]}")
+            continue
+        old = baseline.get(name)
+        new = contender.get(name)
+        if old is None or new is None:
+            status = "skipped" if name in baseline and name in contender else "missing"
+            print(f"{name:<{width}}  {'-' if old is None else f'{old:.4g}':>12}  "
+                  f"{'-' if new is None else f'{new:.4g}':>12}  {status:>8}")
+            continue
+
+        change = (new - old) / old if old > 0 else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            mark = "  faster"
+        print(f"{name:<{width}}  {old:>12.4g}  {new:>12.4g}  {change:>+8.1%}{mark}")
+
+    if failures > 0:
+        print(f"{failures} benchmark(s) failed")
+    if regressions > 0:
+        print(f"{regressions} benchmark(s) slower by more than {args.threshold:.0%}")
+    return 1 if failures > 0 or regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
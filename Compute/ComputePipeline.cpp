@@ -0,0 +1,231 @@
+#include "ComputePipeline.h"
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+#include "Shader.h"
+
+ComputePipeline::ComputePipeline() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	pushConstantSize(0),
+	bindingTypes{},
+	setLayout(nullptr),
+	pipelineLayout(nullptr),
+	pipeline(nullptr),
+	descriptorPool(nullptr)
+{
+}
+
+void ComputePipeline::init(LogicalDevice& device, const std::string& shaderName, const std::vector<VkDescriptorType>& bindings,
+	uint32_t _pushConstantSize, uint32_t maxSets, const std::vector<uint32_t>& specialization)
+{
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	pushConstantSize = _pushConstantSize;
+	bindingTypes = bindings;
+
+	createDescriptors(maxSets);
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = pushConstantSize;
+
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VkResult result = dispatch->vkCreatePipelineLayout(deviceHandle, &layoutInfo, allocator, &pipelineLayout); VK_CHECK(result);
+
+	// Constant i of the shader reads the 4 bytes at offset 4 * i
+	std::vector<VkSpecializationMapEntry> mapEntries(specialization.size());
+	for (uint32_t i = 0; i < mapEntries.size(); i++) {
+		mapEntries[i].constantID = i;
+		mapEntries[i].offset = i * sizeof(uint32_t);
+		mapEntries[i].size = sizeof(uint32_t);
+	}
+	VkSpecializationInfo specializationInfo{};
+	specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+	specializationInfo.pMapEntries = mapEntries.data();
+	specializationInfo.dataSize = specialization.size() * sizeof(uint32_t);
+	specializationInfo.pData = specialization.data();
+
+	Shader shader;
+	shader.init(device, shaderName);
+
+	VkComputePipelineCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	createInfo.stage.module = shader.getHandle();
+	createInfo.stage.pName = "main";
+	createInfo.stage.pSpecializationInfo = specialization.empty() ? nullptr : &specializationInfo;
+	createInfo.layout = pipelineLayout;
+	result = dispatch->vkCreateComputePipelines(deviceHandle, nullptr, 1, &createInfo, allocator, &pipeline); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_PIPELINE, pipeline, shaderName);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, pipelineLayout, shaderName);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_DESCRIPTOR_POOL, descriptorPool, shaderName);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+	cleanup();
+}
+
+void ComputePipeline::cleanup()
+{
+	if (deviceHandle) {
+		dispatch->vkDestroyPipeline(deviceHandle, pipeline, allocator);
+		dispatch->vkDestroyPipelineLayout(deviceHandle, pipelineLayout, allocator);
+		// Destroying the pool frees its sets
+		dispatch->vkDestroyDescriptorPool(deviceHandle, descriptorPool, allocator);
+		dispatch->vkDestroyDescriptorSetLayout(deviceHandle, setLayout, allocator);
+		pipeline = nullptr;
+		pipelineLayout = nullptr;
+		descriptorPool = nullptr;
+		setLayout = nullptr;
+		bindingTypes.clear();
+		deviceHandle = nullptr;
+	}
+}
+
+VkDescriptorSet ComputePipeline::allocateSet()
+{
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = descriptorPool;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &setLayout;
+	VkDescriptorSet set = nullptr;
+	VkResult result = dispatch->vkAllocateDescriptorSets(deviceHandle, &allocateInfo, &set); VK_CHECK(result);
+	return set;
+}
+
+void ComputePipeline::resetSets()
+{
+	VkResult result = dispatch->vkResetDescriptorPool(deviceHandle, descriptorPool, 0); VK_CHECK(result);
+}
+
+void ComputePipeline::writeBuffer(VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo bufferInfo{buffer, offset, range};
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = set;
+	write.dstBinding = binding;
+	write.descriptorCount = 1;
+	write.descriptorType = bindingTypes[binding];
+	write.pBufferInfo = &bufferInfo;
+	dispatch->vkUpdateDescriptorSets(deviceHandle, 1, &write, 0, nullptr);
+}
+
+void ComputePipeline::writeImage(VkDescriptorSet set, uint32_t binding, VkImageView view, VkImageLayout layout, VkSampler sampler)
+{
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = sampler;
+	imageInfo.imageView = view;
+	imageInfo.imageLayout = layout;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = set;
+	write.dstBinding = binding;
+	write.descriptorCount = 1;
+	write.descriptorType = bindingTypes[binding];
+	write.pImageInfo = &imageInfo;
+	dispatch->vkUpdateDescriptorSets(deviceHandle, 1, &write, 0, nullptr);
+}
+
+void ComputePipeline::recordBind(VkCommandBuffer commandBuffer, VkDescriptorSet set)
+{
+	dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	dispatch->vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+}
+
+void ComputePipeline::recordPushConstants(VkCommandBuffer commandBuffer, const void* data)
+{
+	dispatch->vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, data);
+}
+
+void ComputePipeline::recordDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	dispatch->vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void ComputePipeline::recordDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset)
+{
+	dispatch->vkCmdDispatchIndirect(commandBuffer, buffer, offset);
+}
+
+void ComputePipeline::recordBarrier(VkCommandBuffer commandBuffer)
+{
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+		| VK_ACCESS_TRANSFER_READ_BIT;
+	dispatch->vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+VkPipeline ComputePipeline::getHandle()
+{
+	return pipeline;
+}
+
+VkPipelineLayout ComputePipeline::getLayout()
+{
+	return pipelineLayout;
+}
+
+uint32_t ComputePipeline::getGroupCount(uint32_t count, uint32_t groupSize)
+{
+	return (count + groupSize - 1) / groupSize;
+}
+
+void ComputePipeline::createDescriptors(uint32_t maxSets)
+{
+	std::vector<VkDescriptorSetLayoutBinding> bindings(bindingTypes.size());
+	std::vector<VkDescriptorPoolSize> poolSizes{};
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = bindingTypes[i];
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		bool found = false;
+		for (VkDescriptorPoolSize& poolSize : poolSizes) {
+			if (poolSize.type == bindingTypes[i]) {
+				poolSize.descriptorCount += maxSets;
+				found = true;
+			}
+		}
+		if (!found) {
+			poolSizes.push_back({bindingTypes[i], maxSets});
+		}
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+	VkResult result = dispatch->vkCreateDescriptorSetLayout(deviceHandle, &layoutInfo, allocator, &setLayout); VK_CHECK(result);
+
+	// A pool needs at least one size even if the shader has no bindings
+	if (poolSizes.empty()) {
+		poolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1});
+	}
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = maxSets;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	result = dispatch->vkCreateDescriptorPool(deviceHandle, &poolInfo, allocator, &descriptorPool); VK_CHECK(result);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+
+#include "LogicalDevice.h"
+
+// A compute shader with one descriptor set and an optional push constant block.
+// Sets are allocated from a pool owned by the pipeline and can be bound to any pipeline
+// created with the same bindings.
+class ComputePipeline
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create any resources, must call init
+	 */
+	ComputePipeline();
+
+	/**
+	 * @brief Creates the set layout, pipeline layout, pipeline and descriptor pool
+	 *
+	 * @param device - the logical device to create the resources under
+	 * @param shaderName - file name of the compiled shader inside the shader directory, such as "Scan.comp.spv"
+	 * @param bindings - descriptor type of every binding in set 0, binding i has type bindings[i]
+	 * @param pushConstantSize - bytes of the push constant block, 0 if the shader has none. At most 128.
+	 * @param maxSets - descriptor sets that can be allocated with allocateSet
+	 * @param specialization - values of the specialization constants, constant_id i gets specialization[i]
+	 */
+	void init(LogicalDevice& device, const std::string& shaderName, const std::vector<VkDescriptorType>& bindings,
+		uint32_t pushConstantSize = 0, uint32_t maxSets = 1, const std::vector<uint32_t>& specialization = {});
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~ComputePipeline();
+
+	/**
+	 * @brief Destroys all resources, which frees every allocated set. The device must not be using them anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Allocates a descriptor set with the pipeline's bindings.
+	 * Throws an error once maxSets were allocated since init or resetSets.
+	 */
+	VkDescriptorSet allocateSet();
+
+	/**
+	 * @brief Frees every set allocated from this pipeline. The device must not be using them anymore.
+	 */
+	void resetSets();
+
+	/**
+	 * @brief Points a buffer binding of a set at a buffer. The set must not be in use by a pending command buffer.
+	 *
+	 * @param set - set from allocateSet
+	 * @param binding - index of a storage or uniform buffer binding
+	 * @param buffer - the buffer to bind
+	 * @param offset - start of the bound range in bytes
+	 * @param range - size of the bound range in bytes, VK_WHOLE_SIZE for the rest of the buffer
+	 */
+	void writeBuffer(VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+	/**
+	 * @brief Points an image binding of a set at an image view, such as for image processing.
+	 *
+	 * @param set - set from allocateSet
+	 * @param binding - index of a storage image, sampled image or combined image sampler binding
+	 * @param view - the image view to bind
+	 * @param layout - layout the image is in while the shader runs, usually VK_IMAGE_LAYOUT_GENERAL for storage images
+	 * @param sampler - sampler of a combined image sampler, nullptr for other types
+	 */
+	void writeImage(VkDescriptorSet set, uint32_t binding, VkImageView view, VkImageLayout layout, VkSampler sampler = nullptr);
+
+	/**
+	 * @brief Binds the pipeline and a set
+	 *
+	 * @param commandBuffer - command buffer in the recording state on a queue that supports compute
+	 * @param set - set from allocateSet of this pipeline or one with the same bindings
+	 */
+	void recordBind(VkCommandBuffer commandBuffer, VkDescriptorSet set);
+
+	/**
+	 * @brief Sets the push constant block for the following dispatches
+	 *
+	 * @param data - pushConstantSize bytes, laid out like the shader's push_constant block
+	 */
+	void recordPushConstants(VkCommandBuffer commandBuffer, const void* data);
+
+	/**
+	 * @brief Records a dispatch of the bound pipeline
+	 *
+	 * @param groupCountX - workgroups in x, such as getGroupCount(elements, local_size_x)
+	 */
+	void recordDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
+	/**
+	 * @brief Records a dispatch whose workgroup counts are read from a buffer when it executes,
+	 * such as counts written by an earlier dispatch
+	 *
+	 * @param buffer - buffer with VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT holding a VkDispatchIndirectCommand
+	 * @param offset - byte offset of the command in buffer, a multiple of 4
+	 */
+	void recordDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset = 0);
+
+	/**
+	 * @brief Records a barrier that makes compute shader writes visible to following dispatches,
+	 * indirect dispatch and draw reads, and transfers
+	 */
+	void recordBarrier(VkCommandBuffer commandBuffer);
+
+	VkPipeline getHandle();
+	VkPipelineLayout getLayout();
+
+	/**
+	 * @brief Returns the workgroups needed to cover count invocations
+	 */
+	static uint32_t getGroupCount(uint32_t count, uint32_t groupSize);
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	uint32_t pushConstantSize;
+	std::vector<VkDescriptorType> bindingTypes;
+
+	VkDescriptorSetLayout setLayout;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+	VkDescriptorPool descriptorPool;
+
+	void createDescriptors(uint32_t maxSets);
+};
@@ -0,0 +1,249 @@
+#include "ParallelPrimitives.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+#include "GpuProfiler.h"
+
+namespace {
+	// Digits of one radix sort pass, must match RADIX in Primitives.comp
+	constexpr uint32_t RADIX = 256;
+	constexpr uint32_t RADIX_PASSES = 4;
+
+	const std::vector<VkDescriptorType> bindingTypes = {
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+	};
+}
+
+ParallelPrimitives::ParallelPrimitives() :
+	dispatch(nullptr),
+	maxElements(0),
+	subgroups(false),
+	profiler(nullptr),
+	cachedSets{}
+{
+}
+
+void ParallelPrimitives::init(LogicalDevice& device, uint32_t _maxElements)
+{
+	dispatch = &device.getDispatch();
+	maxElements = std::max(_maxElements, 1u);
+	subgroups = device.supportsComputeSubgroups();
+
+	uint32_t pushSize = sizeof(Constants);
+	scanPipeline.init(device, subgroups ? "ScanSubgroups.comp.spv" : "Scan.comp.spv", bindingTypes, pushSize, MAX_CACHED_SETS);
+	scanAddPipeline.init(device, "ScanAdd.comp.spv", bindingTypes, pushSize);
+	reducePipeline.init(device, subgroups ? "ReduceSubgroups.comp.spv" : "Reduce.comp.spv", bindingTypes, pushSize);
+	histogramPipeline.init(device, "RadixHistogram.comp.spv", bindingTypes, pushSize);
+	scatterPipeline.init(device, "RadixScatter.comp.spv", bindingTypes, pushSize);
+
+	// The radix sort scans its digit counts, which takes more than scanning the elements themselves
+	uint32_t histogramSize = RADIX * getBlockCount(maxElements);
+	uint32_t scratchElements = std::max(getScanScratch(maxElements), histogramSize + getScanScratch(histogramSize));
+	scratchBuffer.init(device, sizeof(uint32_t) * scratchElements, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	keysTemp.init(device, sizeof(uint32_t) * maxElements, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	valuesTemp.init(device, sizeof(uint32_t) * maxElements, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	scratchBuffer.setName("ParallelPrimitives scratch");
+	keysTemp.setName("ParallelPrimitives keys");
+	valuesTemp.setName("ParallelPrimitives values");
+}
+
+ParallelPrimitives::~ParallelPrimitives()
+{
+	cleanup();
+}
+
+void ParallelPrimitives::cleanup()
+{
+	if (dispatch) {
+		cachedSets.clear();
+		valuesTemp.cleanup();
+		keysTemp.cleanup();
+		scratchBuffer.cleanup();
+		scatterPipeline.cleanup();
+		histogramPipeline.cleanup();
+		reducePipeline.cleanup();
+		scanAddPipeline.cleanup();
+		scanPipeline.cleanup();
+		dispatch = nullptr;
+	}
+}
+
+void ParallelPrimitives::recordExclusiveScan(VkCommandBuffer commandBuffer, VkBuffer input, VkBuffer output, uint32_t count)
+{
+	if (count == 0) {
+		return;
+	}
+	if (count > maxElements) {
+		throw std::runtime_error("scan of more elements than the maximum given to init");
+	}
+	CommandLabel label(*dispatch, commandBuffer, "Exclusive scan");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Exclusive scan");
+	VkDescriptorSet set = getSet(input, output, valuesTemp.getHandle(), valuesTemp.getHandle());
+	recordScanLevel(commandBuffer, set, 0, 0, count, 0);
+}
+
+void ParallelPrimitives::recordReduce(VkCommandBuffer commandBuffer, VkBuffer input, VkBuffer output, uint32_t count)
+{
+	if (count > maxElements) {
+		throw std::runtime_error("reduce of more elements than the maximum given to init");
+	}
+	CommandLabel label(*dispatch, commandBuffer, "Reduce");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Reduce");
+	VkBuffer scratch = scratchBuffer.getHandle();
+
+	// Every level sums the block totals of the one before until a single block is left, which writes to output
+	Constants constants{};
+	constants.count = count;
+	VkBuffer levelInput = input;
+	while (true) {
+		constants.blockCount = getBlockCount(constants.count);
+		bool last = constants.blockCount == 1;
+		constants.outputOffset = last ? 0 : constants.inputOffset + (levelInput == scratch ? constants.count : 0);
+
+		reducePipeline.recordBind(commandBuffer, getSet(levelInput, last ? output : scratch,
+			valuesTemp.getHandle(), valuesTemp.getHandle()));
+		reducePipeline.recordPushConstants(commandBuffer, &constants);
+		reducePipeline.recordDispatch(commandBuffer, constants.blockCount);
+		reducePipeline.recordBarrier(commandBuffer);
+		if (last) {
+			break;
+		}
+		levelInput = scratch;
+		constants.inputOffset = constants.outputOffset;
+		constants.count = constants.blockCount;
+	}
+}
+
+void ParallelPrimitives::recordRadixSort(VkCommandBuffer commandBuffer, VkBuffer keys, VkBuffer values, uint32_t count)
+{
+	if (count == 0) {
+		return;
+	}
+	if (count > maxElements) {
+		throw std::runtime_error("sort of more elements than the maximum given to init");
+	}
+	CommandLabel label(*dispatch, commandBuffer, "Radix sort");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Radix sort");
+	bool hasValues = values != VK_NULL_HANDLE;
+	VkBuffer valuesBuffer = hasValues ? values : valuesTemp.getHandle();
+	VkBuffer scratch = scratchBuffer.getHandle();
+
+	// Even passes go from the caller's buffers to the temporary ones, odd passes back,
+	// so the sorted keys end up where they started
+	VkDescriptorSet toTemp = getSet(keys, keysTemp.getHandle(), valuesBuffer, valuesTemp.getHandle());
+	VkDescriptorSet fromTemp = getSet(keysTemp.getHandle(), keys, valuesTemp.getHandle(), valuesBuffer);
+	VkDescriptorSet scratchSet = getSet(scratch, scratch, scratch, scratch);
+
+	Constants constants{};
+	constants.count = count;
+	constants.blockCount = getBlockCount(count);
+	constants.hasValues = hasValues ? 1 : 0;
+	uint32_t histogramSize = RADIX * constants.blockCount;
+	for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+		VkDescriptorSet set = pass % 2 == 0 ? toTemp : fromTemp;
+		constants.shift = pass * 8;
+
+		histogramPipeline.recordBind(commandBuffer, set);
+		histogramPipeline.recordPushConstants(commandBuffer, &constants);
+		histogramPipeline.recordDispatch(commandBuffer, constants.blockCount);
+		histogramPipeline.recordBarrier(commandBuffer);
+
+		recordScanLevel(commandBuffer, scratchSet, 0, 0, histogramSize, histogramSize);
+
+		scatterPipeline.recordBind(commandBuffer, set);
+		scatterPipeline.recordPushConstants(commandBuffer, &constants);
+		scatterPipeline.recordDispatch(commandBuffer, constants.blockCount);
+		scatterPipeline.recordBarrier(commandBuffer);
+	}
+}
+
+bool ParallelPrimitives::usesSubgroups()
+{
+	return subgroups;
+}
+
+void ParallelPrimitives::clearCache()
+{
+	scanPipeline.resetSets();
+	cachedSets.clear();
+}
+
+void ParallelPrimitives::setProfiler(GpuProfiler* _profiler)
+{
+	profiler = _profiler;
+}
+
+VkDescriptorSet ParallelPrimitives::getSet(VkBuffer input, VkBuffer output, VkBuffer valuesIn, VkBuffer valuesOut)
+{
+	for (const CachedSet& cached : cachedSets) {
+		if (cached.buffers[0] == input && cached.buffers[1] == output
+			&& cached.buffers[2] == valuesIn && cached.buffers[3] == valuesOut) {
+			return cached.set;
+		}
+	}
+	if (cachedSets.size() >= MAX_CACHED_SETS) {
+		throw std::runtime_error("too many buffer combinations for the parallel primitives, call clearCache");
+	}
+
+	VkDescriptorSet set = scanPipeline.allocateSet();
+	scanPipeline.writeBuffer(set, 0, input);
+	scanPipeline.writeBuffer(set, 1, output);
+	scanPipeline.writeBuffer(set, 2, scratchBuffer.getHandle());
+	scanPipeline.writeBuffer(set, 3, valuesIn);
+	scanPipeline.writeBuffer(set, 4, valuesOut);
+	cachedSets.push_back({{input, output, valuesIn, valuesOut}, set});
+	return set;
+}
+
+void ParallelPrimitives::recordScanLevel(VkCommandBuffer commandBuffer, VkDescriptorSet set, uint32_t inputOffset,
+	uint32_t outputOffset, uint32_t count, uint32_t partialOffset)
+{
+	Constants constants{};
+	constants.count = count;
+	constants.inputOffset = inputOffset;
+	constants.outputOffset = outputOffset;
+	constants.partialOffset = partialOffset;
+	constants.blockCount = getBlockCount(count);
+
+	scanPipeline.recordBind(commandBuffer, set);
+	scanPipeline.recordPushConstants(commandBuffer, &constants);
+	scanPipeline.recordDispatch(commandBuffer, constants.blockCount);
+	scanPipeline.recordBarrier(commandBuffer);
+	if (constants.blockCount == 1) {
+		return;
+	}
+
+	// Scanning the block totals in place turns them into the offset of every block
+	VkBuffer scratch = scratchBuffer.getHandle();
+	recordScanLevel(commandBuffer, getSet(scratch, scratch, scratch, scratch), partialOffset, partialOffset,
+		constants.blockCount, partialOffset + constants.blockCount);
+
+	scanAddPipeline.recordBind(commandBuffer, set);
+	scanAddPipeline.recordPushConstants(commandBuffer, &constants);
+	scanAddPipeline.recordDispatch(commandBuffer, constants.blockCount);
+	scanAddPipeline.recordBarrier(commandBuffer);
+}
+
+uint32_t ParallelPrimitives::getScanScratch(uint32_t count)
+{
+	// Every level writes one total per block, down to the level with a single block
+	uint32_t scratch = 0;
+	do {
+		count = getBlockCount(count);
+		scratch += count;
+	} while (count > 1);
+	return scratch;
+}
+
+uint32_t ParallelPrimitives::getBlockCount(uint32_t count)
+{
+	return std::max((count + BLOCK_SIZE - 1) / BLOCK_SIZE, 1u);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "Buffer.h"
+#include "ComputePipeline.h"
+
+class GpuProfiler;
+
+// Scan, reduce and radix sort of uint32_t arrays on the GPU. Every call records dispatches into the caller's
+// command buffer, with barriers between them, so several calls can be batched into one submission.
+// The workgroup wide sums use subgroup arithmetic when the device supports it.
+// Buffers passed in need VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, the results are visible to compute shaders,
+// indirect reads and transfers after the recorded commands.
+class ParallelPrimitives
+{
+public:
+	// Elements handled by one workgroup, must match BLOCK_SIZE in Primitives.comp
+	static constexpr uint32_t BLOCK_SIZE = 1024;
+
+	/**
+	 * @brief Default Constructor: Doesn't create any resources, must call init
+	 */
+	ParallelPrimitives();
+
+	/**
+	 * @brief Loads the pipelines and creates the scratch buffers
+	 *
+	 * @param device - the logical device to create the resources under
+	 * @param maxElements - most elements of one call, the scratch buffers are sized for it.
+	 * At most BLOCK_SIZE * 65535 so the first level fits the guaranteed workgroup count.
+	 */
+	void init(LogicalDevice& device, uint32_t maxElements);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~ParallelPrimitives();
+
+	/**
+	 * @brief Destroys all resources. The device must not be using them anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Records an exclusive prefix sum, output[i] is the sum of input[0] to input[i - 1]
+	 *
+	 * @param commandBuffer - command buffer in the recording state on a queue that supports compute
+	 * @param input - count uint32_t values
+	 * @param output - receives count values, can be input to scan in place
+	 * @param count - elements to scan, at most maxElements
+	 */
+	void recordExclusiveScan(VkCommandBuffer commandBuffer, VkBuffer input, VkBuffer output, uint32_t count);
+
+	/**
+	 * @brief Records a sum of every element, wrapping on overflow
+	 *
+	 * @param input - count uint32_t values
+	 * @param output - receives the sum in its first uint32_t
+	 * @param count - elements to sum, at most maxElements
+	 */
+	void recordReduce(VkCommandBuffer commandBuffer, VkBuffer input, VkBuffer output, uint32_t count);
+
+	/**
+	 * @brief Records a stable ascending sort of the keys in place, 4 passes of 8 bits
+	 *
+	 * @param keys - count uint32_t keys, sorted in place
+	 * @param values - count uint32_t values moved along with their keys, VK_NULL_HANDLE to only sort the keys
+	 * @param count - elements to sort, at most maxElements
+	 */
+	void recordRadixSort(VkCommandBuffer commandBuffer, VkBuffer keys, VkBuffer values, uint32_t count);
+
+	/**
+	 * @brief Returns whether the subgroup variants of the shaders were loaded
+	 */
+	bool usesSubgroups();
+
+	/**
+	 * @brief Frees the descriptor sets kept for the buffers of earlier calls.
+	 * Call when those buffers are destroyed, no recorded command buffer may still use the sets.
+	 */
+	void clearCache();
+
+	/**
+	 * @brief Times every scan, reduce and sort as a GPU zone, does nothing without APPARATUS_TRACY
+	 *
+	 * @param _profiler - initialized profiler of the queue the commands are submitted to, nullptr to stop
+	 */
+	void setProfiler(GpuProfiler* _profiler);
+
+private:
+	// Must match the push constants of Primitives.comp
+	struct Constants
+	{
+		uint32_t count;
+		uint32_t inputOffset;
+		uint32_t outputOffset;
+		uint32_t partialOffset;
+		uint32_t shift;
+		uint32_t blockCount;
+		uint32_t hasValues;
+		uint32_t padding;
+	};
+
+	struct CachedSet
+	{
+		VkBuffer buffers[4];
+		VkDescriptorSet set;
+	};
+
+	// Descriptor sets for different buffer combinations, each one is written once
+	static constexpr uint32_t MAX_CACHED_SETS = 64;
+
+	const DeviceDispatch* dispatch;
+	uint32_t maxElements;
+	bool subgroups;
+	GpuProfiler* profiler;
+
+	// scanPipeline also owns the descriptor pool, every pipeline has the same set layout
+	ComputePipeline scanPipeline;
+	ComputePipeline scanAddPipeline;
+	ComputePipeline reducePipeline;
+	ComputePipeline histogramPipeline;
+	ComputePipeline scatterPipeline;
+
+	// Block totals of every scan level, and the digit counts of the radix sort
+	Buffer scratchBuffer;
+	// Ping pong targets of the radix sort passes
+	Buffer keysTemp;
+	Buffer valuesTemp;
+	std::vector<CachedSet> cachedSets;
+
+	/**
+	 * @brief Returns a set with input, output, the scratch buffer, valuesIn and valuesOut at bindings 0 to 4.
+	 * Throws an error once MAX_CACHED_SETS combinations were used since the last clearCache.
+	 */
+	VkDescriptorSet getSet(VkBuffer input, VkBuffer output, VkBuffer valuesIn, VkBuffer valuesOut);
+
+	/**
+	 * @brief Records the scan of one level and recurses over its block totals
+	 *
+	 * @param set - set with the level's input and output
+	 * @param inputOffset - first element of the input
+	 * @param outputOffset - first element of the output
+	 * @param partialOffset - where the level's block totals go in the scratch buffer, the levels below follow them
+	 */
+	void recordScanLevel(VkCommandBuffer commandBuffer, VkDescriptorSet set, uint32_t inputOffset, uint32_t outputOffset,
+		uint32_t count, uint32_t partialOffset);
+
+	/**
+	 * @brief Returns the scratch elements a scan of count elements needs for its block totals
+	 */
+	static uint32_t getScanScratch(uint32_t count);
+
+	static uint32_t getBlockCount(uint32_t count);
+};
@@ -0,0 +1,74 @@
+#include "FrameArena.h"
+
+FrameArena::FrameArena() :
+	current(0)
+{
+}
+
+void FrameArena::init(size_t capacity)
+{
+	arenas[0].init(capacity);
+	arenas[1].init(capacity);
+	current = 0;
+}
+
+FrameArena::~FrameArena()
+{
+	cleanup();
+}
+
+void FrameArena::cleanup()
+{
+	arenas[1].cleanup();
+	arenas[0].cleanup();
+}
+
+void FrameArena::beginFrame()
+{
+	current = 1 - current;
+	arenas[current].reset();
+}
+
+LinearArena& FrameArena::get()
+{
+	return arenas[current];
+}
+
+std::pmr::memory_resource* FrameArena::getResource()
+{
+	return &arenas[current];
+}
+
+ScratchScope::ScratchScope() :
+	arena(getThreadArena()),
+	marker(arena.getMarker())
+{
+}
+
+ScratchScope::~ScratchScope()
+{
+	if (marker.offset == 0 && marker.overflowCount == 0) {
+		arena.reset();
+	} else {
+		arena.rewind(marker);
+	}
+}
+
+LinearArena& ScratchScope::get()
+{
+	return arena;
+}
+
+std::pmr::memory_resource* ScratchScope::getResource()
+{
+	return &arena;
+}
+
+LinearArena& ScratchScope::getThreadArena()
+{
+	thread_local LinearArena threadArena;
+	if (threadArena.getCapacity() == 0) {
+		threadArena.init(SCRATCH_ARENA_SIZE);
+	}
+	return threadArena;
+}
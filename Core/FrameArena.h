@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+#include "LinearArena.h"
+
+// Size each thread's scratch arena starts with
+constexpr size_t SCRATCH_ARENA_SIZE = 256 * 1024;
+
+// Memory for transient data of one frame. Two arenas take turns, so data allocated during a frame stays
+// valid through the next one, such as lists still read by the GPU or another thread, and is freed when
+// the frame after that begins. Not thread safe, other threads use ScratchScope.
+class FrameArena
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't allocate anything, must call init
+	 */
+	FrameArena();
+
+	/**
+	 * @brief Allocates both arenas
+	 *
+	 * @param capacity - bytes of each arena, they grow when a frame needed more
+	 */
+	void init(size_t capacity);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~FrameArena();
+
+	/**
+	 * @brief Frees both arenas
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Switches to the other arena and resets it, which frees the data of the frame before last.
+	 * Call once at the start of every frame.
+	 */
+	void beginFrame();
+
+	/**
+	 * @brief Returns the arena of the current frame
+	 */
+	LinearArena& get();
+
+	/**
+	 * @brief Returns the arena of the current frame for pmr containers,
+	 * such as std::pmr::vector<T> list(frameArena.getResource())
+	 */
+	std::pmr::memory_resource* getResource();
+
+private:
+	LinearArena arenas[2];
+	uint32_t current;
+};
+
+// Gives access to the calling thread's scratch arena and frees everything allocated from it
+// once the scope ends. Scopes may nest, the outermost one resets the arena so it grows if needed.
+class ScratchScope
+{
+public:
+	ScratchScope();
+	~ScratchScope();
+
+	ScratchScope(const ScratchScope&) = delete;
+	ScratchScope& operator=(const ScratchScope&) = delete;
+
+	LinearArena& get();
+	std::pmr::memory_resource* getResource();
+
+private:
+	LinearArena& arena;
+	ArenaMarker marker;
+
+	static LinearArena& getThreadArena();
+};
@@ -0,0 +1,104 @@
+#include "LinearArena.h"
+
+#include <algorithm>
+#include <new>
+
+LinearArena::LinearArena() :
+	capacity(0),
+	offset(0),
+	overflowBytes(0),
+	peak(0),
+	overflowCount(0)
+{
+}
+
+void LinearArena::init(size_t _capacity)
+{
+	capacity = _capacity;
+	block = std::make_unique<std::byte[]>(capacity);
+	offset = 0;
+	overflowBytes = 0;
+	peak = 0;
+	overflowCount = 0;
+}
+
+LinearArena::~LinearArena()
+{
+	cleanup();
+}
+
+void LinearArena::cleanup()
+{
+	rewind({0, 0});
+	block.reset();
+	capacity = 0;
+}
+
+void LinearArena::reset()
+{
+	peak = std::max(peak, getUsed());
+	rewind({0, 0});
+	// Only grow while nothing is allocated, so earlier allocations never move
+	if (peak > capacity) {
+		capacity = std::max(peak, capacity * 2);
+		block = std::make_unique<std::byte[]>(capacity);
+	}
+}
+
+ArenaMarker LinearArena::getMarker()
+{
+	return {offset, overflow.size()};
+}
+
+void LinearArena::rewind(ArenaMarker marker)
+{
+	peak = std::max(peak, getUsed());
+	offset = marker.offset;
+	while (overflow.size() > marker.overflowCount) {
+		const Overflow& allocation = overflow.back();
+		::operator delete(allocation.memory, std::align_val_t(allocation.alignment));
+		overflowBytes -= allocation.size;
+		overflow.pop_back();
+	}
+}
+
+size_t LinearArena::getUsed()
+{
+	return offset + overflowBytes;
+}
+
+size_t LinearArena::getCapacity()
+{
+	return capacity;
+}
+
+uint64_t LinearArena::getOverflowCount()
+{
+	return overflowCount;
+}
+
+void* LinearArena::do_allocate(size_t size, size_t alignment)
+{
+	uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+	size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+	if (block && aligned + size <= capacity) {
+		offset = aligned + size;
+		return block.get() + aligned;
+	}
+
+	void* memory = ::operator new(size, std::align_val_t(alignment));
+	overflow.push_back({memory, size, alignment});
+	overflowBytes += size;
+	overflowCount++;
+	return memory;
+}
+
+void LinearArena::do_deallocate(void*, size_t, size_t)
+{
+	// Memory is only given back by reset and rewind
+}
+
+bool LinearArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Position in a LinearArena that it can be rewound to
+struct ArenaMarker
+{
+	size_t offset;
+	size_t overflowCount;
+};
+
+// Bump allocator: an allocation is a pointer increment and nothing is freed until the arena is reset
+// or rewound. Allocations that don't fit in the block go to the heap and are freed on reset, which then
+// grows the block so the next round fits. Usable as a std::pmr::memory_resource, such as for
+// std::pmr::vector, where deallocate does nothing. Not thread safe.
+class LinearArena : public std::pmr::memory_resource
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't allocate the block, must call init
+	 */
+	LinearArena();
+
+	/**
+	 * @brief Allocates the block
+	 *
+	 * @param capacity - bytes of the block, it grows on reset when a round needed more
+	 */
+	void init(size_t capacity);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~LinearArena();
+
+	/**
+	 * @brief Frees the block and every overflow allocation
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Constructs an array of count default initialized T, their destructors are never called
+	 */
+	template<typename T>
+	T* allocateArray(size_t count);
+
+	/**
+	 * @brief Frees everything allocated since init or the last reset
+	 */
+	void reset();
+
+	/**
+	 * @brief Returns the current position, allocations made after it are freed by rewind
+	 */
+	ArenaMarker getMarker();
+	void rewind(ArenaMarker marker);
+
+	/**
+	 * @brief Returns the bytes allocated since the last reset, including overflow and alignment padding
+	 */
+	size_t getUsed();
+	size_t getCapacity();
+
+	/**
+	 * @brief Returns the number of allocations that didn't fit in the block since init
+	 */
+	uint64_t getOverflowCount();
+
+private:
+	struct Overflow
+	{
+		void* memory;
+		size_t size;
+		size_t alignment;
+	};
+
+	std::unique_ptr<std::byte[]> block;
+	size_t capacity;
+	size_t offset;
+	std::vector<Overflow> overflow;
+	size_t overflowBytes;
+	// Most bytes used by one round, the block grows to it on reset
+	size_t peak;
+	uint64_t overflowCount;
+
+	void* do_allocate(size_t size, size_t alignment) override;
+	void do_deallocate(void* memory, size_t size, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+template<typename T>
+T* LinearArena::allocateArray(size_t count)
+{
+	T* memory = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	for (size_t i = 0; i < count; i++) {
+		new (&memory[i]) T;
+	}
+	return memory;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+// CPU instrumentation for the Tracy profiler, enabled by the APPARATUS_TRACY build option.
+// Without it every macro expands to nothing and the mutex types are the plain standard ones,
+// so instrumented code costs nothing. GPU zones are in Graphics/GpuProfiler.h.
+
+#ifdef APPARATUS_TRACY
+
+#include <tracy/Tracy.hpp>
+
+// Times the enclosing scope under the function's name
+#define PROFILE_ZONE() ZoneScoped
+// Times the enclosing scope under a string literal
+#define PROFILE_ZONE_NAMED(name) ZoneScopedN(name)
+// Ends a frame on the timeline, called once per frame from the main loop
+#define PROFILE_FRAME() FrameMark
+// Names the calling thread on the timeline, the string has to outlive the thread
+#define PROFILE_THREAD_NAME(name) tracy::SetThreadName(name)
+// Plots a number over time, such as a queue length
+#define PROFILE_PLOT(name, value) TracyPlot(name, value)
+// Tracks a heap allocation in a named pool, the name has to be a string literal
+#define PROFILE_ALLOC(pointer, size, pool) TracyAllocN(pointer, size, pool)
+#define PROFILE_FREE(pointer, pool) TracyFreeN(pointer, pool)
+
+// Declares a member std::mutex whose waits and holds show on the timeline, lock it as a ProfiledMutex
+#define PROFILED_MUTEX(name) TracyLockable(std::mutex, name)
+using ProfiledMutex = tracy::Lockable<std::mutex>;
+// Waits on a ProfiledMutex
+using ProfiledConditionVariable = std::condition_variable_any;
+
+#else
+
+#define PROFILE_ZONE()
+#define PROFILE_ZONE_NAMED(name)
+#define PROFILE_FRAME()
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_PLOT(name, value)
+#define PROFILE_ALLOC(pointer, size, pool)
+#define PROFILE_FREE(pointer, pool)
+
+#define PROFILED_MUTEX(name) std::mutex name
+using ProfiledMutex = std::mutex;
+using ProfiledConditionVariable = std::condition_variable;
+
+#endif
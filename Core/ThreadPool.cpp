@@ -0,0 +1,113 @@
+#include "ThreadPool.h"
+
+#include <memory>
+
+ThreadPool::ThreadPool() :
+	stopping(false)
+{
+}
+
+void ThreadPool::init(uint32_t threadCount)
+{
+	if (threadCount == 0) {
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	stopping = false;
+	for (uint32_t i = 0; i < threadCount; i++) {
+		threads.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	cleanup();
+}
+
+void ThreadPool::cleanup()
+{
+	{
+		std::lock_guard<ProfiledMutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	threads.clear();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	if (threads.empty()) {
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<ProfiledMutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	condition.notify_one();
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& job)
+{
+	if (count == 0) {
+		return;
+	}
+	PROFILE_ZONE();
+
+	// Indices are handed out through a shared counter so fast threads take more of them
+	struct Work
+	{
+		std::atomic<uint32_t> next{0};
+		std::atomic<uint32_t> finished{0};
+	};
+	auto work = std::make_shared<Work>();
+	auto run = [work, count, &job]() {
+		for (uint32_t i = work->next.fetch_add(1); i < count; i = work->next.fetch_add(1)) {
+			job(i);
+			work->finished.fetch_add(1, std::memory_order_release);
+		}
+	};
+
+	uint32_t helpers = static_cast<uint32_t>(threads.size());
+	if (helpers > count - 1) {
+		helpers = count - 1;
+	}
+	for (uint32_t i = 0; i < helpers; i++) {
+		submit(run);
+	}
+	run();
+
+	// Helpers that start after every index was taken return immediately, so only running jobs are waited on
+	while (work->finished.load(std::memory_order_acquire) < count) {
+		std::this_thread::yield();
+	}
+}
+
+uint32_t ThreadPool::getThreadCount()
+{
+	return static_cast<uint32_t>(threads.size());
+}
+
+void ThreadPool::workerLoop()
+{
+	PROFILE_THREAD_NAME("Worker");
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<ProfiledMutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (tasks.empty()) {
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		PROFILE_ZONE_NAMED("Task");
+		task();
+	}
+}
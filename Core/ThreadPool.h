@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Profiler.h"
+
+class ThreadPool
+{
+public:
+	/**
+	 * @brief Default Constructor: No threads are started, must call init
+	 */
+	ThreadPool();
+
+	/**
+	 * @brief Starts the worker threads.
+	 * 
+	 * @param threadCount - number of worker threads, 0 uses one less than the hardware thread count
+	 * so the calling thread can take part in parallelFor
+	 */
+	void init(uint32_t threadCount = 0);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to join the threads
+	 */
+	~ThreadPool();
+
+	/**
+	 * @brief Finishes every submitted task and joins the worker threads
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Runs a task on a worker thread. Runs it on the calling thread if the pool has no threads.
+	 */
+	void submit(std::function<void()> task);
+
+	/**
+	 * @brief Calls job(i) for every i in [0, count) spread over the worker threads and the calling thread.
+	 * Returns once every call finished.
+	 * 
+	 * @param count - number of indices
+	 * @param job - called once per index, possibly from several threads at the same time
+	 */
+	void parallelFor(uint32_t count, const std::function<void(uint32_t)>& job);
+
+	/**
+	 * @brief Returns the number of worker threads, not counting the calling thread
+	 */
+	uint32_t getThreadCount();
+
+private:
+	std::vector<std::thread> threads;
+	std::deque<std::function<void()>> tasks;
+	PROFILED_MUTEX(mutex);
+	ProfiledConditionVariable condition;
+	bool stopping;
+
+	void workerLoop();
+};
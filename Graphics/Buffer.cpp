@@ -0,0 +1,87 @@
+#include "Buffer.h"
+
+#include "DebugMessenger.h"
+
+Buffer::Buffer() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	handle(nullptr),
+	memory(nullptr),
+	size(0),
+	mapped(nullptr)
+{
+}
+
+void Buffer::init(LogicalDevice& device, VkDeviceSize _size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+	const std::vector<uint32_t>& queueFamilies)
+{
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	size = _size;
+
+	VkBufferCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	createInfo.size = size;
+	createInfo.usage = usage;
+	if (queueFamilies.size() > 1) {
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		createInfo.pQueueFamilyIndices = queueFamilies.data();
+	} else {
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
+	VkResult result = dispatch->vkCreateBuffer(deviceHandle, &createInfo, allocator, &handle); VK_CHECK(result);
+
+	VkMemoryRequirements requirements;
+	dispatch->vkGetBufferMemoryRequirements(deviceHandle, handle, &requirements);
+
+	VkMemoryAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = device.findMemoryType(requirements.memoryTypeBits, properties);
+	result = dispatch->vkAllocateMemory(deviceHandle, &allocateInfo, allocator, &memory); VK_CHECK(result);
+	result = dispatch->vkBindBufferMemory(deviceHandle, handle, memory, 0); VK_CHECK(result);
+
+	if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		result = dispatch->vkMapMemory(deviceHandle, memory, 0, VK_WHOLE_SIZE, 0, &mapped); VK_CHECK(result);
+	}
+}
+
+Buffer::~Buffer()
+{
+	cleanup();
+}
+
+void Buffer::cleanup()
+{
+	if (deviceHandle) {
+		if (handle) {
+			dispatch->vkDestroyBuffer(deviceHandle, handle, allocator);
+			handle = nullptr;
+		}
+		if (memory) {
+			// Freeing the memory also unmaps it
+			dispatch->vkFreeMemory(deviceHandle, memory, allocator);
+			memory = nullptr;
+			mapped = nullptr;
+		}
+		deviceHandle = nullptr;
+	}
+}
+
+VkBuffer Buffer::getHandle()
+{
+	return handle;
+}
+
+VkDeviceSize Buffer::getSize()
+{
+	return size;
+}
+
+void* Buffer::getMapped()
+{
+	return mapped;
+}
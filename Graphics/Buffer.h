@@ -0,0 +1,82 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "DebugLabels.h"
+
+class Buffer
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create the buffer, must call init
+	 */
+	Buffer();
+
+	/**
+	 * @brief Creates a buffer and binds it to its own memory allocation.
+	 * Host visible buffers are persistently mapped.
+	 * 
+	 * @param device - the logical device to create the buffer under
+	 * @param size - size of the buffer in bytes
+	 * @param usage - how the buffer will be used
+	 * @param properties - properties the backing memory must have
+	 * @param queueFamilies - queue families that use the buffer. With more than one family the buffer is
+	 * shared concurrently so it needs no ownership transfers
+	 */
+	void init(LogicalDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+		const std::vector<uint32_t>& queueFamilies = {});
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~Buffer();
+
+	/**
+	 * @brief Destroys the buffer and frees its memory
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Returns the handle to this buffer.
+	 * 
+	 * @return buffer handle
+	 */
+	VkBuffer getHandle();
+
+	/**
+	 * @brief Returns the size in bytes given in init
+	 */
+	VkDeviceSize getSize();
+
+	/**
+	 * @brief Returns the mapped memory of a host visible buffer.
+	 * 
+	 * @return pointer to the start of the buffer, nullptr if the buffer isn't host visible
+	 */
+	void* getMapped();
+
+	/**
+	 * @brief Names the buffer and its memory in debuggers and GPU captures, compiles to nothing without APPARATUS_DEBUG_NAMES
+	 *
+	 * @param parts - strings and integers joined into the name, see setObjectName
+	 */
+	template <typename... Parts>
+	void setName(const Parts&... parts)
+	{
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_BUFFER, handle, parts...);
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_DEVICE_MEMORY, memory, parts..., " memory");
+	}
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkBuffer handle;
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	void* mapped;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <type_traits>
+
+#include "VulkanDispatch.h"
+
+// Object names and command buffer label regions from VK_EXT_debug_utils, shown in validation messages and
+// in RenderDoc, Tracy and other GPU captures. Everything compiles to nothing unless the build defines
+// APPARATUS_DEBUG_NAMES, and does nothing when the instance was created without the extension.
+// Names and labels are copied by the driver, so temporaries are fine.
+
+#ifdef APPARATUS_DEBUG_NAMES
+inline void appendNamePart(std::string& name, const char* part)
+{
+	name += part;
+}
+
+inline void appendNamePart(std::string& name, const std::string& part)
+{
+	name += part;
+}
+
+template <typename Integer, std::enable_if_t<std::is_integral_v<Integer>, int> = 0>
+inline void appendNamePart(std::string& name, Integer part)
+{
+	name += std::to_string(part);
+}
+#endif
+
+/**
+ * @brief Names a vulkan object. The name is joined from its parts only when names are compiled in,
+ * so callers pass indices as parts instead of building strings themselves.
+ *
+ * @param dispatch - functions of the device that created the object
+ * @param device - the device that created the object
+ * @param type - type of the object, such as VK_OBJECT_TYPE_BUFFER
+ * @param handle - the object, nullptr is ignored
+ * @param parts - strings and integers that make up the name to show, such as "Swapchain image ", i
+ */
+template <typename Handle, typename... Parts>
+inline void setObjectName(const DeviceDispatch& dispatch, VkDevice device, VkObjectType type, Handle handle, const Parts&... parts)
+{
+#ifdef APPARATUS_DEBUG_NAMES
+	if (dispatch.vkSetDebugUtilsObjectNameEXT == nullptr || !handle) {
+		return;
+	}
+
+	std::string name;
+	(appendNamePart(name, parts), ...);
+
+	VkDebugUtilsObjectNameInfoEXT nameInfo{};
+	nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+	nameInfo.objectType = type;
+	// Non-dispatchable handles are integers on 32 bit platforms
+	if constexpr (std::is_pointer_v<Handle>) {
+		nameInfo.objectHandle = reinterpret_cast<uint64_t>(handle);
+	} else {
+		nameInfo.objectHandle = static_cast<uint64_t>(handle);
+	}
+	nameInfo.pObjectName = name.c_str();
+	dispatch.vkSetDebugUtilsObjectNameEXT(device, &nameInfo);
+#else
+	(void)dispatch; (void)device; (void)type; (void)handle; ((void)parts, ...);
+#endif
+}
+
+/**
+ * @brief Opens a label region, every command until the matching endCommandLabel is grouped under it.
+ * Regions can nest but have to be closed in the same command buffer.
+ *
+ * @param commandBuffer - command buffer in the recording state
+ * @param name - name of the region, such as the pass
+ */
+inline void beginCommandLabel(const DeviceDispatch& dispatch, VkCommandBuffer commandBuffer, const char* name)
+{
+#ifdef APPARATUS_DEBUG_NAMES
+	if (dispatch.vkCmdBeginDebugUtilsLabelEXT == nullptr) {
+		return;
+	}
+
+	VkDebugUtilsLabelEXT label{};
+	label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+	label.pLabelName = name;
+	dispatch.vkCmdBeginDebugUtilsLabelEXT(commandBuffer, &label);
+#else
+	(void)dispatch; (void)commandBuffer; (void)name;
+#endif
+}
+
+/**
+ * @brief Closes the innermost label region opened by beginCommandLabel
+ */
+inline void endCommandLabel(const DeviceDispatch& dispatch, VkCommandBuffer commandBuffer)
+{
+#ifdef APPARATUS_DEBUG_NAMES
+	if (dispatch.vkCmdEndDebugUtilsLabelEXT == nullptr) {
+		return;
+	}
+
+	dispatch.vkCmdEndDebugUtilsLabelEXT(commandBuffer);
+#else
+	(void)dispatch; (void)commandBuffer;
+#endif
+}
+
+/**
+ * @brief Marks a single point in the command buffer, such as a dispatch without a region of its own
+ */
+inline void insertCommandLabel(const DeviceDispatch& dispatch, VkCommandBuffer commandBuffer, const char* name)
+{
+#ifdef APPARATUS_DEBUG_NAMES
+	if (dispatch.vkCmdInsertDebugUtilsLabelEXT == nullptr) {
+		return;
+	}
+
+	VkDebugUtilsLabelEXT label{};
+	label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+	label.pLabelName = name;
+	dispatch.vkCmdInsertDebugUtilsLabelEXT(commandBuffer, &label);
+#else
+	(void)dispatch; (void)commandBuffer; (void)name;
+#endif
+}
+
+// Label region for the lifetime of a scope, for record functions with several returns
+class CommandLabel
+{
+public:
+	/**
+	 * @brief Opens the region with beginCommandLabel
+	 */
+	CommandLabel(const DeviceDispatch& _dispatch, VkCommandBuffer _commandBuffer, const char* name) :
+		dispatch(_dispatch),
+		commandBuffer(_commandBuffer)
+	{
+		beginCommandLabel(dispatch, commandBuffer, name);
+	}
+
+	/**
+	 * @brief Destructor: Closes the region with endCommandLabel
+	 */
+	~CommandLabel()
+	{
+		endCommandLabel(dispatch, commandBuffer);
+	}
+
+	CommandLabel(const CommandLabel&) = delete;
+	CommandLabel& operator=(const CommandLabel&) = delete;
+
+private:
+	const DeviceDispatch& dispatch;
+	VkCommandBuffer commandBuffer;
+};
@@ -2,35 +2,86 @@
 
 #include <iostream>
 
+namespace {
+	std::function<std::string()> deviceLostHandler;
+	// Set while the handler runs, so its own vulkan errors don't call it again
+	thread_local bool handlingDeviceLost = false;
+}
+
 void logError(VkResult result, std::string file, std::string func, int line)
 {
 	if (result != VK_SUCCESS) {
-		throw std::runtime_error("VULKAN ERROR: " + std::to_string(result) + ", file: " + file + ", func: " + func + ", line: " + std::to_string(line));
+		std::string message = std::string("VULKAN ERROR: ") + resultToString(result) + " (" + std::to_string(result) + ")"
+			+ ", file: " + file + ", func: " + func + ", line: " + std::to_string(line);
+		if (result == VK_ERROR_DEVICE_LOST && deviceLostHandler && !handlingDeviceLost) {
+			handlingDeviceLost = true;
+			std::string report = deviceLostHandler();
+			handlingDeviceLost = false;
+			// Written before throwing, so the report survives even if nothing catches the error
+			std::cerr << message << '\n' << report << std::flush;
+			message += "\n" + report;
+		}
+		throw std::runtime_error(message);
 	}
 }
 
+const char* resultToString(VkResult result)
+{
+	switch (result) {
+	case VK_SUCCESS: return "VK_SUCCESS";
+	case VK_NOT_READY: return "VK_NOT_READY";
+	case VK_TIMEOUT: return "VK_TIMEOUT";
+	case VK_EVENT_SET: return "VK_EVENT_SET";
+	case VK_EVENT_RESET: return "VK_EVENT_RESET";
+	case VK_INCOMPLETE: return "VK_INCOMPLETE";
+	case VK_ERROR_OUT_OF_HOST_MEMORY: return "VK_ERROR_OUT_OF_HOST_MEMORY";
+	case VK_ERROR_OUT_OF_DEVICE_MEMORY: return "VK_ERROR_OUT_OF_DEVICE_MEMORY";
+	case VK_ERROR_INITIALIZATION_FAILED: return "VK_ERROR_INITIALIZATION_FAILED";
+	case VK_ERROR_DEVICE_LOST: return "VK_ERROR_DEVICE_LOST";
+	case VK_ERROR_MEMORY_MAP_FAILED: return "VK_ERROR_MEMORY_MAP_FAILED";
+	case VK_ERROR_LAYER_NOT_PRESENT: return "VK_ERROR_LAYER_NOT_PRESENT";
+	case VK_ERROR_EXTENSION_NOT_PRESENT: return "VK_ERROR_EXTENSION_NOT_PRESENT";
+	case VK_ERROR_FEATURE_NOT_PRESENT: return "VK_ERROR_FEATURE_NOT_PRESENT";
+	case VK_ERROR_INCOMPATIBLE_DRIVER: return "VK_ERROR_INCOMPATIBLE_DRIVER";
+	case VK_ERROR_TOO_MANY_OBJECTS: return "VK_ERROR_TOO_MANY_OBJECTS";
+	case VK_ERROR_FORMAT_NOT_SUPPORTED: return "VK_ERROR_FORMAT_NOT_SUPPORTED";
+	case VK_ERROR_FRAGMENTED_POOL: return "VK_ERROR_FRAGMENTED_POOL";
+	case VK_ERROR_OUT_OF_POOL_MEMORY: return "VK_ERROR_OUT_OF_POOL_MEMORY";
+	case VK_ERROR_SURFACE_LOST_KHR: return "VK_ERROR_SURFACE_LOST_KHR";
+	case VK_ERROR_NATIVE_WINDOW_IN_USE_KHR: return "VK_ERROR_NATIVE_WINDOW_IN_USE_KHR";
+	case VK_SUBOPTIMAL_KHR: return "VK_SUBOPTIMAL_KHR";
+	case VK_ERROR_OUT_OF_DATE_KHR: return "VK_ERROR_OUT_OF_DATE_KHR";
+	default: return "unknown result";
+	}
+}
+
+void setDeviceLostHandler(std::function<std::string()> handler)
+{
+	deviceLostHandler = std::move(handler);
+}
+
 VkResult createDebugUtilsMessengerEXT(
+	const InstanceDispatch& dispatch,
 	VkInstance instance,
 	VkDebugUtilsMessengerCreateInfoEXT const* createInfo,
-	VkAllocationCallbacks* allocator,
+	const VkAllocationCallbacks* allocator,
 	VkDebugUtilsMessengerEXT* handle)
 {
-	auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
-	if (func != nullptr) {
-		return func(instance, createInfo, allocator, handle);
+	if (dispatch.vkCreateDebugUtilsMessengerEXT != nullptr) {
+		return dispatch.vkCreateDebugUtilsMessengerEXT(instance, createInfo, allocator, handle);
 	}
 	// Returns an error if the function wasn't found
 	return VK_ERROR_EXTENSION_NOT_PRESENT;
 }
 
 void destroyDebugUtilsMessengerEXT(
+	const InstanceDispatch& dispatch,
 	VkInstance instance,
 	VkDebugUtilsMessengerEXT handle,
-	VkAllocationCallbacks* allocator)
+	const VkAllocationCallbacks* allocator)
 {
-	auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
-	if (func != nullptr) {
-		func(instance, handle, allocator);
+	if (dispatch.vkDestroyDebugUtilsMessengerEXT != nullptr) {
+		dispatch.vkDestroyDebugUtilsMessengerEXT(instance, handle, allocator);
 	} else {
 		// Shouldn't stop program
 		// TODO
@@ -40,16 +91,20 @@ void destroyDebugUtilsMessengerEXT(
 
 DebugMessenger::DebugMessenger() :
 	instanceHandle(nullptr),
-	handle(nullptr)
+	handle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr)
 {
 }
 
 void DebugMessenger::init(VulkanInstance& instance)
 {
 	instanceHandle = instance.getHandle();
+	allocator = instance.getAllocator();
+	dispatch = &instance.getDispatch();
 	auto createInfo = getCreateInfo();
 	// TODO test for nullptr instanceHandle
-	VkResult result = createDebugUtilsMessengerEXT(instanceHandle, &createInfo, nullptr, &handle); VK_CHECK(result);
+	VkResult result = createDebugUtilsMessengerEXT(*dispatch, instanceHandle, &createInfo, allocator, &handle); VK_CHECK(result);
 }
 
 DebugMessenger::~DebugMessenger()
@@ -60,7 +115,7 @@ DebugMessenger::~DebugMessenger()
 void DebugMessenger::cleanup()
 {
 	if (handle && instanceHandle) {
-		destroyDebugUtilsMessengerEXT(instanceHandle, handle, nullptr);
+		destroyDebugUtilsMessengerEXT(*dispatch, instanceHandle, handle, allocator);
 		handle = nullptr;
 		instanceHandle = nullptr;
 	}
@@ -3,27 +3,38 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <functional>
 #include <string>
 
 #include "VulkanInstance.h"
 
 #define VK_CHECK(result) logError(result, __FILE__, __func__, __LINE__)
 
-// Throws a runtime error if the result isn't VK_SUCCESS
+// Throws a runtime error if the result isn't VK_SUCCESS.
+// On VK_ERROR_DEVICE_LOST the device lost handler's report is written to stderr and added to the error.
 void logError(VkResult result, std::string file, std::string func, int line);
 
-// A proxy function that finds and calls the vulkan create function
+// Returns the name of a result, such as "VK_ERROR_DEVICE_LOST"
+const char* resultToString(VkResult result);
+
+// Sets what logError calls when the device is lost, such as GpuDiagnostics::getReport.
+// An empty function removes the handler.
+void setDeviceLostHandler(std::function<std::string()> handler);
+
+// A proxy function that calls the vulkan create function if the instance loaded it
 static VkResult createDebugUtilsMessengerEXT(
+	const InstanceDispatch& dispatch,
 	VkInstance instance,
 	VkDebugUtilsMessengerCreateInfoEXT const* createInfo,
-	VkAllocationCallbacks* allocator,
+	const VkAllocationCallbacks* allocator,
 	VkDebugUtilsMessengerEXT* handle);
 
-// A proxy function that finds and calls the vulkan destroy function
+// A proxy function that calls the vulkan destroy function if the instance loaded it
 static void destroyDebugUtilsMessengerEXT(
+	const InstanceDispatch& dispatch,
 	VkInstance instance,
 	VkDebugUtilsMessengerEXT handle,
-	VkAllocationCallbacks* allocator);
+	const VkAllocationCallbacks* allocator);
 
 class DebugMessenger
 {
@@ -63,6 +74,8 @@ private:
 	// The instance this object was created under
 	VkInstance instanceHandle;
 	VkDebugUtilsMessengerEXT handle;
+	const VkAllocationCallbacks* allocator;
+	const InstanceDispatch* dispatch;
 
 	static std::string messageSeverityToString(VkDebugUtilsMessageSeverityFlagBitsEXT severity);
 	static std::string messageTypeToString(VkDebugUtilsMessageTypeFlagsEXT type);
@@ -0,0 +1,303 @@
+#include "DepthPyramid.h"
+
+#include <algorithm>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+#include "Shader.h"
+
+namespace
+{
+	// Matches the push constants in Shaders/DepthPyramid.comp
+	struct PyramidConstants
+	{
+		int32_t depthSize[2];
+		int32_t pyramidSize[2];
+		int32_t mipCount;
+		uint32_t tileCount;
+	};
+
+	// Mips in the shader: a 64x64 tile per workgroup down to mip 6, then one more tile down to mip 12
+	constexpr uint32_t MAX_MIPS = 13;
+	constexpr uint32_t TILE_SIZE = 64;
+
+	uint32_t previousPowerOfTwo(uint32_t value)
+	{
+		uint32_t power = 1;
+		while (power * 2 <= value) {
+			power *= 2;
+		}
+		return power;
+	}
+}
+
+DepthPyramid::DepthPyramid() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	depthExtent{0, 0},
+	image{},
+	mipViews{},
+	sampler(nullptr),
+	counterBuffer{},
+	descriptorPool(nullptr),
+	setLayout(nullptr),
+	set(nullptr),
+	pipelineLayout(nullptr),
+	pipeline(nullptr)
+{
+}
+
+void DepthPyramid::init(LogicalDevice& device, VkExtent2D _depthExtent)
+{
+	if (!device.getEnabledFeatures().shaderStorageImageArrayDynamicIndexing) {
+		VK_CHECK(VK_ERROR_FEATURE_NOT_PRESENT);
+	}
+
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	depthExtent = _depthExtent;
+
+	// Rounding down keeps every mip exactly half of the previous one, so a texel always covers 2x2 texels below it
+	constexpr uint32_t MAX_SIZE = 1u << (MAX_MIPS - 1);
+	ImageInfo info{};
+	info.extent.width = std::min(previousPowerOfTwo(depthExtent.width), MAX_SIZE);
+	info.extent.height = std::min(previousPowerOfTwo(depthExtent.height), MAX_SIZE);
+	info.format = VK_FORMAT_R32_SFLOAT;
+	info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	info.mipLevels = 1;
+	while ((std::max(info.extent.width, info.extent.height) >> info.mipLevels) > 0) {
+		info.mipLevels++;
+	}
+	image.init(device, info);
+	image.setName("Depth pyramid");
+
+	mipViews.resize(info.mipLevels);
+	for (uint32_t mip = 0; mip < info.mipLevels; mip++) {
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image.getHandle();
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = info.format;
+		viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 1};
+		VkResult result = dispatch->vkCreateImageView(deviceHandle, &viewInfo, allocator, &mipViews[mip]); VK_CHECK(result);
+	}
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	VkResult result = dispatch->vkCreateSampler(deviceHandle, &samplerInfo, allocator, &sampler); VK_CHECK(result);
+
+	// Coherent and zeroed once, the last workgroup of every build resets it
+	counterBuffer.init(device, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	*static_cast<uint32_t*>(counterBuffer.getMapped()) = 0;
+	counterBuffer.setName("Depth pyramid counter");
+
+	createDescriptors();
+	createPipeline(device);
+}
+
+DepthPyramid::~DepthPyramid()
+{
+	cleanup();
+}
+
+void DepthPyramid::cleanup()
+{
+	if (deviceHandle) {
+		dispatch->vkDestroyPipeline(deviceHandle, pipeline, allocator);
+		dispatch->vkDestroyPipelineLayout(deviceHandle, pipelineLayout, allocator);
+		// Destroying the pool frees its set
+		dispatch->vkDestroyDescriptorPool(deviceHandle, descriptorPool, allocator);
+		dispatch->vkDestroyDescriptorSetLayout(deviceHandle, setLayout, allocator);
+		dispatch->vkDestroySampler(deviceHandle, sampler, allocator);
+		for (VkImageView view : mipViews) {
+			dispatch->vkDestroyImageView(deviceHandle, view, allocator);
+		}
+		pipeline = nullptr;
+		pipelineLayout = nullptr;
+		descriptorPool = nullptr;
+		setLayout = nullptr;
+		set = nullptr;
+		sampler = nullptr;
+		mipViews.clear();
+
+		counterBuffer.cleanup();
+		image.cleanup();
+		deviceHandle = nullptr;
+	}
+}
+
+void DepthPyramid::setDepth(VkImageView depthView)
+{
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = sampler;
+	imageInfo.imageView = depthView;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = set;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+	dispatch->vkUpdateDescriptorSets(deviceHandle, 1, &write, 0, nullptr);
+}
+
+void DepthPyramid::recordBuild(VkCommandBuffer commandBuffer)
+{
+	CommandLabel label(*dispatch, commandBuffer, "Depth pyramid");
+	VkExtent2D extent = image.getExtent();
+	uint32_t mipLevels = image.getMipLevels();
+
+	// Culling against the previous pyramid has to finish before it's overwritten, and the previous build's
+	// counter reset before this one counts. Every mip is rewritten, so the old contents are discarded.
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	VkImageMemoryBarrier imageBarrier{};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = image.getHandle();
+	imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+	dispatch->vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &memoryBarrier, 0, nullptr, 1, &imageBarrier);
+
+	uint32_t tilesX = (extent.width + TILE_SIZE - 1) / TILE_SIZE;
+	uint32_t tilesY = (extent.height + TILE_SIZE - 1) / TILE_SIZE;
+	PyramidConstants constants{};
+	constants.depthSize[0] = static_cast<int32_t>(depthExtent.width);
+	constants.depthSize[1] = static_cast<int32_t>(depthExtent.height);
+	constants.pyramidSize[0] = static_cast<int32_t>(extent.width);
+	constants.pyramidSize[1] = static_cast<int32_t>(extent.height);
+	constants.mipCount = static_cast<int32_t>(mipLevels);
+	constants.tileCount = tilesX * tilesY;
+	dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	dispatch->vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+	dispatch->vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	dispatch->vkCmdDispatch(commandBuffer, tilesX, tilesY, 1);
+
+	imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	dispatch->vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+}
+
+VkImageView DepthPyramid::getView()
+{
+	return image.getView();
+}
+
+VkSampler DepthPyramid::getSampler()
+{
+	return sampler;
+}
+
+VkExtent2D DepthPyramid::getExtent()
+{
+	return image.getExtent();
+}
+
+uint32_t DepthPyramid::getMipLevels()
+{
+	return image.getMipLevels();
+}
+
+void DepthPyramid::createDescriptors()
+{
+	VkDescriptorSetLayoutBinding bindings[3]{};
+	bindings[0] = {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+	bindings[1] = {1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_MIPS, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+	bindings[2] = {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 3;
+	layoutInfo.pBindings = bindings;
+	VkResult result = dispatch->vkCreateDescriptorSetLayout(deviceHandle, &layoutInfo, allocator, &setLayout); VK_CHECK(result);
+
+	VkDescriptorPoolSize poolSizes[] = {
+		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1},
+		{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_MIPS},
+		{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1}
+	};
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 3;
+	poolInfo.pPoolSizes = poolSizes;
+	result = dispatch->vkCreateDescriptorPool(deviceHandle, &poolInfo, allocator, &descriptorPool); VK_CHECK(result);
+
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = descriptorPool;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &setLayout;
+	result = dispatch->vkAllocateDescriptorSets(deviceHandle, &allocateInfo, &set); VK_CHECK(result);
+
+	// Every element of the array has to be valid, the ones past the last mip repeat it
+	VkDescriptorImageInfo mipInfos[MAX_MIPS];
+	for (uint32_t mip = 0; mip < MAX_MIPS; mip++) {
+		mipInfos[mip] = {nullptr, mipViews[std::min(mip, static_cast<uint32_t>(mipViews.size()) - 1)], VK_IMAGE_LAYOUT_GENERAL};
+	}
+	VkDescriptorBufferInfo counterInfo{counterBuffer.getHandle(), 0, VK_WHOLE_SIZE};
+	VkWriteDescriptorSet writes[2]{};
+	writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writes[0].dstSet = set;
+	writes[0].dstBinding = 1;
+	writes[0].descriptorCount = MAX_MIPS;
+	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	writes[0].pImageInfo = mipInfos;
+	writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writes[1].dstSet = set;
+	writes[1].dstBinding = 2;
+	writes[1].descriptorCount = 1;
+	writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writes[1].pBufferInfo = &counterInfo;
+	dispatch->vkUpdateDescriptorSets(deviceHandle, 2, writes, 0, nullptr);
+}
+
+void DepthPyramid::createPipeline(LogicalDevice& device)
+{
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.size = sizeof(PyramidConstants);
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VkResult result = dispatch->vkCreatePipelineLayout(deviceHandle, &layoutInfo, allocator, &pipelineLayout); VK_CHECK(result);
+
+	Shader shader;
+	shader.init(device, "DepthPyramid.comp.spv");
+
+	VkComputePipelineCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	createInfo.stage.module = shader.getHandle();
+	createInfo.stage.pName = "main";
+	createInfo.layout = pipelineLayout;
+	result = dispatch->vkCreateComputePipelines(deviceHandle, nullptr, 1, &createInfo, allocator, &pipeline); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_PIPELINE, pipeline, "DepthPyramid.comp.spv");
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "Buffer.h"
+#include "Image.h"
+
+// Hierarchical depth buffer for occlusion culling: mip 0 is the depth rounded down to powers of two, and each texel
+// holds the farthest depth of the texels it covers, so one sample tells whether anything behind it can be seen.
+// Every mip is built in a single dispatch. Meant for IndirectDrawPass::setDepthPyramid.
+class DepthPyramid
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create any resources, must call init
+	 */
+	DepthPyramid();
+
+	/**
+	 * @brief Creates the pyramid image, its views and sampler, and the downsampling pipeline.
+	 * Throws an error if the device doesn't support shaderStorageImageArrayDynamicIndexing.
+	 *
+	 * @param device - the logical device to create the resources under
+	 * @param _depthExtent - size of the depth it's built from, the pyramid is at most 4096 texels wide and high
+	 */
+	void init(LogicalDevice& device, VkExtent2D _depthExtent);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~DepthPyramid();
+
+	/**
+	 * @brief Destroys all resources, such as before init with a new extent. The device must not be using them anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Sets the depth the pyramid is built from
+	 *
+	 * @param depthView - view of the depth aspect of an image of the depth extent with VK_IMAGE_USAGE_SAMPLED_BIT,
+	 * such as a stored D32 RenderTargets attachment
+	 */
+	void setDepth(VkImageView depthView);
+
+	/**
+	 * @brief Rebuilds every mip from the depth. Must be recorded outside of a render pass.
+	 * The pyramid is in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL for compute shaders afterwards.
+	 *
+	 * @param commandBuffer - command buffer on a queue that supports compute, the depth must be in
+	 * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and written before a barrier to the compute shader stage
+	 */
+	void recordBuild(VkCommandBuffer commandBuffer);
+
+	/**
+	 * @brief Returns the view of every mip
+	 */
+	VkImageView getView();
+
+	/**
+	 * @brief Returns a nearest filtering sampler that clamps to the edge
+	 */
+	VkSampler getSampler();
+
+	/**
+	 * @brief Returns the size of mip 0
+	 */
+	VkExtent2D getExtent();
+	uint32_t getMipLevels();
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkExtent2D depthExtent;
+
+	Image image;
+	std::vector<VkImageView> mipViews;
+	VkSampler sampler;
+	Buffer counterBuffer;
+
+	VkDescriptorPool descriptorPool;
+	VkDescriptorSetLayout setLayout;
+	VkDescriptorSet set;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+
+	void createDescriptors();
+	void createPipeline(LogicalDevice& device);
+};
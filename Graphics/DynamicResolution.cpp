@@ -0,0 +1,155 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "DebugLabels.h"
+#include "GpuProfiler.h"
+
+DynamicResolution::DynamicResolution() :
+	device(nullptr),
+	dispatch(nullptr),
+	settings{},
+	outputExtent{},
+	scale(1.0f),
+	gpuMilliseconds(0.0),
+	profiler(nullptr)
+{
+}
+
+void DynamicResolution::init(LogicalDevice& _device, VkExtent2D _outputExtent, uint32_t frameCount, const DynamicResolutionSettings& _settings)
+{
+	device = &_device;
+	dispatch = &device->getDispatch();
+	settings = _settings;
+	outputExtent = _outputExtent;
+	scale = settings.maxScale;
+	gpuMilliseconds = 0.0;
+	timer.init(*device, device->getGraphicsFamilyIndex(), frameCount);
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	cleanup();
+}
+
+void DynamicResolution::cleanup()
+{
+	if (dispatch) {
+		timer.cleanup();
+		device = nullptr;
+		dispatch = nullptr;
+	}
+}
+
+void DynamicResolution::setOutputExtent(VkExtent2D _outputExtent)
+{
+	outputExtent = _outputExtent;
+}
+
+void DynamicResolution::recordBeginFrame(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+	double milliseconds = 0.0;
+	if (timer.getMilliseconds(frame, milliseconds)) {
+		update(milliseconds);
+	}
+	timer.recordStart(commandBuffer, frame);
+}
+
+bool DynamicResolution::canUpscale(VkFormat sourceFormat, VkFormat targetFormat, VkImageUsageFlags targetUsage)
+{
+	VkFormatFeatureFlags sourceFeatures = device->getFormatFeatures(sourceFormat);
+	VkFormatFeatureFlags targetFeatures = device->getFormatFeatures(targetFormat);
+	return (sourceFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) && (sourceFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+		&& (targetFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT) && (targetUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+}
+
+void DynamicResolution::recordUpscale(VkCommandBuffer commandBuffer, uint32_t frame, VkImage source, VkExtent2D sourceExtent, VkImage target,
+	VkImageLayout finalLayout)
+{
+	beginCommandLabel(*dispatch, commandBuffer, "Upscale");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Upscale");
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = target;
+	barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	dispatch->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	// Blits clamp to the edge of the whole source, so near the right and bottom edges of the rendered region the
+	// filter blends in texels outside of it, left over from earlier frames. Offsets are whole texels, so instead of
+	// half a texel the region loses its last column or row when there are texels past it.
+	VkExtent2D renderExtent = getRenderExtent();
+	int32_t width = static_cast<int32_t>(renderExtent.width);
+	int32_t height = static_cast<int32_t>(renderExtent.height);
+	if (renderExtent.width < sourceExtent.width && width > 1) {
+		width--;
+	}
+	if (renderExtent.height < sourceExtent.height && height > 1) {
+		height--;
+	}
+	VkImageBlit region{};
+	region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.srcOffsets[1] = {width, height, 1};
+	region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.dstOffsets[1] = {static_cast<int32_t>(outputExtent.width), static_cast<int32_t>(outputExtent.height), 1};
+	dispatch->vkCmdBlitImage(commandBuffer, source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = finalLayout;
+	dispatch->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+	endCommandLabel(*dispatch, commandBuffer);
+
+	timer.recordEnd(commandBuffer, frame);
+}
+
+void DynamicResolution::update(double _gpuMilliseconds)
+{
+	gpuMilliseconds = _gpuMilliseconds;
+	if (gpuMilliseconds <= 0.0) {
+		return;
+	}
+
+	// GPU time grows with the pixel count, which is the square of the scale
+	float ideal = scale * static_cast<float>(std::sqrt(settings.targetMilliseconds / gpuMilliseconds));
+	ideal = std::clamp(ideal, settings.minScale, settings.maxScale);
+	float next = scale + (ideal - scale) * settings.adjustRate;
+	if (std::abs(next - scale) >= settings.deadband * scale) {
+		scale = next;
+	} else if (ideal == settings.minScale || ideal == settings.maxScale) {
+		// The last small step onto a limit is taken so the limit is reached instead of only approached
+		scale = ideal;
+	}
+}
+
+VkExtent2D DynamicResolution::getRenderExtent()
+{
+	uint32_t width = static_cast<uint32_t>(std::lround(outputExtent.width * scale));
+	uint32_t height = static_cast<uint32_t>(std::lround(outputExtent.height * scale));
+	return {std::max(width, 1u), std::max(height, 1u)};
+}
+
+float DynamicResolution::getScale()
+{
+	return scale;
+}
+
+double DynamicResolution::getGpuMilliseconds()
+{
+	return gpuMilliseconds;
+}
+
+void DynamicResolution::setProfiler(GpuProfiler* _profiler)
+{
+	profiler = _profiler;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "LogicalDevice.h"
+#include "GpuTimer.h"
+
+class GpuProfiler;
+
+struct DynamicResolutionSettings
+{
+	// GPU time per frame the scale is adjusted to hold, such as a bit under the display's refresh interval
+	float targetMilliseconds = 14.0f;
+	float minScale = 0.5f;
+	// Above 1 renders more pixels than the output has, the render target has to be that much bigger
+	float maxScale = 1.0f;
+	// Fraction of the way to the ideal scale moved every frame, lower reacts slower but steadier
+	float adjustRate = 0.25f;
+	// Scale changes smaller than this are skipped so the resolution doesn't change on every frame
+	float deadband = 0.01f;
+};
+
+// Renders at a fraction of the output resolution picked from the measured GPU frame time, then upscales
+// to the output, such as a swapchain image whose extent Swapchain::pickExtent picked.
+// The scene is rendered into the top left getRenderExtent() of a target sized like the output, so changing
+// the scale never reallocates anything, and the upscale is a bilinear blit of that region.
+class DynamicResolution
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create the timer, must call init
+	 */
+	DynamicResolution();
+
+	/**
+	 * @brief Creates the timestamp queries and starts at the maximum scale
+	 *
+	 * @param _device - the logical device to create the queries under
+	 * @param _outputExtent - size of the upscaled image, the render target must be at least this big times maxScale
+	 * @param frameCount - frames in flight, frame indices given to recordBeginFrame are below it
+	 * @param _settings - target time and scale limits
+	 */
+	void init(LogicalDevice& _device, VkExtent2D _outputExtent, uint32_t frameCount, const DynamicResolutionSettings& _settings = {});
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~DynamicResolution();
+
+	/**
+	 * @brief Destroys the timer. The device must not be using it anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Changes the size of the upscaled image, such as after the swapchain was recreated. The scale is kept.
+	 */
+	void setOutputExtent(VkExtent2D _outputExtent);
+
+	/**
+	 * @brief Adjusts the scale to the GPU time of the last frame that used this frame index and starts timing
+	 * this one. Call before recording the frame's rendering, then render to getRenderExtent.
+	 *
+	 * @param commandBuffer - command buffer on the graphics queue, outside of a render pass
+	 * @param frame - index of the frame in flight, whose last submission has finished
+	 */
+	void recordBeginFrame(VkCommandBuffer commandBuffer, uint32_t frame);
+
+	/**
+	 * @brief Returns whether recordUpscale can blit between images of these formats, such as from a render target
+	 * to a swapchain image with Swapchain::getFormat and Swapchain::getUsage. Swapchains don't always allow
+	 * VK_IMAGE_USAGE_TRANSFER_DST_BIT, draw the render target to the output with a shader then.
+	 *
+	 * @param sourceFormat - format of the render target, needs blit source and linear filtering support
+	 * @param targetFormat - format of the output, needs blit destination support
+	 * @param targetUsage - usage the output was created with, needs VK_IMAGE_USAGE_TRANSFER_DST_BIT
+	 */
+	bool canUpscale(VkFormat sourceFormat, VkFormat targetFormat, VkImageUsageFlags targetUsage);
+
+	/**
+	 * @brief Blits the rendered region of source to all of target with linear filtering and stops timing the frame.
+	 * canUpscale must have returned true for the images. Waits on the acquire semaphore of a swapchain image
+	 * need VK_PIPELINE_STAGE_TRANSFER_BIT.
+	 *
+	 * @param source - the render target in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, with VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+	 * @param sourceExtent - size of source, at least the output extent times maxScale
+	 * @param target - image of the output extent with VK_IMAGE_USAGE_TRANSFER_DST_BIT, its contents are discarded
+	 * @param finalLayout - layout of target afterwards, such as VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+	 */
+	void recordUpscale(VkCommandBuffer commandBuffer, uint32_t frame, VkImage source, VkExtent2D sourceExtent, VkImage target,
+		VkImageLayout finalLayout);
+
+	/**
+	 * @brief Moves the scale towards the one that would have taken targetMilliseconds, assuming GPU time
+	 * grows with the rendered pixels. Called by recordBeginFrame with the measured time.
+	 *
+	 * @param gpuMilliseconds - GPU time of a frame rendered at the current scale
+	 */
+	void update(double gpuMilliseconds);
+
+	/**
+	 * @brief Returns the size to render at, the output extent times the scale
+	 */
+	VkExtent2D getRenderExtent();
+
+	float getScale();
+
+	/**
+	 * @brief Returns the last measured GPU frame time, 0 before the first measurement
+	 */
+	double getGpuMilliseconds();
+
+	/**
+	 * @brief Times every recordUpscale as a GPU zone, does nothing without APPARATUS_TRACY
+	 *
+	 * @param _profiler - initialized profiler of the graphics queue, nullptr to stop
+	 */
+	void setProfiler(GpuProfiler* _profiler);
+
+private:
+	LogicalDevice* device;
+	const DeviceDispatch* dispatch;
+	DynamicResolutionSettings settings;
+	VkExtent2D outputExtent;
+	float scale;
+	double gpuMilliseconds;
+	GpuTimer timer;
+	GpuProfiler* profiler;
+};
@@ -0,0 +1,254 @@
+#include "GpuDiagnostics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+
+GpuDiagnostics::GpuDiagnostics() :
+	deviceHandle(nullptr),
+	dispatch(nullptr),
+	bufferMarkers(false),
+	fillBreadcrumbs(false),
+	deviceFault(false),
+	maxBreadcrumbs(0),
+	dumpPath{},
+	markerBuffer{},
+	nextBreadcrumb(0),
+	labels{},
+	passStages{},
+	history{},
+	historyNext(0),
+	historyCount(0)
+{
+}
+
+void GpuDiagnostics::init(LogicalDevice& device, uint32_t _maxBreadcrumbs, uint32_t historySize, const std::string& _dumpPath)
+{
+	deviceHandle = device.getHandle();
+	dispatch = &device.getDispatch();
+	bufferMarkers = device.supportsBufferMarkers();
+	deviceFault = device.supportsDeviceFault();
+	maxBreadcrumbs = _maxBreadcrumbs;
+	dumpPath = _dumpPath;
+	nextBreadcrumb.store(0, std::memory_order_relaxed);
+	labels.assign(maxBreadcrumbs, nullptr);
+	passStages.assign(maxBreadcrumbs, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	history.assign(historySize, SubmitRecord{});
+	historyNext = 0;
+	historyCount = 0;
+
+	// Breadcrumbs can be written from any queue, so the buffer is shared by all of them
+	std::vector<uint32_t> families;
+	for (uint32_t family : {device.getGraphicsFamilyIndex(), device.getTransferFamilyIndex(), device.getComputeFamilyIndex()}) {
+		if (std::find(families.begin(), families.end(), family) == families.end()) {
+			families.push_back(family);
+		}
+	}
+	// Coherent so the markers can be read after a device loss without invalidating
+	markerBuffer.init(device, 2 * sizeof(uint32_t) * maxBreadcrumbs, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, families);
+	std::fill_n(static_cast<uint32_t*>(markerBuffer.getMapped()), 2 * maxBreadcrumbs, 0u);
+	markerBuffer.setName("GpuDiagnostics breadcrumbs");
+
+	setDeviceLostHandler([this]() {
+		std::string report = getReport();
+		if (!dumpPath.empty()) {
+			std::ofstream file(dumpPath);
+			file << report;
+		}
+		return report;
+	});
+}
+
+GpuDiagnostics::~GpuDiagnostics()
+{
+	cleanup();
+}
+
+void GpuDiagnostics::cleanup()
+{
+	if (deviceHandle) {
+		setDeviceLostHandler(nullptr);
+		markerBuffer.cleanup();
+		labels.clear();
+		passStages.clear();
+		history.clear();
+		deviceHandle = nullptr;
+	}
+}
+
+void GpuDiagnostics::setFillBreadcrumbs(bool enabled)
+{
+	fillBreadcrumbs = enabled;
+}
+
+bool GpuDiagnostics::recordsBreadcrumbs() const
+{
+	return bufferMarkers || fillBreadcrumbs;
+}
+
+uint32_t GpuDiagnostics::recordBegin(VkCommandBuffer commandBuffer, const char* label, VkPipelineStageFlags stages)
+{
+	if (!recordsBreadcrumbs()) {
+		return 0;
+	}
+
+	uint32_t id = nextBreadcrumb.fetch_add(1, std::memory_order_relaxed);
+	uint32_t slot = id % maxBreadcrumbs;
+	labels[slot] = label;
+	passStages[slot] = stages;
+	writeMarker(commandBuffer, false, stages, sizeof(uint32_t) * slot, id + 1);
+	return id;
+}
+
+void GpuDiagnostics::recordEnd(VkCommandBuffer commandBuffer, uint32_t id)
+{
+	if (!recordsBreadcrumbs()) {
+		return;
+	}
+
+	uint32_t slot = id % maxBreadcrumbs;
+	writeMarker(commandBuffer, true, passStages[slot], sizeof(uint32_t) * (maxBreadcrumbs + slot), id + 1);
+}
+
+void GpuDiagnostics::addSubmit(VkQueue queue, const char* label, uint64_t serial, uint32_t commandBufferCount)
+{
+	if (history.empty()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(historyMutex);
+	history[historyNext] = {queue, label, serial, commandBufferCount, nextBreadcrumb.load(std::memory_order_relaxed)};
+	historyNext = (historyNext + 1) % history.size();
+	historyCount = std::min(historyCount + 1, history.size());
+}
+
+std::string GpuDiagnostics::getReport()
+{
+	std::string report = "GPU diagnostics after device loss\n";
+	if (deviceFault) {
+		appendFaultInfo(report);
+	} else {
+		report += "Device fault: VK_EXT_device_fault isn't supported\n";
+	}
+
+	std::ostringstream stream;
+	{
+		std::lock_guard<std::mutex> lock(historyMutex);
+		stream << "Last " << historyCount << " submissions, oldest first:\n";
+		for (size_t i = 0; i < historyCount; i++) {
+			const SubmitRecord& record = history[(historyNext + history.size() - historyCount + i) % history.size()];
+			stream << "  queue " << record.queue << " serial " << record.serial << ' '
+				<< (record.label != nullptr ? record.label : "(unlabeled)") << ", "
+				<< record.commandBufferCount << " command buffers, after breadcrumb " << record.breadcrumbCount << '\n';
+		}
+	}
+
+	if (!recordsBreadcrumbs()) {
+		stream << "Breadcrumbs: none, VK_AMD_buffer_marker isn't supported and fill breadcrumbs are off\n";
+		return report + stream.str();
+	}
+
+	// Only breadcrumbs that weren't overwritten yet can be checked
+	uint32_t end = nextBreadcrumb.load(std::memory_order_relaxed);
+	uint32_t begin = end > maxBreadcrumbs ? end - maxBreadcrumbs : 0;
+	const uint32_t* started = static_cast<const uint32_t*>(markerBuffer.getMapped());
+	const uint32_t* finished = started + maxBreadcrumbs;
+	uint32_t lastFinished = UINT32_MAX;
+	uint32_t unfinished = 0;
+	stream << "Breadcrumbs " << begin << " to " << end << " (" << (bufferMarkers ? "buffer markers" : "buffer fills") << "), "
+		<< "started but not finished:\n";
+	for (uint32_t id = begin; id < end; id++) {
+		uint32_t slot = id % maxBreadcrumbs;
+		bool hasStarted = started[slot] == id + 1;
+		bool hasFinished = finished[slot] == id + 1;
+		if (hasFinished) {
+			lastFinished = id;
+		} else if (hasStarted) {
+			stream << "  " << id << ' ' << (labels[slot] != nullptr ? labels[slot] : "(unlabeled)") << '\n';
+			unfinished++;
+		}
+	}
+	if (unfinished == 0) {
+		stream << "  none, the fault happened outside the marked passes\n";
+	}
+	if (lastFinished != UINT32_MAX) {
+		uint32_t slot = lastFinished % maxBreadcrumbs;
+		stream << "Last finished breadcrumb: " << lastFinished << ' ' << (labels[slot] != nullptr ? labels[slot] : "(unlabeled)") << '\n';
+	}
+
+	return report + stream.str();
+}
+
+void GpuDiagnostics::writeMarker(VkCommandBuffer commandBuffer, bool isEnd, VkPipelineStageFlags stages, VkDeviceSize offset, uint32_t value)
+{
+	if (bufferMarkers) {
+		dispatch->vkCmdWriteBufferMarkerAMD(commandBuffer, isEnd ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			markerBuffer.getHandle(), offset, value);
+	} else {
+		// A fill is a transfer that isn't ordered against other commands by itself. The end marker waits for the
+		// pass's stages, and those stages after the begin marker wait for it, so the marked pass lies between the two.
+		// Work in other stages keeps overlapping the fills.
+		if (isEnd) {
+			dispatch->vkCmdPipelineBarrier(commandBuffer, stages, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, nullptr, 0, nullptr, 0, nullptr);
+		}
+		dispatch->vkCmdFillBuffer(commandBuffer, markerBuffer.getHandle(), offset, sizeof(uint32_t), value);
+		if (!isEnd) {
+			dispatch->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, stages,
+				0, 0, nullptr, 0, nullptr, 0, nullptr);
+		}
+	}
+}
+
+void GpuDiagnostics::appendFaultInfo(std::string& report)
+{
+	VkDeviceFaultCountsEXT counts{};
+	counts.sType = VK_STRUCTURE_TYPE_DEVICE_FAULT_COUNTS_EXT;
+	if (dispatch->vkGetDeviceFaultInfoEXT(deviceHandle, &counts, nullptr) != VK_SUCCESS) {
+		report += "Device fault: no information\n";
+		return;
+	}
+
+	std::vector<VkDeviceFaultAddressInfoEXT> addressInfos(counts.addressInfoCount);
+	std::vector<VkDeviceFaultVendorInfoEXT> vendorInfos(counts.vendorInfoCount);
+	// The vendor binary isn't enabled
+	counts.vendorBinarySize = 0;
+	VkDeviceFaultInfoEXT info{};
+	info.sType = VK_STRUCTURE_TYPE_DEVICE_FAULT_INFO_EXT;
+	info.pAddressInfos = addressInfos.data();
+	info.pVendorInfos = vendorInfos.data();
+	VkResult result = dispatch->vkGetDeviceFaultInfoEXT(deviceHandle, &counts, &info);
+	if (result != VK_SUCCESS && result != VK_INCOMPLETE) {
+		report += "Device fault: no information\n";
+		return;
+	}
+
+	std::ostringstream stream;
+	stream << "Device fault: " << info.description << '\n';
+	for (uint32_t i = 0; i < counts.addressInfoCount; i++) {
+		const VkDeviceFaultAddressInfoEXT& address = addressInfos[i];
+		const char* type = "unknown";
+		switch (address.addressType) {
+		case VK_DEVICE_FAULT_ADDRESS_TYPE_NONE_EXT: type = "none"; break;
+		case VK_DEVICE_FAULT_ADDRESS_TYPE_READ_INVALID_EXT: type = "invalid read"; break;
+		case VK_DEVICE_FAULT_ADDRESS_TYPE_WRITE_INVALID_EXT: type = "invalid write"; break;
+		case VK_DEVICE_FAULT_ADDRESS_TYPE_EXECUTE_INVALID_EXT: type = "invalid execute"; break;
+		case VK_DEVICE_FAULT_ADDRESS_TYPE_INSTRUCTION_POINTER_UNKNOWN_EXT: type = "instruction pointer, unknown"; break;
+		case VK_DEVICE_FAULT_ADDRESS_TYPE_INSTRUCTION_POINTER_INVALID_EXT: type = "instruction pointer, invalid"; break;
+		case VK_DEVICE_FAULT_ADDRESS_TYPE_INSTRUCTION_POINTER_FAULT_EXT: type = "instruction pointer, fault"; break;
+		default: break;
+		}
+		stream << "  address 0x" << std::hex << address.reportedAddress << " +- 0x" << address.addressPrecision
+			<< std::dec << ", " << type << '\n';
+	}
+	for (uint32_t i = 0; i < counts.vendorInfoCount; i++) {
+		const VkDeviceFaultVendorInfoEXT& vendor = vendorInfos[i];
+		stream << "  vendor " << vendor.description << ", code 0x" << std::hex << vendor.vendorFaultCode
+			<< ", data 0x" << vendor.vendorFaultData << std::dec << '\n';
+	}
+	report += stream.str();
+}
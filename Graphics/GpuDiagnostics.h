@@ -0,0 +1,138 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "Buffer.h"
+
+// One submission in the history kept by GpuDiagnostics
+struct SubmitRecord
+{
+	VkQueue queue;
+	// Label of the batch, nullptr without one
+	const char* label;
+	uint64_t serial;
+	uint32_t commandBufferCount;
+	// Breadcrumbs begun on any thread before the submission
+	uint32_t breadcrumbCount;
+};
+
+// Explains a device loss after the fact. Passes write breadcrumbs into host visible memory as the GPU reaches
+// and leaves them, the last submissions are kept with their labels, and VK_EXT_device_fault describes the
+// fault when the device has it. When VK_CHECK sees VK_ERROR_DEVICE_LOST all of it is written to stderr,
+// the dump file, and the thrown error.
+// With VK_AMD_buffer_marker each breadcrumb is one pipelined write, cheap enough to leave on in release builds.
+// Other devices only get breadcrumbs after setFillBreadcrumbs(true): a fill has to be fenced by barriers that
+// make consecutive marked passes wait for each other, so it's meant for chasing a device loss rather than shipping.
+class GpuDiagnostics
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create the marker buffer, must call init
+	 */
+	GpuDiagnostics();
+
+	/**
+	 * @brief Creates the marker buffer and becomes the device lost handler of logError
+	 *
+	 * @param device - the logical device to create the marker buffer under
+	 * @param _maxBreadcrumbs - breadcrumbs kept, older ones are overwritten
+	 * @param historySize - submissions kept, older ones are dropped
+	 * @param _dumpPath - file the report is written to on a device loss, empty to only write it to stderr
+	 */
+	void init(LogicalDevice& device, uint32_t _maxBreadcrumbs = 1024, uint32_t historySize = 16, const std::string& _dumpPath = "");
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~GpuDiagnostics();
+
+	/**
+	 * @brief Stops handling device losses and destroys the marker buffer. The device must not be using it anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Whether devices without VK_AMD_buffer_marker write breadcrumbs with vkCmdFillBuffer, off by default.
+	 * Every fill is fenced by barriers on the stages of its pass, so marked passes sharing stages no longer overlap.
+	 * Set it before recording, a breadcrumb begun with fills on and ended with them off is never finished.
+	 */
+	void setFillBreadcrumbs(bool enabled);
+
+	/**
+	 * @brief Whether recordBegin and recordEnd record anything, either buffer markers or fills
+	 */
+	bool recordsBreadcrumbs() const;
+
+	/**
+	 * @brief Records a breadcrumb written once the GPU starts the commands after it.
+	 * Safe to call from any thread. Records nothing unless recordsBreadcrumbs().
+	 * Fill breadcrumbs can't be recorded inside a render pass and need a queue with transfer support, so call it
+	 * around render passes rather than draws. The fill is followed by a barrier that makes the given stages wait for it.
+	 *
+	 * @param commandBuffer - command buffer in the recording state
+	 * @param label - name of the pass, must outlive the diagnostics, such as a string literal
+	 * @param stages - stages the pass runs in, only used by fill breadcrumbs
+	 *
+	 * @return id of the breadcrumb for recordEnd
+	 */
+	uint32_t recordBegin(VkCommandBuffer commandBuffer, const char* label, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+	/**
+	 * @brief Records that the breadcrumb is written once the GPU finished every command before it.
+	 * A fill breadcrumb waits for the stages given to recordBegin instead.
+	 *
+	 * @param id - returned by recordBegin
+	 */
+	void recordEnd(VkCommandBuffer commandBuffer, uint32_t id);
+
+	/**
+	 * @brief Adds a submission to the history, called by SubmissionScheduler before every vkQueueSubmit.
+	 * Safe to call from any thread.
+	 *
+	 * @param label - name of the batch, must outlive the diagnostics, nullptr without one
+	 */
+	void addSubmit(VkQueue queue, const char* label, uint64_t serial, uint32_t commandBufferCount);
+
+	/**
+	 * @brief Describes the device fault, the last submissions and the breadcrumbs that started but never finished.
+	 * Meant to be read after a device loss, while the device still exists.
+	 */
+	std::string getReport();
+
+private:
+	VkDevice deviceHandle;
+	const DeviceDispatch* dispatch;
+	bool bufferMarkers;
+	bool fillBreadcrumbs;
+	bool deviceFault;
+	uint32_t maxBreadcrumbs;
+	std::string dumpPath;
+
+	// maxBreadcrumbs begin markers followed by as many end markers, each one is the id + 1 of the breadcrumb
+	// that last wrote it so 0 means never written
+	Buffer markerBuffer;
+	std::atomic<uint32_t> nextBreadcrumb;
+	std::vector<const char*> labels;
+	// Stages of the pass of each breadcrumb, what its fills wait for and are waited on by
+	std::vector<VkPipelineStageFlags> passStages;
+
+	std::mutex historyMutex;
+	std::vector<SubmitRecord> history;
+	// Where the next submission goes in history
+	size_t historyNext;
+	size_t historyCount;
+
+	void writeMarker(VkCommandBuffer commandBuffer, bool isEnd, VkPipelineStageFlags stages, VkDeviceSize offset, uint32_t value);
+
+	/**
+	 * @brief Appends what vkGetDeviceFaultInfoEXT reports
+	 */
+	void appendFaultInfo(std::string& report);
+};
@@ -0,0 +1,88 @@
+#include "GpuProfiler.h"
+
+#include <cstring>
+
+#include "DebugMessenger.h"
+
+#ifdef APPARATUS_TRACY
+
+GpuProfiler::GpuProfiler() :
+	context(nullptr)
+{
+}
+
+void GpuProfiler::init(LogicalDevice& device, SubmissionScheduler& scheduler, VkQueue queue, uint32_t queueFamily, const char* name)
+{
+	const DeviceDispatch& dispatch = device.getDispatch();
+	VkDevice deviceHandle = device.getHandle();
+
+	// The calibration only needs a command buffer for the duration of the context's creation
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = queueFamily;
+	VkCommandPool commandPool = nullptr;
+	VkResult result = dispatch.vkCreateCommandPool(deviceHandle, &poolInfo, device.getAllocator(), &commandPool); VK_CHECK(result);
+
+	VkCommandBufferAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	VkCommandBuffer commandBuffer = nullptr;
+	result = dispatch.vkAllocateCommandBuffers(deviceHandle, &allocateInfo, &commandBuffer); VK_CHECK(result);
+
+	{
+		auto lock = scheduler.lockQueue(queue);
+		context = TracyVkContext(device.getPhysicalDevice(), deviceHandle, queue, commandBuffer);
+	}
+	TracyVkContextName(context, name, static_cast<uint16_t>(std::strlen(name)));
+	dispatch.vkDestroyCommandPool(deviceHandle, commandPool, device.getAllocator());
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	cleanup();
+}
+
+void GpuProfiler::cleanup()
+{
+	if (context) {
+		TracyVkDestroy(context);
+		context = nullptr;
+	}
+}
+
+void GpuProfiler::recordCollect(VkCommandBuffer commandBuffer)
+{
+	TracyVkCollect(context, commandBuffer);
+}
+
+TracyVkCtx GpuProfiler::getContext()
+{
+	return context;
+}
+
+#else
+
+GpuProfiler::GpuProfiler()
+{
+}
+
+void GpuProfiler::init(LogicalDevice&, SubmissionScheduler&, VkQueue, uint32_t, const char*)
+{
+}
+
+GpuProfiler::~GpuProfiler()
+{
+}
+
+void GpuProfiler::cleanup()
+{
+}
+
+void GpuProfiler::recordCollect(VkCommandBuffer)
+{
+}
+
+#endif
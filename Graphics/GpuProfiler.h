@@ -0,0 +1,68 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "LogicalDevice.h"
+#include "SubmissionScheduler.h"
+
+#ifdef APPARATUS_TRACY
+#include <tracy/TracyVulkan.hpp>
+#endif
+
+// GPU zones of one queue on the Tracy timeline, measured with timestamp queries and lined up with the CPU zones.
+// Like Core/Profiler.h it compiles to nothing without the APPARATUS_TRACY build option.
+class GpuProfiler
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create the profiling context, must call init
+	 */
+	GpuProfiler();
+
+	/**
+	 * @brief Creates the profiling context of a queue. Calibrates it with a submission that is waited on.
+	 *
+	 * @param device - the logical device the queue belongs to
+	 * @param scheduler - scheduler the queue is submitted through, the queue is locked during the calibration
+	 * @param queue - the measured queue, such as LogicalDevice::getGraphicsQueue
+	 * @param queueFamily - family of the queue, it has to support timestamps
+	 * @param name - name of the queue on the timeline
+	 */
+	void init(LogicalDevice& device, SubmissionScheduler& scheduler, VkQueue queue, uint32_t queueFamily, const char* name);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~GpuProfiler();
+
+	/**
+	 * @brief Destroys the profiling context. The device must not be using it anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Reads the finished zones and frees their queries, call once per frame
+	 *
+	 * @param commandBuffer - command buffer outside of a render pass, on the measured queue
+	 */
+	void recordCollect(VkCommandBuffer commandBuffer);
+
+#ifdef APPARATUS_TRACY
+	TracyVkCtx getContext();
+#endif
+
+private:
+#ifdef APPARATUS_TRACY
+	TracyVkCtx context;
+#endif
+};
+
+#ifdef APPARATUS_TRACY
+// Times the commands recorded in the enclosing scope, name is a string literal.
+// profiler is a GpuProfiler pointer of the command buffer's queue, nothing is recorded when it's nullptr.
+#define PROFILE_GPU_ZONE(profiler, commandBuffer, name) \
+	TracyVkNamedZone((profiler) != nullptr ? (profiler)->getContext() : nullptr, ___tracy_gpu_zone, commandBuffer, name, (profiler) != nullptr)
+#else
+#define PROFILE_GPU_ZONE(profiler, commandBuffer, name)
+#endif
@@ -0,0 +1,95 @@
+#include "GpuTimer.h"
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+
+GpuTimer::GpuTimer() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	queryPool(nullptr),
+	frameCount(0),
+	period(0.0),
+	validMask(0),
+	recorded{}
+{
+}
+
+void GpuTimer::init(LogicalDevice& device, uint32_t queueFamily, uint32_t _frameCount)
+{
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	frameCount = _frameCount;
+	period = device.getProperties().limits.timestampPeriod;
+	recorded.assign(frameCount, false);
+
+	uint32_t validBits = device.getTimestampValidBits(queueFamily);
+	if (validBits == 0) {
+		return;
+	}
+	validMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	createInfo.queryCount = 2 * frameCount;
+	VkResult result = dispatch->vkCreateQueryPool(deviceHandle, &createInfo, allocator, &queryPool); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_QUERY_POOL, queryPool, "GpuTimer");
+}
+
+GpuTimer::~GpuTimer()
+{
+	cleanup();
+}
+
+void GpuTimer::cleanup()
+{
+	if (deviceHandle) {
+		dispatch->vkDestroyQueryPool(deviceHandle, queryPool, allocator);
+		queryPool = nullptr;
+		recorded.clear();
+		deviceHandle = nullptr;
+	}
+}
+
+void GpuTimer::recordStart(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+	if (!queryPool) {
+		return;
+	}
+	dispatch->vkCmdResetQueryPool(commandBuffer, queryPool, 2 * frame, 2);
+	dispatch->vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 2 * frame);
+}
+
+void GpuTimer::recordEnd(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+	if (!queryPool) {
+		return;
+	}
+	dispatch->vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 2 * frame + 1);
+	recorded[frame] = true;
+}
+
+bool GpuTimer::getMilliseconds(uint32_t frame, double& milliseconds)
+{
+	if (!queryPool || !recorded[frame]) {
+		return false;
+	}
+	uint64_t timestamps[2];
+	VkResult result = dispatch->vkGetQueryPoolResults(deviceHandle, queryPool, 2 * frame, 2, sizeof(timestamps), timestamps,
+		sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (result == VK_NOT_READY) {
+		return false;
+	}
+	VK_CHECK(result);
+
+	uint64_t ticks = ((timestamps[1] & validMask) - (timestamps[0] & validMask)) & validMask;
+	milliseconds = static_cast<double>(ticks) * period / 1e6;
+	return true;
+}
+
+bool GpuTimer::isSupported()
+{
+	return queryPool != nullptr;
+}
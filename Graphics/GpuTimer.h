@@ -0,0 +1,79 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "LogicalDevice.h"
+
+// Measures the GPU time between two points of a command buffer with timestamp queries.
+// Every frame in flight has its own pair of queries, read without waiting once the frame finished.
+class GpuTimer
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create the query pool, must call init
+	 */
+	GpuTimer();
+
+	/**
+	 * @brief Creates two timestamp queries per frame. Without timestamp support on the queue family
+	 * nothing is created and nothing is measured.
+	 *
+	 * @param device - the logical device to create the query pool under
+	 * @param queueFamily - family of the queues the measured command buffers are submitted to
+	 * @param _frameCount - frames in flight, each measures into its own queries
+	 */
+	void init(LogicalDevice& device, uint32_t queueFamily, uint32_t _frameCount);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~GpuTimer();
+
+	/**
+	 * @brief Destroys the query pool. The device must not be using it anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Resets the frame's queries and writes the start timestamp once all earlier commands started
+	 *
+	 * @param commandBuffer - command buffer outside of a render pass
+	 * @param frame - index of the frame in flight, below the frame count given to init
+	 */
+	void recordStart(VkCommandBuffer commandBuffer, uint32_t frame);
+
+	/**
+	 * @brief Writes the end timestamp once all earlier commands finished
+	 */
+	void recordEnd(VkCommandBuffer commandBuffer, uint32_t frame);
+
+	/**
+	 * @brief Reads the time between the frame's start and end without waiting
+	 *
+	 * @param frame - index of the frame in flight, whose last submission has to have finished
+	 * @param milliseconds - set to the measured time
+	 *
+	 * @return false if the frame was never measured, its results aren't available or timestamps aren't supported
+	 */
+	bool getMilliseconds(uint32_t frame, double& milliseconds);
+
+	/**
+	 * @brief Returns whether the queue family supports timestamps
+	 */
+	bool isSupported();
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkQueryPool queryPool;
+	uint32_t frameCount;
+	// Nanoseconds per timestamp tick
+	double period;
+	// Timestamps only have timestampValidBits bits, the rest is garbage
+	uint64_t validMask;
+	std::vector<bool> recorded;
+};
@@ -0,0 +1,236 @@
+#include "HostAllocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "Profiler.h"
+
+namespace
+{
+	// Command scope allocations of one thread. They end before the command returns,
+	// so the arena is only used by its own thread and can be rewound whenever none are alive.
+	struct CommandArena
+	{
+		std::unique_ptr<std::byte[]> memory;
+		size_t size = 0;
+		size_t head = 0;
+		uint32_t live = 0;
+	};
+
+	thread_local CommandArena commandArena;
+
+	// Stored right before every allocation
+	struct AllocationHeader
+	{
+		size_t size;
+		// Pointer returned by malloc, nullptr for arena allocations
+		void* block;
+		CommandArena* arena;
+		VkSystemAllocationScope scope;
+	};
+
+	std::byte* alignUp(std::byte* pointer, size_t alignment)
+	{
+		uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+		return reinterpret_cast<std::byte*>((address + alignment - 1) & ~(alignment - 1));
+	}
+
+	AllocationHeader* getHeader(void* memory)
+	{
+		return reinterpret_cast<AllocationHeader*>(static_cast<std::byte*>(memory) - sizeof(AllocationHeader));
+	}
+}
+
+HostAllocator::HostAllocator() :
+	initialized(false),
+	callbacks{},
+	commandArenaSize(0),
+	scopes{},
+	arenaAllocations(0)
+{
+}
+
+void HostAllocator::init(size_t _commandArenaSize)
+{
+	commandArenaSize = _commandArenaSize;
+	for (ScopeCounters& counters : scopes) {
+		counters.bytes = 0;
+		counters.peakBytes = 0;
+		counters.allocations = 0;
+		counters.totalAllocations = 0;
+		counters.internalBytes = 0;
+	}
+	arenaAllocations = 0;
+
+	callbacks = {};
+	callbacks.pUserData = this;
+	callbacks.pfnAllocation = allocationCallback;
+	callbacks.pfnReallocation = reallocationCallback;
+	callbacks.pfnFree = freeCallback;
+	callbacks.pfnInternalAllocation = internalAllocationCallback;
+	callbacks.pfnInternalFree = internalFreeCallback;
+	initialized = true;
+}
+
+HostAllocator::~HostAllocator()
+{
+	cleanup();
+}
+
+void HostAllocator::cleanup()
+{
+	initialized = false;
+}
+
+const VkAllocationCallbacks* HostAllocator::getCallbacks()
+{
+	return initialized ? &callbacks : nullptr;
+}
+
+HostAllocationStats HostAllocator::getStats()
+{
+	HostAllocationStats stats{};
+	for (uint32_t i = 0; i < HOST_ALLOCATION_SCOPE_COUNT; i++) {
+		stats.bytes[i] = scopes[i].bytes.load(std::memory_order_relaxed);
+		stats.peakBytes[i] = scopes[i].peakBytes.load(std::memory_order_relaxed);
+		stats.allocations[i] = scopes[i].allocations.load(std::memory_order_relaxed);
+		stats.totalAllocations[i] = scopes[i].totalAllocations.load(std::memory_order_relaxed);
+		stats.internalBytes[i] = scopes[i].internalBytes.load(std::memory_order_relaxed);
+	}
+	stats.arenaAllocations = arenaAllocations.load(std::memory_order_relaxed);
+	return stats;
+}
+
+const char* HostAllocator::getScopeName(VkSystemAllocationScope scope)
+{
+	switch (scope) {
+	case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:
+		return "command";
+	case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:
+		return "object";
+	case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:
+		return "cache";
+	case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:
+		return "device";
+	case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE:
+		return "instance";
+	default:
+		return "unknown";
+	}
+}
+
+void* HostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	alignment = std::max(alignment, alignof(AllocationHeader));
+	std::byte* memory = nullptr;
+	AllocationHeader header{size, nullptr, nullptr, scope};
+
+	if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && commandArenaSize > 0) {
+		CommandArena& arena = commandArena;
+		if (!arena.memory) {
+			arena.memory = std::make_unique<std::byte[]>(commandArenaSize);
+			arena.size = commandArenaSize;
+		}
+		std::byte* candidate = alignUp(arena.memory.get() + arena.head + sizeof(AllocationHeader), alignment);
+		if (candidate + size <= arena.memory.get() + arena.size) {
+			memory = candidate;
+			header.arena = &arena;
+			arena.head = static_cast<size_t>(candidate + size - arena.memory.get());
+			arena.live++;
+			arenaAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Allocations that don't fit in the arena go to malloc
+	if (!memory) {
+		header.block = std::malloc(size + alignment + sizeof(AllocationHeader));
+		if (!header.block) {
+			return nullptr;
+		}
+		memory = alignUp(static_cast<std::byte*>(header.block) + sizeof(AllocationHeader), alignment);
+	}
+	std::memcpy(getHeader(memory), &header, sizeof(header));
+
+	ScopeCounters& counters = scopes[scope];
+	uint64_t bytes = counters.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+	uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+	while (bytes > peak && !counters.peakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+	}
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+	PROFILE_ALLOC(memory, size, "Vulkan host");
+	return memory;
+}
+
+void* HostAllocator::reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (!original) {
+		return allocate(size, alignment, scope);
+	}
+	if (size == 0) {
+		free(original);
+		return nullptr;
+	}
+
+	// The original allocation's scope is kept
+	AllocationHeader* header = getHeader(original);
+	void* memory = allocate(size, alignment, header->scope);
+	if (memory) {
+		std::memcpy(memory, original, std::min(size, header->size));
+		free(original);
+	}
+	return memory;
+}
+
+void HostAllocator::free(void* memory)
+{
+	if (!memory) {
+		return;
+	}
+	PROFILE_FREE(memory, "Vulkan host");
+
+	AllocationHeader header;
+	std::memcpy(&header, getHeader(memory), sizeof(header));
+	ScopeCounters& counters = scopes[header.scope];
+	counters.bytes.fetch_sub(header.size, std::memory_order_relaxed);
+	counters.allocations.fetch_sub(1, std::memory_order_relaxed);
+
+	if (header.arena) {
+		header.arena->live--;
+		if (header.arena->live == 0) {
+			header.arena->head = 0;
+		}
+	} else {
+		std::free(header.block);
+	}
+}
+
+void* HostAllocator::allocationCallback(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	return static_cast<HostAllocator*>(userData)->allocate(size, alignment, scope);
+}
+
+void* HostAllocator::reallocationCallback(void* userData, void* original, size_t size, size_t alignment,
+	VkSystemAllocationScope scope)
+{
+	return static_cast<HostAllocator*>(userData)->reallocate(original, size, alignment, scope);
+}
+
+void HostAllocator::freeCallback(void* userData, void* memory)
+{
+	static_cast<HostAllocator*>(userData)->free(memory);
+}
+
+void HostAllocator::internalAllocationCallback(void* userData, size_t size, VkInternalAllocationType,
+	VkSystemAllocationScope scope)
+{
+	static_cast<HostAllocator*>(userData)->scopes[scope].internalBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void HostAllocator::internalFreeCallback(void* userData, size_t size, VkInternalAllocationType,
+	VkSystemAllocationScope scope)
+{
+	static_cast<HostAllocator*>(userData)->scopes[scope].internalBytes.fetch_sub(size, std::memory_order_relaxed);
+}
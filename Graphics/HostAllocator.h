@@ -0,0 +1,100 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+constexpr uint32_t HOST_ALLOCATION_SCOPE_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+// Host memory used by the driver, every array is indexed by VkSystemAllocationScope
+struct HostAllocationStats
+{
+	// Bytes currently allocated through the callbacks
+	uint64_t bytes[HOST_ALLOCATION_SCOPE_COUNT];
+	uint64_t peakBytes[HOST_ALLOCATION_SCOPE_COUNT];
+	// Allocations currently alive
+	uint64_t allocations[HOST_ALLOCATION_SCOPE_COUNT];
+	uint64_t totalAllocations[HOST_ALLOCATION_SCOPE_COUNT];
+	// Bytes the driver allocated itself, such as executable memory, reported through the internal notifications
+	uint64_t internalBytes[HOST_ALLOCATION_SCOPE_COUNT];
+	// Command scope allocations served by the arenas instead of malloc
+	uint64_t arenaAllocations;
+};
+
+// Allocation callbacks for vulkan objects that track the driver's host memory by allocation scope.
+// Allocations scoped to a single command come from a per thread bump arena that is rewound once all of them
+// were freed, so the short lived allocations made inside vkCreate* calls don't go through malloc.
+// The callbacks may be called from any thread.
+class HostAllocator
+{
+public:
+	/**
+	 * @brief Default Constructor: getCallbacks returns nullptr until init is called
+	 */
+	HostAllocator();
+
+	/**
+	 * @brief Sets up the callbacks
+	 *
+	 * @param commandArenaSize - bytes of the arena each thread gets on its first command scope allocation,
+	 * 0 sends command scope allocations to malloc as well
+	 */
+	void init(size_t commandArenaSize = 64 * 1024);
+
+	/**
+	 * @brief Destructor: Calls cleanup()
+	 */
+	~HostAllocator();
+
+	/**
+	 * @brief Stops handing out the callbacks. Every object created with them must already be destroyed,
+	 * the memory of any that weren't stays allocated.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Returns the callbacks to pass to VulkanInstance::init and LogicalDevice::init,
+	 * nullptr before init so the driver's allocator is used
+	 */
+	const VkAllocationCallbacks* getCallbacks();
+
+	/**
+	 * @brief Returns the memory currently used by the driver and the totals since init
+	 */
+	HostAllocationStats getStats();
+
+	static const char* getScopeName(VkSystemAllocationScope scope);
+
+private:
+	struct ScopeCounters
+	{
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> peakBytes;
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> totalAllocations;
+		std::atomic<uint64_t> internalBytes;
+	};
+
+	bool initialized;
+	VkAllocationCallbacks callbacks;
+	size_t commandArenaSize;
+	ScopeCounters scopes[HOST_ALLOCATION_SCOPE_COUNT];
+	std::atomic<uint64_t> arenaAllocations;
+
+	void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+	void* reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	void free(void* memory);
+
+	static VKAPI_ATTR void* VKAPI_CALL allocationCallback(void* userData, size_t size, size_t alignment,
+		VkSystemAllocationScope scope);
+	static VKAPI_ATTR void* VKAPI_CALL reallocationCallback(void* userData, void* original, size_t size,
+		size_t alignment, VkSystemAllocationScope scope);
+	static VKAPI_ATTR void VKAPI_CALL freeCallback(void* userData, void* memory);
+	static VKAPI_ATTR void VKAPI_CALL internalAllocationCallback(void* userData, size_t size,
+		VkInternalAllocationType type, VkSystemAllocationScope scope);
+	static VKAPI_ATTR void VKAPI_CALL internalFreeCallback(void* userData, size_t size,
+		VkInternalAllocationType type, VkSystemAllocationScope scope);
+};
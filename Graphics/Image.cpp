@@ -0,0 +1,141 @@
+#include "Image.h"
+
+#include "DebugMessenger.h"
+
+Image::Image() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	handle(nullptr),
+	view(nullptr),
+	memory(nullptr),
+	memorySize(0),
+	lazilyAllocated(false),
+	extent{},
+	format(VK_FORMAT_UNDEFINED),
+	mipLevels(0)
+{
+}
+
+void Image::init(LogicalDevice& device, const ImageInfo& info)
+{
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	extent = info.extent;
+	format = info.format;
+	mipLevels = info.mipLevels;
+
+	VkImageCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	createInfo.imageType = VK_IMAGE_TYPE_2D;
+	createInfo.format = format;
+	createInfo.extent = {extent.width, extent.height, 1};
+	createInfo.mipLevels = mipLevels;
+	createInfo.arrayLayers = 1;
+	createInfo.samples = info.samples;
+	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	createInfo.usage = info.usage;
+	createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (info.queueFamilies.size() > 1) {
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = static_cast<uint32_t>(info.queueFamilies.size());
+		createInfo.pQueueFamilyIndices = info.queueFamilies.data();
+	} else {
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
+	VkResult result = dispatch->vkCreateImage(deviceHandle, &createInfo, allocator, &handle); VK_CHECK(result);
+
+	VkMemoryRequirements requirements;
+	dispatch->vkGetImageMemoryRequirements(deviceHandle, handle, &requirements);
+	memorySize = requirements.size;
+
+	VkMemoryPropertyFlags memoryProperties = info.memoryProperties;
+	if ((memoryProperties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+		&& !device.hasMemoryType(requirements.memoryTypeBits, memoryProperties)) {
+		memoryProperties &= ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+	}
+	lazilyAllocated = (memoryProperties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+
+	VkMemoryAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = device.findMemoryType(requirements.memoryTypeBits, memoryProperties);
+	result = dispatch->vkAllocateMemory(deviceHandle, &allocateInfo, allocator, &memory); VK_CHECK(result);
+	result = dispatch->vkBindImageMemory(deviceHandle, handle, memory, 0); VK_CHECK(result);
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = handle;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = info.aspect;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+	result = dispatch->vkCreateImageView(deviceHandle, &viewInfo, allocator, &view); VK_CHECK(result);
+}
+
+Image::~Image()
+{
+	cleanup();
+}
+
+void Image::cleanup()
+{
+	if (deviceHandle) {
+		dispatch->vkDestroyImageView(deviceHandle, view, allocator);
+		dispatch->vkDestroyImage(deviceHandle, handle, allocator);
+		dispatch->vkFreeMemory(deviceHandle, memory, allocator);
+		view = nullptr;
+		handle = nullptr;
+		memory = nullptr;
+		deviceHandle = nullptr;
+	}
+}
+
+VkImage Image::getHandle()
+{
+	return handle;
+}
+
+VkImageView Image::getView()
+{
+	return view;
+}
+
+VkExtent2D Image::getExtent()
+{
+	return extent;
+}
+
+VkFormat Image::getFormat()
+{
+	return format;
+}
+
+uint32_t Image::getMipLevels()
+{
+	return mipLevels;
+}
+
+VkDeviceSize Image::getMemorySize()
+{
+	return memorySize;
+}
+
+bool Image::isLazilyAllocated()
+{
+	return lazilyAllocated;
+}
+
+VkDeviceSize Image::getCommittedMemory()
+{
+	if (!lazilyAllocated) {
+		return memorySize;
+	}
+	VkDeviceSize committed = 0;
+	dispatch->vkGetDeviceMemoryCommitment(deviceHandle, memory, &committed);
+	return committed;
+}
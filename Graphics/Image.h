@@ -0,0 +1,110 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "DebugLabels.h"
+
+struct ImageInfo
+{
+	VkExtent2D extent;
+	VkFormat format;
+	VkImageUsageFlags usage;
+	uint32_t mipLevels = 1;
+	VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+	// With VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT the image falls back to the other properties when no memory type
+	// has it. Lazily allocated memory only suits transient attachments.
+	VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	// Queue families that use the image. With more than one family the image is shared concurrently
+	// so it needs no ownership transfers.
+	std::vector<uint32_t> queueFamilies;
+};
+
+class Image
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create the image, must call init
+	 */
+	Image();
+
+	/**
+	 * @brief Creates a 2D image, binds it to its own memory allocation and creates a view of every mip level.
+	 * 
+	 * @param device - the logical device to create the image under
+	 * @param info - description of the image
+	 */
+	void init(LogicalDevice& device, const ImageInfo& info);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~Image();
+
+	/**
+	 * @brief Destroys the view and the image and frees its memory
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Returns the handle to this image.
+	 * 
+	 * @return image handle
+	 */
+	VkImage getHandle();
+
+	/**
+	 * @brief Returns the view of every mip level
+	 */
+	VkImageView getView();
+
+	VkExtent2D getExtent();
+	VkFormat getFormat();
+	uint32_t getMipLevels();
+
+	/**
+	 * @brief Returns the size in bytes of the memory allocated for the image
+	 */
+	VkDeviceSize getMemorySize();
+
+	/**
+	 * @brief Returns whether the image got lazily allocated memory, which the driver only backs if the
+	 * image has to leave tile memory
+	 */
+	bool isLazilyAllocated();
+
+	/**
+	 * @brief Returns the bytes actually backing lazily allocated memory, getMemorySize for other memory
+	 */
+	VkDeviceSize getCommittedMemory();
+
+	/**
+	 * @brief Names the image, its view and its memory in debuggers and GPU captures, compiles to nothing without APPARATUS_DEBUG_NAMES
+	 *
+	 * @param parts - strings and integers joined into the name, see setObjectName
+	 */
+	template <typename... Parts>
+	void setName(const Parts&... parts)
+	{
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_IMAGE, handle, parts...);
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_IMAGE_VIEW, view, parts..., " view");
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_DEVICE_MEMORY, memory, parts..., " memory");
+	}
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkImage handle;
+	VkImageView view;
+	VkDeviceMemory memory;
+	VkDeviceSize memorySize;
+	bool lazilyAllocated;
+	VkExtent2D extent;
+	VkFormat format;
+	uint32_t mipLevels;
+};
@@ -0,0 +1,419 @@
+#include "IndirectDrawPass.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+#include "GpuProfiler.h"
+
+namespace
+{
+	// Matches the std140 CullData block in Shaders/Cull.comp
+	struct CullData
+	{
+		float viewProjection[16];
+		float frustumPlanes[6][4];
+		float cameraPosition[4];
+		uint32_t objectCount;
+		uint32_t compact;
+		float lodScale;
+		uint32_t phase;
+		float pyramidSize[2];
+		float padding1[2];
+	};
+
+	constexpr uint32_t WORKGROUP_SIZE = 64;
+
+	// Values of CullData::phase
+	constexpr uint32_t SINGLE_PHASE = 0;
+	constexpr uint32_t FIRST_PHASE = 1;
+	constexpr uint32_t SECOND_PHASE = 2;
+
+	// Bits of the per object visibility in Shaders/Cull.comp, bit 0 is whether the object was visible.
+	// A single pass sets the first phase bit of the objects it draws
+	constexpr uint32_t FIRST_PHASE_DRAWN_BIT = 2;
+	constexpr uint32_t SECOND_PHASE_DRAWN_BIT = 4;
+}
+
+IndirectDrawPass::IndirectDrawPass() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	maxObjects(0),
+	objectCount(0),
+	compact(false),
+	multiDraw(false),
+	descriptorPool(nullptr),
+	setLayout(nullptr),
+	pyramidSetLayout(nullptr),
+	set(nullptr),
+	pyramidSet(nullptr),
+	pipelineLayout(nullptr),
+	occlusionPipelineLayout(nullptr),
+	pipeline(nullptr),
+	occlusionPipeline(nullptr),
+	pyramidSize{0.0f, 0.0f},
+	pyramidHistory(false),
+	profiler(nullptr)
+{
+}
+
+void IndirectDrawPass::init(LogicalDevice& device, uint32_t _maxObjects, uint32_t maxMeshes)
+{
+	if (!device.getEnabledFeatures().drawIndirectFirstInstance) {
+		VK_CHECK(VK_ERROR_FEATURE_NOT_PRESENT);
+	}
+
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	maxObjects = _maxObjects;
+	objectCount = 0;
+	pyramidHistory = false;
+	multiDraw = device.getEnabledFeatures().multiDrawIndirect;
+	compact = device.supportsDrawIndirectCount() && dispatch->vkCmdDrawIndexedIndirectCountKHR != nullptr;
+
+	VkMemoryPropertyFlags hostMemory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	objectBuffer.init(device, sizeof(ObjectData) * maxObjects, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+	meshBuffer.init(device, sizeof(MeshInfo) * maxMeshes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+	drawBuffer.init(device, sizeof(VkDrawIndexedIndirectCommand) * maxObjects,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	countBuffer.init(device, sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	cullDataBuffer.init(device, sizeof(CullData),
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	// Mapped so getCullStats can count the draws, every object starts out hidden
+	visibilityBuffer.init(device, sizeof(uint32_t) * maxObjects, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+	std::memset(visibilityBuffer.getMapped(), 0, sizeof(uint32_t) * maxObjects);
+	objectBuffer.setName("IndirectDrawPass objects");
+	meshBuffer.setName("IndirectDrawPass meshes");
+	drawBuffer.setName("IndirectDrawPass draws");
+	countBuffer.setName("IndirectDrawPass draw count");
+	cullDataBuffer.setName("IndirectDrawPass cull data");
+	visibilityBuffer.setName("IndirectDrawPass visibility");
+
+	createDescriptors();
+
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	VkResult result = dispatch->vkCreatePipelineLayout(deviceHandle, &layoutInfo, allocator, &pipelineLayout); VK_CHECK(result);
+
+	VkDescriptorSetLayout occlusionLayouts[] = {setLayout, pyramidSetLayout};
+	layoutInfo.setLayoutCount = 2;
+	layoutInfo.pSetLayouts = occlusionLayouts;
+	result = dispatch->vkCreatePipelineLayout(deviceHandle, &layoutInfo, allocator, &occlusionPipelineLayout); VK_CHECK(result);
+
+	pipeline = createPipeline(device, "Cull.comp.spv", pipelineLayout);
+	occlusionPipeline = createPipeline(device, "CullOcclusion.comp.spv", occlusionPipelineLayout);
+}
+
+IndirectDrawPass::~IndirectDrawPass()
+{
+	cleanup();
+}
+
+void IndirectDrawPass::cleanup()
+{
+	if (deviceHandle) {
+		dispatch->vkDestroyPipeline(deviceHandle, occlusionPipeline, allocator);
+		dispatch->vkDestroyPipeline(deviceHandle, pipeline, allocator);
+		dispatch->vkDestroyPipelineLayout(deviceHandle, occlusionPipelineLayout, allocator);
+		dispatch->vkDestroyPipelineLayout(deviceHandle, pipelineLayout, allocator);
+		// Destroying the pool frees its sets
+		dispatch->vkDestroyDescriptorPool(deviceHandle, descriptorPool, allocator);
+		dispatch->vkDestroyDescriptorSetLayout(deviceHandle, pyramidSetLayout, allocator);
+		dispatch->vkDestroyDescriptorSetLayout(deviceHandle, setLayout, allocator);
+		occlusionPipeline = nullptr;
+		pipeline = nullptr;
+		occlusionPipelineLayout = nullptr;
+		pipelineLayout = nullptr;
+		descriptorPool = nullptr;
+		pyramidSetLayout = nullptr;
+		setLayout = nullptr;
+		set = nullptr;
+		pyramidSet = nullptr;
+
+		visibilityBuffer.cleanup();
+		cullDataBuffer.cleanup();
+		countBuffer.cleanup();
+		drawBuffer.cleanup();
+		meshBuffer.cleanup();
+		objectBuffer.cleanup();
+		deviceHandle = nullptr;
+	}
+}
+
+ObjectData* IndirectDrawPass::getObjects()
+{
+	return static_cast<ObjectData*>(objectBuffer.getMapped());
+}
+
+MeshInfo* IndirectDrawPass::getMeshes()
+{
+	return static_cast<MeshInfo*>(meshBuffer.getMapped());
+}
+
+void IndirectDrawPass::setObjectCount(uint32_t count)
+{
+	objectCount = count < maxObjects ? count : maxObjects;
+}
+
+void IndirectDrawPass::setDepthPyramid(VkImageView view, VkSampler sampler, uint32_t width, uint32_t height)
+{
+	pyramidSize[0] = static_cast<float>(width);
+	pyramidSize[1] = static_cast<float>(height);
+	pyramidHistory = false;
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = sampler;
+	imageInfo.imageView = view;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = pyramidSet;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+	dispatch->vkUpdateDescriptorSets(deviceHandle, 1, &write, 0, nullptr);
+}
+
+void IndirectDrawPass::setProfiler(GpuProfiler* _profiler)
+{
+	profiler = _profiler;
+}
+
+void IndirectDrawPass::recordCull(VkCommandBuffer commandBuffer, const CullView& view)
+{
+	CommandLabel label(*dispatch, commandBuffer, "Cull");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Cull");
+	recordCullPass(commandBuffer, view, SINGLE_PHASE);
+}
+
+void IndirectDrawPass::recordCullFirstPhase(VkCommandBuffer commandBuffer, const CullView& view)
+{
+	CommandLabel label(*dispatch, commandBuffer, "Cull first phase");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Cull first phase");
+	recordCullPass(commandBuffer, view, FIRST_PHASE);
+}
+
+void IndirectDrawPass::recordCullSecondPhase(VkCommandBuffer commandBuffer, const CullView& view)
+{
+	if (pyramidSize[0] <= 0.0f) {
+		throw std::runtime_error("the second culling phase needs a depth pyramid");
+	}
+
+	CommandLabel label(*dispatch, commandBuffer, "Cull second phase");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Cull second phase");
+	recordCullPass(commandBuffer, view, SECOND_PHASE);
+	pyramidHistory = true;
+}
+
+CullStats IndirectDrawPass::getCullStats()
+{
+	CullStats stats{objectCount, 0, 0};
+	const uint32_t* visibility = static_cast<const uint32_t*>(visibilityBuffer.getMapped());
+	for (uint32_t i = 0; i < objectCount; i++) {
+		stats.firstPhaseDraws += (visibility[i] & FIRST_PHASE_DRAWN_BIT) != 0;
+		stats.secondPhaseDraws += (visibility[i] & SECOND_PHASE_DRAWN_BIT) != 0;
+	}
+	return stats;
+}
+
+void IndirectDrawPass::recordCullPass(VkCommandBuffer commandBuffer, const CullView& view, uint32_t phase)
+{
+	// The first phase can only test occlusion once the pyramid holds an earlier frame's depth
+	bool occlusion = pyramidSize[0] > 0.0f && (phase != FIRST_PHASE || pyramidHistory);
+
+	CullData data{};
+	std::memcpy(data.viewProjection, view.viewProjection, sizeof(data.viewProjection));
+	extractFrustumPlanes(view.viewProjection, data.frustumPlanes);
+	std::memcpy(data.cameraPosition, view.cameraPosition, sizeof(view.cameraPosition));
+	data.objectCount = objectCount;
+	data.compact = compact ? 1 : 0;
+	data.lodScale = view.lodScale;
+	data.phase = phase;
+	data.pyramidSize[0] = pyramidSize[0];
+	data.pyramidSize[1] = pyramidSize[1];
+
+	// The previous frame's draws and culling have to finish before their inputs are overwritten,
+	// and the previous phase's visibility has to be written before this one reads it
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	dispatch->vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	dispatch->vkCmdUpdateBuffer(commandBuffer, cullDataBuffer.getHandle(), 0, sizeof(CullData), &data);
+	dispatch->vkCmdFillBuffer(commandBuffer, countBuffer.getHandle(), 0, sizeof(uint32_t), 0);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	dispatch->vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	if (occlusion) {
+		VkDescriptorSet sets[] = {set, pyramidSet};
+		dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusionPipeline);
+		dispatch->vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusionPipelineLayout, 0, 2, sets, 0, nullptr);
+	} else {
+		dispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		dispatch->vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+	}
+	dispatch->vkCmdDispatch(commandBuffer, (objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+	// The host reads the visibility in getCullStats once the submission finished. Its memory is host coherent,
+	// so the barrier is all it takes to make the writes visible, no invalidate is needed.
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	dispatch->vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void IndirectDrawPass::recordDraw(VkCommandBuffer commandBuffer)
+{
+	CommandLabel label(*dispatch, commandBuffer, "Indirect draws");
+	PROFILE_GPU_ZONE(profiler, commandBuffer, "Indirect draws");
+	uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	if (compact) {
+		dispatch->vkCmdDrawIndexedIndirectCountKHR(commandBuffer, drawBuffer.getHandle(), 0, countBuffer.getHandle(), 0, objectCount, stride);
+	} else if (multiDraw) {
+		dispatch->vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer.getHandle(), 0, objectCount, stride);
+	} else {
+		// Without multiDrawIndirect each draw needs its own call
+		for (uint32_t i = 0; i < objectCount; i++) {
+			dispatch->vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer.getHandle(), i * stride, 1, stride);
+		}
+	}
+}
+
+VkBuffer IndirectDrawPass::getObjectBuffer()
+{
+	return objectBuffer.getHandle();
+}
+
+void IndirectDrawPass::createDescriptors()
+{
+	VkDescriptorSetLayoutBinding bindings[6]{};
+	for (uint32_t i = 0; i < 6; i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 6;
+	layoutInfo.pBindings = bindings;
+	VkResult result = dispatch->vkCreateDescriptorSetLayout(deviceHandle, &layoutInfo, allocator, &setLayout); VK_CHECK(result);
+
+	VkDescriptorSetLayoutBinding pyramidBinding{};
+	pyramidBinding.binding = 0;
+	pyramidBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pyramidBinding.descriptorCount = 1;
+	pyramidBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &pyramidBinding;
+	result = dispatch->vkCreateDescriptorSetLayout(deviceHandle, &layoutInfo, allocator, &pyramidSetLayout); VK_CHECK(result);
+
+	VkDescriptorPoolSize poolSizes[] = {
+		{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
+		{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5},
+		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1}
+	};
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = 2;
+	poolInfo.poolSizeCount = 3;
+	poolInfo.pPoolSizes = poolSizes;
+	result = dispatch->vkCreateDescriptorPool(deviceHandle, &poolInfo, allocator, &descriptorPool); VK_CHECK(result);
+
+	VkDescriptorSetLayout layouts[] = {setLayout, pyramidSetLayout};
+	VkDescriptorSet sets[2];
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = descriptorPool;
+	allocateInfo.descriptorSetCount = 2;
+	allocateInfo.pSetLayouts = layouts;
+	result = dispatch->vkAllocateDescriptorSets(deviceHandle, &allocateInfo, sets); VK_CHECK(result);
+	set = sets[0];
+	pyramidSet = sets[1];
+
+	VkDescriptorBufferInfo bufferInfos[] = {
+		{cullDataBuffer.getHandle(), 0, VK_WHOLE_SIZE},
+		{objectBuffer.getHandle(), 0, VK_WHOLE_SIZE},
+		{meshBuffer.getHandle(), 0, VK_WHOLE_SIZE},
+		{drawBuffer.getHandle(), 0, VK_WHOLE_SIZE},
+		{countBuffer.getHandle(), 0, VK_WHOLE_SIZE},
+		{visibilityBuffer.getHandle(), 0, VK_WHOLE_SIZE}
+	};
+	VkWriteDescriptorSet writes[6]{};
+	for (uint32_t i = 0; i < 6; i++) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = set;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = bindings[i].descriptorType;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	dispatch->vkUpdateDescriptorSets(deviceHandle, 6, writes, 0, nullptr);
+}
+
+VkPipeline IndirectDrawPass::createPipeline(LogicalDevice& device, const char* shaderName, VkPipelineLayout layout)
+{
+	Shader shader;
+	shader.init(device, shaderName);
+
+	VkComputePipelineCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	createInfo.stage.module = shader.getHandle();
+	createInfo.stage.pName = "main";
+	createInfo.layout = layout;
+
+	VkPipeline createdPipeline = nullptr;
+	VkResult result = dispatch->vkCreateComputePipelines(deviceHandle, nullptr, 1, &createInfo, allocator, &createdPipeline); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_PIPELINE, createdPipeline, shaderName);
+	return createdPipeline;
+}
+
+void IndirectDrawPass::extractFrustumPlanes(const float m[16], float planes[6][4])
+{
+	// Rows of the column major matrix
+	float rows[4][4];
+	for (int row = 0; row < 4; row++) {
+		for (int column = 0; column < 4; column++) {
+			rows[row][column] = m[column * 4 + row];
+		}
+	}
+
+	for (int i = 0; i < 4; i++) {
+		planes[0][i] = rows[3][i] + rows[0][i];
+		planes[1][i] = rows[3][i] - rows[0][i];
+		planes[2][i] = rows[3][i] + rows[1][i];
+		planes[3][i] = rows[3][i] - rows[1][i];
+		// Vulkan clip space depth goes from 0 to w
+		planes[4][i] = rows[2][i];
+		planes[5][i] = rows[3][i] - rows[2][i];
+	}
+
+	for (int plane = 0; plane < 6; plane++) {
+		float length = std::sqrt(planes[plane][0] * planes[plane][0] + planes[plane][1] * planes[plane][1] + planes[plane][2] * planes[plane][2]);
+		for (int i = 0; i < 4; i++) {
+			planes[plane][i] /= length;
+		}
+	}
+}
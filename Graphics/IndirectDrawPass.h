@@ -0,0 +1,213 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "LogicalDevice.h"
+#include "Buffer.h"
+#include "Shader.h"
+
+class GpuProfiler;
+
+constexpr uint32_t MAX_MESH_LODS = 4;
+
+// Per object data read by the culling shader, and by vertex shaders through gl_InstanceIndex.
+// Matches the std430 layout in Shaders/Cull.comp
+struct ObjectData
+{
+	// Column major
+	float model[16];
+	// xyz is the center in object space, w is the radius
+	float boundingSphere[4];
+	uint32_t meshIndex;
+	uint32_t padding[3];
+};
+
+struct MeshLod
+{
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	// This lod is used while the object's distance to the camera is below maxDistance
+	float maxDistance;
+};
+
+// Lods are ordered from most to least detailed, the last lod is used past every maxDistance.
+// Objects of a mesh with a lodCount of 0 are culled, counts above MAX_MESH_LODS are clamped.
+struct MeshInfo
+{
+	MeshLod lods[MAX_MESH_LODS];
+	uint32_t lodCount;
+	uint32_t padding[3];
+};
+
+// Camera information for one culling pass
+struct CullView
+{
+	// Column major, maps world space to vulkan clip space
+	float viewProjection[16];
+	float cameraPosition[3];
+	// Multiplies distances before lods are picked, larger values pick coarser lods
+	float lodScale = 1.0f;
+};
+
+// Draws of the last two phase occlusion culling, counted from the per object visibility
+struct CullStats
+{
+	uint32_t objectCount;
+	// Objects visible in the previous frame that still passed against its depth pyramid,
+	// or every drawn object after recordCull
+	uint32_t firstPhaseDraws;
+	// Objects that only passed against the pyramid of the first phase's depth
+	uint32_t secondPhaseDraws;
+};
+
+class IndirectDrawPass
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create any resources, must call init
+	 */
+	IndirectDrawPass();
+
+	/**
+	 * @brief Creates the object, mesh and draw buffers and the culling pipeline.
+	 * Draws are compacted with vkCmdDrawIndexedIndirectCountKHR when the device supports it,
+	 * otherwise every object gets a draw slot and culled objects get an instance count of 0.
+	 *
+	 * Throws an error if the device doesn't support drawIndirectFirstInstance.
+	 *
+	 * @param device - the logical device to create the resources under
+	 * @param maxObjects - capacity of the object buffer
+	 * @param maxMeshes - capacity of the mesh buffer
+	 */
+	void init(LogicalDevice& device, uint32_t maxObjects, uint32_t maxMeshes);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~IndirectDrawPass();
+
+	/**
+	 * @brief Destroys all resources. The device must not be using them anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Returns the mapped object buffer with room for maxObjects objects.
+	 * Only write to objects the GPU isn't reading, such as after the previous frame's fence was waited on.
+	 */
+	ObjectData* getObjects();
+
+	/**
+	 * @brief Returns the mapped mesh buffer with room for maxMeshes meshes.
+	 */
+	MeshInfo* getMeshes();
+
+	/**
+	 * @brief Sets how many objects from the start of the object buffer are culled and drawn.
+	 */
+	void setObjectCount(uint32_t count);
+
+	/**
+	 * @brief Enables occlusion culling against a depth pyramid, where each texel holds
+	 * the farthest depth of the texels it covers in the previous mip. The first phase of two phase culling
+	 * skips the occlusion test until the second phase has been recorded with this pyramid.
+	 *
+	 * @param view - view of every mip of the pyramid, such as DepthPyramid::getView,
+	 * in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL when culling
+	 * @param sampler - nearest filtering sampler with clamp to edge addressing
+	 * @param width - width of mip 0
+	 * @param height - height of mip 0
+	 */
+	void setDepthPyramid(VkImageView view, VkSampler sampler, uint32_t width, uint32_t height);
+
+	/**
+	 * @brief Times the culling and the draws as GPU zones, does nothing without APPARATUS_TRACY
+	 *
+	 * @param _profiler - initialized profiler of the queue the commands are submitted to, nullptr to stop
+	 */
+	void setProfiler(GpuProfiler* _profiler);
+
+	/**
+	 * @brief Records the culling dispatch and the barriers around it.
+	 * Must be recorded outside of a render pass, before recordDraw.
+	 *
+	 * @param commandBuffer - command buffer in the recording state on a queue that supports compute
+	 * @param view - camera used for frustum culling and lod selection
+	 */
+	void recordCull(VkCommandBuffer commandBuffer, const CullView& view);
+
+	/**
+	 * @brief First phase of two phase occlusion culling, replaces recordCull. Keeps the objects that were visible
+	 * in the previous frame's second phase, and aren't occluded in the depth pyramid, which still holds the depth of
+	 * the previous frame's first phase. Draw them with recordDraw, then build the pyramid from their depth and record
+	 * the second phase.
+	 * Every object starts out hidden, so the first frame only draws in the second phase.
+	 *
+	 * @param commandBuffer - command buffer in the recording state on a queue that supports compute
+	 * @param view - camera used for frustum culling, occlusion culling and lod selection
+	 */
+	void recordCullFirstPhase(VkCommandBuffer commandBuffer, const CullView& view);
+
+	/**
+	 * @brief Second phase of two phase occlusion culling. Tests every object against the pyramid built from the
+	 * first phase's depth and keeps the visible ones the first phase didn't draw, such as objects that were
+	 * occluded last frame. Draw them with recordDraw into the same depth. Needs setDepthPyramid.
+	 *
+	 * @param commandBuffer - command buffer in the recording state on a queue that supports compute
+	 * @param view - the camera given to recordCullFirstPhase
+	 */
+	void recordCullSecondPhase(VkCommandBuffer commandBuffer, const CullView& view);
+
+	/**
+	 * @brief Counts the draws of the last culling, a single recordCull counts as a first phase.
+	 * Only valid once its submission finished, and it reads the visibility of every object on the CPU.
+	 */
+	CullStats getCullStats();
+
+	/**
+	 * @brief Records the draws of every visible object. The CPU cost doesn't depend on the object count
+	 * unless the device lacks multiDrawIndirect.
+	 * The graphics pipeline, vertex buffer and index buffer must already be bound.
+	 *
+	 * @param commandBuffer - command buffer inside a render pass
+	 */
+	void recordDraw(VkCommandBuffer commandBuffer);
+
+	/**
+	 * @brief Returns the object buffer so vertex shaders can read object data
+	 */
+	VkBuffer getObjectBuffer();
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	uint32_t maxObjects;
+	uint32_t objectCount;
+	bool compact;
+	bool multiDraw;
+
+	Buffer objectBuffer, meshBuffer, drawBuffer, countBuffer, cullDataBuffer, visibilityBuffer;
+
+	VkDescriptorPool descriptorPool;
+	VkDescriptorSetLayout setLayout, pyramidSetLayout;
+	VkDescriptorSet set, pyramidSet;
+	VkPipelineLayout pipelineLayout, occlusionPipelineLayout;
+	VkPipeline pipeline, occlusionPipeline;
+	float pyramidSize[2];
+	// Whether the pyramid holds the depth of a previous frame, which the first phase needs for occlusion
+	bool pyramidHistory;
+	GpuProfiler* profiler;
+
+	void createDescriptors();
+	void recordCullPass(VkCommandBuffer commandBuffer, const CullView& view, uint32_t phase);
+	VkPipeline createPipeline(LogicalDevice& device, const char* shaderName, VkPipelineLayout layout);
+
+	/**
+	 * @brief Extracts the inward facing, normalized frustum planes of a vulkan clip space matrix
+	 * in the order left, right, bottom, top, near, far
+	 */
+	static void extractFrustumPlanes(const float viewProjection[16], float planes[6][4]);
+};
@@ -1,55 +1,176 @@
 #include "LogicalDevice.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include "DebugMessenger.h"
+#include "FrameArena.h"
+#include "Profiler.h"
 
 LogicalDevice::LogicalDevice() :
 	handle(nullptr),
 	physicalDevice(nullptr),
+	allocator(nullptr),
+	instanceDispatch(nullptr),
+	dispatch{},
 	graphicsFamily{},
-	presentFamily{}
+	presentFamily{},
+	transferFamily{},
+	computeFamily{},
+	enabledExtensions{},
+	enabledFeatures{},
+	deviceProperties{},
+	subgroupProperties{}
 {
 }
 
-void LogicalDevice::init(VkPhysicalDevice _physicalDevice, Surface& surface)
+void LogicalDevice::init(VkPhysicalDevice _physicalDevice, Surface& surface, const VkAllocationCallbacks* _allocator)
 {
+	init(_physicalDevice, std::vector<Surface*>{&surface}, _allocator);
+}
+
+void LogicalDevice::init(VkPhysicalDevice _physicalDevice, const std::vector<Surface*>& surfaces,
+	const VkAllocationCallbacks* _allocator)
+{
+	PROFILE_ZONE();
 	physicalDevice = _physicalDevice;
+	allocator = _allocator;
 	if (physicalDevice == nullptr) {
 		VK_CHECK(VK_ERROR_INCOMPATIBLE_DRIVER);
 	}
+	if (surfaces.empty()) {
+		VK_CHECK(VK_ERROR_SURFACE_LOST_KHR);
+	}
+	// Every surface is created under the instance the physical device belongs to
+	instanceDispatch = &surfaces.front()->getInstanceDispatch();
 
 	VkDeviceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
 	// Get queue families and create infos for queues
-	graphicsFamily.index = findGraphicsFamily(physicalDevice);
-	presentFamily.index = findPresentFamily(physicalDevice, surface);
+	graphicsFamily.index = findGraphicsFamily(*instanceDispatch, physicalDevice);
+	presentFamily.index = findPresentFamily(*instanceDispatch, physicalDevice, surfaces);
+	transferFamily.index = findTransferFamily(*instanceDispatch, physicalDevice);
+	computeFamily.index = findComputeFamily(*instanceDispatch, physicalDevice);
+	if (!graphicsFamily.index.has_value() || !presentFamily.index.has_value()) {
+		VK_CHECK(VK_ERROR_SURFACE_LOST_KHR);
+	}
+	if (!computeFamily.index.has_value()) {
+		VK_CHECK(VK_ERROR_FEATURE_NOT_PRESENT);
+	}
 	float priority = 1.0f;
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos{};
-	if (graphicsFamily.index.value() == presentFamily.index.value()) {
-		getQueueCreateInfos(queueCreateInfos,
-			graphicsFamily.index.value(), 1, &priority);
-	} else {
-		getQueueCreateInfos(queueCreateInfos,
-			graphicsFamily.index.value(), 1, &priority,
-			presentFamily.index.value(), 1, &priority);
+	// Each family may only get one create info, so families shared between roles are skipped
+	std::vector<uint32_t> uniqueFamilies{};
+	for (uint32_t index : {graphicsFamily.index.value(), presentFamily.index.value(), transferFamily.index.value(), computeFamily.index.value()}) {
+		bool found = false;
+		for (uint32_t uniqueIndex : uniqueFamilies) {
+			if (uniqueIndex == index) {
+				found = true;
+			}
+		}
+
+		if (!found) {
+			uniqueFamilies.push_back(index);
+			getQueueCreateInfos(queueCreateInfos, index, 1, &priority);
+		}
 	}
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-	auto extensions = getRequiredExtensions();
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
-	createInfo.ppEnabledExtensionNames = extensions.data();
+	// Optional extensions are enabled whenever the device supports them
+	enabledExtensions = getRequiredExtensions();
+	for (const char* extension : getOptionalExtensions()) {
+		if (isExtensionsSupported(*instanceDispatch, physicalDevice, {extension})) {
+			enabledExtensions.push_back(extension);
+		}
+	}
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+	createInfo.ppEnabledExtensionNames = enabledExtensions.data();
+
+	// Only optional features are used, enable the ones that are supported
+	VkPhysicalDeviceFeatures supportedFeatures{};
+	instanceDispatch->vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+	enabledFeatures = {};
+	enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+	enabledFeatures.shaderStorageImageArrayDynamicIndexing = supportedFeatures.shaderStorageImageArrayDynamicIndexing;
+	// Sparse binds are done on the graphics queue, so its family has to support them
+	ScratchScope scratch;
+	auto queueFamilies = getQueueFamilies(*instanceDispatch, physicalDevice, scratch.getResource());
+	if (queueFamilies[graphicsFamily.index.value()].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) {
+		enabledFeatures.sparseBinding = supportedFeatures.sparseBinding;
+		enabledFeatures.sparseResidencyImage2D = supportedFeatures.sparseResidencyImage2D;
+	}
+	createInfo.pEnabledFeatures = &enabledFeatures;
+
+	// Mesh shaders need SPIR-V 1.4, which is core from vulkan 1.2
+	instanceDispatch->vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+	// Core functions of a version can only be used when both the instance and the device support it
+	uint32_t apiVersion = std::min(deviceProperties.apiVersion, instanceDispatch->apiVersion);
+
+	// Subgroup properties are core from vulkan 1.1
+	subgroupProperties = {};
+	subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+	if (apiVersion >= VK_API_VERSION_1_1) {
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &subgroupProperties;
+		instanceDispatch->vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+		subgroupProperties.pNext = nullptr;
+	}
 
-	// No features are currently needed
-	VkPhysicalDeviceFeatures features{};
-	createInfo.pEnabledFeatures = &features;
+	// Fault reports after a device loss, without the vendor binary which needs a vendor tool to read
+	VkPhysicalDeviceFaultFeaturesEXT faultFeatures{};
+	faultFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FAULT_FEATURES_EXT;
+	if (apiVersion >= VK_API_VERSION_1_1 && isExtensionsSupported(*instanceDispatch, physicalDevice, {VK_EXT_DEVICE_FAULT_EXTENSION_NAME})) {
+		VkPhysicalDeviceFeatures2 features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &faultFeatures;
+		instanceDispatch->vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+		if (faultFeatures.deviceFault) {
+			faultFeatures = {};
+			faultFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FAULT_FEATURES_EXT;
+			faultFeatures.deviceFault = VK_TRUE;
+			faultFeatures.pNext = const_cast<void*>(createInfo.pNext);
+			createInfo.pNext = &faultFeatures;
+			enabledExtensions.push_back(VK_EXT_DEVICE_FAULT_EXTENSION_NAME);
+			createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+			createInfo.ppEnabledExtensionNames = enabledExtensions.data();
+		}
+	}
+
+	VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{};
+	meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+	if (apiVersion >= VK_API_VERSION_1_2 && isExtensionsSupported(*instanceDispatch, physicalDevice, {VK_EXT_MESH_SHADER_EXTENSION_NAME})) {
+		VkPhysicalDeviceFeatures2 features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &meshShaderFeatures;
+		instanceDispatch->vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+		if (meshShaderFeatures.taskShader && meshShaderFeatures.meshShader) {
+			// Only the two stages are used, not multiview or shading rate with mesh shaders
+			VkPhysicalDeviceMeshShaderFeaturesEXT supported = meshShaderFeatures;
+			meshShaderFeatures = {};
+			meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+			meshShaderFeatures.taskShader = supported.taskShader;
+			meshShaderFeatures.meshShader = supported.meshShader;
+			meshShaderFeatures.pNext = const_cast<void*>(createInfo.pNext);
+			createInfo.pNext = &meshShaderFeatures;
+			enabledExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+			createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+			createInfo.ppEnabledExtensionNames = enabledExtensions.data();
+		}
+	}
 
-	VkResult result = vkCreateDevice(physicalDevice, &createInfo, nullptr, &handle); VK_CHECK(result);
+	VkResult result = instanceDispatch->vkCreateDevice(physicalDevice, &createInfo, allocator, &handle); VK_CHECK(result);
+	dispatch.load(*instanceDispatch, handle);
 
-	vkGetDeviceQueue(handle, graphicsFamily.index.value(), 0, &graphicsFamily.queue);
-	vkGetDeviceQueue(handle, presentFamily.index.value(), 0, &presentFamily.queue);
+	dispatch.vkGetDeviceQueue(handle, graphicsFamily.index.value(), 0, &graphicsFamily.queue);
+	dispatch.vkGetDeviceQueue(handle, presentFamily.index.value(), 0, &presentFamily.queue);
+	dispatch.vkGetDeviceQueue(handle, transferFamily.index.value(), 0, &transferFamily.queue);
+	dispatch.vkGetDeviceQueue(handle, computeFamily.index.value(), 0, &computeFamily.queue);
 }
 
 LogicalDevice::~LogicalDevice()
@@ -60,8 +181,9 @@ LogicalDevice::~LogicalDevice()
 void LogicalDevice::cleanup()
 {
 	if (handle) {
-		vkDestroyDevice(handle, nullptr);
+		dispatch.vkDestroyDevice(handle, allocator);
 		handle = nullptr;
+		dispatch = {};
 	}
 }
 
@@ -75,11 +197,200 @@ VkPhysicalDevice LogicalDevice::getPhysicalDevice()
 	return physicalDevice;
 }
 
+const VkAllocationCallbacks* LogicalDevice::getAllocator()
+{
+	return allocator;
+}
+
+const DeviceDispatch& LogicalDevice::getDispatch()
+{
+	return dispatch;
+}
+
+VkQueue LogicalDevice::getGraphicsQueue()
+{
+	return graphicsFamily.queue;
+}
+
+VkQueue LogicalDevice::getPresentQueue()
+{
+	return presentFamily.queue;
+}
+
+uint32_t LogicalDevice::getGraphicsFamilyIndex()
+{
+	return graphicsFamily.index.value();
+}
+
+uint32_t LogicalDevice::getPresentFamilyIndex()
+{
+	return presentFamily.index.value();
+}
+
+bool LogicalDevice::supportsSurface(Surface& surface)
+{
+	return surface.supportsQueueFamily(physicalDevice, presentFamily.index.value()) == VK_TRUE;
+}
+
+VkQueue LogicalDevice::getTransferQueue()
+{
+	return transferFamily.queue;
+}
+
+uint32_t LogicalDevice::getTransferFamilyIndex()
+{
+	return transferFamily.index.value();
+}
+
+VkQueue LogicalDevice::getComputeQueue()
+{
+	return computeFamily.queue;
+}
+
+uint32_t LogicalDevice::getComputeFamilyIndex()
+{
+	return computeFamily.index.value();
+}
+
+const VkPhysicalDeviceProperties& LogicalDevice::getProperties()
+{
+	return deviceProperties;
+}
+
+uint32_t LogicalDevice::getTimestampValidBits(uint32_t queueFamily)
+{
+	ScratchScope scratch;
+	auto queueFamilies = getQueueFamilies(*instanceDispatch, physicalDevice, scratch.getResource());
+	return queueFamilies[queueFamily].timestampValidBits;
+}
+
+VkFormatFeatureFlags LogicalDevice::getFormatFeatures(VkFormat format)
+{
+	VkFormatProperties properties{};
+	instanceDispatch->vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+	return properties.optimalTilingFeatures;
+}
+
+const VkPhysicalDeviceSubgroupProperties& LogicalDevice::getSubgroupProperties()
+{
+	return subgroupProperties;
+}
+
+bool LogicalDevice::supportsComputeSubgroups()
+{
+	VkSubgroupFeatureFlags operations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT;
+	return (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT)
+		&& (subgroupProperties.supportedOperations & operations) == operations;
+}
+
+bool LogicalDevice::isExtensionEnabled(const char* extension)
+{
+	for (const char* enabledExtension : enabledExtensions) {
+		if (std::strcmp(extension, enabledExtension) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const VkPhysicalDeviceFeatures& LogicalDevice::getEnabledFeatures()
+{
+	return enabledFeatures;
+}
+
+bool LogicalDevice::supportsDrawIndirectCount()
+{
+	return isExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+}
+
+bool LogicalDevice::supportsMeshShaders()
+{
+	return isExtensionEnabled(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+}
+
+bool LogicalDevice::supportsBufferMarkers()
+{
+	return isExtensionEnabled(VK_AMD_BUFFER_MARKER_EXTENSION_NAME);
+}
+
+bool LogicalDevice::supportsDeviceFault()
+{
+	return isExtensionEnabled(VK_EXT_DEVICE_FAULT_EXTENSION_NAME);
+}
+
+bool LogicalDevice::supportsSparseResidency()
+{
+	return enabledFeatures.sparseBinding && enabledFeatures.sparseResidencyImage2D;
+}
+
+VkDeviceSize LogicalDevice::getDeviceLocalHeapSize()
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	instanceDispatch->vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	VkDeviceSize size = 0;
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+		if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+			size += memoryProperties.memoryHeaps[i].size;
+		}
+	}
+	return size;
+}
+
+uint32_t LogicalDevice::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	instanceDispatch->vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			return i;
+		}
+	}
+
+	VK_CHECK(VK_ERROR_FEATURE_NOT_PRESENT);
+	return 0;
+}
+
+bool LogicalDevice::hasMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	instanceDispatch->vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<VkQueue> LogicalDevice::getQueues()
+{
+	std::vector<VkQueue> queues{};
+	for (VkQueue queue : {graphicsFamily.queue, presentFamily.queue, transferFamily.queue, computeFamily.queue}) {
+		bool found = false;
+		for (VkQueue uniqueQueue : queues) {
+			if (uniqueQueue == queue) {
+				found = true;
+			}
+		}
+
+		if (!found) {
+			queues.push_back(queue);
+		}
+	}
+	return queues;
+}
+
 VkPhysicalDevice LogicalDevice::findSuitablePhysicalDevice(VulkanInstance& instance, Surface& surface)
+{
+	return findSuitablePhysicalDevice(instance, std::vector<Surface*>{&surface});
+}
+
+VkPhysicalDevice LogicalDevice::findSuitablePhysicalDevice(VulkanInstance& instance, const std::vector<Surface*>& surfaces)
 {
 	auto physicalDevices = getPhysicalDevices(instance);
 	for (auto device : physicalDevices) {
-		if (isPhysicalDeviceSuitable(device, surface)) {
+		if (isPhysicalDeviceSuitable(instance, device, surfaces)) {
 			return device;
 		}
 	}
@@ -90,30 +401,43 @@ VkPhysicalDevice LogicalDevice::findSuitablePhysicalDevice(VulkanInstance& insta
 std::vector<VkPhysicalDevice> LogicalDevice::getPhysicalDevices(VulkanInstance& instance)
 {
 	uint32_t count = 0;
-	vkEnumeratePhysicalDevices(instance.getHandle(), &count, nullptr);
+	instance.getDispatch().vkEnumeratePhysicalDevices(instance.getHandle(), &count, nullptr);
 	std::vector<VkPhysicalDevice> physicalDevices(count);
-	vkEnumeratePhysicalDevices(instance.getHandle(), &count, physicalDevices.data());
+	instance.getDispatch().vkEnumeratePhysicalDevices(instance.getHandle(), &count, physicalDevices.data());
 	return physicalDevices;
 }
 
-bool LogicalDevice::isPhysicalDeviceSuitable(VkPhysicalDevice device, Surface& surface)
+bool LogicalDevice::isPhysicalDeviceSuitable(VulkanInstance& instance, VkPhysicalDevice device, Surface& surface)
+{
+	return isPhysicalDeviceSuitable(instance, device, std::vector<Surface*>{&surface});
+}
+
+bool LogicalDevice::isPhysicalDeviceSuitable(VulkanInstance& instance, VkPhysicalDevice device, const std::vector<Surface*>& surfaces)
 {
+	const InstanceDispatch& instanceFunctions = instance.getDispatch();
 	auto extensions = getRequiredExtensions();
-	if (!isExtensionsSupported(device, extensions)) {
+	if (!isExtensionsSupported(instanceFunctions, device, extensions)) {
 		return false;
 	}
 
-	// Check if the surface and physicalDevice supports the swapchain details needed
-	if (surface.getFormats(device).empty() || surface.getPresentModes(device).empty()) {
-		return false;
+	// Check if every surface and physicalDevice supports the swapchain details needed
+	for (Surface* surface : surfaces) {
+		ScratchScope scratch;
+		if (surface->getFormats(device, scratch.getResource()).empty()
+			|| surface->getPresentModes(device, scratch.getResource()).empty()) {
+			return false;
+		}
 	}
 
-	// Check if the device supports the needed queues and that the present queue supports presenting to the specific surface
-	std::optional<uint32_t> graphicsFamilyIndex = findGraphicsFamily(device);
-	std::optional<uint32_t> presentFamilyIndex = findPresentFamily(device, surface);
+	// Check if the device supports the needed queues and that one queue family can present to every surface
+	std::optional<uint32_t> graphicsFamilyIndex = findGraphicsFamily(instanceFunctions, device);
+	std::optional<uint32_t> presentFamilyIndex = findPresentFamily(instanceFunctions, device, surfaces);
 	if (!graphicsFamilyIndex.has_value() || !presentFamilyIndex.has_value()) {
 		return false;
 	}
+	if (!findComputeFamily(instanceFunctions, device).has_value()) {
+		return false;
+	}
 
 	return true;
 }
@@ -123,21 +447,28 @@ std::vector<const char*> LogicalDevice::getRequiredExtensions()
 	return {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 }
 
-std::vector<VkExtensionProperties> LogicalDevice::getSupportedExtensions(VkPhysicalDevice device)
+std::vector<const char*> LogicalDevice::getOptionalExtensions()
+{
+	return {VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, VK_AMD_BUFFER_MARKER_EXTENSION_NAME};
+}
+
+std::pmr::vector<VkExtensionProperties> LogicalDevice::getSupportedExtensions(const InstanceDispatch& instance, VkPhysicalDevice device,
+	std::pmr::memory_resource* memory)
 {
 	uint32_t count = 0;
-	vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
-	std::vector<VkExtensionProperties> extensions(count);
-	vkEnumerateDeviceExtensionProperties(device, nullptr, &count, extensions.data());
+	instance.vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+	std::pmr::vector<VkExtensionProperties> extensions(count, memory);
+	instance.vkEnumerateDeviceExtensionProperties(device, nullptr, &count, extensions.data());
 	return extensions;
 }
 
-bool LogicalDevice::isExtensionsSupported(VkPhysicalDevice device, std::vector<const char*> extensions)
+bool LogicalDevice::isExtensionsSupported(const InstanceDispatch& instance, VkPhysicalDevice device, const std::vector<const char*>& extensions)
 {
-	auto supportedExtensions = getSupportedExtensions(device);
+	ScratchScope scratch;
+	auto supportedExtensions = getSupportedExtensions(instance, device, scratch.getResource());
 	for (auto extension : extensions) {
 		bool supported = false;
-		for (auto supportedExtension : supportedExtensions) {
+		for (const auto& supportedExtension : supportedExtensions) {
 			if (std::strcmp(extension, supportedExtension.extensionName) == 0) {
 				supported = true;
 			}
@@ -149,21 +480,23 @@ bool LogicalDevice::isExtensionsSupported(VkPhysicalDevice device, std::vector<c
 	return true;
 }
 
-std::vector<VkQueueFamilyProperties> LogicalDevice::getQueueFamilies(VkPhysicalDevice device)
+std::pmr::vector<VkQueueFamilyProperties> LogicalDevice::getQueueFamilies(const InstanceDispatch& instance, VkPhysicalDevice device,
+	std::pmr::memory_resource* memory)
 {
 	uint32_t count = 0;
-	vkGetPhysicalDeviceQueueFamilyProperties(device, &count, nullptr);
-	std::vector<VkQueueFamilyProperties> queueFamilies(count);
-	vkGetPhysicalDeviceQueueFamilyProperties(device, &count, queueFamilies.data());
+	instance.vkGetPhysicalDeviceQueueFamilyProperties(device, &count, nullptr);
+	std::pmr::vector<VkQueueFamilyProperties> queueFamilies(count, memory);
+	instance.vkGetPhysicalDeviceQueueFamilyProperties(device, &count, queueFamilies.data());
 	return queueFamilies;
 }
 
-std::optional<uint32_t> LogicalDevice::findGraphicsFamily(VkPhysicalDevice device)
+std::optional<uint32_t> LogicalDevice::findGraphicsFamily(const InstanceDispatch& instance, VkPhysicalDevice device)
 {
 	std::optional<uint32_t> graphicsFamilyIndex{};
 
 	// Search for a queue family that supports graphics
-	auto queueFamilies = getQueueFamilies(device);
+	ScratchScope scratch;
+	auto queueFamilies = getQueueFamilies(instance, device, scratch.getResource());
 	for (int i = 0; i < queueFamilies.size(); i++) {
 		if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
 			graphicsFamilyIndex = i;
@@ -175,12 +508,13 @@ std::optional<uint32_t> LogicalDevice::findGraphicsFamily(VkPhysicalDevice devic
 	return graphicsFamilyIndex;
 }
 
-std::optional<uint32_t> LogicalDevice::findPresentFamily(VkPhysicalDevice device, Surface& surface)
+std::optional<uint32_t> LogicalDevice::findPresentFamily(const InstanceDispatch& instance, VkPhysicalDevice device, Surface& surface)
 {
 	std::optional<uint32_t> presentFamilyIndex{};
 
 	// Search for a queue family that supports presenting to the surface
-	auto queueFamilies = getQueueFamilies(device);
+	ScratchScope scratch;
+	auto queueFamilies = getQueueFamilies(instance, device, scratch.getResource());
 	for (int i = 0; i < queueFamilies.size(); i++) {
 		if (surface.supportsQueueFamily(device, i)) {
 			presentFamilyIndex = i;
@@ -192,6 +526,73 @@ std::optional<uint32_t> LogicalDevice::findPresentFamily(VkPhysicalDevice device
 	return presentFamilyIndex;
 }
 
+std::optional<uint32_t> LogicalDevice::findPresentFamily(const InstanceDispatch& instance, VkPhysicalDevice device, const std::vector<Surface*>& surfaces)
+{
+	auto supportsAll = [&](uint32_t index) {
+		for (Surface* surface : surfaces) {
+			if (!surface->supportsQueueFamily(device, index)) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Presenting from the graphics queue avoids sharing swapchain images between families
+	std::optional<uint32_t> graphicsFamilyIndex = findGraphicsFamily(instance, device);
+	if (graphicsFamilyIndex.has_value() && supportsAll(graphicsFamilyIndex.value())) {
+		return graphicsFamilyIndex;
+	}
+
+	ScratchScope scratch;
+	auto queueFamilies = getQueueFamilies(instance, device, scratch.getResource());
+	for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+		if (supportsAll(i)) {
+			return i;
+		}
+	}
+
+	// no queue family can present to every surface
+	return std::nullopt;
+}
+
+std::optional<uint32_t> LogicalDevice::findTransferFamily(const InstanceDispatch& instance, VkPhysicalDevice device)
+{
+	// A family with transfer but no graphics or compute is usually a dedicated DMA engine
+	ScratchScope scratch;
+	auto queueFamilies = getQueueFamilies(instance, device, scratch.getResource());
+	for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+		VkQueueFlags flags = queueFamilies[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			return i;
+		}
+	}
+
+	// Graphics queues always support transfers
+	return findGraphicsFamily(instance, device);
+}
+
+std::optional<uint32_t> LogicalDevice::findComputeFamily(const InstanceDispatch& instance, VkPhysicalDevice device)
+{
+	// A compute family without graphics runs alongside the graphics queue
+	ScratchScope scratch;
+	auto queueFamilies = getQueueFamilies(instance, device, scratch.getResource());
+	for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+		VkQueueFlags flags = queueFamilies[i].queueFlags;
+		if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+			return i;
+		}
+	}
+
+	// Vulkan requires a family with both graphics and compute when graphics is supported
+	for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+		VkQueueFlags flags = queueFamilies[i].queueFlags;
+		if ((flags & VK_QUEUE_COMPUTE_BIT) && (flags & VK_QUEUE_GRAPHICS_BIT)) {
+			return i;
+		}
+	}
+	return std::nullopt;
+}
+
 void LogicalDevice::getQueueCreateInfos(std::vector<VkDeviceQueueCreateInfo>& createInfos)
 {
 }
\ No newline at end of file
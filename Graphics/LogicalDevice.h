@@ -3,6 +3,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <memory_resource>
 #include <vector>
 #include <optional>
 
@@ -25,13 +26,29 @@ public:
 
 	/**
 	 * @brief Creates a logical device which is a view of the specified physicalDevice.
-	 * Enables the required extensions and creates queues for drawing and presenting.
+	 * Enables the required extensions and creates queues for drawing, presenting, uploads and compute.
 	 * 
 	 * @param _physicalDevice - the computer's physical device to use for graphics.
 	 * use static member function findSuitablePhysicalDevice to locate a usable physical device
 	 * @param surface - the surface that this logical device's queues will be presenting to
+	 * @param _allocator - host allocation callbacks used for the device and every object created under it,
+	 * usually VulkanInstance::getAllocator. nullptr uses the driver's allocator.
 	 */
-	void init(VkPhysicalDevice _physicalDevice, Surface& surface);
+	void init(VkPhysicalDevice _physicalDevice, Surface& surface, const VkAllocationCallbacks* _allocator = nullptr);
+
+	/**
+	 * @brief Creates a logical device that presents to several surfaces, such as one per window.
+	 * The present queue is picked from a family that can present to every surface, preferring the graphics family.
+	 * 
+	 * Throws an error if no queue family can present to all the surfaces.
+	 * 
+	 * @param _physicalDevice - the computer's physical device to use for graphics.
+	 * use static member function findSuitablePhysicalDevice to locate a usable physical device
+	 * @param surfaces - the surfaces that this logical device's queues will be presenting to
+	 * @param _allocator - host allocation callbacks used for the device and every object created under it
+	 */
+	void init(VkPhysicalDevice _physicalDevice, const std::vector<Surface*>& surfaces,
+		const VkAllocationCallbacks* _allocator = nullptr);
 
 	/**
 	 * @brief Destructor: Calls cleanup() to free up memory
@@ -59,6 +76,169 @@ public:
 	 */
 	VkPhysicalDevice getPhysicalDevice();
 
+	/**
+	 * @brief Returns the allocation callbacks given to init, pass them to every
+	 * vkCreate and vkDestroy call of objects created under this device
+	 */
+	const VkAllocationCallbacks* getAllocator();
+
+	/**
+	 * @brief Returns the device functions loaded in init. Wrappers call through them
+	 * instead of the loader's exports, which look up the device's dispatch on every call.
+	 */
+	const DeviceDispatch& getDispatch();
+
+	/**
+	 * @brief Returns the queue that graphics commands are submitted to.
+	 */
+	VkQueue getGraphicsQueue();
+
+	/**
+	 * @brief Returns the queue that presents to the surface given in init.
+	 * May be the same queue as the graphics queue.
+	 */
+	VkQueue getPresentQueue();
+
+	/**
+	 * @brief Returns the index of the graphics queue family, used for command pool creation.
+	 */
+	uint32_t getGraphicsFamilyIndex();
+
+	/**
+	 * @brief Returns the index of the present queue family
+	 */
+	uint32_t getPresentFamilyIndex();
+
+	/**
+	 * @brief Returns whether the present queue can present to the specified surface.
+	 * Surfaces created after init, such as for a new window, have to be checked before use.
+	 */
+	bool supportsSurface(Surface& surface);
+
+	/**
+	 * @brief Returns the queue for uploads. This is a dedicated transfer queue when the device has one,
+	 * otherwise the graphics queue.
+	 */
+	VkQueue getTransferQueue();
+
+	/**
+	 * @brief Returns the index of the transfer queue family
+	 */
+	uint32_t getTransferFamilyIndex();
+
+	/**
+	 * @brief Returns the queue for compute work. This is a queue of an async compute family without
+	 * graphics when the device has one, so it can overlap rendering, otherwise the graphics queue.
+	 */
+	VkQueue getComputeQueue();
+
+	/**
+	 * @brief Returns the index of the compute queue family
+	 */
+	uint32_t getComputeFamilyIndex();
+
+	/**
+	 * @brief Returns the properties of the physical device, such as limits.timestampPeriod
+	 */
+	const VkPhysicalDeviceProperties& getProperties();
+
+	/**
+	 * @brief Returns the bits written by timestamp queries on a queue family, 0 if it doesn't support them
+	 *
+	 * @param queueFamily - index of the queue family, such as getGraphicsFamilyIndex
+	 */
+	uint32_t getTimestampValidBits(uint32_t queueFamily);
+
+	/**
+	 * @brief Returns what images of a format with optimal tiling support, such as VK_FORMAT_FEATURE_BLIT_DST_BIT
+	 */
+	VkFormatFeatureFlags getFormatFeatures(VkFormat format);
+
+	/**
+	 * @brief Returns the subgroup size and the subgroup operations supported per stage.
+	 * Everything is 0 on a vulkan 1.0 device.
+	 */
+	const VkPhysicalDeviceSubgroupProperties& getSubgroupProperties();
+
+	/**
+	 * @brief Returns whether compute shaders can use subgroup arithmetic and ballots,
+	 * such as subgroupExclusiveAdd and subgroupBallot
+	 */
+	bool supportsComputeSubgroups();
+
+	/**
+	 * @brief Returns whether the specified device extension was enabled in init.
+	 * Optional extensions are only enabled when the physical device supports them.
+	 */
+	bool isExtensionEnabled(const char* extension);
+
+	/**
+	 * @brief Returns the features enabled in init.
+	 * Only features that are supported by the physical device are enabled.
+	 */
+	const VkPhysicalDeviceFeatures& getEnabledFeatures();
+
+	/**
+	 * @brief Returns whether vkCmdDrawIndexedIndirectCountKHR can be used on this device.
+	 */
+	bool supportsDrawIndirectCount();
+
+	/**
+	 * @brief Returns whether task and mesh shaders from VK_EXT_mesh_shader can be used on this device.
+	 * Requires a vulkan 1.2 device.
+	 */
+	bool supportsMeshShaders();
+
+	/**
+	 * @brief Returns whether vkCmdWriteBufferMarkerAMD can be used on this device.
+	 */
+	bool supportsBufferMarkers();
+
+	/**
+	 * @brief Returns whether vkGetDeviceFaultInfoEXT can describe a device loss on this device.
+	 * Requires a vulkan 1.1 device.
+	 */
+	bool supportsDeviceFault();
+
+	/**
+	 * @brief Returns whether 2D images can be partially resident through sparse binding.
+	 * Sparse binds go through the graphics queue.
+	 */
+	bool supportsSparseResidency();
+
+	/**
+	 * @brief Returns the combined size in bytes of every device local memory heap
+	 */
+	VkDeviceSize getDeviceLocalHeapSize();
+
+	/**
+	 * @brief Returns the index of a memory type that is allowed by typeBits and has all the specified properties.
+	 * Throws an error if no such memory type exists.
+	 * 
+	 * @param typeBits - memoryTypeBits from VkMemoryRequirements
+	 * @param properties - properties the memory type must have
+	 * 
+	 * @return memory type index
+	 */
+	uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties);
+
+	/**
+	 * @brief Returns whether a memory type allowed by typeBits has all the specified properties,
+	 * such as VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT which mostly tile based GPUs offer
+	 * 
+	 * @param typeBits - memoryTypeBits from VkMemoryRequirements, ~0u for any memory type
+	 * @param properties - properties the memory type must have
+	 */
+	bool hasMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties);
+
+	/**
+	 * @brief Returns every distinct queue created by this device.
+	 * Queues shared between roles are only listed once.
+	 * 
+	 * @return vector of queue handles
+	 */
+	std::vector<VkQueue> getQueues();
+
 	/**
 	 * @brief Returns a physical device that supports all the neccessary details for use in graphics.
 	 * 
@@ -70,6 +250,17 @@ public:
 	 */
 	static VkPhysicalDevice findSuitablePhysicalDevice(VulkanInstance& instance, Surface& surface);
 
+	/**
+	 * @brief Returns a physical device that supports all the neccessary details for use in graphics
+	 * and has a queue family that can present to every specified surface.
+	 * 
+	 * @param instance - used to locate all physical devices
+	 * @param surfaces - the physical device must be compatible with every surface to be suitable
+	 * 
+	 * @return first suitable physical device found. nullptr if no physical device is found.
+	 */
+	static VkPhysicalDevice findSuitablePhysicalDevice(VulkanInstance& instance, const std::vector<Surface*>& surfaces);
+
 	/**
 	 * @brief Returns all physical devices on the computer
 	 * 
@@ -82,17 +273,37 @@ public:
 	/**
 	 * @brief Returns whether the specified device supports the neccessary details for use in graphics
 	 * 
+	 * @param instance - the vulkan instance the physical device belongs to
 	 * @param device - the physical device to check
 	 * @param surface - the physical device must be compatible with the surface to be suitable
 	 * 
 	 * @return True if the physical device supports the required extensions, surface compatibility, and required queue families. False otherwise
 	 */
-	static bool isPhysicalDeviceSuitable(VkPhysicalDevice device, Surface& surface);
+	static bool isPhysicalDeviceSuitable(VulkanInstance& instance, VkPhysicalDevice device, Surface& surface);
+
+	/**
+	 * @brief Returns whether the specified device supports the neccessary details for use in graphics
+	 * and has a queue family that can present to every specified surface
+	 * 
+	 * @param instance - the vulkan instance the physical device belongs to
+	 * @param device - the physical device to check
+	 * @param surfaces - the physical device must be compatible with every surface to be suitable
+	 * 
+	 * @return True if the physical device is suitable for all the surfaces. False otherwise
+	 */
+	static bool isPhysicalDeviceSuitable(VulkanInstance& instance, VkPhysicalDevice device, const std::vector<Surface*>& surfaces);
 
 private:
 	VkDevice handle;
 	VkPhysicalDevice physicalDevice;
-	QueueFamily graphicsFamily, presentFamily;
+	const VkAllocationCallbacks* allocator;
+	const InstanceDispatch* instanceDispatch;
+	DeviceDispatch dispatch;
+	QueueFamily graphicsFamily, presentFamily, transferFamily, computeFamily;
+	std::vector<const char*> enabledExtensions;
+	VkPhysicalDeviceFeatures enabledFeatures;
+	VkPhysicalDeviceProperties deviceProperties;
+	VkPhysicalDeviceSubgroupProperties subgroupProperties;
 
 	/**
 	 * @brief Returns the neccessary device extensions
@@ -101,43 +312,58 @@ private:
 	 */
 	static std::vector<const char*> getRequiredExtensions();
 
+	/**
+	 * @brief Returns the device extensions that are enabled only if they are supported
+	 * 
+	 * @return vector of device extension names
+	 */
+	static std::vector<const char*> getOptionalExtensions();
+
 	/**
 	 * @brief Returns the extensions supported by the specified device
 	 * 
+	 * @param instance - functions of the instance the physical device belongs to
 	 * @param device - the physical device to find extensions under
+	 * @param memory - allocates the vector, such as a ScratchScope's arena
 	 * 
 	 * @return vector of supported device extensions
 	 */
-	static std::vector<VkExtensionProperties> getSupportedExtensions(VkPhysicalDevice device);
+	static std::pmr::vector<VkExtensionProperties> getSupportedExtensions(const InstanceDispatch& instance, VkPhysicalDevice device,
+		std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 
 	/**
 	 * @brief Returns whether the specified device supports the specified extensions
 	 * 
+	 * @param instance - functions of the instance the physical device belongs to
 	 * @param device - the physical device used to get supported extensions
 	 * @param extensions - the extensions to check for compatibility with the specified device
 	 * 
 	 * @return true if the extensions are supported by the device. False otherwise.
 	 */
-	static bool isExtensionsSupported(VkPhysicalDevice device, std::vector<const char*> extensions);
+	static bool isExtensionsSupported(const InstanceDispatch& instance, VkPhysicalDevice device, const std::vector<const char*>& extensions);
 
 	/**
 	 * @brief Returns the queue families that the specified device supports
 	 * 
+	 * @param instance - functions of the instance the physical device belongs to
 	 * @param device - the physical device used to find the queue families
+	 * @param memory - allocates the vector, such as a ScratchScope's arena
 	 * 
 	 * @return vector of queue families supported by device
 	 */
-	static std::vector<VkQueueFamilyProperties> getQueueFamilies(VkPhysicalDevice device);
+	static std::pmr::vector<VkQueueFamilyProperties> getQueueFamilies(const InstanceDispatch& instance, VkPhysicalDevice device,
+		std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 
 	/**
 	 * @brief Returns an optional that may have the index of a queue family that supports graphics.
 	 * If the optional has no value, the specified device has no graphics queue family.
 	 * 
+	 * @param instance - functions of the instance the physical device belongs to
 	 * @param device - the physical device used to find all available queue families
 	 * 
 	 * @return first queue family found supporting graphics. Empty optional if none were found.
 	 */
-	static std::optional<uint32_t> findGraphicsFamily(VkPhysicalDevice device);
+	static std::optional<uint32_t> findGraphicsFamily(const InstanceDispatch& instance, VkPhysicalDevice device);
 
 	/**
 	 * @brief Returns an optional that may have the index of a queue family that supports 
@@ -145,12 +371,48 @@ private:
 	 * If the optional has no value, the specified device has no queue family that supports
 	 * presenting to the specified surface.
 	 * 
+	 * @param instance - functions of the instance the physical device belongs to
 	 * @param device - the physical device used to find all available queue families
 	 * @param surface - the surface to test support for presenting to
 	 * 
 	 * @return first queue family found that supports presenting to the surface. Empty optional if none were found.
 	 */
-	static std::optional<uint32_t> findPresentFamily(VkPhysicalDevice device, Surface& surface);
+	static std::optional<uint32_t> findPresentFamily(const InstanceDispatch& instance, VkPhysicalDevice device, Surface& surface);
+
+	/**
+	 * @brief Returns an optional that may have the index of a queue family that supports
+	 * presenting to every specified surface. The graphics family is preferred so that
+	 * rendering and presenting share a queue.
+	 * 
+	 * @param instance - functions of the instance the physical device belongs to
+	 * @param device - the physical device used to find all available queue families
+	 * @param surfaces - the surfaces to test support for presenting to
+	 * 
+	 * @return queue family that supports presenting to all surfaces. Empty optional if none were found.
+	 */
+	static std::optional<uint32_t> findPresentFamily(const InstanceDispatch& instance, VkPhysicalDevice device, const std::vector<Surface*>& surfaces);
+
+	/**
+	 * @brief Returns the index of the queue family to use for uploads.
+	 * Prefers a family that only supports transfers, falls back to the graphics family.
+	 * 
+	 * @param instance - functions of the instance the physical device belongs to
+	 * @param device - the physical device used to find all available queue families
+	 * 
+	 * @return transfer queue family. Empty optional if the device has no graphics family either.
+	 */
+	static std::optional<uint32_t> findTransferFamily(const InstanceDispatch& instance, VkPhysicalDevice device);
+
+	/**
+	 * @brief Returns the index of the queue family to use for compute work.
+	 * Prefers a family with compute but no graphics, falls back to the graphics family.
+	 * 
+	 * @param instance - functions of the instance the physical device belongs to
+	 * @param device - the physical device used to find all available queue families
+	 * 
+	 * @return compute queue family. Empty optional if the device has no graphics family either.
+	 */
+	static std::optional<uint32_t> findComputeFamily(const InstanceDispatch& instance, VkPhysicalDevice device);
 
 	// Recursive creation of queue create infos. Input a vector to store the create infos and provide
 	// the info to put into each create info.
@@ -0,0 +1,76 @@
+#include "PresentBatch.h"
+
+#include <algorithm>
+
+#include "DebugMessenger.h"
+
+PresentBatch::PresentBatch() :
+	scheduler(nullptr),
+	dispatch(nullptr),
+	presentQueue(nullptr),
+	swapchains{},
+	imageIndices{},
+	waitSemaphores{},
+	results{}
+{
+}
+
+void PresentBatch::init(LogicalDevice& device, SubmissionScheduler& _scheduler)
+{
+	scheduler = &_scheduler;
+	dispatch = &device.getDispatch();
+	presentQueue = device.getPresentQueue();
+}
+
+void PresentBatch::add(Swapchain& swapchain, uint32_t imageIndex, VkSemaphore waitSemaphore)
+{
+	swapchains.push_back(swapchain.getHandle());
+	imageIndices.push_back(imageIndex);
+
+	// A binary semaphore can only be waited on once, windows rendered by the same submit share it
+	if (std::find(waitSemaphores.begin(), waitSemaphores.end(), waitSemaphore) == waitSemaphores.end()) {
+		waitSemaphores.push_back(waitSemaphore);
+	}
+}
+
+const std::vector<VkResult>& PresentBatch::present()
+{
+	results.assign(swapchains.size(), VK_SUCCESS);
+	if (swapchains.empty()) {
+		return results;
+	}
+
+	// Semaphore signals have to be submitted before a present can wait on them
+	scheduler->flushAll();
+
+	VkPresentInfoKHR presentInfo{};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	presentInfo.pWaitSemaphores = waitSemaphores.data();
+	presentInfo.swapchainCount = static_cast<uint32_t>(swapchains.size());
+	presentInfo.pSwapchains = swapchains.data();
+	presentInfo.pImageIndices = imageIndices.data();
+	presentInfo.pResults = results.data();
+
+	VkResult result;
+	{
+		auto lock = scheduler->lockQueue(presentQueue);
+		result = dispatch->vkQueuePresentKHR(presentQueue, &presentInfo);
+	}
+
+	swapchains.clear();
+	imageIndices.clear();
+	waitSemaphores.clear();
+
+	// One out of date swapchain makes the whole call return out of date, the others are still presented
+	for (VkResult swapchainResult : results) {
+		if (swapchainResult != VK_SUBOPTIMAL_KHR && swapchainResult != VK_ERROR_OUT_OF_DATE_KHR) {
+			VK_CHECK(swapchainResult);
+		}
+	}
+	if (result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR) {
+		VK_CHECK(result);
+	}
+
+	return results;
+}
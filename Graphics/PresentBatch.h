@@ -0,0 +1,54 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "SubmissionScheduler.h"
+#include "Swapchain.h"
+
+class PresentBatch
+{
+public:
+	/**
+	 * @brief Default Constructor: Must call init before presenting
+	 */
+	PresentBatch();
+
+	/**
+	 * @brief Prepares presenting on the device's present queue.
+	 *
+	 * @param device - the logical device every swapchain was created under
+	 * @param scheduler - flushed before presenting, and used to lock the present queue
+	 */
+	void init(LogicalDevice& device, SubmissionScheduler& scheduler);
+
+	/**
+	 * @brief Adds a swapchain image to the next present.
+	 *
+	 * @param swapchain - the swapchain the image was acquired from, at most once per present
+	 * @param imageIndex - index from Swapchain::acquireNextImage
+	 * @param waitSemaphore - signaled when rendering to the image is done, may be shared between images
+	 */
+	void add(Swapchain& swapchain, uint32_t imageIndex, VkSemaphore waitSemaphore);
+
+	/**
+	 * @brief Flushes the scheduler so the work signaling the semaphores is submitted, then presents
+	 * every added image with a single vkQueuePresentKHR. The batch is empty afterwards.
+	 *
+	 * @return result of each image in the order they were added: VK_SUCCESS, VK_SUBOPTIMAL_KHR or
+	 * VK_ERROR_OUT_OF_DATE_KHR, in which case the swapchain should be recreated. Other errors are thrown.
+	 */
+	const std::vector<VkResult>& present();
+
+private:
+	SubmissionScheduler* scheduler;
+	const DeviceDispatch* dispatch;
+	VkQueue presentQueue;
+	std::vector<VkSwapchainKHR> swapchains;
+	std::vector<uint32_t> imageIndices;
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<VkResult> results;
+};
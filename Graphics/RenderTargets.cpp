@@ -0,0 +1,409 @@
+#include "RenderTargets.h"
+
+#include <stdexcept>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+
+namespace {
+	const VkPipelineStageFlags ATTACHMENT_STAGES = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+		| VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	const VkAccessFlags ATTACHMENT_WRITES = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	const VkAccessFlags ATTACHMENT_ACCESSES = ATTACHMENT_WRITES | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+		| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+
+	// Whether a subpass writes or reads the attachment in any way
+	bool usesAttachment(const SubpassInfo& subpass, uint32_t attachment)
+	{
+		for (const std::vector<uint32_t>* list : {&subpass.colorAttachments, &subpass.inputAttachments, &subpass.resolveAttachments}) {
+			for (uint32_t index : *list) {
+				if (index == attachment) {
+					return true;
+				}
+			}
+		}
+		return subpass.depthAttachment == attachment;
+	}
+
+	// Input attachments are only read, everything else a subpass uses it writes
+	bool writesAttachment(const SubpassInfo& subpass, uint32_t attachment)
+	{
+		for (const std::vector<uint32_t>* list : {&subpass.colorAttachments, &subpass.resolveAttachments}) {
+			for (uint32_t index : *list) {
+				if (index == attachment) {
+					return true;
+				}
+			}
+		}
+		return subpass.depthAttachment == attachment;
+	}
+
+	bool readsAsInput(const std::vector<SubpassInfo>& subpasses, uint32_t attachment)
+	{
+		for (const SubpassInfo& subpass : subpasses) {
+			for (uint32_t index : subpass.inputAttachments) {
+				if (index == attachment) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+}
+
+RenderTargets::RenderTargets() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	extent{},
+	renderPass(nullptr),
+	attachmentInfos{},
+	images{},
+	framebuffers{}
+{
+}
+
+void RenderTargets::init(LogicalDevice& device, VkExtent2D _extent, const std::vector<AttachmentInfo>& attachments,
+	const std::vector<SubpassInfo>& subpasses, const std::vector<VkImageView>& externalViews)
+{
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	extent = _extent;
+	attachmentInfos = attachments;
+
+	createImages(device, subpasses);
+	createRenderPass(subpasses);
+	createFramebuffers(externalViews);
+}
+
+RenderTargets::~RenderTargets()
+{
+	cleanup();
+}
+
+void RenderTargets::cleanup()
+{
+	if (deviceHandle) {
+		for (VkFramebuffer framebuffer : framebuffers) {
+			dispatch->vkDestroyFramebuffer(deviceHandle, framebuffer, allocator);
+		}
+		framebuffers.clear();
+		dispatch->vkDestroyRenderPass(deviceHandle, renderPass, allocator);
+		renderPass = nullptr;
+		images.clear();
+		attachmentInfos.clear();
+		deviceHandle = nullptr;
+	}
+}
+
+void RenderTargets::recordBegin(VkCommandBuffer commandBuffer, uint32_t framebuffer, const std::vector<VkClearValue>& clearValues,
+	VkExtent2D area)
+{
+	if (area.width == 0 || area.height == 0) {
+		area = extent;
+	}
+	// Closed by recordEnd, so every subpass is grouped under the render pass in captures
+	beginCommandLabel(*dispatch, commandBuffer, "Render pass");
+	VkRenderPassBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	beginInfo.renderPass = renderPass;
+	beginInfo.framebuffer = framebuffers[framebuffer];
+	beginInfo.renderArea = {{0, 0}, area};
+	beginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	beginInfo.pClearValues = clearValues.data();
+	dispatch->vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkViewport viewport{0.0f, 0.0f, static_cast<float>(area.width), static_cast<float>(area.height), 0.0f, 1.0f};
+	VkRect2D scissor{{0, 0}, area};
+	dispatch->vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	dispatch->vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+void RenderTargets::recordNextSubpass(VkCommandBuffer commandBuffer)
+{
+	dispatch->vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void RenderTargets::recordEnd(VkCommandBuffer commandBuffer)
+{
+	dispatch->vkCmdEndRenderPass(commandBuffer);
+	endCommandLabel(*dispatch, commandBuffer);
+}
+
+VkRenderPass RenderTargets::getRenderPass()
+{
+	return renderPass;
+}
+
+VkFramebuffer RenderTargets::getFramebuffer(uint32_t framebuffer)
+{
+	return framebuffers[framebuffer];
+}
+
+VkExtent2D RenderTargets::getExtent()
+{
+	return extent;
+}
+
+Image& RenderTargets::getAttachment(uint32_t attachment)
+{
+	return *images[attachment];
+}
+
+RenderTargetStats RenderTargets::getStats()
+{
+	RenderTargetStats stats{};
+	for (size_t i = 0; i < images.size(); i++) {
+		if (!images[i] || attachmentInfos[i].store) {
+			continue;
+		}
+		VkDeviceSize size = images[i]->getMemorySize();
+		stats.transientMemory += size;
+		stats.storeBytesSaved += size;
+		if (images[i]->isLazilyAllocated()) {
+			stats.lazyMemory += size;
+			stats.committedLazyMemory += images[i]->getCommittedMemory();
+		}
+	}
+	return stats;
+}
+
+VkImageAspectFlags RenderTargets::getAspect(VkFormat format)
+{
+	switch (format) {
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_S8_UINT:
+		return VK_IMAGE_ASPECT_STENCIL_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+void RenderTargets::createImages(LogicalDevice& device, const std::vector<SubpassInfo>& subpasses)
+{
+	images.resize(attachmentInfos.size());
+	for (uint32_t i = 0; i < attachmentInfos.size(); i++) {
+		const AttachmentInfo& attachment = attachmentInfos[i];
+		if (attachment.external) {
+			continue;
+		}
+
+		ImageInfo info{};
+		info.extent = extent;
+		info.format = attachment.format;
+		info.aspect = getAspect(attachment.format);
+		info.samples = attachment.samples;
+		info.usage = info.aspect & VK_IMAGE_ASPECT_COLOR_BIT
+			? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT : VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		if (readsAsInput(subpasses, i)) {
+			info.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		}
+		if (attachment.store) {
+			info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		} else {
+			// Falls back to plain device local memory when the device has no lazily allocated memory
+			info.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			info.memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		}
+		images[i] = std::make_unique<Image>();
+		images[i]->init(device, info);
+		images[i]->setName("RenderTargets attachment ", i);
+	}
+}
+
+void RenderTargets::createRenderPass(const std::vector<SubpassInfo>& subpasses)
+{
+	std::vector<VkAttachmentDescription> attachmentDescriptions(attachmentInfos.size());
+	for (size_t i = 0; i < attachmentInfos.size(); i++) {
+		const AttachmentInfo& attachment = attachmentInfos[i];
+		VkImageAspectFlags aspect = getAspect(attachment.format);
+		VkAttachmentLoadOp loadOp = attachment.load ? VK_ATTACHMENT_LOAD_OP_LOAD
+			: attachment.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		VkAttachmentStoreOp storeOp = attachment.store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		attachmentDescriptions[i].format = attachment.format;
+		attachmentDescriptions[i].samples = attachment.samples;
+		bool hasColorOrDepth = aspect & (VK_IMAGE_ASPECT_COLOR_BIT | VK_IMAGE_ASPECT_DEPTH_BIT);
+		attachmentDescriptions[i].loadOp = hasColorOrDepth ? loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachmentDescriptions[i].storeOp = hasColorOrDepth ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachmentDescriptions[i].stencilLoadOp = aspect & VK_IMAGE_ASPECT_STENCIL_BIT ? loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachmentDescriptions[i].stencilStoreOp = aspect & VK_IMAGE_ASPECT_STENCIL_BIT ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		// Unless they are loaded, the old contents never need a layout transition
+		attachmentDescriptions[i].initialLayout = attachment.load ? attachment.finalLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+		if (attachment.store) {
+			attachmentDescriptions[i].finalLayout = attachment.finalLayout;
+		} else {
+			attachmentDescriptions[i].finalLayout = aspect & VK_IMAGE_ASPECT_COLOR_BIT
+				? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		}
+	}
+
+	// References are kept per subpass until the render pass is created
+	std::vector<std::vector<VkAttachmentReference>> colorReferences(subpasses.size());
+	std::vector<std::vector<VkAttachmentReference>> inputReferences(subpasses.size());
+	std::vector<std::vector<VkAttachmentReference>> resolveReferences(subpasses.size());
+	std::vector<VkAttachmentReference> depthReferences(subpasses.size());
+	std::vector<std::vector<uint32_t>> preserved(subpasses.size());
+	std::vector<VkSubpassDescription> subpassDescriptions(subpasses.size());
+	for (size_t s = 0; s < subpasses.size(); s++) {
+		const SubpassInfo& subpass = subpasses[s];
+		if (!subpass.resolveAttachments.empty() && subpass.resolveAttachments.size() != subpass.colorAttachments.size()) {
+			throw std::runtime_error("a subpass needs one resolve attachment per color attachment");
+		}
+		for (uint32_t index : subpass.colorAttachments) {
+			colorReferences[s].push_back({index, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+		}
+		for (uint32_t index : subpass.inputAttachments) {
+			VkImageLayout layout = getAspect(attachmentInfos[index].format) & VK_IMAGE_ASPECT_COLOR_BIT
+				? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			inputReferences[s].push_back({index, layout});
+		}
+		for (uint32_t index : subpass.resolveAttachments) {
+			resolveReferences[s].push_back({index, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+		}
+		depthReferences[s] = {subpass.depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+		// Attachments used before and after this subpass but not by it have to be preserved through it
+		for (uint32_t a = 0; a < attachmentInfos.size(); a++) {
+			if (usesAttachment(subpass, a)) {
+				continue;
+			}
+			bool before = false, after = false;
+			for (size_t other = 0; other < subpasses.size(); other++) {
+				if (usesAttachment(subpasses[other], a)) {
+					before = before || other < s;
+					after = after || other > s;
+				}
+			}
+			if (before && after) {
+				preserved[s].push_back(a);
+			}
+		}
+
+		VkSubpassDescription& description = subpassDescriptions[s];
+		description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		description.colorAttachmentCount = static_cast<uint32_t>(colorReferences[s].size());
+		description.pColorAttachments = colorReferences[s].data();
+		description.inputAttachmentCount = static_cast<uint32_t>(inputReferences[s].size());
+		description.pInputAttachments = inputReferences[s].data();
+		description.pResolveAttachments = resolveReferences[s].empty() ? nullptr : resolveReferences[s].data();
+		description.pDepthStencilAttachment = subpass.depthAttachment == VK_ATTACHMENT_UNUSED ? nullptr : &depthReferences[s];
+		description.preserveAttachmentCount = static_cast<uint32_t>(preserved[s].size());
+		description.pPreserveAttachments = preserved[s].data();
+	}
+
+	std::vector<VkSubpassDependency> dependencies{};
+	// The previous frame's use of the attachments, or an earlier pass's for loaded ones, has to finish before they are written.
+	// That is needed by every subpass that is the first to use an attachment, subpass 0 always is.
+	for (uint32_t s = 0; s < subpasses.size(); s++) {
+		bool firstUse = s == 0;
+		for (uint32_t a = 0; a < attachmentInfos.size() && !firstUse; a++) {
+			firstUse = usesAttachment(subpasses[s], a);
+			for (uint32_t earlier = 0; earlier < s && firstUse; earlier++) {
+				firstUse = !usesAttachment(subpasses[earlier], a);
+			}
+		}
+		if (!firstUse) {
+			continue;
+		}
+		VkSubpassDependency first{};
+		first.srcSubpass = VK_SUBPASS_EXTERNAL;
+		first.dstSubpass = s;
+		first.srcStageMask = ATTACHMENT_STAGES | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		first.dstStageMask = ATTACHMENT_STAGES;
+		first.srcAccessMask = ATTACHMENT_WRITES;
+		first.dstAccessMask = ATTACHMENT_ACCESSES;
+		dependencies.push_back(first);
+	}
+
+	// By region: a subpass only reads the pixel the earlier one wrote at the same place, which is what lets
+	// tile based GPUs run them as one pass without going through memory
+	for (uint32_t s = 1; s < subpasses.size(); s++) {
+		for (uint32_t earlier = 0; earlier < s; earlier++) {
+			bool shared = false;
+			for (uint32_t a = 0; a < attachmentInfos.size() && !shared; a++) {
+				shared = usesAttachment(subpasses[earlier], a) && usesAttachment(subpasses[s], a);
+			}
+			if (!shared) {
+				continue;
+			}
+			VkSubpassDependency dependency{};
+			dependency.srcSubpass = earlier;
+			dependency.dstSubpass = s;
+			dependency.srcStageMask = ATTACHMENT_STAGES;
+			dependency.dstStageMask = ATTACHMENT_STAGES | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			dependency.srcAccessMask = ATTACHMENT_WRITES;
+			dependency.dstAccessMask = ATTACHMENT_ACCESSES | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+			dependencies.push_back(dependency);
+		}
+	}
+
+	// Stored attachments are sampled or copied after the render pass, such as depth by DepthPyramid. Every subpass
+	// writing one needs its own dependency, the one of the last subpass doesn't cover writes of the earlier ones.
+	for (uint32_t s = 0; s < subpasses.size(); s++) {
+		bool writesStored = false;
+		for (uint32_t a = 0; a < attachmentInfos.size() && !writesStored; a++) {
+			writesStored = attachmentInfos[a].store && writesAttachment(subpasses[s], a);
+		}
+		if (!writesStored) {
+			continue;
+		}
+		VkSubpassDependency last{};
+		last.srcSubpass = s;
+		last.dstSubpass = VK_SUBPASS_EXTERNAL;
+		last.srcStageMask = ATTACHMENT_STAGES;
+		last.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		last.srcAccessMask = ATTACHMENT_WRITES;
+		last.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		dependencies.push_back(last);
+	}
+
+	VkRenderPassCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	createInfo.attachmentCount = static_cast<uint32_t>(attachmentDescriptions.size());
+	createInfo.pAttachments = attachmentDescriptions.data();
+	createInfo.subpassCount = static_cast<uint32_t>(subpassDescriptions.size());
+	createInfo.pSubpasses = subpassDescriptions.data();
+	createInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	createInfo.pDependencies = dependencies.data();
+	VkResult result = dispatch->vkCreateRenderPass(deviceHandle, &createInfo, allocator, &renderPass); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_RENDER_PASS, renderPass, "RenderTargets");
+}
+
+void RenderTargets::createFramebuffers(const std::vector<VkImageView>& externalViews)
+{
+	size_t framebufferCount = externalViews.empty() ? 1 : externalViews.size();
+	framebuffers.resize(framebufferCount, nullptr);
+	for (size_t f = 0; f < framebufferCount; f++) {
+		std::vector<VkImageView> views(images.size());
+		for (size_t i = 0; i < images.size(); i++) {
+			if (images[i]) {
+				views[i] = images[i]->getView();
+			} else if (!externalViews.empty()) {
+				views[i] = externalViews[f];
+			} else {
+				throw std::runtime_error("an external attachment needs its views given to init");
+			}
+		}
+
+		VkFramebufferCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		createInfo.renderPass = renderPass;
+		createInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		createInfo.pAttachments = views.data();
+		createInfo.width = extent.width;
+		createInfo.height = extent.height;
+		createInfo.layers = 1;
+		VkResult result = dispatch->vkCreateFramebuffer(deviceHandle, &createInfo, allocator, &framebuffers[f]); VK_CHECK(result);
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_FRAMEBUFFER, framebuffers[f], "RenderTargets framebuffer ", f);
+	}
+}
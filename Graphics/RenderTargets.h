@@ -0,0 +1,138 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <memory>
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "Image.h"
+
+struct AttachmentInfo
+{
+	VkFormat format;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+	// Clears at the start of the render pass, otherwise the old contents are discarded (DONT_CARE).
+	bool clear = true;
+	// Keeps the contents an earlier render pass stored instead, such as the depth of the first phase of occlusion
+	// culling. The attachment has to be stored and in finalLayout already. Overrides clear.
+	bool load = false;
+	// Writes the contents to memory at the end of the render pass so they can be sampled, copied or presented.
+	// Attachments that aren't stored are transient: they only live in tile memory on tile based GPUs and get
+	// lazily allocated memory when the device has it.
+	bool store = false;
+	// Layout after the render pass when stored, such as VK_IMAGE_LAYOUT_PRESENT_SRC_KHR for a swapchain image
+	VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	// The image is created elsewhere, such as a swapchain image, and its views are given to init.
+	// At most one attachment can be external.
+	bool external = false;
+};
+
+struct SubpassInfo
+{
+	// Attachment indices written by the fragment shader, in output location order
+	std::vector<uint32_t> colorAttachments;
+	// Attachment indices written by earlier subpasses and read with subpassLoad, in input_attachment_index order
+	std::vector<uint32_t> inputAttachments;
+	// Empty, or one single sampled attachment per color attachment to resolve it into
+	std::vector<uint32_t> resolveAttachments;
+	uint32_t depthAttachment = VK_ATTACHMENT_UNUSED;
+};
+
+struct RenderTargetStats
+{
+	// Memory of the attachments that aren't stored
+	VkDeviceSize transientMemory;
+	// The part of transientMemory in lazily allocated memory, which a tile based GPU never backs
+	VkDeviceSize lazyMemory;
+	// What the driver actually backs of lazyMemory
+	VkDeviceSize committedLazyMemory;
+	// Bytes every frame doesn't write to memory because the attachments aren't stored
+	VkDeviceSize storeBytesSaved;
+};
+
+// The attachments of a render pass, the render pass and its framebuffers, created together so the load and
+// store ops, image usage and memory agree. Attachments that are only used inside the render pass are transient,
+// and passes that read earlier results as input attachments are subpasses of one render pass with by-region
+// dependencies, so tile based GPUs can merge them and keep everything in tile memory, such as a G-buffer
+// that is written and lit without ever being stored.
+class RenderTargets
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create any resources, must call init
+	 */
+	RenderTargets();
+
+	/**
+	 * @brief Creates the attachment images, the render pass and a framebuffer per external view
+	 *
+	 * @param device - the logical device to create the resources under
+	 * @param _extent - size of every attachment
+	 * @param attachments - the attachments, subpasses refer to them by index
+	 * @param subpasses - the subpasses in execution order
+	 * @param externalViews - views of the external attachment, such as Swapchain::getImageViews,
+	 * one framebuffer is created for each. Empty if no attachment is external.
+	 */
+	void init(LogicalDevice& device, VkExtent2D _extent, const std::vector<AttachmentInfo>& attachments,
+		const std::vector<SubpassInfo>& subpasses, const std::vector<VkImageView>& externalViews = {});
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~RenderTargets();
+
+	/**
+	 * @brief Destroys all resources, such as before init with a new extent. The device must not be using them anymore.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Begins the render pass on a framebuffer and sets the viewport and scissor to the rendered area
+	 *
+	 * @param commandBuffer - command buffer in the recording state on a graphics queue
+	 * @param framebuffer - index of the external view to render to, 0 without an external attachment
+	 * @param clearValues - one per attachment, only read for the ones that are cleared
+	 * @param area - rendered part at the top left, such as DynamicResolution::getRenderExtent. {0, 0} for the whole extent.
+	 */
+	void recordBegin(VkCommandBuffer commandBuffer, uint32_t framebuffer, const std::vector<VkClearValue>& clearValues,
+		VkExtent2D area = {0, 0});
+
+	void recordNextSubpass(VkCommandBuffer commandBuffer);
+	void recordEnd(VkCommandBuffer commandBuffer);
+
+	VkRenderPass getRenderPass();
+	VkFramebuffer getFramebuffer(uint32_t framebuffer);
+	VkExtent2D getExtent();
+
+	/**
+	 * @brief Returns the image of an attachment that isn't external
+	 */
+	Image& getAttachment(uint32_t attachment);
+
+	/**
+	 * @brief Returns how much memory and bandwidth the transient attachments save
+	 */
+	RenderTargetStats getStats();
+
+	/**
+	 * @brief Returns the image aspect of a format, depth and stencil for depth formats
+	 */
+	static VkImageAspectFlags getAspect(VkFormat format);
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkExtent2D extent;
+	VkRenderPass renderPass;
+	std::vector<AttachmentInfo> attachmentInfos;
+	// nullptr for the external attachment
+	std::vector<std::unique_ptr<Image>> images;
+	std::vector<VkFramebuffer> framebuffers;
+
+	void createImages(LogicalDevice& device, const std::vector<SubpassInfo>& subpasses);
+	void createRenderPass(const std::vector<SubpassInfo>& subpasses);
+	void createFramebuffers(const std::vector<VkImageView>& externalViews);
+};
@@ -0,0 +1,65 @@
+#include "Shader.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+
+Shader::Shader() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	handle(nullptr)
+{
+}
+
+void Shader::init(LogicalDevice& device, const std::string& name)
+{
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+
+	std::string path = getShaderDirectory() + "/" + name;
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open shader: " + path);
+	}
+	// SPIR-V is read as 32 bit words
+	size_t size = static_cast<size_t>(file.tellg());
+	std::vector<uint32_t> code((size + 3) / 4);
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(code.data()), size);
+
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = size;
+	createInfo.pCode = code.data();
+	VkResult result = dispatch->vkCreateShaderModule(deviceHandle, &createInfo, allocator, &handle); VK_CHECK(result);
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_SHADER_MODULE, handle, name);
+}
+
+Shader::~Shader()
+{
+	cleanup();
+}
+
+void Shader::cleanup()
+{
+	if (handle && deviceHandle) {
+		dispatch->vkDestroyShaderModule(deviceHandle, handle, allocator);
+		handle = nullptr;
+		deviceHandle = nullptr;
+	}
+}
+
+VkShaderModule Shader::getHandle()
+{
+	return handle;
+}
+
+std::string Shader::getShaderDirectory()
+{
+	return APPARATUS_SHADER_DIR;
+}
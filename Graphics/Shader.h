@@ -0,0 +1,54 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <string>
+
+#include "LogicalDevice.h"
+
+class Shader
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create the shader module, must call init
+	 */
+	Shader();
+
+	/**
+	 * @brief Creates a shader module from a compiled SPIR-V file.
+	 * Throws an error if the file can't be read.
+	 * 
+	 * @param device - the logical device to create the shader module under
+	 * @param name - file name of the shader inside the shader directory, such as "Cull.comp.spv"
+	 */
+	void init(LogicalDevice& device, const std::string& name);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~Shader();
+
+	/**
+	 * @brief Destroys the shader module. Pipelines created from it remain valid.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Returns the handle to this shader module.
+	 * 
+	 * @return shader module handle
+	 */
+	VkShaderModule getHandle();
+
+	/**
+	 * @brief Returns the directory the build places compiled shaders in
+	 */
+	static std::string getShaderDirectory();
+
+private:
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkShaderModule handle;
+};
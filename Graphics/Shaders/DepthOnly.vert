@@ -0,0 +1,31 @@
+#version 450
+
+// Depth of the objects drawn by IndirectDrawPass, such as the phases of occlusion culling.
+// Each draw's first instance is its object index. Layouts must match the structs in IndirectDrawPass.h
+
+layout(location = 0) in vec3 inPosition;
+
+struct ObjectData
+{
+	mat4 model;
+	vec4 boundingSphere;
+	uint meshIndex;
+	uint padding0;
+	uint padding1;
+	uint padding2;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects
+{
+	ObjectData objects[];
+};
+
+layout(push_constant) uniform Constants
+{
+	mat4 viewProjection;
+};
+
+void main()
+{
+	gl_Position = viewProjection * objects[gl_InstanceIndex].model * vec4(inPosition, 1.0);
+}
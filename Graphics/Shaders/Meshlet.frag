@@ -0,0 +1,16 @@
+#version 450
+
+// Default shading of the meshlet pipelines, a fixed light on the object space normal.
+// Replacements take the same inputs
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec2 inUv;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+	const vec3 lightDirection = normalize(vec3(0.4, 0.8, 0.6));
+	float diffuse = max(dot(normalize(inNormal), lightDirection), 0.0);
+	outColor = vec4(vec3(0.2 + 0.8 * diffuse), 1.0);
+}
@@ -0,0 +1,23 @@
+#version 450
+
+// Used when the device lacks mesh shaders, the meshlets visible after CPU culling are drawn as index ranges.
+// The push constants are the start of the ones in Meshlet.task
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUv;
+
+layout(push_constant) uniform Constants
+{
+	mat4 modelViewProjection;
+};
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec2 outUv;
+
+void main()
+{
+	gl_Position = modelViewProjection * vec4(inPosition, 1.0);
+	outNormal = inNormal;
+	outUv = inUv;
+}
@@ -0,0 +1,281 @@
+#include "SubmissionScheduler.h"
+
+#include <stdexcept>
+
+#include "DebugMessenger.h"
+#include "GpuDiagnostics.h"
+#include "DebugLabels.h"
+
+SubmissionScheduler::SubmissionScheduler() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	diagnostics(nullptr)
+{
+}
+
+void SubmissionScheduler::init(LogicalDevice& device)
+{
+	deviceHandle = device.getHandle();
+	allocator = device.getAllocator();
+	dispatch = &device.getDispatch();
+	for (VkQueue queue : device.getQueues()) {
+		auto state = std::make_unique<QueueState>();
+		state->queue = queue;
+		queues.push_back(std::move(state));
+	}
+}
+
+SubmissionScheduler::~SubmissionScheduler()
+{
+	cleanup();
+}
+
+void SubmissionScheduler::cleanup()
+{
+	if (deviceHandle) {
+		for (auto& state : queues) {
+			std::lock_guard<ProfiledMutex> lock(state->mutex);
+			for (auto& [serial, fence] : state->inFlight) {
+				dispatch->vkWaitForFences(deviceHandle, 1, &fence, VK_TRUE, UINT64_MAX);
+				dispatch->vkDestroyFence(deviceHandle, fence, allocator);
+			}
+			for (VkFence fence : state->freeFences) {
+				dispatch->vkDestroyFence(deviceHandle, fence, allocator);
+			}
+		}
+		queues.clear();
+		deviceHandle = nullptr;
+	}
+}
+
+uint64_t SubmissionScheduler::enqueue(VkQueue queue, SubmitBatch batch)
+{
+	QueueState& state = getState(queue);
+	state.batches.fetch_add(1, std::memory_order_relaxed);
+	state.commandBuffers.fetch_add(static_cast<uint32_t>(batch.commandBuffers.size()), std::memory_order_relaxed);
+
+	std::lock_guard<ProfiledMutex> lock(state.mutex);
+	state.pending.push_back(std::move(batch));
+	return state.nextSerial;
+}
+
+uint64_t SubmissionScheduler::flush(VkQueue queue)
+{
+	QueueState& state = getState(queue);
+	std::lock_guard<ProfiledMutex> lock(state.mutex);
+	return flushLocked(state);
+}
+
+void SubmissionScheduler::flushAll()
+{
+	for (auto& state : queues) {
+		std::lock_guard<ProfiledMutex> lock(state->mutex);
+		flushLocked(*state);
+	}
+}
+
+bool SubmissionScheduler::isComplete(VkQueue queue, uint64_t serial)
+{
+	QueueState& state = getState(queue);
+	if (state.completedSerial.load(std::memory_order_acquire) >= serial) {
+		return true;
+	}
+
+	std::lock_guard<ProfiledMutex> lock(state.mutex);
+	retireCompleted(state);
+	return state.completedSerial.load(std::memory_order_relaxed) >= serial;
+}
+
+void SubmissionScheduler::wait(VkQueue queue, uint64_t serial)
+{
+	QueueState& state = getState(queue);
+	if (state.completedSerial.load(std::memory_order_acquire) >= serial) {
+		return;
+	}
+
+	std::unique_lock<ProfiledMutex> lock(state.mutex);
+	if (serial >= state.nextSerial) {
+		flushLocked(state);
+	}
+
+	// Submissions on a queue complete in order, so waiting on the first fence at or past
+	// the serial is enough
+	VkFence fence = nullptr;
+	for (auto& [fenceSerial, inFlightFence] : state.inFlight) {
+		if (fenceSerial >= serial) {
+			fence = inFlightFence;
+			break;
+		}
+	}
+	if (fence != nullptr) {
+		state.waiters++;
+		lock.unlock();
+		VkResult result;
+		{
+			PROFILE_ZONE_NAMED("Wait for GPU");
+			result = dispatch->vkWaitForFences(deviceHandle, 1, &fence, VK_TRUE, UINT64_MAX);
+		}
+		lock.lock();
+		state.waiters--;
+		VK_CHECK(result);
+	}
+	retireCompleted(state);
+}
+
+std::unique_lock<ProfiledMutex> SubmissionScheduler::lockQueue(VkQueue queue)
+{
+	return std::unique_lock<ProfiledMutex>(getState(queue).mutex);
+}
+
+void SubmissionScheduler::beginFrame()
+{
+	for (auto& state : queues) {
+		state->lastFrame.submitCalls = state->submitCalls.exchange(0, std::memory_order_relaxed);
+		state->lastFrame.submitInfos = state->submitInfos.exchange(0, std::memory_order_relaxed);
+		state->lastFrame.batches = state->batches.exchange(0, std::memory_order_relaxed);
+		state->lastFrame.commandBuffers = state->commandBuffers.exchange(0, std::memory_order_relaxed);
+	}
+}
+
+SubmissionStats SubmissionScheduler::getFrameStats()
+{
+	SubmissionStats total{};
+	for (auto& state : queues) {
+		total.submitCalls += state->lastFrame.submitCalls;
+		total.submitInfos += state->lastFrame.submitInfos;
+		total.batches += state->lastFrame.batches;
+		total.commandBuffers += state->lastFrame.commandBuffers;
+	}
+	return total;
+}
+
+SubmissionStats SubmissionScheduler::getFrameStats(VkQueue queue)
+{
+	return getState(queue).lastFrame;
+}
+
+void SubmissionScheduler::setDiagnostics(GpuDiagnostics* _diagnostics)
+{
+	diagnostics = _diagnostics;
+}
+
+SubmissionScheduler::QueueState& SubmissionScheduler::getState(VkQueue queue)
+{
+	for (auto& state : queues) {
+		if (state->queue == queue) {
+			return *state;
+		}
+	}
+
+	throw std::runtime_error("SubmissionScheduler: queue wasn't created by the scheduler's device");
+}
+
+uint64_t SubmissionScheduler::flushLocked(QueueState& state)
+{
+	if (state.pending.empty()) {
+		return state.nextSerial - 1;
+	}
+	PROFILE_ZONE();
+
+	// Reserve everything up front so pointers into the arrays stay valid while they're filled
+	size_t commandBufferCount = 0, waitCount = 0, signalCount = 0;
+	for (const SubmitBatch& batch : state.pending) {
+		commandBufferCount += batch.commandBuffers.size();
+		waitCount += batch.waitSemaphores.size();
+		signalCount += batch.signalSemaphores.size();
+	}
+	std::vector<VkCommandBuffer> commandBuffers;
+	commandBuffers.reserve(commandBufferCount);
+	std::vector<VkSemaphore> waitSemaphores;
+	waitSemaphores.reserve(waitCount);
+	std::vector<VkPipelineStageFlags> waitStages;
+	waitStages.reserve(waitCount);
+	std::vector<VkSemaphore> signalSemaphores;
+	signalSemaphores.reserve(signalCount);
+
+	// A batch that waits has to start a new VkSubmitInfo so earlier command buffers aren't held back,
+	// and a batch that signals has to end one so later command buffers aren't waited on by mistake.
+	std::vector<VkSubmitInfo> submitInfos;
+	bool closed = true;
+	for (const SubmitBatch& batch : state.pending) {
+		if (closed || !batch.waitSemaphores.empty()) {
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.pWaitSemaphores = waitSemaphores.data() + waitSemaphores.size();
+			submitInfo.pWaitDstStageMask = waitStages.data() + waitStages.size();
+			submitInfo.pCommandBuffers = commandBuffers.data() + commandBuffers.size();
+			submitInfo.pSignalSemaphores = signalSemaphores.data() + signalSemaphores.size();
+			submitInfos.push_back(submitInfo);
+		}
+		VkSubmitInfo& submitInfo = submitInfos.back();
+
+		waitSemaphores.insert(waitSemaphores.end(), batch.waitSemaphores.begin(), batch.waitSemaphores.end());
+		waitStages.insert(waitStages.end(), batch.waitStages.begin(), batch.waitStages.end());
+		submitInfo.waitSemaphoreCount += static_cast<uint32_t>(batch.waitSemaphores.size());
+
+		commandBuffers.insert(commandBuffers.end(), batch.commandBuffers.begin(), batch.commandBuffers.end());
+		submitInfo.commandBufferCount += static_cast<uint32_t>(batch.commandBuffers.size());
+
+		signalSemaphores.insert(signalSemaphores.end(), batch.signalSemaphores.begin(), batch.signalSemaphores.end());
+		submitInfo.signalSemaphoreCount += static_cast<uint32_t>(batch.signalSemaphores.size());
+
+		closed = !batch.signalSemaphores.empty();
+	}
+	// Recorded before submitting so a submission that loses the device is in the history too
+	if (diagnostics != nullptr) {
+		for (const SubmitBatch& batch : state.pending) {
+			diagnostics->addSubmit(state.queue, batch.label, state.nextSerial, static_cast<uint32_t>(batch.commandBuffers.size()));
+		}
+	}
+	state.pending.clear();
+
+	retireCompleted(state);
+	VkFence fence = acquireFence(state);
+	VkResult result = dispatch->vkQueueSubmit(state.queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), fence); VK_CHECK(result);
+
+	uint64_t serial = state.nextSerial++;
+	state.inFlight.emplace_back(serial, fence);
+	state.submitCalls.fetch_add(1, std::memory_order_relaxed);
+	state.submitInfos.fetch_add(static_cast<uint32_t>(submitInfos.size()), std::memory_order_relaxed);
+	return serial;
+}
+
+void SubmissionScheduler::retireCompleted(QueueState& state)
+{
+	size_t retired = 0;
+	for (auto& [serial, fence] : state.inFlight) {
+		if (dispatch->vkGetFenceStatus(deviceHandle, fence) != VK_SUCCESS) {
+			break;
+		}
+		state.completedSerial.store(serial, std::memory_order_release);
+		retired++;
+	}
+	// A waiting thread may still use any of the fences, the last one to return recycles them
+	if (state.waiters > 0) {
+		return;
+	}
+	for (size_t i = 0; i < retired; i++) {
+		VkFence fence = state.inFlight[i].second;
+		VkResult result = dispatch->vkResetFences(deviceHandle, 1, &fence); VK_CHECK(result);
+		state.freeFences.push_back(fence);
+	}
+	state.inFlight.erase(state.inFlight.begin(), state.inFlight.begin() + retired);
+}
+
+VkFence SubmissionScheduler::acquireFence(QueueState& state)
+{
+	if (!state.freeFences.empty()) {
+		VkFence fence = state.freeFences.back();
+		state.freeFences.pop_back();
+		return fence;
+	}
+
+	VkFenceCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	VkFence fence = nullptr;
+	VkResult result = dispatch->vkCreateFence(deviceHandle, &createInfo, allocator, &fence); VK_CHECK(result);
+	// No fence is free, so every fence of the queue is in flight and this one is numbered after them
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_FENCE, fence, "SubmissionScheduler fence ", state.inFlight.size());
+	return fence;
+}
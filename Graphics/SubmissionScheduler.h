@@ -0,0 +1,179 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "Profiler.h"
+
+class GpuDiagnostics;
+
+// A unit of work for a single queue. The semaphores only apply to the command buffers in this batch.
+struct SubmitBatch
+{
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkSemaphore> waitSemaphores;
+	// One stage mask per wait semaphore
+	std::vector<VkPipelineStageFlags> waitStages;
+	std::vector<VkSemaphore> signalSemaphores;
+	// Name of the batch in the submission history of GpuDiagnostics, must outlive it, such as a string literal
+	const char* label = nullptr;
+};
+
+// Counters for one frame, either for a single queue or summed over all queues
+struct SubmissionStats
+{
+	uint32_t submitCalls = 0;     // vkQueueSubmit calls
+	uint32_t submitInfos = 0;     // VkSubmitInfo structures passed to those calls
+	uint32_t batches = 0;         // batches given to enqueue
+	uint32_t commandBuffers = 0;
+};
+
+class SubmissionScheduler
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't initialize the scheduler, must call init
+	 */
+	SubmissionScheduler();
+
+	/**
+	 * @brief Prepares a submission queue for every queue the device created.
+	 *
+	 * @param device - the initialized logical device whose queues will be submitted to
+	 */
+	void init(LogicalDevice& device);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~SubmissionScheduler();
+
+	/**
+	 * @brief Waits for all submitted work to finish and destroys the fences used for tracking it.
+	 * Pending batches that were never flushed are dropped.
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Queues a batch to be submitted on the next flush of the specified queue.
+	 * Safe to call from any thread, only threads using the same queue contend with each other.
+	 *
+	 * @param queue - the device queue the batch is for
+	 * @param batch - the command buffers and semaphores to submit
+	 *
+	 * @return serial of the flush the batch will be part of, used with isComplete and wait
+	 */
+	uint64_t enqueue(VkQueue queue, SubmitBatch batch);
+
+	/**
+	 * @brief Submits every pending batch of the specified queue with as few vkQueueSubmit calls as possible.
+	 * Consecutive batches are merged into the same VkSubmitInfo unless a semaphore wait or signal
+	 * forces a split, and all VkSubmitInfos go through a single vkQueueSubmit.
+	 *
+	 * @param queue - the device queue to flush
+	 *
+	 * @return serial of the submission, 0 if nothing has ever been submitted to the queue
+	 */
+	uint64_t flush(VkQueue queue);
+
+	/**
+	 * @brief Flushes every queue, meant to be called once per frame after all systems recorded their work
+	 */
+	void flushAll();
+
+	/**
+	 * @brief Returns whether the GPU finished the submission with the specified serial.
+	 *
+	 * @param queue - the queue the serial belongs to
+	 * @param serial - returned by enqueue or flush
+	 */
+	bool isComplete(VkQueue queue, uint64_t serial);
+
+	/**
+	 * @brief Blocks until the GPU finished the submission with the specified serial.
+	 * Flushes the queue first if the serial has not been submitted yet. The queue isn't locked while waiting,
+	 * so other threads can keep enqueueing and flushing on it.
+	 *
+	 * @param queue - the queue the serial belongs to
+	 * @param serial - returned by enqueue or flush
+	 */
+	void wait(VkQueue queue, uint64_t serial);
+
+	/**
+	 * @brief Locks the specified queue for work that doesn't go through vkQueueSubmit,
+	 * such as vkQueuePresentKHR, since vulkan requires queue access to be externally synchronized.
+	 *
+	 * @return lock held until it goes out of scope
+	 */
+	std::unique_lock<ProfiledMutex> lockQueue(VkQueue queue);
+
+	/**
+	 * @brief Ends the counters of the current frame and starts new ones.
+	 * Call once per frame before any work is enqueued.
+	 */
+	void beginFrame();
+
+	/**
+	 * @brief Returns the counters of the previous frame summed over all queues
+	 */
+	SubmissionStats getFrameStats();
+
+	/**
+	 * @brief Returns the counters of the previous frame for the specified queue
+	 */
+	SubmissionStats getFrameStats(VkQueue queue);
+
+	/**
+	 * @brief Adds every batch to the submission history of the diagnostics before it's submitted
+	 *
+	 * @param _diagnostics - initialized diagnostics of the same device, nullptr to stop
+	 */
+	void setDiagnostics(GpuDiagnostics* _diagnostics);
+
+private:
+	// Everything needed to submit to one queue. Each queue has its own lock
+	// so threads submitting to different queues never wait on each other.
+	struct QueueState
+	{
+		VkQueue queue = nullptr;
+		PROFILED_MUTEX(mutex);
+		std::vector<SubmitBatch> pending;
+		// Serial the next flush will use
+		uint64_t nextSerial = 1;
+		std::atomic<uint64_t> completedSerial{0};
+		// Fences of submissions the GPU may still be working on, ordered by serial
+		std::vector<std::pair<uint64_t, VkFence>> inFlight;
+		std::vector<VkFence> freeFences;
+		// Threads in wait without the mutex. Signaled fences stay in inFlight until it's back to 0,
+		// so none is reset or reused while a thread waits on it
+		uint32_t waiters = 0;
+
+		std::atomic<uint32_t> submitCalls{0};
+		std::atomic<uint32_t> submitInfos{0};
+		std::atomic<uint32_t> batches{0};
+		std::atomic<uint32_t> commandBuffers{0};
+		SubmissionStats lastFrame;
+	};
+
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	GpuDiagnostics* diagnostics;
+	// Created once in init and never resized, so lookups don't need a lock
+	std::vector<std::unique_ptr<QueueState>> queues;
+
+	QueueState& getState(VkQueue queue);
+
+	// Both require the state's mutex to be held
+	uint64_t flushLocked(QueueState& state);
+	void retireCompleted(QueueState& state);
+
+	VkFence acquireFence(QueueState& state);
+};
@@ -4,7 +4,9 @@
 
 Surface::Surface() :
 	handle(nullptr),
-	instanceHandle(nullptr)
+	instanceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr)
 {
 }
 
@@ -12,7 +14,23 @@ void Surface::init(VulkanInstance& instance, Window& window)
 {
 	// TODO test for nullptr instanceHandle
 	instanceHandle = instance.getHandle();
-	VkResult result = glfwCreateWindowSurface(instanceHandle, window.getHandle(), nullptr, &handle); VK_CHECK(result);
+	allocator = instance.getAllocator();
+	dispatch = &instance.getDispatch();
+	VkResult result = glfwCreateWindowSurface(instanceHandle, window.getHandle(), allocator, &handle); VK_CHECK(result);
+}
+
+void Surface::initHeadless(VulkanInstance& instance)
+{
+	if (!instance.isHeadless()) {
+		VK_CHECK(VK_ERROR_EXTENSION_NOT_PRESENT);
+	}
+	instanceHandle = instance.getHandle();
+	allocator = instance.getAllocator();
+	dispatch = &instance.getDispatch();
+
+	VkHeadlessSurfaceCreateInfoEXT createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+	VkResult result = dispatch->vkCreateHeadlessSurfaceEXT(instanceHandle, &createInfo, allocator, &handle); VK_CHECK(result);
 }
 
 Surface::~Surface()
@@ -23,7 +41,7 @@ Surface::~Surface()
 void Surface::cleanup()
 {
 	if (instanceHandle && handle) {
-		vkDestroySurfaceKHR(instanceHandle, handle, nullptr);
+		dispatch->vkDestroySurfaceKHR(instanceHandle, handle, allocator);
 		instanceHandle = nullptr;
 		handle = nullptr;
 	}
@@ -34,34 +52,39 @@ VkSurfaceKHR Surface::getHandle()
 	return handle;
 }
 
+const InstanceDispatch& Surface::getInstanceDispatch()
+{
+	return *dispatch;
+}
+
 VkSurfaceCapabilitiesKHR Surface::getCapabilities(VkPhysicalDevice device)
 {
 	VkSurfaceCapabilitiesKHR capabilities;
-	VkResult result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, handle, &capabilities); VK_CHECK(result);
+	VkResult result = dispatch->vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, handle, &capabilities); VK_CHECK(result);
 	return capabilities;
 }
 
-std::vector<VkSurfaceFormatKHR> Surface::getFormats(VkPhysicalDevice device)
+std::pmr::vector<VkSurfaceFormatKHR> Surface::getFormats(VkPhysicalDevice device, std::pmr::memory_resource* memory)
 {
 	uint32_t count = 0;
-	VkResult result = vkGetPhysicalDeviceSurfaceFormatsKHR(device, handle, &count, nullptr); VK_CHECK(result);
-	std::vector<VkSurfaceFormatKHR> formats(count);
-	result = vkGetPhysicalDeviceSurfaceFormatsKHR(device, handle, &count, formats.data()); VK_CHECK(result);
+	VkResult result = dispatch->vkGetPhysicalDeviceSurfaceFormatsKHR(device, handle, &count, nullptr); VK_CHECK(result);
+	std::pmr::vector<VkSurfaceFormatKHR> formats(count, memory);
+	result = dispatch->vkGetPhysicalDeviceSurfaceFormatsKHR(device, handle, &count, formats.data()); VK_CHECK(result);
 	return formats;
 }
 
-std::vector<VkPresentModeKHR> Surface::getPresentModes(VkPhysicalDevice device)
+std::pmr::vector<VkPresentModeKHR> Surface::getPresentModes(VkPhysicalDevice device, std::pmr::memory_resource* memory)
 {
 	uint32_t count = 0;
-	VkResult result = vkGetPhysicalDeviceSurfacePresentModesKHR(device, handle, &count, nullptr); VK_CHECK(result);
-	std::vector<VkPresentModeKHR> presentModes(count);
-	result = vkGetPhysicalDeviceSurfacePresentModesKHR(device, handle, &count, presentModes.data()); VK_CHECK(result);
+	VkResult result = dispatch->vkGetPhysicalDeviceSurfacePresentModesKHR(device, handle, &count, nullptr); VK_CHECK(result);
+	std::pmr::vector<VkPresentModeKHR> presentModes(count, memory);
+	result = dispatch->vkGetPhysicalDeviceSurfacePresentModesKHR(device, handle, &count, presentModes.data()); VK_CHECK(result);
 	return presentModes;
 }
 
 VkBool32 Surface::supportsQueueFamily(VkPhysicalDevice device, uint32_t queueFamilyIndex)
 {
 	VkBool32 supported = VK_FALSE;
-	VkResult result = vkGetPhysicalDeviceSurfaceSupportKHR(device, queueFamilyIndex, handle, &supported); VK_CHECK(result);
+	VkResult result = dispatch->vkGetPhysicalDeviceSurfaceSupportKHR(device, queueFamilyIndex, handle, &supported); VK_CHECK(result);
 	return supported;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <memory_resource>
 #include <vector>
 
 #include "VulkanInstance.h"
@@ -24,6 +25,13 @@ public:
 	 */
 	void init(VulkanInstance& instance, Window& window);
 
+	/**
+	 * @brief Creates a surface that isn't shown anywhere, presents to it only go through the swapchain
+	 * 
+	 * @param instance - a headless instance to create this surface under
+	 */
+	void initHeadless(VulkanInstance& instance);
+
 	/**
 	 * @brief Destructor: Calls cleanup() to free up memory
 	 */
@@ -42,6 +50,11 @@ public:
 	 */
 	VkSurfaceKHR getHandle();
 
+	/**
+	 * @brief Returns the functions of the instance this surface was created under
+	 */
+	const InstanceDispatch& getInstanceDispatch();
+
 	/**
 	 * @brief Returns the surface's capabilities that are compatible with the specified device
 	 * 
@@ -55,19 +68,23 @@ public:
 	 * @brief Returns the surface's formats that are compatible with the specified device
 	 * 
 	 * @param device - the physical device to check for compatibility
+	 * @param memory - allocates the vector, such as a ScratchScope's arena
 	 * 
 	 * @return vector of compatible surface formats
 	 */
-	std::vector<VkSurfaceFormatKHR> getFormats(VkPhysicalDevice device);
+	std::pmr::vector<VkSurfaceFormatKHR> getFormats(VkPhysicalDevice device,
+		std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 
 	/**
 	 * @brief Returns the surface's present modes that are compatible with the specified device
 	 * 
 	 * @param device - the physical device to check for compatibility
+	 * @param memory - allocates the vector, such as a ScratchScope's arena
 	 * 
 	 * @return vector of compatible present modes
 	 */
-	std::vector<VkPresentModeKHR> getPresentModes(VkPhysicalDevice device);
+	std::pmr::vector<VkPresentModeKHR> getPresentModes(VkPhysicalDevice device,
+		std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 
 	/**
 	 * @brief returns whether the specified queue family from the specified device supports
@@ -83,4 +100,6 @@ public:
 private:
 	VkInstance instanceHandle;
 	VkSurfaceKHR handle;
+	const VkAllocationCallbacks* allocator;
+	const InstanceDispatch* dispatch;
 };
\ No newline at end of file
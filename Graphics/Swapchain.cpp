@@ -1,60 +1,214 @@
 #include "Swapchain.h"
 
 #include "DebugMessenger.h"
+#include "DebugLabels.h"
+#include "FrameArena.h"
 
 #include <limits>
 #include <algorithm>
 
 Swapchain::Swapchain() :
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
 	handle(nullptr),
-	deviceHandle(nullptr)
+	device(nullptr),
+	surface(nullptr),
+	window(nullptr),
+	format(VK_FORMAT_UNDEFINED),
+	extent{},
+	usage(0),
+	images{},
+	imageViews{}
 {
 }
 
-void Swapchain::init(LogicalDevice& device, Surface& surface, Window& window)
+void Swapchain::init(LogicalDevice& _device, Surface& _surface, Window& _window)
+{
+	device = &_device;
+	surface = &_surface;
+	window = &_window;
+	deviceHandle = device->getHandle();
+	allocator = device->getAllocator();
+	dispatch = &device->getDispatch();
+	if (!device->supportsSurface(*surface)) {
+		VK_CHECK(VK_ERROR_SURFACE_LOST_KHR);
+	}
+
+	create();
+}
+
+void Swapchain::init(LogicalDevice& _device, Surface& _surface, VkExtent2D _extent)
+{
+	device = &_device;
+	surface = &_surface;
+	window = nullptr;
+	extent = _extent;
+	deviceHandle = device->getHandle();
+	allocator = device->getAllocator();
+	dispatch = &device->getDispatch();
+	if (!device->supportsSurface(*surface)) {
+		VK_CHECK(VK_ERROR_SURFACE_LOST_KHR);
+	}
+
+	create();
+}
+
+Swapchain::~Swapchain()
+{
+	cleanup();
+}
+
+void Swapchain::cleanup()
+{
+	if (handle && deviceHandle) {
+		destroyImageViews();
+		dispatch->vkDestroySwapchainKHR(deviceHandle, handle, allocator);
+		handle = nullptr;
+		deviceHandle = nullptr;
+	}
+}
+
+void Swapchain::recreate()
+{
+	create();
+}
+
+VkResult Swapchain::acquireNextImage(VkSemaphore semaphore, uint32_t& imageIndex)
+{
+	VkResult result = dispatch->vkAcquireNextImageKHR(deviceHandle, handle, UINT64_MAX, semaphore, nullptr, &imageIndex);
+	if (result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR) {
+		VK_CHECK(result);
+	}
+
+	return result;
+}
+
+VkSwapchainKHR Swapchain::getHandle()
+{
+	return handle;
+}
+
+VkFormat Swapchain::getFormat()
+{
+	return format;
+}
+
+VkExtent2D Swapchain::getExtent()
+{
+	return extent;
+}
+
+VkImageUsageFlags Swapchain::getUsage()
+{
+	return usage;
+}
+
+const std::vector<VkImage>& Swapchain::getImages()
+{
+	return images;
+}
+
+const std::vector<VkImageView>& Swapchain::getImageViews()
+{
+	return imageViews;
+}
+
+void Swapchain::create()
 {
-	deviceHandle = device.getHandle();
 	VkSwapchainCreateInfoKHR createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-	createInfo.surface = surface.getHandle();
+	createInfo.surface = surface->getHandle();
 
 	// Retrieve surface information
-	auto surfaceCapabilities = surface.getCapabilities(device.getPhysicalDevice));
-	auto surfaceFormats = surface.getFormats(device.getPhysicalDevice));
+	auto capabilities = surface->getCapabilities(device->getPhysicalDevice());
+	// Recreated on every resize, so the formats go to the scratch arena
+	ScratchScope scratch;
+	auto surfaceFormats = surface->getFormats(device->getPhysicalDevice(), scratch.getResource());
 
 	// Pick min image count
-	uint32_t minImageCount = pickMinImageCount(capabilities);
-	createInfo.minImageCount = minImageCount;
+	createInfo.minImageCount = pickMinImageCount(capabilities);
 
 	// Pick surface format
 	VkSurfaceFormatKHR surfaceFormat = pickFormat(surfaceFormats);
 	createInfo.imageFormat = surfaceFormat.format;
 	createInfo.imageColorSpace = surfaceFormat.colorSpace;
 
-	// Pick image extent
-	createInfo.imageExtent = pickExtent(capabilities, window);
+	// Pick image extent, without a window the size given to init is kept
+	VkExtent2D requested = extent;
+	if (window) {
+		int width, height;
+		glfwGetFramebufferSize(window->getHandle(), &width, &height);
+		requested = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+	}
+	createInfo.imageExtent = pickExtent(capabilities, requested);
 
 	// image specifics
 	createInfo.imageArrayLayers = 1;
-	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-
-	VkResult result = vkCreateSwapchainKHR(deviceHandle, &createInfo, nullptr, &handle); VK_CHECK(result);
-
-	// TODO retrieve images
-}
+	// Transfers let a lower resolution image be blitted in, such as by DynamicResolution
+	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+		| (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+	// Images are rendered on the graphics queue and presented on the present queue
+	uint32_t queueFamilies[] = {device->getGraphicsFamilyIndex(), device->getPresentFamilyIndex()};
+	if (queueFamilies[0] != queueFamilies[1]) {
+		createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = 2;
+		createInfo.pQueueFamilyIndices = queueFamilies;
+	} else {
+		createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
 
-Swapchain::~Swapchain()
-{
-	cleanup();
+	createInfo.preTransform = capabilities.currentTransform;
+	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	// FIFO is always supported and doesn't render frames that are never shown
+	createInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	createInfo.clipped = VK_TRUE;
+	createInfo.oldSwapchain = handle;
+
+	VkSwapchainKHR newHandle = nullptr;
+	VkResult result = dispatch->vkCreateSwapchainKHR(deviceHandle, &createInfo, allocator, &newHandle); VK_CHECK(result);
+	if (handle) {
+		destroyImageViews();
+		dispatch->vkDestroySwapchainKHR(deviceHandle, handle, allocator);
+	}
+	handle = newHandle;
+	setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_SWAPCHAIN_KHR, handle, "Swapchain");
+	format = surfaceFormat.format;
+	extent = createInfo.imageExtent;
+	usage = createInfo.imageUsage;
+
+	// Retrieve images
+	uint32_t count = 0;
+	dispatch->vkGetSwapchainImagesKHR(deviceHandle, handle, &count, nullptr);
+	images.resize(count);
+	dispatch->vkGetSwapchainImagesKHR(deviceHandle, handle, &count, images.data());
+
+	imageViews.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = images[i];
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+		result = dispatch->vkCreateImageView(deviceHandle, &viewInfo, allocator, &imageViews[i]); VK_CHECK(result);
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_IMAGE, images[i], "Swapchain image ", i);
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_IMAGE_VIEW, imageViews[i], "Swapchain image ", i, " view");
+	}
 }
 
-void Swapchain::cleanup()
+void Swapchain::destroyImageViews()
 {
-	if (handle && deviceHandle) {
-		vkDestroySwapchainKHR(deviceHandle, handle, nullptr);
-		handle = nullptr;
-		deviceHandle = nullptr;
+	for (VkImageView view : imageViews) {
+		dispatch->vkDestroyImageView(deviceHandle, view, allocator);
 	}
+	imageViews.clear();
+	images.clear();
 }
 
 uint32_t Swapchain::pickMinImageCount(VkSurfaceCapabilitiesKHR capabilities)
@@ -69,21 +223,26 @@ uint32_t Swapchain::pickMinImageCount(VkSurfaceCapabilitiesKHR capabilities)
 	return count;
 }
 
-VkExtent2D Swapchain::pickExtent(VkSurfaceCapabilitiesKHR capabilities, Window& window)
+VkSurfaceFormatKHR Swapchain::pickFormat(const std::pmr::vector<VkSurfaceFormatKHR>& formats)
+{
+	// Prefer 8 bit sRGB, otherwise take what the surface lists first
+	for (auto surfaceFormat : formats) {
+		if (surfaceFormat.format == VK_FORMAT_B8G8R8A8_SRGB && surfaceFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+			return surfaceFormat;
+		}
+	}
+
+	return formats[0];
+}
+
+VkExtent2D Swapchain::pickExtent(VkSurfaceCapabilitiesKHR capabilities, VkExtent2D requested)
 {
 	if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
 		return capabilities.currentExtent;
 	} else {
-		int width, height;
-		glfwGetFramebufferSize(window.getHandle(), &width, &height);
-
-		VkExtent2D extent {
-			static_cast<uint32_t>(width),
-			static_cast<uint32_t>(height)
-		};
-
-		extent.width = std::clamp(extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
-		extent.height = std::clamp(extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
-		return extent;
+		VkExtent2D framebufferExtent = requested;
+		framebufferExtent.width = std::clamp(framebufferExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+		framebufferExtent.height = std::clamp(framebufferExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+		return framebufferExtent;
 	}
-}
\ No newline at end of file
+}
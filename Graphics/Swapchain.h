@@ -1,22 +1,109 @@
 #pragma once
 
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <memory_resource>
+#include <vector>
+
 #include "LogicalDevice.h"
 #include "Surface.h"
+#include "Window.h"
 
 class Swapchain
 {
 public:
+	/**
+	 * @brief Default Constructor: Doesn't create the swapchain, must call init
+	 */
 	Swapchain();
+
+	/**
+	 * @brief Creates a swapchain for the window's surface and views of its images.
+	 * Every window gets its own swapchain, they can all share one logical device.
+	 *
+	 * Throws an error if the device's present queue can't present to the surface.
+	 *
+	 * @param device - the logical device, the surface must have been given to its init
+	 * @param surface - the surface created for window
+	 * @param window - used to find the image size when the surface doesn't dictate one
+	 */
 	void init(LogicalDevice& device, Surface& surface, Window& window);
 
+	/**
+	 * @brief Creates a swapchain for a surface without a window, such as from Surface::initHeadless
+	 *
+	 * @param device - the logical device, the surface must have been given to its init
+	 * @param surface - the surface to present to
+	 * @param _extent - image size when the surface doesn't dictate one, kept by recreate
+	 */
+	void init(LogicalDevice& device, Surface& surface, VkExtent2D _extent);
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
 	~Swapchain();
+
+	/**
+	 * @brief Destroys the image views and the swapchain. The images must not be in use anymore.
+	 */
 	void cleanup();
 
+	/**
+	 * @brief Creates a new swapchain with the window's current size, such as after presenting
+	 * returned VK_ERROR_OUT_OF_DATE_KHR. The images must not be in use anymore.
+	 */
+	void recreate();
+
+	/**
+	 * @brief Gets the index of the next image to render to.
+	 *
+	 * @param semaphore - signaled once the image can be written to
+	 * @param imageIndex - set to the index of the acquired image
+	 *
+	 * @return VK_SUCCESS, VK_SUBOPTIMAL_KHR or VK_ERROR_OUT_OF_DATE_KHR, other errors are thrown
+	 */
+	VkResult acquireNextImage(VkSemaphore semaphore, uint32_t& imageIndex);
+
+	/**
+	 * @brief Returns the handle to this swapchain.
+	 *
+	 * @return swapchain handle
+	 */
+	VkSwapchainKHR getHandle();
+
+	VkFormat getFormat();
+	VkExtent2D getExtent();
+
+	/**
+	 * @brief Returns the usage of the images, color attachment and transfer destination when the surface allows it
+	 */
+	VkImageUsageFlags getUsage();
+
+	const std::vector<VkImage>& getImages();
+	const std::vector<VkImageView>& getImageViews();
+
 private:
 	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
 	VkSwapchainKHR handle;
+	LogicalDevice* device;
+	Surface* surface;
+	Window* window;
+	VkFormat format;
+	VkExtent2D extent;
+	VkImageUsageFlags usage;
+	std::vector<VkImage> images;
+	std::vector<VkImageView> imageViews;
+
+	/**
+	 * @brief Creates the swapchain, replacing the current one if there is one
+	 */
+	void create();
+	void destroyImageViews();
 
-	uint32_t pickMinImageCount(VkSurfaceCapabilitiesKHR capabilities);
-	VkSurfaceFormatKHR pickFormat(std::vector<VkSurfaceFormatKHR> formats);
-	VkExtent2D pickExtent(VkSurfaceCapabilitiesKHR capabilities, Window& window);
-};
\ No newline at end of file
+	static uint32_t pickMinImageCount(VkSurfaceCapabilitiesKHR capabilities);
+	static VkSurfaceFormatKHR pickFormat(const std::pmr::vector<VkSurfaceFormatKHR>& formats);
+	static VkExtent2D pickExtent(VkSurfaceCapabilitiesKHR capabilities, VkExtent2D requested);
+};
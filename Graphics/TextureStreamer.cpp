@@ -0,0 +1,820 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "DebugMessenger.h"
+#include "DebugLabels.h"
+
+namespace
+{
+	constexpr uint64_t PENDING_SERIAL = UINT64_MAX;
+
+	VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+TextureStreamer::TextureStreamer() :
+	device(nullptr),
+	scheduler(nullptr),
+	settings{},
+	deviceHandle(nullptr),
+	allocator(nullptr),
+	dispatch(nullptr),
+	transferQueue(nullptr),
+	sparseQueue(nullptr),
+	queueFamilies{},
+	sparse(false),
+	budget(0),
+	frame(0),
+	stats{},
+	textures{},
+	textureCount(0),
+	retired{},
+	stagingAllocations{},
+	stagingHead(0),
+	commandPool(nullptr),
+	commandBuffers{}
+{
+}
+
+void TextureStreamer::init(LogicalDevice& _device, SubmissionScheduler& _scheduler, const StreamingSettings& _settings)
+{
+	device = &_device;
+	scheduler = &_scheduler;
+	settings = _settings;
+	deviceHandle = device->getHandle();
+	allocator = device->getAllocator();
+	dispatch = &device->getDispatch();
+	transferQueue = device->getTransferQueue();
+	sparseQueue = device->getGraphicsQueue();
+	sparse = settings.useSparse && device->supportsSparseResidency();
+	textures.resize(settings.maxTextures);
+
+	// Images are shared concurrently so the transfer queue needs no ownership transfers
+	queueFamilies = {device->getGraphicsFamilyIndex()};
+	if (device->getTransferFamilyIndex() != device->getGraphicsFamilyIndex()) {
+		queueFamilies.push_back(device->getTransferFamilyIndex());
+	}
+
+	budget = settings.budget;
+	if (budget == 0) {
+		budget = static_cast<VkDeviceSize>(device->getDeviceLocalHeapSize() * settings.budgetFraction);
+	}
+	stats.budget = budget;
+
+	stagingBuffer.init(*device, settings.stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	feedbackBuffer.init(*device, sizeof(uint32_t) * settings.maxTextures,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	std::fill_n(static_cast<uint32_t*>(feedbackBuffer.getMapped()), settings.maxTextures, NO_REQUEST);
+	stagingBuffer.setName("TextureStreamer staging");
+	feedbackBuffer.setName("TextureStreamer feedback");
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = device->getTransferFamilyIndex();
+	VkResult result = dispatch->vkCreateCommandPool(deviceHandle, &poolInfo, allocator, &commandPool); VK_CHECK(result);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	cleanup();
+}
+
+void TextureStreamer::cleanup()
+{
+	if (deviceHandle) {
+		dispatch->vkDeviceWaitIdle(deviceHandle);
+		retired.clear();
+		for (uint32_t i = 0; i < textureCount; i++) {
+			destroyTexture(*textures[i]);
+		}
+		textures.clear();
+		textureCount = 0;
+
+		dispatch->vkDestroyCommandPool(deviceHandle, commandPool, allocator);
+		commandPool = nullptr;
+		commandBuffers.clear();
+		stagingAllocations.clear();
+		stagingHead = 0;
+		feedbackBuffer.cleanup();
+		stagingBuffer.cleanup();
+		deviceHandle = nullptr;
+	}
+}
+
+TextureHandle TextureStreamer::addTexture(const StreamedTextureInfo& info)
+{
+	if (textureCount == settings.maxTextures) {
+		throw std::runtime_error("TextureStreamer already holds StreamingSettings::maxTextures textures");
+	}
+	TextureHandle handle = textureCount;
+	auto texture = std::make_unique<Texture>();
+	texture->info = info;
+
+	// The tail starts at the first mip that fits in residentTailSize
+	texture->tailMip = info.mipLevels - 1;
+	for (uint32_t mip = 0; mip < info.mipLevels; mip++) {
+		VkExtent2D extent = getMipExtent(info, mip);
+		if (extent.width <= settings.residentTailSize && extent.height <= settings.residentTailSize) {
+			texture->tailMip = mip;
+			break;
+		}
+	}
+
+	VkImage image = nullptr;
+	uint32_t baseMip = 0;
+	if (sparse) {
+		createSparseImage(*texture);
+		image = texture->sparseImage;
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_IMAGE, texture->sparseImage, "Streamed texture ", handle);
+		setObjectName(*dispatch, deviceHandle, VK_OBJECT_TYPE_IMAGE_VIEW, texture->sparseView, "Streamed texture ", handle, " view");
+	} else {
+		ImageInfo imageInfo{};
+		imageInfo.extent = getMipExtent(info, texture->tailMip);
+		imageInfo.format = info.format;
+		imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageInfo.mipLevels = info.mipLevels - texture->tailMip;
+		imageInfo.queueFamilies = queueFamilies;
+		texture->image = std::make_unique<Image>();
+		texture->image->init(*device, imageInfo);
+		texture->image->setName("Streamed texture ", handle);
+		image = texture->image->getHandle();
+		baseMip = texture->tailMip;
+	}
+
+	// Without sparse residency every upload holds the whole chain from its target on, with it the worst case is
+	// a single mip uploaded on top of the next coarser one
+	texture->stagingMip = texture->tailMip;
+	while (texture->stagingMip > 0) {
+		uint32_t mip = texture->stagingMip - 1;
+		VkDeviceSize bytes = sparse ? getUploadBytes(info, mip, mip + 1) : getUploadBytes(info, mip, info.mipLevels);
+		if (bytes > settings.stagingSize) {
+			break;
+		}
+		texture->stagingMip = mip;
+	}
+
+	VkCommandBuffer commandBuffer = beginCommandBuffer();
+	if (!recordUploads(commandBuffer, *texture, image, baseMip, texture->tailMip, info.mipLevels)) {
+		// Staging is full of uploads that are still running, wait for them and try once more
+		dispatch->vkDeviceWaitIdle(deviceHandle);
+		releaseStaging();
+		if (!recordUploads(commandBuffer, *texture, image, baseMip, texture->tailMip, info.mipLevels)) {
+			VK_CHECK(VK_ERROR_OUT_OF_DEVICE_MEMORY);
+		}
+	}
+
+	std::vector<VkSemaphore> waits{};
+	if (sparse) {
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		VkResult result = dispatch->vkCreateSemaphore(deviceHandle, &semaphoreInfo, allocator, &texture->bindSemaphore); VK_CHECK(result);
+		// Mips between the streamer's tail and the sparse mip tail are bound individually
+		bindSparseMips(*texture, texture->tailMip, info.mipLevels, true, texture->bindSemaphore);
+		waits.push_back(texture->bindSemaphore);
+	}
+
+	uint64_t serial = submit(commandBuffer, waits);
+	scheduler->wait(transferQueue, serial);
+	if (texture->bindSemaphore) {
+		dispatch->vkDestroySemaphore(deviceHandle, texture->bindSemaphore, allocator);
+		texture->bindSemaphore = nullptr;
+	}
+
+	texture->residentMip = texture->tailMip;
+	texture->pendingMip = texture->tailMip;
+	texture->pendingSerial = serial;
+	texture->wantedMip = texture->tailMip;
+	texture->requestedMip.store(NO_REQUEST);
+	texture->lastRequestFrame = frame;
+	// Only this slot is written, requestMip may be reading the others
+	textures[handle] = std::move(texture);
+	textureCount++;
+	return handle;
+}
+
+void TextureStreamer::requestMip(TextureHandle texture, uint32_t mip)
+{
+	std::atomic<uint32_t>& requested = textures[texture]->requestedMip;
+	uint32_t current = requested.load(std::memory_order_relaxed);
+	while (mip < current && !requested.compare_exchange_weak(current, mip, std::memory_order_relaxed)) {
+	}
+}
+
+VkBuffer TextureStreamer::getFeedbackBuffer()
+{
+	return feedbackBuffer.getHandle();
+}
+
+void TextureStreamer::recordFeedbackReset(VkCommandBuffer commandBuffer)
+{
+	dispatch->vkCmdFillBuffer(commandBuffer, feedbackBuffer.getHandle(), 0, VK_WHOLE_SIZE, NO_REQUEST);
+
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	dispatch->vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void TextureStreamer::recordFeedbackReadback(VkCommandBuffer commandBuffer)
+{
+	// The buffer is host coherent, so once the frame's fence signaled the barrier is all readFeedback needs
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	dispatch->vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void TextureStreamer::readFeedback()
+{
+	const uint32_t* feedback = static_cast<const uint32_t*>(feedbackBuffer.getMapped());
+	for (uint32_t i = 0; i < textureCount; i++) {
+		if (feedback[i] != NO_REQUEST) {
+			requestMip(i, feedback[i]);
+		}
+	}
+}
+
+void TextureStreamer::update()
+{
+	frame++;
+	stats.uploadedMips = 0;
+	stats.evictedMips = 0;
+
+	// Destroy what frames in flight can't be using anymore
+	while (!retired.empty() && retired.front().frame + settings.framesInFlight <= frame) {
+		Retired& entry = retired.front();
+		if (!entry.image) {
+			Texture& texture = *textures[entry.texture];
+			// Mips that were requested again since the eviction keep their memory
+			bindSparseMips(texture, 0, std::min(texture.residentMip, texture.pendingMip), false, nullptr);
+		}
+		retired.pop_front();
+	}
+
+	// Finish uploads the GPU is done with
+	for (uint32_t i = 0; i < textureCount; i++) {
+		auto& texture = textures[i];
+		if (texture->pendingMip != texture->residentMip && scheduler->isComplete(transferQueue, texture->pendingSerial)) {
+			if (sparse) {
+				dispatch->vkDestroySemaphore(deviceHandle, texture->bindSemaphore, allocator);
+				texture->bindSemaphore = nullptr;
+			} else {
+				retired.push_back({frame, std::move(texture->image), 0});
+				texture->image = std::move(texture->pendingImage);
+			}
+			texture->residentMip = texture->pendingMip;
+		}
+	}
+	releaseStaging();
+
+	for (uint32_t i = 0; i < textureCount; i++) {
+		auto& texture = textures[i];
+		uint32_t requested = texture->requestedMip.exchange(NO_REQUEST, std::memory_order_relaxed);
+		if (requested != NO_REQUEST) {
+			texture->wantedMip = std::clamp(requested, texture->stagingMip, texture->tailMip);
+			texture->lastRequestFrame = frame;
+		}
+	}
+
+	std::vector<uint32_t> targets;
+	pickTargets(targets);
+
+	VkCommandBuffer commandBuffer = nullptr;
+	std::vector<VkSemaphore> waits{};
+	std::vector<Texture*> submitted{};
+	for (uint32_t i = 0; i < textureCount; i++) {
+		Texture& texture = *textures[i];
+		uint32_t target = targets[i];
+		if (target == texture.residentMip || texture.pendingMip != texture.residentMip) {
+			continue;
+		}
+
+		if (sparse && target > texture.residentMip) {
+			// Shaders stop sampling the mips right away, the memory goes once frames in flight finished
+			stats.evictedMips += target - texture.residentMip;
+			texture.residentMip = target;
+			texture.pendingMip = target;
+			retired.push_back({frame, nullptr, i});
+			continue;
+		}
+
+		// With staging too full for every wanted mip, the coarser ones that fit are uploaded now and become
+		// resident on their own, the rest follows in later updates
+		uint32_t lastMip = sparse ? texture.residentMip : texture.info.mipLevels;
+		VkDeviceSize alignment = getStagingAlignment(texture.info);
+		VkDeviceSize offset = 0;
+		while (target + 1 < texture.residentMip && !findStaging(getUploadBytes(texture.info, target, lastMip), alignment, offset)) {
+			target++;
+		}
+		if (!findStaging(getUploadBytes(texture.info, target, lastMip), alignment, offset)) {
+			// Wait for running uploads to free staging, without holding back the textures after this one
+			continue;
+		}
+
+		if (!commandBuffer) {
+			commandBuffer = beginCommandBuffer();
+		}
+
+		if (sparse) {
+			if (!recordUploads(commandBuffer, texture, texture.sparseImage, 0, target, texture.residentMip)) {
+				continue;
+			}
+			VkSemaphoreCreateInfo semaphoreInfo{};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			VkResult result = dispatch->vkCreateSemaphore(deviceHandle, &semaphoreInfo, allocator, &texture.bindSemaphore); VK_CHECK(result);
+			bindSparseMips(texture, target, texture.residentMip, true, texture.bindSemaphore);
+			waits.push_back(texture.bindSemaphore);
+		} else {
+			// The replacement image is filled completely from the source, the old image is left alone
+			// since the graphics queue may be sampling it
+			ImageInfo imageInfo{};
+			imageInfo.extent = getMipExtent(texture.info, target);
+			imageInfo.format = texture.info.format;
+			imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			imageInfo.mipLevels = texture.info.mipLevels - target;
+			imageInfo.queueFamilies = queueFamilies;
+			auto image = std::make_unique<Image>();
+			image->init(*device, imageInfo);
+			image->setName("Streamed texture ", i);
+			if (!recordUploads(commandBuffer, texture, image->getHandle(), target, target, texture.info.mipLevels)) {
+				continue;
+			}
+			texture.pendingImage = std::move(image);
+		}
+		if (target > texture.residentMip) {
+			stats.evictedMips += target - texture.residentMip;
+		} else {
+			stats.uploadedMips += texture.residentMip - target;
+		}
+		texture.pendingMip = target;
+		submitted.push_back(&texture);
+	}
+
+	if (commandBuffer) {
+		uint64_t serial = submit(commandBuffer, waits);
+		for (Texture* texture : submitted) {
+			texture->pendingSerial = serial;
+		}
+	}
+
+	stats.residentBytes = 0;
+	stats.pendingTextures = 0;
+	for (uint32_t i = 0; i < textureCount; i++) {
+		auto& texture = textures[i];
+		stats.residentBytes += getChainBytes(texture->info, texture->residentMip);
+		if (texture->pendingMip != texture->residentMip) {
+			stats.pendingTextures++;
+		}
+	}
+}
+
+VkImageView TextureStreamer::getView(TextureHandle texture)
+{
+	return sparse ? textures[texture]->sparseView : textures[texture]->image->getView();
+}
+
+float TextureStreamer::getMinLod(TextureHandle texture)
+{
+	return sparse ? static_cast<float>(textures[texture]->residentMip) : 0.0f;
+}
+
+uint32_t TextureStreamer::getResidentMip(TextureHandle texture)
+{
+	return textures[texture]->residentMip;
+}
+
+bool TextureStreamer::isSparse()
+{
+	return sparse;
+}
+
+StreamingStats TextureStreamer::getStats()
+{
+	return stats;
+}
+
+bool TextureStreamer::findStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+	VkDeviceSize capacity = stagingBuffer.getSize();
+	VkDeviceSize head = stagingAllocations.empty() ? 0 : stagingHead;
+
+	// Allocations are handed out in a ring, the oldest live allocation marks where free space ends
+	VkDeviceSize aligned = alignUp(head, alignment);
+	VkDeviceSize tail = stagingAllocations.empty() ? capacity : stagingAllocations.front().offset;
+	bool wrapped = !stagingAllocations.empty() && head <= tail;
+	if (wrapped) {
+		if (aligned + size > tail) {
+			return false;
+		}
+	} else if (aligned + size > capacity) {
+		// Not enough room at the end, start again from the front
+		aligned = 0;
+		if (size > (stagingAllocations.empty() ? capacity : tail)) {
+			return false;
+		}
+	}
+
+	offset = aligned;
+	return true;
+}
+
+void* TextureStreamer::allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+	if (!findStaging(size, alignment, offset)) {
+		return nullptr;
+	}
+
+	stagingHead = offset + size;
+	stagingAllocations.push_back({offset, size, PENDING_SERIAL});
+	return static_cast<char*>(stagingBuffer.getMapped()) + offset;
+}
+
+void TextureStreamer::releaseStaging()
+{
+	while (!stagingAllocations.empty()
+		&& stagingAllocations.front().serial != PENDING_SERIAL
+		&& scheduler->isComplete(transferQueue, stagingAllocations.front().serial)) {
+		stagingAllocations.pop_front();
+	}
+}
+
+VkCommandBuffer TextureStreamer::beginCommandBuffer()
+{
+	VkCommandBuffer commandBuffer = nullptr;
+	for (auto it = commandBuffers.begin(); it != commandBuffers.end(); it++) {
+		if (scheduler->isComplete(transferQueue, it->first)) {
+			commandBuffer = it->second;
+			commandBuffers.erase(it);
+			break;
+		}
+	}
+
+	if (commandBuffer) {
+		VkResult result = dispatch->vkResetCommandBuffer(commandBuffer, 0); VK_CHECK(result);
+	} else {
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+		VkResult result = dispatch->vkAllocateCommandBuffers(deviceHandle, &allocateInfo, &commandBuffer); VK_CHECK(result);
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VkResult result = dispatch->vkBeginCommandBuffer(commandBuffer, &beginInfo); VK_CHECK(result);
+	// Closed by submit
+	beginCommandLabel(*dispatch, commandBuffer, "Texture uploads");
+	return commandBuffer;
+}
+
+uint64_t TextureStreamer::submit(VkCommandBuffer commandBuffer, std::vector<VkSemaphore> waitSemaphores)
+{
+	endCommandLabel(*dispatch, commandBuffer);
+	VkResult result = dispatch->vkEndCommandBuffer(commandBuffer); VK_CHECK(result);
+
+	SubmitBatch batch{};
+	batch.commandBuffers = {commandBuffer};
+	batch.label = "Texture uploads";
+	batch.waitStages.assign(waitSemaphores.size(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+	batch.waitSemaphores = std::move(waitSemaphores);
+	scheduler->enqueue(transferQueue, std::move(batch));
+	uint64_t serial = scheduler->flush(transferQueue);
+
+	for (StagingAllocation& allocation : stagingAllocations) {
+		if (allocation.serial == PENDING_SERIAL) {
+			allocation.serial = serial;
+		}
+	}
+	commandBuffers.emplace_back(serial, commandBuffer);
+	return serial;
+}
+
+VkExtent2D TextureStreamer::getMipExtent(const StreamedTextureInfo& info, uint32_t mip)
+{
+	return {std::max(info.extent.width >> mip, 1u), std::max(info.extent.height >> mip, 1u)};
+}
+
+VkDeviceSize TextureStreamer::getMipBytes(const StreamedTextureInfo& info, uint32_t mip)
+{
+	VkExtent2D extent = getMipExtent(info, mip);
+	return static_cast<VkDeviceSize>(extent.width) * extent.height * info.texelSize;
+}
+
+VkDeviceSize TextureStreamer::getChainBytes(const StreamedTextureInfo& info, uint32_t mip)
+{
+	VkDeviceSize bytes = 0;
+	for (; mip < info.mipLevels; mip++) {
+		bytes += getMipBytes(info, mip);
+	}
+	return bytes;
+}
+
+VkDeviceSize TextureStreamer::getStagingAlignment(const StreamedTextureInfo& info)
+{
+	// Buffer offsets have to be multiples of the texel size and of 4
+	VkDeviceSize texelSize = info.texelSize;
+	return texelSize * 4 / std::gcd(texelSize, VkDeviceSize{4});
+}
+
+VkDeviceSize TextureStreamer::getUploadBytes(const StreamedTextureInfo& info, uint32_t firstMip, uint32_t lastMip)
+{
+	VkDeviceSize alignment = getStagingAlignment(info);
+	VkDeviceSize size = 0;
+	for (uint32_t mip = firstMip; mip < lastMip; mip++) {
+		size = alignUp(size, alignment) + getMipBytes(info, mip);
+	}
+	return size;
+}
+
+void TextureStreamer::pickTargets(std::vector<uint32_t>& targets)
+{
+	targets.resize(textureCount);
+	VkDeviceSize total = 0;
+	for (uint32_t i = 0; i < textureCount; i++) {
+		// Textures with an upload in flight keep their target and are counted at their larger size
+		const Texture& texture = *textures[i];
+		bool busy = texture.pendingMip != texture.residentMip;
+		targets[i] = busy ? texture.pendingMip : texture.wantedMip;
+		total += getChainBytes(texture.info, busy ? std::min(texture.residentMip, texture.pendingMip) : targets[i]);
+	}
+	if (total <= budget) {
+		return;
+	}
+
+	// Over budget: drop detail from the least recently requested textures first
+	std::vector<uint32_t> order(textureCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+		return textures[a]->lastRequestFrame < textures[b]->lastRequestFrame;
+	});
+	for (uint32_t i : order) {
+		Texture& texture = *textures[i];
+		if (texture.pendingMip != texture.residentMip) {
+			continue;
+		}
+		while (total > budget && targets[i] < texture.tailMip) {
+			total -= getMipBytes(texture.info, targets[i]);
+			targets[i]++;
+		}
+		if (total <= budget) {
+			break;
+		}
+	}
+}
+
+bool TextureStreamer::recordUploads(VkCommandBuffer commandBuffer, Texture& texture, VkImage image, uint32_t baseMip,
+	uint32_t firstMip, uint32_t lastMip)
+{
+	if (firstMip >= lastMip) {
+		return true;
+	}
+
+	// One allocation for every mip, so nothing is recorded if it doesn't fit
+	VkDeviceSize alignment = getStagingAlignment(texture.info);
+	VkDeviceSize offset = 0;
+	char* staging = static_cast<char*>(allocateStaging(getUploadBytes(texture.info, firstMip, lastMip), alignment, offset));
+	if (!staging) {
+		return false;
+	}
+
+	std::vector<VkBufferImageCopy> copies{};
+	VkDeviceSize mipOffset = 0;
+	for (uint32_t mip = firstMip; mip < lastMip; mip++) {
+		mipOffset = alignUp(mipOffset, alignment);
+		texture.info.source->readMip(mip, staging + mipOffset);
+
+		VkExtent2D extent = getMipExtent(texture.info, mip);
+		VkBufferImageCopy copy{};
+		copy.bufferOffset = offset + mipOffset;
+		copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copy.imageSubresource.mipLevel = mip - baseMip;
+		copy.imageSubresource.baseArrayLayer = 0;
+		copy.imageSubresource.layerCount = 1;
+		copy.imageExtent = {extent.width, extent.height, 1};
+		copies.push_back(copy);
+		mipOffset += getMipBytes(texture.info, mip);
+	}
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = firstMip - baseMip;
+	barrier.subresourceRange.levelCount = lastMip - firstMip;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	dispatch->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	dispatch->vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.getHandle(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(copies.size()), copies.data());
+
+	// A transfer queue can't name shader stages, the graphics queue only samples the mips
+	// once the upload's fence was seen signaled
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	dispatch->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+	return true;
+}
+
+void TextureStreamer::createSparseImage(Texture& texture)
+{
+	VkImageCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	createInfo.flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+	createInfo.imageType = VK_IMAGE_TYPE_2D;
+	createInfo.format = texture.info.format;
+	createInfo.extent = {texture.info.extent.width, texture.info.extent.height, 1};
+	createInfo.mipLevels = texture.info.mipLevels;
+	createInfo.arrayLayers = 1;
+	createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	createInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (queueFamilies.size() > 1) {
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		createInfo.pQueueFamilyIndices = queueFamilies.data();
+	} else {
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
+	VkResult result = dispatch->vkCreateImage(deviceHandle, &createInfo, allocator, &texture.sparseImage); VK_CHECK(result);
+
+	// For sparse images the alignment is the size of one memory page
+	VkMemoryRequirements requirements;
+	dispatch->vkGetImageMemoryRequirements(deviceHandle, texture.sparseImage, &requirements);
+	texture.pageSize = requirements.alignment;
+	texture.memoryType = device->findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	uint32_t count = 0;
+	dispatch->vkGetImageSparseMemoryRequirements(deviceHandle, texture.sparseImage, &count, nullptr);
+	std::vector<VkSparseImageMemoryRequirements> sparseRequirements(count);
+	dispatch->vkGetImageSparseMemoryRequirements(deviceHandle, texture.sparseImage, &count, sparseRequirements.data());
+	const VkSparseImageMemoryRequirements* colorRequirements = nullptr;
+	for (const auto& sparseRequirement : sparseRequirements) {
+		if (sparseRequirement.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) {
+			colorRequirements = &sparseRequirement;
+		}
+	}
+	if (!colorRequirements) {
+		VK_CHECK(VK_ERROR_FORMAT_NOT_SUPPORTED);
+	}
+	texture.granularity = colorRequirements->formatProperties.imageGranularity;
+	texture.sparseTailMip = std::min(colorRequirements->imageMipTailFirstLod, texture.info.mipLevels);
+	texture.tailMip = std::min(texture.tailMip, texture.sparseTailMip);
+	texture.mipMemory.assign(texture.info.mipLevels, nullptr);
+
+	// The mip tail can only be bound as a whole, it stays bound for the image's lifetime
+	if (texture.sparseTailMip < texture.info.mipLevels) {
+		VkMemoryAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = colorRequirements->imageMipTailSize;
+		allocateInfo.memoryTypeIndex = texture.memoryType;
+		result = dispatch->vkAllocateMemory(deviceHandle, &allocateInfo, allocator, &texture.tailMemory); VK_CHECK(result);
+
+		VkSparseMemoryBind tailBind{};
+		tailBind.resourceOffset = colorRequirements->imageMipTailOffset;
+		tailBind.size = colorRequirements->imageMipTailSize;
+		tailBind.memory = texture.tailMemory;
+		VkSparseImageOpaqueMemoryBindInfo opaqueBind{};
+		opaqueBind.image = texture.sparseImage;
+		opaqueBind.bindCount = 1;
+		opaqueBind.pBinds = &tailBind;
+
+		VkBindSparseInfo bindInfo{};
+		bindInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+		bindInfo.imageOpaqueBindCount = 1;
+		bindInfo.pImageOpaqueBinds = &opaqueBind;
+		auto lock = scheduler->lockQueue(sparseQueue);
+		result = dispatch->vkQueueBindSparse(sparseQueue, 1, &bindInfo, nullptr); VK_CHECK(result);
+	}
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = texture.sparseImage;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = texture.info.format;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = texture.info.mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+	result = dispatch->vkCreateImageView(deviceHandle, &viewInfo, allocator, &texture.sparseView); VK_CHECK(result);
+}
+
+void TextureStreamer::bindSparseMips(Texture& texture, uint32_t firstMip, uint32_t lastMip, bool bind, VkSemaphore signal)
+{
+	std::vector<VkSparseImageMemoryBind> binds{};
+	std::vector<VkDeviceMemory> freed{};
+	lastMip = std::min(lastMip, texture.sparseTailMip);
+	for (uint32_t mip = firstMip; mip < lastMip; mip++) {
+		if (bind == (texture.mipMemory[mip] != nullptr)) {
+			continue;
+		}
+
+		VkExtent2D extent = getMipExtent(texture.info, mip);
+		if (bind) {
+			VkDeviceSize pagesX = (extent.width + texture.granularity.width - 1) / texture.granularity.width;
+			VkDeviceSize pagesY = (extent.height + texture.granularity.height - 1) / texture.granularity.height;
+			VkMemoryAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocateInfo.allocationSize = pagesX * pagesY * texture.pageSize;
+			allocateInfo.memoryTypeIndex = texture.memoryType;
+			VkResult result = dispatch->vkAllocateMemory(deviceHandle, &allocateInfo, allocator, &texture.mipMemory[mip]); VK_CHECK(result);
+		} else {
+			freed.push_back(texture.mipMemory[mip]);
+			texture.mipMemory[mip] = nullptr;
+		}
+
+		// Covering the whole mip is allowed even when its size isn't a multiple of the granularity
+		VkSparseImageMemoryBind mipBind{};
+		mipBind.subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		mipBind.subresource.mipLevel = mip;
+		mipBind.subresource.arrayLayer = 0;
+		mipBind.offset = {0, 0, 0};
+		mipBind.extent = {extent.width, extent.height, 1};
+		mipBind.memory = texture.mipMemory[mip];
+		mipBind.memoryOffset = 0;
+		binds.push_back(mipBind);
+	}
+	if (binds.empty() && !signal) {
+		return;
+	}
+
+	VkSparseImageMemoryBindInfo imageBind{};
+	imageBind.image = texture.sparseImage;
+	imageBind.bindCount = static_cast<uint32_t>(binds.size());
+	imageBind.pBinds = binds.data();
+
+	VkBindSparseInfo bindInfo{};
+	bindInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+	bindInfo.imageBindCount = binds.empty() ? 0 : 1;
+	bindInfo.pImageBinds = &imageBind;
+	bindInfo.signalSemaphoreCount = signal ? 1 : 0;
+	bindInfo.pSignalSemaphores = &signal;
+
+	VkFence fence = nullptr;
+	if (!freed.empty()) {
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkResult result = dispatch->vkCreateFence(deviceHandle, &fenceInfo, allocator, &fence); VK_CHECK(result);
+	}
+	{
+		auto lock = scheduler->lockQueue(sparseQueue);
+		VkResult result = dispatch->vkQueueBindSparse(sparseQueue, 1, &bindInfo, fence); VK_CHECK(result);
+	}
+
+	// Unbinding only takes a page table update, so waiting for it before freeing is cheap
+	if (fence) {
+		VkResult result = dispatch->vkWaitForFences(deviceHandle, 1, &fence, VK_TRUE, UINT64_MAX); VK_CHECK(result);
+		dispatch->vkDestroyFence(deviceHandle, fence, allocator);
+		for (VkDeviceMemory memory : freed) {
+			dispatch->vkFreeMemory(deviceHandle, memory, allocator);
+		}
+	}
+}
+
+void TextureStreamer::destroyTexture(Texture& texture)
+{
+	texture.pendingImage.reset();
+	texture.image.reset();
+	if (texture.sparseImage) {
+		dispatch->vkDestroyImageView(deviceHandle, texture.sparseView, allocator);
+		dispatch->vkDestroyImage(deviceHandle, texture.sparseImage, allocator);
+		for (VkDeviceMemory memory : texture.mipMemory) {
+			dispatch->vkFreeMemory(deviceHandle, memory, allocator);
+		}
+		dispatch->vkFreeMemory(deviceHandle, texture.tailMemory, allocator);
+		texture.sparseView = nullptr;
+		texture.sparseImage = nullptr;
+		texture.tailMemory = nullptr;
+		texture.mipMemory.clear();
+	}
+	dispatch->vkDestroySemaphore(deviceHandle, texture.bindSemaphore, allocator);
+	texture.bindSemaphore = nullptr;
+}
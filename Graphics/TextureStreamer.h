@@ -0,0 +1,285 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "LogicalDevice.h"
+#include "SubmissionScheduler.h"
+#include "Buffer.h"
+#include "Image.h"
+
+// Supplies the texels of a streamed texture
+class TextureSource
+{
+public:
+	virtual ~TextureSource() = default;
+
+	/**
+	 * @brief Copies the tightly packed texels of one mip level to destination.
+	 * Called from TextureStreamer::addTexture and TextureStreamer::update.
+	 */
+	virtual void readMip(uint32_t mip, void* destination) = 0;
+};
+
+struct StreamedTextureInfo
+{
+	// Size of mip 0
+	VkExtent2D extent;
+	// Uncompressed color format
+	VkFormat format;
+	// Bytes per texel of the format
+	uint32_t texelSize;
+	uint32_t mipLevels;
+	// Must outlive the texture
+	TextureSource* source;
+};
+
+struct StreamingSettings
+{
+	// Bytes of texture memory the streamer may use. 0 uses budgetFraction of the device local heaps
+	VkDeviceSize budget = 0;
+	float budgetFraction = 0.5f;
+	// Mips whose sides are both at or below this size are loaded when a texture is added and never evicted
+	uint32_t residentTailSize = 64;
+	// Host memory uploads go through. An upload that doesn't fit in the free part starts with the coarser mips
+	// that do and the rest follows in later updates. Mips whose upload can never fit aren't streamed in,
+	// such as mip 0 of a 4096x4096 RGBA8 texture with the default size.
+	VkDeviceSize stagingSize = 32 * 1024 * 1024;
+	// Most textures that can be added, also the capacity of the GPU feedback buffer
+	uint32_t maxTextures = 4096;
+	// Frames a replaced image or evicted mip is kept for, so frames still in flight can finish with it
+	uint32_t framesInFlight = 2;
+	// Use sparse residency when LogicalDevice supports it instead of recreating images
+	bool useSparse = true;
+};
+
+struct StreamingStats
+{
+	VkDeviceSize residentBytes;
+	VkDeviceSize budget;
+	uint32_t pendingTextures;
+	uint32_t uploadedMips;
+	uint32_t evictedMips;
+};
+
+using TextureHandle = uint32_t;
+
+class TextureStreamer
+{
+public:
+	/**
+	 * @brief Default Constructor: Doesn't create any resources, must call init
+	 */
+	TextureStreamer();
+
+	/**
+	 * @brief Creates the staging and feedback buffers. Uploads are submitted to the device's transfer queue.
+	 *
+	 * @param device - the logical device textures are created under
+	 * @param scheduler - used to submit uploads and track their completion
+	 * @param settings - budget and streaming behaviour
+	 */
+	void init(LogicalDevice& device, SubmissionScheduler& scheduler, const StreamingSettings& settings = {});
+
+	/**
+	 * @brief Destructor: Calls cleanup() to free up memory
+	 */
+	~TextureStreamer();
+
+	/**
+	 * @brief Waits for uploads to finish and destroys every texture
+	 */
+	void cleanup();
+
+	/**
+	 * @brief Creates a texture with only its low resolution mip tail loaded.
+	 * The tail is uploaded and waited on before returning. Throws an error once maxTextures textures were added.
+	 *
+	 * @return handle used by the other functions, also the texture's index in the feedback buffer
+	 */
+	TextureHandle addTexture(const StreamedTextureInfo& info);
+
+	/**
+	 * @brief Asks for a mip level to be resident, such as from CPU side distance estimates.
+	 * The most detailed level requested between two updates is used, at most the most detailed level whose upload
+	 * fits in StreamingSettings::stagingSize. Safe to call from any thread,
+	 * also while addTexture runs, with a handle addTexture returned before.
+	 */
+	void requestMip(TextureHandle texture, uint32_t mip);
+
+	/**
+	 * @brief Returns a storage buffer with one uint per texture. Shaders atomicMin the mip level
+	 * they wanted to sample into their texture's element.
+	 */
+	VkBuffer getFeedbackBuffer();
+
+	/**
+	 * @brief Records a fill that resets the feedback buffer, must come before the shaders writing feedback.
+	 */
+	void recordFeedbackReset(VkCommandBuffer commandBuffer);
+
+	/**
+	 * @brief Records a barrier that makes the feedback visible to the host, must come after the shaders writing it
+	 * and outside of a render pass.
+	 */
+	void recordFeedbackReadback(VkCommandBuffer commandBuffer);
+
+	/**
+	 * @brief Turns the feedback buffer into mip requests. Call after the frame that wrote it finished on the GPU,
+	 * with recordFeedbackReadback recorded after its shaders.
+	 */
+	void readFeedback();
+
+	/**
+	 * @brief Finishes completed uploads, evicts mips to stay under the budget and starts new uploads.
+	 * Call once per frame.
+	 */
+	void update();
+
+	/**
+	 * @brief Returns the view to sample the texture through. The view changes when mips are streamed
+	 * in or out unless sparse residency is used.
+	 */
+	VkImageView getView(TextureHandle texture);
+
+	/**
+	 * @brief Returns the most detailed mip that can be sampled, shaders must clamp their lod to it.
+	 * Relative to the view, which only starts at this mip when sparse residency isn't used.
+	 */
+	float getMinLod(TextureHandle texture);
+
+	/**
+	 * @brief Returns the most detailed mip level that is resident
+	 */
+	uint32_t getResidentMip(TextureHandle texture);
+
+	/**
+	 * @brief Returns whether textures use sparse residency
+	 */
+	bool isSparse();
+
+	/**
+	 * @brief Returns memory use and the work done by the last update
+	 */
+	StreamingStats getStats();
+
+private:
+	static constexpr uint32_t NO_REQUEST = UINT32_MAX;
+
+	struct Texture
+	{
+		StreamedTextureInfo info;
+		// Mips from tailMip on are always resident
+		uint32_t tailMip;
+		// Most detailed resident mip, shaders may sample it
+		uint32_t residentMip;
+		// Most detailed mip once the pending upload finishes, residentMip if nothing is pending
+		uint32_t pendingMip;
+		uint64_t pendingSerial;
+		// Most detailed mip wanted, from the requests
+		uint32_t wantedMip;
+		// Most detailed mip whose upload fits in the staging buffer, requests are clamped to it
+		uint32_t stagingMip;
+		std::atomic<uint32_t> requestedMip;
+		uint64_t lastRequestFrame;
+
+		// Used without sparse residency. The image holds mips residentMip to mipLevels - 1
+		std::unique_ptr<Image> image, pendingImage;
+
+		// Used with sparse residency. The image holds every mip, memory is bound per mip below the tail
+		VkImage sparseImage;
+		VkImageView sparseView;
+		VkDeviceMemory tailMemory;
+		std::vector<VkDeviceMemory> mipMemory;
+		VkSemaphore bindSemaphore;
+		// First mip of the sparse mip tail, which is bound as a whole
+		uint32_t sparseTailMip;
+		VkExtent3D granularity;
+		VkDeviceSize pageSize;
+		uint32_t memoryType;
+	};
+
+	// A staging range that is reused once its upload finished
+	struct StagingAllocation
+	{
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		uint64_t serial;
+	};
+
+	// Replaced images and evicted sparse mips stay alive until frames in flight are done with them
+	struct Retired
+	{
+		uint64_t frame;
+		std::unique_ptr<Image> image;
+		// Texture whose evicted sparse mips get unbound, used when image is empty
+		TextureHandle texture;
+	};
+
+	LogicalDevice* device;
+	SubmissionScheduler* scheduler;
+	StreamingSettings settings;
+	VkDevice deviceHandle;
+	const VkAllocationCallbacks* allocator;
+	const DeviceDispatch* dispatch;
+	VkQueue transferQueue;
+	VkQueue sparseQueue;
+	std::vector<uint32_t> queueFamilies;
+	bool sparse;
+	VkDeviceSize budget;
+	uint64_t frame;
+	StreamingStats stats;
+
+	// Sized to maxTextures by init and never resized, so requestMip can index it while addTexture fills the next slot
+	std::vector<std::unique_ptr<Texture>> textures;
+	uint32_t textureCount;
+	std::deque<Retired> retired;
+
+	Buffer stagingBuffer, feedbackBuffer;
+	std::deque<StagingAllocation> stagingAllocations;
+	VkDeviceSize stagingHead;
+
+	VkCommandPool commandPool;
+	std::vector<std::pair<uint64_t, VkCommandBuffer>> commandBuffers;
+
+	// Returns false if there isn't enough free staging memory right now, otherwise where allocateStaging would put it
+	bool findStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	// Returns nullptr if there isn't enough free staging memory right now.
+	// The allocation is released once the next submitted upload finishes.
+	void* allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	void releaseStaging();
+
+	VkCommandBuffer beginCommandBuffer();
+
+	static VkExtent2D getMipExtent(const StreamedTextureInfo& info, uint32_t mip);
+	static VkDeviceSize getMipBytes(const StreamedTextureInfo& info, uint32_t mip);
+	// Bytes used by mips from the specified mip to the last one
+	static VkDeviceSize getChainBytes(const StreamedTextureInfo& info, uint32_t mip);
+	// Alignment of every mip in the staging buffer
+	static VkDeviceSize getStagingAlignment(const StreamedTextureInfo& info);
+	// Staging bytes recordUploads needs for mips [firstMip, lastMip)
+	static VkDeviceSize getUploadBytes(const StreamedTextureInfo& info, uint32_t firstMip, uint32_t lastMip);
+
+	// Picks the mip every texture should have while staying under the budget
+	void pickTargets(std::vector<uint32_t>& targets);
+
+	// Records uploads of mips [firstMip, lastMip) of a texture into an image whose mip 0 is baseMip.
+	// Returns false without recording anything if they don't fit in the free staging memory.
+	bool recordUploads(VkCommandBuffer commandBuffer, Texture& texture, VkImage image, uint32_t baseMip,
+		uint32_t firstMip, uint32_t lastMip);
+
+	// Submits a command buffer from beginCommandBuffer to the transfer queue and tags
+	// the staging allocations made since the last submit with its serial
+	uint64_t submit(VkCommandBuffer commandBuffer, std::vector<VkSemaphore> waitSemaphores);
+
+	void createSparseImage(Texture& texture);
+	// Binds memory to or unbinds memory from mips [firstMip, lastMip) below the sparse mip tail.
+	// Binding signals the semaphore, unbinding waits for the unbind and frees the memory.
+	void bindSparseMips(Texture& texture, uint32_t firstMip, uint32_t lastMip, bool bind, VkSemaphore signal);
+	void destroyTexture(Texture& texture);
+};
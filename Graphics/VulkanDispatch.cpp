@@ -0,0 +1,16 @@
+#include "VulkanDispatch.h"
+
+void InstanceDispatch::load(VkInstance instance, uint32_t _apiVersion)
+{
+	apiVersion = _apiVersion;
+#define VULKAN_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+	VULKAN_INSTANCE_FUNCTIONS(VULKAN_LOAD_FUNCTION)
+#undef VULKAN_LOAD_FUNCTION
+}
+
+void DeviceDispatch::load(const InstanceDispatch& instance, VkDevice device)
+{
+#define VULKAN_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(instance.vkGetDeviceProcAddr(device, #name));
+	VULKAN_DEVICE_FUNCTIONS(VULKAN_LOAD_FUNCTION)
+#undef VULKAN_LOAD_FUNCTION
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+// Functions loaded from the instance, called on the instance or a physical device.
+// Functions of extensions that weren't enabled stay nullptr.
+#define VULKAN_INSTANCE_FUNCTIONS(X) \
+	X(vkDestroyInstance) \
+	X(vkEnumeratePhysicalDevices) \
+	X(vkGetPhysicalDeviceProperties) \
+	X(vkGetPhysicalDeviceProperties2) \
+	X(vkGetPhysicalDeviceFeatures) \
+	X(vkGetPhysicalDeviceFeatures2) \
+	X(vkGetPhysicalDeviceMemoryProperties) \
+	X(vkGetPhysicalDeviceFormatProperties) \
+	X(vkGetPhysicalDeviceQueueFamilyProperties) \
+	X(vkEnumerateDeviceExtensionProperties) \
+	X(vkCreateDevice) \
+	X(vkGetDeviceProcAddr) \
+	X(vkDestroySurfaceKHR) \
+	X(vkGetPhysicalDeviceSurfaceSupportKHR) \
+	X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+	X(vkGetPhysicalDeviceSurfaceFormatsKHR) \
+	X(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+	X(vkCreateHeadlessSurfaceEXT) \
+	X(vkCreateDebugUtilsMessengerEXT) \
+	X(vkDestroyDebugUtilsMessengerEXT)
+
+// Functions loaded from a device, called on the device or its queues and command buffers.
+// Functions of extensions that weren't enabled stay nullptr.
+#define VULKAN_DEVICE_FUNCTIONS(X) \
+	X(vkDestroyDevice) \
+	X(vkGetDeviceQueue) \
+	X(vkDeviceWaitIdle) \
+	X(vkQueueSubmit) \
+	X(vkQueueBindSparse) \
+	X(vkCreateBuffer) \
+	X(vkDestroyBuffer) \
+	X(vkGetBufferMemoryRequirements) \
+	X(vkBindBufferMemory) \
+	X(vkAllocateMemory) \
+	X(vkFreeMemory) \
+	X(vkMapMemory) \
+	X(vkGetDeviceMemoryCommitment) \
+	X(vkCreateImage) \
+	X(vkDestroyImage) \
+	X(vkGetImageMemoryRequirements) \
+	X(vkGetImageSparseMemoryRequirements) \
+	X(vkBindImageMemory) \
+	X(vkCreateImageView) \
+	X(vkDestroyImageView) \
+	X(vkCreateSampler) \
+	X(vkDestroySampler) \
+	X(vkCreateShaderModule) \
+	X(vkDestroyShaderModule) \
+	X(vkCreatePipelineLayout) \
+	X(vkDestroyPipelineLayout) \
+	X(vkCreateGraphicsPipelines) \
+	X(vkCreateComputePipelines) \
+	X(vkDestroyPipeline) \
+	X(vkCreateRenderPass) \
+	X(vkDestroyRenderPass) \
+	X(vkCreateFramebuffer) \
+	X(vkDestroyFramebuffer) \
+	X(vkCreateDescriptorSetLayout) \
+	X(vkDestroyDescriptorSetLayout) \
+	X(vkCreateDescriptorPool) \
+	X(vkDestroyDescriptorPool) \
+	X(vkResetDescriptorPool) \
+	X(vkAllocateDescriptorSets) \
+	X(vkUpdateDescriptorSets) \
+	X(vkCreateQueryPool) \
+	X(vkDestroyQueryPool) \
+	X(vkGetQueryPoolResults) \
+	X(vkCreateFence) \
+	X(vkDestroyFence) \
+	X(vkResetFences) \
+	X(vkGetFenceStatus) \
+	X(vkWaitForFences) \
+	X(vkCreateSemaphore) \
+	X(vkDestroySemaphore) \
+	X(vkCreateCommandPool) \
+	X(vkDestroyCommandPool) \
+	X(vkAllocateCommandBuffers) \
+	X(vkBeginCommandBuffer) \
+	X(vkEndCommandBuffer) \
+	X(vkResetCommandBuffer) \
+	X(vkCmdPipelineBarrier) \
+	X(vkCmdBindPipeline) \
+	X(vkCmdBindDescriptorSets) \
+	X(vkCmdPushConstants) \
+	X(vkCmdBeginRenderPass) \
+	X(vkCmdNextSubpass) \
+	X(vkCmdEndRenderPass) \
+	X(vkCmdSetViewport) \
+	X(vkCmdSetScissor) \
+	X(vkCmdBindVertexBuffers) \
+	X(vkCmdBindIndexBuffer) \
+	X(vkCmdDrawIndexed) \
+	X(vkCmdDrawIndexedIndirect) \
+	X(vkCmdDispatch) \
+	X(vkCmdDispatchIndirect) \
+	X(vkCmdCopyBuffer) \
+	X(vkCmdCopyBufferToImage) \
+	X(vkCmdBlitImage) \
+	X(vkCmdFillBuffer) \
+	X(vkCmdUpdateBuffer) \
+	X(vkCmdResetQueryPool) \
+	X(vkCmdWriteTimestamp) \
+	X(vkCmdWriteBufferMarkerAMD) \
+	X(vkGetDeviceFaultInfoEXT) \
+	X(vkCreateSwapchainKHR) \
+	X(vkDestroySwapchainKHR) \
+	X(vkGetSwapchainImagesKHR) \
+	X(vkAcquireNextImageKHR) \
+	X(vkQueuePresentKHR) \
+	X(vkCmdDrawIndexedIndirectCountKHR) \
+	X(vkCmdDrawMeshTasksEXT) \
+	X(vkSetDebugUtilsObjectNameEXT) \
+	X(vkCmdBeginDebugUtilsLabelEXT) \
+	X(vkCmdEndDebugUtilsLabelEXT) \
+	X(vkCmdInsertDebugUtilsLabelEXT)
+
+#define VULKAN_DECLARE_FUNCTION(name) PFN_##name name = nullptr;
+
+// Instance function pointers, filled once by VulkanInstance::init so calls skip the loader's trampoline.
+// Members are named after the functions they point to, such as dispatch.vkEnumeratePhysicalDevices(...).
+struct InstanceDispatch
+{
+	VULKAN_INSTANCE_FUNCTIONS(VULKAN_DECLARE_FUNCTION)
+
+	// Version the instance was created with, core functions of later versions must not be called
+	uint32_t apiVersion;
+
+	/**
+	 * @brief Loads every function through vkGetInstanceProcAddr
+	 *
+	 * @param instance - the created instance, its enabled extensions decide which extension functions are found
+	 * @param _apiVersion - the apiVersion the instance was created with
+	 */
+	void load(VkInstance instance, uint32_t _apiVersion);
+};
+
+// Device function pointers, filled once by LogicalDevice::init through vkGetDeviceProcAddr.
+// They go straight to the driver, skipping the loader's lookup of the device's dispatch on every call.
+struct DeviceDispatch
+{
+	VULKAN_DEVICE_FUNCTIONS(VULKAN_DECLARE_FUNCTION)
+
+	/**
+	 * @brief Loads every function through the instance's vkGetDeviceProcAddr
+	 *
+	 * @param instance - functions of the instance the device was created under
+	 * @param device - the created device, its enabled extensions decide which extension functions are found
+	 */
+	void load(const InstanceDispatch& instance, VkDevice device);
+};
+
+#undef VULKAN_DECLARE_FUNCTION
@@ -1,16 +1,26 @@
 #include "VulkanInstance.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include "DebugMessenger.h"
+#include "FrameArena.h"
+#include "Profiler.h"
 
 VulkanInstance::VulkanInstance() :
-	handle(nullptr)
+	handle(nullptr),
+	allocator(nullptr),
+	dispatch{},
+	headless(false)
 {
 }
 
-void VulkanInstance::init(const char* appName)
+void VulkanInstance::init(const char* appName, const VkAllocationCallbacks* _allocator, bool _headless)
 {
+	PROFILE_ZONE();
+	allocator = _allocator;
+	headless = _headless;
+
 	// Specify the application info
 	VkApplicationInfo appInfo{};
 	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -18,7 +28,15 @@ void VulkanInstance::init(const char* appName)
 	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	appInfo.pEngineName = "Apparatus Engine";
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	appInfo.apiVersion = VK_API_VERSION_1_0;
+	// Devices stay usable at 1.0, 1.2 is only needed by optional features such as mesh shaders.
+	// A 1.0 loader fails instance creation with any later version, and doesn't export vkEnumerateInstanceVersion
+	uint32_t instanceVersion = VK_API_VERSION_1_0;
+	auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+		vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+	if (enumerateInstanceVersion != nullptr) {
+		VkResult result = enumerateInstanceVersion(&instanceVersion); VK_CHECK(result);
+	}
+	appInfo.apiVersion = std::min(instanceVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
 
 	// Instance Create Info construction
 	VkInstanceCreateInfo createInfo{};
@@ -26,25 +44,35 @@ void VulkanInstance::init(const char* appName)
 	createInfo.pApplicationInfo = &appInfo;
 
 	// TODO make debugging optional
-	auto layers = getValidationLayers();
-	if (!isValidationLayersSupported(layers)) {
-		VK_CHECK(VK_ERROR_LAYER_NOT_PRESENT);
-	}
-	createInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
-	createInfo.ppEnabledLayerNames = layers.data();
-	// Allows for debugging for the creation of the instance
+	std::vector<const char*> layers{};
 	auto debugMessengerCreateInfo = DebugMessenger::getCreateInfo();
-	createInfo.pNext = &debugMessengerCreateInfo;
+	if (!headless) {
+		layers = getValidationLayers();
+		if (!isValidationLayersSupported(layers)) {
+			VK_CHECK(VK_ERROR_LAYER_NOT_PRESENT);
+		}
+		createInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
+		createInfo.ppEnabledLayerNames = layers.data();
+		// Allows for debugging for the creation of the instance
+		createInfo.pNext = &debugMessengerCreateInfo;
+	}
 
 	// Get required extensions and stop program if they aren't supported
 	std::vector<const char*> extensions = getRequiredExtensions();
 	if (!isExtensionsSupported(extensions)) {
 		VK_CHECK(VK_ERROR_EXTENSION_NOT_PRESENT);
 	}
+#ifdef APPARATUS_DEBUG_NAMES
+	// Headless instances leave out validation but still name objects for captures of the benchmarks
+	if (headless && isExtensionsSupported({VK_EXT_DEBUG_UTILS_EXTENSION_NAME})) {
+		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
+#endif
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 	createInfo.ppEnabledExtensionNames = extensions.data();
 
-	VkResult result = vkCreateInstance(&createInfo, nullptr, &handle); VK_CHECK(result);
+	VkResult result = vkCreateInstance(&createInfo, allocator, &handle); VK_CHECK(result);
+	dispatch.load(handle, appInfo.apiVersion);
 }
 
 VulkanInstance::~VulkanInstance()
@@ -55,8 +83,9 @@ VulkanInstance::~VulkanInstance()
 void VulkanInstance::cleanup()
 {
 	if (handle) {
-		vkDestroyInstance(handle, nullptr);
+		dispatch.vkDestroyInstance(handle, allocator);
 		handle = nullptr;
+		dispatch = {};
 	}
 }
 
@@ -65,8 +94,27 @@ VkInstance VulkanInstance::getHandle()
 	return handle;
 }
 
+const VkAllocationCallbacks* VulkanInstance::getAllocator()
+{
+	return allocator;
+}
+
+const InstanceDispatch& VulkanInstance::getDispatch()
+{
+	return dispatch;
+}
+
+bool VulkanInstance::isHeadless()
+{
+	return headless;
+}
+
 std::vector<const char*> VulkanInstance::getRequiredExtensions()
 {
+	if (headless) {
+		return {VK_KHR_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME};
+	}
+
 	uint32_t glfwExtensionCount = 0;
 	const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
@@ -77,22 +125,23 @@ std::vector<const char*> VulkanInstance::getRequiredExtensions()
 	return extensions;
 }
 
-std::vector<VkExtensionProperties> VulkanInstance::getSupportedExtensions()
+std::pmr::vector<VkExtensionProperties> VulkanInstance::getSupportedExtensions(std::pmr::memory_resource* memory)
 {
 	uint32_t count = 0;
 	vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
-	std::vector<VkExtensionProperties> extensions(count);
+	std::pmr::vector<VkExtensionProperties> extensions(count, memory);
 	vkEnumerateInstanceExtensionProperties(nullptr, &count, extensions.data());
 	return extensions;
 }
 
-bool VulkanInstance::isExtensionsSupported(std::vector<const char*> extensions)
+bool VulkanInstance::isExtensionsSupported(const std::vector<const char*>& extensions)
 {
-	std::vector<VkExtensionProperties> supportedExtensions = getSupportedExtensions();
+	ScratchScope scratch;
+	std::pmr::vector<VkExtensionProperties> supportedExtensions = getSupportedExtensions(scratch.getResource());
 	// Searches through each of the extensions and returns false if it isn't contained in supportedExtensions
 	for (const char* extension : extensions) {
 		bool found = false;
-		for (VkExtensionProperties supportedExtension : supportedExtensions) {
+		for (const VkExtensionProperties& supportedExtension : supportedExtensions) {
 			if (std::strcmp(extension, supportedExtension.extensionName) == 0) {
 				found = true;
 			}
@@ -109,21 +158,22 @@ std::vector<const char*> VulkanInstance::getValidationLayers()
 	return {"VK_LAYER_KHRONOS_validation"};
 }
 
-std::vector<VkLayerProperties> VulkanInstance::getSupportedValidationLayers()
+std::pmr::vector<VkLayerProperties> VulkanInstance::getSupportedValidationLayers(std::pmr::memory_resource* memory)
 {
 	uint32_t count = 0;
 	vkEnumerateInstanceLayerProperties(&count, nullptr);
-	std::vector<VkLayerProperties> layers(count);
+	std::pmr::vector<VkLayerProperties> layers(count, memory);
 	vkEnumerateInstanceLayerProperties(&count, layers.data());
 	return layers;
 }
 
-bool VulkanInstance::isValidationLayersSupported(std::vector<const char*> layers)
+bool VulkanInstance::isValidationLayersSupported(const std::vector<const char*>& layers)
 {
-	auto supportedLayers = getSupportedValidationLayers();
+	ScratchScope scratch;
+	auto supportedLayers = getSupportedValidationLayers(scratch.getResource());
 	for (const char* layer : layers) {
 		bool found = false;
-		for (VkLayerProperties supportedLayer : supportedLayers) {
+		for (const VkLayerProperties& supportedLayer : supportedLayers) {
 			if (std::strcmp(layer, supportedLayer.layerName) == 0) {
 				found = true;
 			}
@@ -3,8 +3,11 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <memory_resource>
 #include <vector>
 
+#include "VulkanDispatch.h"
+
 class VulkanInstance
 {
 public:
@@ -19,8 +22,13 @@ public:
 	 * Throws an error if the extensions or validation layers aren't found or creation fails.
 	 * 
 	 * @param appName - specifies the application's name to use for initializing the instance
+	 * @param _allocator - host allocation callbacks used for the instance and every object created under it,
+	 * such as from HostAllocator. nullptr uses the driver's allocator.
+	 * @param _headless - runs without a window system, such as benchmarks on a machine without a display.
+	 * Enables VK_EXT_headless_surface instead of GLFW's extensions, glfwInit isn't needed,
+	 * and leaves out the validation layers so they don't skew timings.
 	 */
-	void init(const char* appName);
+	void init(const char* appName, const VkAllocationCallbacks* _allocator = nullptr, bool _headless = false);
 
 	/**
 	 * @brief Destructor: Calls cleanup() to free up memory
@@ -42,11 +50,30 @@ public:
 	 */
 	VkInstance getHandle();
 
+	/**
+	 * @brief Returns the allocation callbacks given to init
+	 */
+	const VkAllocationCallbacks* getAllocator();
+
+	/**
+	 * @brief Returns the instance functions loaded in init, use them instead of the loader's exports
+	 */
+	const InstanceDispatch& getDispatch();
+
+	/**
+	 * @brief Returns whether the instance was created headless, surfaces must then use Surface::initHeadless
+	 */
+	bool isHeadless();
+
 private:
 	VkInstance handle;
+	const VkAllocationCallbacks* allocator;
+	InstanceDispatch dispatch;
+	bool headless;
 
 	/**
-	 * @brief Returns the GLFW instance extensions and debug utils if needed
+	 * @brief Returns the GLFW instance extensions and debug utils if needed,
+	 * or the headless surface extensions when headless
 	 * 
 	 * The given extensions may or may not be supported, be sure to check.
 	 * 
@@ -57,12 +84,12 @@ private:
 	/**
 	 * @brief Returns all the supported instance extensions by the computer's hardware
 	 */
-	std::vector<VkExtensionProperties> getSupportedExtensions();
+	std::pmr::vector<VkExtensionProperties> getSupportedExtensions(std::pmr::memory_resource* memory);
 
 	/**
 	 * @brief Returns whether the provided extensions are supported by the computer's hardware
 	 */
-	bool isExtensionsSupported(std::vector<const char*> extensions);
+	bool isExtensionsSupported(const std::vector<const char*>& extensions);
 
 	/**
 	 * @brief Returns the standard validation layer
@@ -72,10 +99,10 @@ private:
 	/**
 	 * @brief Returns supported validation layers
 	 */
-	std::vector<VkLayerProperties> getSupportedValidationLayers();
+	std::pmr::vector<VkLayerProperties> getSupportedValidationLayers(std::pmr::memory_resource* memory);
 
 	/**
 	 * @brief Checks if the specified layers are supported
 	 */
-	bool isValidationLayersSupported(std::vector<const char*> layers);
+	bool isValidationLayersSupported(const std::vector<const char*>& layers);
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Matrix.h"
+
+// Six inward facing planes (xyz normal, w distance) in the order left, right, bottom, top, near, far.
+// A point p is inside a plane when dot(normal, p) + w >= 0.
+struct Frustum
+{
+	Vec4 planes[6];
+};
+
+/**
+ * @brief Extracts the normalized planes of a matrix that maps to vulkan clip space (depth from 0 to w)
+ */
+inline Frustum makeFrustum(const Mat4& viewProjection)
+{
+	Mat4 rows = transpose(viewProjection);
+	Frustum frustum{{
+		rows.columns[3] + rows.columns[0],
+		rows.columns[3] - rows.columns[0],
+		rows.columns[3] + rows.columns[1],
+		rows.columns[3] - rows.columns[1],
+		rows.columns[2],
+		rows.columns[3] - rows.columns[2]}};
+
+	for (Vec4& plane : frustum.planes) {
+		plane = plane * (1.0f / length(makeVec3(plane)));
+	}
+	return frustum;
+}
+
+inline bool isSphereVisible(const Frustum& frustum, Vec3 center, float radius)
+{
+	for (const Vec4& plane : frustum.planes) {
+		if (dot(makeVec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+inline bool isAABBVisible(const Frustum& frustum, Vec3 min, Vec3 max)
+{
+	for (const Vec4& plane : frustum.planes) {
+		// The corner farthest along the plane's normal
+		Vec3 corner{
+			plane.x > 0.0f ? max.x : min.x,
+			plane.y > 0.0f ? max.y : min.y,
+			plane.z > 0.0f ? max.z : min.z};
+		if (dot(makeVec3(plane), corner) + plane.w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
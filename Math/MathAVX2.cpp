@@ -0,0 +1,105 @@
+#include "MathKernels.h"
+
+#include <immintrin.h>
+
+namespace
+{
+	// out = a * b for column major matrices, two columns of the result per 256 bit register.
+	// Built without -mfma so multiplies and adds aren't fused and results match the scalar path.
+	inline void multiply(const float* a, const float* b, float* out)
+	{
+		__m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a));
+		__m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 4));
+		__m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 8));
+		__m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 12));
+
+		__m256 columns[2];
+		for (int c = 0; c < 2; c++) {
+			// Columns 2c and 2c + 1 of b, each element broadcast within its own half
+			__m256 bc = _mm256_loadu_ps(b + c * 8);
+			__m256 column = _mm256_mul_ps(a0, _mm256_permute_ps(bc, 0x00));
+			column = _mm256_add_ps(column, _mm256_mul_ps(a1, _mm256_permute_ps(bc, 0x55)));
+			column = _mm256_add_ps(column, _mm256_mul_ps(a2, _mm256_permute_ps(bc, 0xAA)));
+			column = _mm256_add_ps(column, _mm256_mul_ps(a3, _mm256_permute_ps(bc, 0xFF)));
+			columns[c] = column;
+		}
+		_mm256_storeu_ps(out, columns[0]);
+		_mm256_storeu_ps(out + 8, columns[1]);
+	}
+
+	void multiplyMatricesAVX2(const Mat4* a, const Mat4* b, Mat4* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			multiply(reinterpret_cast<const float*>(a + i), reinterpret_cast<const float*>(b + i), reinterpret_cast<float*>(out + i));
+		}
+	}
+
+	void multiplyMatricesParentAVX2(const Mat4& parent, const Mat4* local, Mat4* out, size_t count)
+	{
+		alignas(32) float p[16];
+		_mm256_store_ps(p, _mm256_loadu_ps(reinterpret_cast<const float*>(&parent)));
+		_mm256_store_ps(p + 8, _mm256_loadu_ps(reinterpret_cast<const float*>(&parent) + 8));
+		for (size_t i = 0; i < count; i++) {
+			multiply(p, reinterpret_cast<const float*>(local + i), reinterpret_cast<float*>(out + i));
+		}
+	}
+
+	inline void storeVisible(__m256 mask, uint8_t* visible)
+	{
+		int bits = _mm256_movemask_ps(mask);
+		for (int lane = 0; lane < 8; lane++) {
+			visible[lane] = (bits >> lane) & 1;
+		}
+	}
+
+	void cullSpheresAVX2(const Frustum& frustum, const SphereArrays& spheres, uint8_t* visible, size_t count)
+	{
+		const float* planes = reinterpret_cast<const float*>(frustum.planes);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 x = _mm256_loadu_ps(spheres.x + i);
+			__m256 y = _mm256_loadu_ps(spheres.y + i);
+			__m256 z = _mm256_loadu_ps(spheres.z + i);
+			__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius + i));
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < 6; p++) {
+				const float* plane = planes + p * 4;
+				__m256 distance = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane[0])), _mm256_mul_ps(y, _mm256_set1_ps(plane[1])));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(z, _mm256_set1_ps(plane[2])));
+				distance = _mm256_add_ps(distance, _mm256_set1_ps(plane[3]));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+			}
+			storeVisible(inside, visible + i);
+		}
+		cullSpheresRange(frustum, spheres, visible, i, count);
+	}
+
+	void cullAABBsAVX2(const Frustum& frustum, const AABBArrays& boxes, uint8_t* visible, size_t count)
+	{
+		const float* planes = reinterpret_cast<const float*>(frustum.planes);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < 6; p++) {
+				const float* plane = planes + p * 4;
+				// The corner farthest along the normal is the same for every box, so pick its arrays once
+				__m256 x = _mm256_loadu_ps((plane[0] > 0.0f ? boxes.maxX : boxes.minX) + i);
+				__m256 y = _mm256_loadu_ps((plane[1] > 0.0f ? boxes.maxY : boxes.minY) + i);
+				__m256 z = _mm256_loadu_ps((plane[2] > 0.0f ? boxes.maxZ : boxes.minZ) + i);
+				__m256 distance = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane[0])), _mm256_mul_ps(y, _mm256_set1_ps(plane[1])));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(z, _mm256_set1_ps(plane[2])));
+				distance = _mm256_add_ps(distance, _mm256_set1_ps(plane[3]));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+			storeVisible(inside, visible + i);
+		}
+		cullAABBsRange(frustum, boxes, visible, i, count);
+	}
+}
+
+const MathKernels& getAVX2Kernels()
+{
+	// Point transforms gain nothing from wider registers, the SSE4 kernel is reused
+	static const MathKernels kernels{multiplyMatricesAVX2, multiplyMatricesParentAVX2, getSSE4Kernels().transformPoints, cullSpheresAVX2, cullAABBsAVX2};
+	return kernels;
+}
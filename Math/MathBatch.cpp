@@ -0,0 +1,119 @@
+#include "MathBatch.h"
+
+#include "MathKernels.h"
+
+#if defined(APPARATUS_MATH_RUNTIME_DISPATCH) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Best level the CPU supports out of the levels that were compiled in
+	SimdLevel detectSimdLevel()
+	{
+#if defined(APPARATUS_MATH_RUNTIME_DISPATCH)
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool sse4 = (info[2] & (1 << 19)) != 0;
+		// AVX also needs the OS to save the upper halves of the registers
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = osxsave && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+		__cpuidex(info, 7, 0);
+		bool avx2 = avx && (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		bool sse4 = __builtin_cpu_supports("sse4.1");
+		bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+		if (avx2) {
+			return SimdLevel::AVX2;
+		}
+		if (sse4) {
+			return SimdLevel::SSE4;
+		}
+		return SimdLevel::SCALAR;
+#elif defined(APPARATUS_MATH_AVX2)
+		// Fixed at compile time
+		return SimdLevel::AVX2;
+#elif defined(APPARATUS_MATH_SSE4)
+		return SimdLevel::SSE4;
+#else
+		return SimdLevel::SCALAR;
+#endif
+	}
+
+	const MathKernels& getKernels(SimdLevel level)
+	{
+		switch (level) {
+#ifdef APPARATUS_MATH_AVX2
+		case SimdLevel::AVX2:
+			return getAVX2Kernels();
+#endif
+#ifdef APPARATUS_MATH_SSE4
+		case SimdLevel::SSE4:
+			return getSSE4Kernels();
+#endif
+		default:
+			return getScalarKernels();
+		}
+	}
+
+	SimdLevel supportedLevel = detectSimdLevel();
+	SimdLevel currentLevel = supportedLevel;
+	const MathKernels* kernels = &getKernels(currentLevel);
+}
+
+SimdLevel getSimdLevel()
+{
+	return currentLevel;
+}
+
+SimdLevel setSimdLevel(SimdLevel level)
+{
+	currentLevel = level < supportedLevel ? level : supportedLevel;
+	kernels = &getKernels(currentLevel);
+	return currentLevel;
+}
+
+const char* getSimdLevelName(SimdLevel level)
+{
+	switch (level) {
+	case SimdLevel::SCALAR:
+		return "scalar";
+		break;
+	case SimdLevel::SSE4:
+		return "SSE4";
+		break;
+	case SimdLevel::AVX2:
+		return "AVX2";
+		break;
+	}
+
+	return "UNKNOWN SIMD LEVEL";
+}
+
+void multiplyMatrices(const Mat4* a, const Mat4* b, Mat4* out, size_t count)
+{
+	kernels->multiplyMatrices(a, b, out, count);
+}
+
+void multiplyMatrices(const Mat4& parent, const Mat4* local, Mat4* out, size_t count)
+{
+	kernels->multiplyMatricesParent(parent, local, out, count);
+}
+
+void transformPoints(const Mat4& matrix, const Vec3* points, Vec3* out, size_t count)
+{
+	kernels->transformPoints(matrix, points, out, count);
+}
+
+void cullSpheres(const Frustum& frustum, const SphereArrays& spheres, uint8_t* visible, size_t count)
+{
+	kernels->cullSpheres(frustum, spheres, visible, count);
+}
+
+void cullAABBs(const Frustum& frustum, const AABBArrays& boxes, uint8_t* visible, size_t count)
+{
+	kernels->cullAABBs(frustum, boxes, visible, count);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Matrix.h"
+#include "Frustum.h"
+
+enum class SimdLevel
+{
+	SCALAR,
+	SSE4,
+	AVX2
+};
+
+// Bounding spheres stored as one array per field, such as SoA lanes from the Scene module
+struct SphereArrays
+{
+	const float* x;
+	const float* y;
+	const float* z;
+	const float* radius;
+};
+
+// Axis aligned boxes stored as one array per field
+struct AABBArrays
+{
+	const float* minX;
+	const float* minY;
+	const float* minZ;
+	const float* maxX;
+	const float* maxY;
+	const float* maxZ;
+};
+
+/**
+ * @brief Returns the instruction set the batch functions currently use.
+ * Picked when the program starts from what the CPU supports and what was compiled in (APPARATUS_SIMD).
+ */
+SimdLevel getSimdLevel();
+
+/**
+ * @brief Forces the batch functions to use an instruction set, such as SCALAR to compare against the reference.
+ * Falls back to the best supported level below the requested one.
+ * 
+ * @return the level that is now used
+ */
+SimdLevel setSimdLevel(SimdLevel level);
+
+/**
+ * @brief Returns a readable name of a SIMD level
+ */
+const char* getSimdLevelName(SimdLevel level);
+
+/**
+ * @brief out[i] = a[i] * b[i] for every i below count. out may alias a or b.
+ */
+void multiplyMatrices(const Mat4* a, const Mat4* b, Mat4* out, size_t count);
+
+/**
+ * @brief out[i] = parent * local[i] for every i below count, used to move a batch of children into world space.
+ * out may alias local.
+ */
+void multiplyMatrices(const Mat4& parent, const Mat4* local, Mat4* out, size_t count);
+
+/**
+ * @brief Transforms count points by a matrix, w is assumed to be 1. out may alias points.
+ */
+void transformPoints(const Mat4& matrix, const Vec3* points, Vec3* out, size_t count);
+
+/**
+ * @brief Tests count spheres against a frustum, 8 at a time with AVX2.
+ * 
+ * @param visible - set to 1 for spheres intersecting the frustum, 0 otherwise
+ */
+void cullSpheres(const Frustum& frustum, const SphereArrays& spheres, uint8_t* visible, size_t count);
+
+/**
+ * @brief Tests count boxes against a frustum, 8 at a time with AVX2.
+ * 
+ * @param visible - set to 1 for boxes intersecting the frustum, 0 otherwise
+ */
+void cullAABBs(const Frustum& frustum, const AABBArrays& boxes, uint8_t* visible, size_t count);
@@ -0,0 +1,29 @@
+#pragma once
+
+// Internal to the math module: one set of batch kernels per instruction set.
+// The SSE4 and AVX2 kernels are compiled with extra instruction set flags, so they must only use
+// intrinsics and raw floats. Calling an inline function from the math headers there could emit
+// a copy using those instructions which the linker may then pick for every caller.
+
+#include "MathBatch.h"
+
+struct MathKernels
+{
+	void (*multiplyMatrices)(const Mat4* a, const Mat4* b, Mat4* out, size_t count);
+	void (*multiplyMatricesParent)(const Mat4& parent, const Mat4* local, Mat4* out, size_t count);
+	void (*transformPoints)(const Mat4& matrix, const Vec3* points, Vec3* out, size_t count);
+	void (*cullSpheres)(const Frustum& frustum, const SphereArrays& spheres, uint8_t* visible, size_t count);
+	void (*cullAABBs)(const Frustum& frustum, const AABBArrays& boxes, uint8_t* visible, size_t count);
+};
+
+const MathKernels& getScalarKernels();
+#ifdef APPARATUS_MATH_SSE4
+const MathKernels& getSSE4Kernels();
+#endif
+#ifdef APPARATUS_MATH_AVX2
+const MathKernels& getAVX2Kernels();
+#endif
+
+// Scalar kernels over a range, used for the tails the vector kernels don't cover
+void cullSpheresRange(const Frustum& frustum, const SphereArrays& spheres, uint8_t* visible, size_t begin, size_t end);
+void cullAABBsRange(const Frustum& frustum, const AABBArrays& boxes, uint8_t* visible, size_t begin, size_t end);
@@ -0,0 +1,127 @@
+#include "MathKernels.h"
+
+#include <smmintrin.h>
+
+namespace
+{
+	// out = a * b for column major matrices, one column of the result per iteration
+	inline void multiply(const float* a, const float* b, float* out)
+	{
+		__m128 a0 = _mm_load_ps(a);
+		__m128 a1 = _mm_load_ps(a + 4);
+		__m128 a2 = _mm_load_ps(a + 8);
+		__m128 a3 = _mm_load_ps(a + 12);
+		__m128 columns[4];
+		for (int c = 0; c < 4; c++) {
+			__m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[c * 4 + 0]));
+			column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[c * 4 + 1])));
+			column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[c * 4 + 2])));
+			column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[c * 4 + 3])));
+			columns[c] = column;
+		}
+		// Stored after every column is computed so out may alias a or b
+		for (int c = 0; c < 4; c++) {
+			_mm_store_ps(out + c * 4, columns[c]);
+		}
+	}
+
+	void multiplyMatricesSSE4(const Mat4* a, const Mat4* b, Mat4* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			multiply(reinterpret_cast<const float*>(a + i), reinterpret_cast<const float*>(b + i), reinterpret_cast<float*>(out + i));
+		}
+	}
+
+	void multiplyMatricesParentSSE4(const Mat4& parent, const Mat4* local, Mat4* out, size_t count)
+	{
+		alignas(16) float p[16];
+		_mm_store_ps(p, _mm_load_ps(reinterpret_cast<const float*>(&parent)));
+		_mm_store_ps(p + 4, _mm_load_ps(reinterpret_cast<const float*>(&parent) + 4));
+		_mm_store_ps(p + 8, _mm_load_ps(reinterpret_cast<const float*>(&parent) + 8));
+		_mm_store_ps(p + 12, _mm_load_ps(reinterpret_cast<const float*>(&parent) + 12));
+		for (size_t i = 0; i < count; i++) {
+			multiply(p, reinterpret_cast<const float*>(local + i), reinterpret_cast<float*>(out + i));
+		}
+	}
+
+	void transformPointsSSE4(const Mat4& matrix, const Vec3* points, Vec3* out, size_t count)
+	{
+		const float* m = reinterpret_cast<const float*>(&matrix);
+		__m128 c0 = _mm_load_ps(m);
+		__m128 c1 = _mm_load_ps(m + 4);
+		__m128 c2 = _mm_load_ps(m + 8);
+		__m128 c3 = _mm_load_ps(m + 12);
+		for (size_t i = 0; i < count; i++) {
+			const float* p = reinterpret_cast<const float*>(points + i);
+			__m128 result = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+			result = _mm_add_ps(result, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+			result = _mm_add_ps(result, c3);
+
+			alignas(16) float stored[4];
+			_mm_store_ps(stored, result);
+			float* o = reinterpret_cast<float*>(out + i);
+			o[0] = stored[0];
+			o[1] = stored[1];
+			o[2] = stored[2];
+		}
+	}
+
+	// Writes 1 or 0 for 4 objects from the sign bits of a comparison mask
+	inline void storeVisible(__m128 mask, uint8_t* visible)
+	{
+		int bits = _mm_movemask_ps(mask);
+		for (int lane = 0; lane < 4; lane++) {
+			visible[lane] = (bits >> lane) & 1;
+		}
+	}
+
+	void cullSpheresSSE4(const Frustum& frustum, const SphereArrays& spheres, uint8_t* visible, size_t count)
+	{
+		const float* planes = reinterpret_cast<const float*>(frustum.planes);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128 x = _mm_loadu_ps(spheres.x + i);
+			__m128 y = _mm_loadu_ps(spheres.y + i);
+			__m128 z = _mm_loadu_ps(spheres.z + i);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius + i));
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < 6; p++) {
+				const float* plane = planes + p * 4;
+				__m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])), _mm_mul_ps(y, _mm_set1_ps(plane[1])));
+				distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane[2])));
+				distance = _mm_add_ps(distance, _mm_set1_ps(plane[3]));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+			}
+			storeVisible(inside, visible + i);
+		}
+		cullSpheresRange(frustum, spheres, visible, i, count);
+	}
+
+	void cullAABBsSSE4(const Frustum& frustum, const AABBArrays& boxes, uint8_t* visible, size_t count)
+	{
+		const float* planes = reinterpret_cast<const float*>(frustum.planes);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < 6; p++) {
+				const float* plane = planes + p * 4;
+				// The corner farthest along the normal is the same for every box, so pick its arrays once
+				__m128 x = _mm_loadu_ps((plane[0] > 0.0f ? boxes.maxX : boxes.minX) + i);
+				__m128 y = _mm_loadu_ps((plane[1] > 0.0f ? boxes.maxY : boxes.minY) + i);
+				__m128 z = _mm_loadu_ps((plane[2] > 0.0f ? boxes.maxZ : boxes.minZ) + i);
+				__m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])), _mm_mul_ps(y, _mm_set1_ps(plane[1])));
+				distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane[2])));
+				distance = _mm_add_ps(distance, _mm_set1_ps(plane[3]));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+			}
+			storeVisible(inside, visible + i);
+		}
+		cullAABBsRange(frustum, boxes, visible, i, count);
+	}
+}
+
+const MathKernels& getSSE4Kernels()
+{
+	static const MathKernels kernels{multiplyMatricesSSE4, multiplyMatricesParentSSE4, transformPointsSSE4, cullSpheresSSE4, cullAABBsSSE4};
+	return kernels;
+}
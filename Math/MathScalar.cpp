@@ -0,0 +1,60 @@
+#include "MathKernels.h"
+
+namespace
+{
+	void multiplyMatricesScalar(const Mat4* a, const Mat4* b, Mat4* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			out[i] = a[i] * b[i];
+		}
+	}
+
+	void multiplyMatricesParentScalar(const Mat4& parent, const Mat4* local, Mat4* out, size_t count)
+	{
+		// Copied in case out aliases the parent
+		Mat4 p = parent;
+		for (size_t i = 0; i < count; i++) {
+			out[i] = p * local[i];
+		}
+	}
+
+	void transformPointsScalar(const Mat4& matrix, const Vec3* points, Vec3* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			out[i] = transformPoint(matrix, points[i]);
+		}
+	}
+
+	void cullSpheresScalar(const Frustum& frustum, const SphereArrays& spheres, uint8_t* visible, size_t count)
+	{
+		cullSpheresRange(frustum, spheres, visible, 0, count);
+	}
+
+	void cullAABBsScalar(const Frustum& frustum, const AABBArrays& boxes, uint8_t* visible, size_t count)
+	{
+		cullAABBsRange(frustum, boxes, visible, 0, count);
+	}
+}
+
+void cullSpheresRange(const Frustum& frustum, const SphereArrays& spheres, uint8_t* visible, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++) {
+		Vec3 center{spheres.x[i], spheres.y[i], spheres.z[i]};
+		visible[i] = isSphereVisible(frustum, center, spheres.radius[i]) ? 1 : 0;
+	}
+}
+
+void cullAABBsRange(const Frustum& frustum, const AABBArrays& boxes, uint8_t* visible, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++) {
+		Vec3 min{boxes.minX[i], boxes.minY[i], boxes.minZ[i]};
+		Vec3 max{boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]};
+		visible[i] = isAABBVisible(frustum, min, max) ? 1 : 0;
+	}
+}
+
+const MathKernels& getScalarKernels()
+{
+	static const MathKernels kernels{multiplyMatricesScalar, multiplyMatricesParentScalar, transformPointsScalar, cullSpheresScalar, cullAABBsScalar};
+	return kernels;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Vector.h"
+#include "Quaternion.h"
+
+// Column major 4x4 matrix with the same memory layout as a GLSL mat4
+struct alignas(16) Mat4
+{
+	Vec4 columns[4];
+};
+
+inline Mat4 identityMat4()
+{
+	return {{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+}
+
+inline Vec4 operator*(const Mat4& m, Vec4 v)
+{
+	return m.columns[0] * v.x + m.columns[1] * v.y + m.columns[2] * v.z + m.columns[3] * v.w;
+}
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b)
+{
+	return {{a * b.columns[0], a * b.columns[1], a * b.columns[2], a * b.columns[3]}};
+}
+
+/**
+ * @brief Transforms a point, w is assumed to be 1 and the result isn't divided by w
+ */
+inline Vec3 transformPoint(const Mat4& m, Vec3 p)
+{
+	return makeVec3(m * makeVec4(p, 1.0f));
+}
+
+inline Mat4 transpose(const Mat4& m)
+{
+	const Vec4* c = m.columns;
+	return {{
+		{c[0].x, c[1].x, c[2].x, c[3].x},
+		{c[0].y, c[1].y, c[2].y, c[3].y},
+		{c[0].z, c[1].z, c[2].z, c[3].z},
+		{c[0].w, c[1].w, c[2].w, c[3].w}}};
+}
+
+/**
+ * @brief Inverts a matrix whose last row is 0 0 0 1, such as one from composeTransform
+ */
+inline Mat4 inverseAffine(const Mat4& m)
+{
+	Vec3 x = makeVec3(m.columns[0]);
+	Vec3 y = makeVec3(m.columns[1]);
+	Vec3 z = makeVec3(m.columns[2]);
+	Vec3 t = makeVec3(m.columns[3]);
+	// The rows of the inverse 3x3 part are the cross products of its columns over the determinant
+	Vec3 r0 = cross(y, z);
+	Vec3 r1 = cross(z, x);
+	Vec3 r2 = cross(x, y);
+	float inverseDeterminant = 1.0f / dot(x, r0);
+	r0 = r0 * inverseDeterminant;
+	r1 = r1 * inverseDeterminant;
+	r2 = r2 * inverseDeterminant;
+	return {{
+		{r0.x, r1.x, r2.x, 0.0f},
+		{r0.y, r1.y, r2.y, 0.0f},
+		{r0.z, r1.z, r2.z, 0.0f},
+		{-dot(r0, t), -dot(r1, t), -dot(r2, t), 1.0f}}};
+}
+
+/**
+ * @brief Builds translation * rotation * scale
+ */
+inline Mat4 composeTransform(Vec3 position, Quat rotation, Vec3 scale)
+{
+	float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+	float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+	float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+	return {{
+		{(1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f},
+		{2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f},
+		{2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f},
+		{position.x, position.y, position.z, 1.0f}}};
+}
+
+/**
+ * @brief Right handed view matrix looking from eye towards target
+ */
+inline Mat4 lookAt(Vec3 eye, Vec3 target, Vec3 up)
+{
+	Vec3 forward = normalize(target - eye);
+	Vec3 right = normalize(cross(forward, up));
+	Vec3 trueUp = cross(right, forward);
+	return {{
+		{right.x, trueUp.x, -forward.x, 0.0f},
+		{right.y, trueUp.y, -forward.y, 0.0f},
+		{right.z, trueUp.z, -forward.z, 0.0f},
+		{-dot(right, eye), -dot(trueUp, eye), dot(forward, eye), 1.0f}}};
+}
+
+/**
+ * @brief Right handed perspective projection to vulkan clip space: depth from 0 to 1 and y pointing down
+ * 
+ * @param verticalFov - vertical field of view in radians
+ * @param aspect - width divided by height
+ */
+inline Mat4 perspective(float verticalFov, float aspect, float zNear, float zFar)
+{
+	float f = 1.0f / std::tan(verticalFov * 0.5f);
+	return {{
+		{f / aspect, 0.0f, 0.0f, 0.0f},
+		{0.0f, -f, 0.0f, 0.0f},
+		{0.0f, 0.0f, zFar / (zNear - zFar), -1.0f},
+		{0.0f, 0.0f, zNear * zFar / (zNear - zFar), 0.0f}}};
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Vector.h"
+
+// Unit quaternion describing a rotation, w is the scalar part
+struct Quat
+{
+	float x, y, z, w;
+};
+
+inline Quat identityQuat()
+{
+	return {0.0f, 0.0f, 0.0f, 1.0f};
+}
+
+/**
+ * @brief Returns the rotation of angle radians around a normalized axis
+ */
+inline Quat quatFromAxisAngle(Vec3 axis, float angle)
+{
+	float s = std::sin(angle * 0.5f);
+	return {axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f)};
+}
+
+// Applies b first, then a
+inline Quat operator*(Quat a, Quat b)
+{
+	return {
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+inline Quat conjugate(Quat q)
+{
+	return {-q.x, -q.y, -q.z, q.w};
+}
+
+inline Quat normalize(Quat q)
+{
+	float inverseLength = 1.0f / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+	return {q.x * inverseLength, q.y * inverseLength, q.z * inverseLength, q.w * inverseLength};
+}
+
+/**
+ * @brief Rotates a vector by a unit quaternion
+ */
+inline Vec3 rotate(Quat q, Vec3 v)
+{
+	Vec3 u{q.x, q.y, q.z};
+	Vec3 t = 2.0f * cross(u, v);
+	return v + q.w * t + cross(u, t);
+}
+
+/**
+ * @brief Spherical interpolation between two unit quaternions along the shortest path
+ */
+inline Quat slerp(Quat a, Quat b, float t)
+{
+	float cosine = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	if (cosine < 0.0f) {
+		b = {-b.x, -b.y, -b.z, -b.w};
+		cosine = -cosine;
+	}
+
+	// Nearly parallel, fall back to normalized linear interpolation
+	if (cosine > 0.9995f) {
+		return normalize(Quat{
+			a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t,
+			a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t});
+	}
+
+	float angle = std::acos(cosine);
+	float sine = std::sin(angle);
+	float wa = std::sin((1.0f - t) * angle) / sine;
+	float wb = std::sin(t * angle) / sine;
+	return {a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb};
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cmath>
+
+// Vectors are plain aggregates so they can be copied straight into GPU buffers
+// and read as float arrays by the batch kernels.
+
+struct Vec3
+{
+	float x, y, z;
+};
+
+struct alignas(16) Vec4
+{
+	float x, y, z, w;
+};
+
+inline Vec3 operator+(Vec3 a, Vec3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+inline Vec3 operator-(Vec3 a, Vec3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline Vec3 operator-(Vec3 a) { return {-a.x, -a.y, -a.z}; }
+inline Vec3 operator*(Vec3 a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+inline Vec3 operator*(float s, Vec3 a) { return a * s; }
+inline Vec3 operator*(Vec3 a, Vec3 b) { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+inline Vec3 operator/(Vec3 a, float s) { return a * (1.0f / s); }
+
+inline float dot(Vec3 a, Vec3 b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vec3 cross(Vec3 a, Vec3 b)
+{
+	return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+inline float length(Vec3 a)
+{
+	return std::sqrt(dot(a, a));
+}
+
+inline Vec3 normalize(Vec3 a)
+{
+	return a / length(a);
+}
+
+inline Vec4 operator+(Vec4 a, Vec4 b) { return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w}; }
+inline Vec4 operator-(Vec4 a, Vec4 b) { return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w}; }
+inline Vec4 operator*(Vec4 a, float s) { return {a.x * s, a.y * s, a.z * s, a.w * s}; }
+inline Vec4 operator*(float s, Vec4 a) { return a * s; }
+
+inline float dot(Vec4 a, Vec4 b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+inline Vec4 makeVec4(Vec3 v, float w)
+{
+	return {v.x, v.y, v.z, w};
+}
+
+inline Vec3 makeVec3(Vec4 v)
+{
+	return {v.x, v.y, v.z};
+}
@@ -0,0 +1,192 @@
+#include "Archetype.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace
+{
+	size_t alignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Bytes needed for a chunk of the given capacity, also fills the column offsets
+	size_t computeLayout(ComponentMask mask, uint32_t capacity, size_t* columnOffsets, size_t& laneStride)
+	{
+		laneStride = alignUp(sizeof(float) * capacity, Archetype::CHUNK_ALIGNMENT);
+		size_t offset = alignUp(sizeof(Entity) * capacity, Archetype::CHUNK_ALIGNMENT);
+		for (uint32_t id = 0; id < MAX_COMPONENTS; id++) {
+			if (!(mask & (ComponentMask{1} << id))) {
+				continue;
+			}
+
+			const ComponentInfo& info = ComponentRegistry::getInfo(id);
+			columnOffsets[id] = offset;
+			if (info.lanes > 0) {
+				offset += laneStride * info.lanes;
+			} else {
+				offset += alignUp(static_cast<size_t>(info.size) * capacity, Archetype::CHUNK_ALIGNMENT);
+			}
+		}
+		return offset;
+	}
+}
+
+Archetype::Archetype(ComponentMask _mask) :
+	mask(_mask),
+	capacity(0),
+	chunkBytes(CHUNK_SIZE),
+	laneStride(0),
+	columnOffsets{},
+	chunks{}
+{
+	size_t bytesPerEntity = sizeof(Entity);
+	for (uint32_t id = 0; id < MAX_COMPONENTS; id++) {
+		if (mask & (ComponentMask{1} << id)) {
+			const ComponentInfo& info = ComponentRegistry::getInfo(id);
+			if (info.alignment > CHUNK_ALIGNMENT) {
+				throw std::runtime_error("component alignment is larger than the chunk alignment");
+			}
+			bytesPerEntity += info.size;
+		}
+	}
+
+	// Start from the estimate without padding and shrink until the padded columns fit
+	capacity = static_cast<uint32_t>(CHUNK_SIZE / bytesPerEntity);
+	while (capacity > 0 && computeLayout(mask, capacity, columnOffsets, laneStride) > CHUNK_SIZE) {
+		capacity--;
+	}
+	if (capacity == 0) {
+		// Components larger than a chunk get one entity per chunk
+		capacity = 1;
+		chunkBytes = alignUp(computeLayout(mask, capacity, columnOffsets, laneStride), CHUNK_ALIGNMENT);
+	}
+}
+
+Archetype::~Archetype()
+{
+	for (Chunk& chunk : chunks) {
+		::operator delete(chunk.data, std::align_val_t(CHUNK_ALIGNMENT));
+	}
+}
+
+ComponentMask Archetype::getMask()
+{
+	return mask;
+}
+
+uint32_t Archetype::getCapacity()
+{
+	return capacity;
+}
+
+uint32_t Archetype::getChunkCount()
+{
+	return static_cast<uint32_t>(chunks.size());
+}
+
+Chunk& Archetype::getChunk(uint32_t index)
+{
+	return chunks[index];
+}
+
+uint32_t Archetype::getEntityCount()
+{
+	if (chunks.empty()) {
+		return 0;
+	}
+	// Every chunk but the last is full
+	return static_cast<uint32_t>(chunks.size() - 1) * capacity + chunks.back().count;
+}
+
+Entity* Archetype::getEntities(Chunk& chunk)
+{
+	return reinterpret_cast<Entity*>(chunk.data);
+}
+
+std::byte* Archetype::getColumn(Chunk& chunk, uint32_t componentId)
+{
+	return chunk.data + columnOffsets[componentId];
+}
+
+size_t Archetype::getLaneStride()
+{
+	return laneStride;
+}
+
+EntityLocation Archetype::allocate(Entity entity)
+{
+	if (chunks.empty() || chunks.back().count == capacity) {
+		Chunk chunk{};
+		chunk.data = static_cast<std::byte*>(::operator new(chunkBytes, std::align_val_t(CHUNK_ALIGNMENT)));
+		chunk.count = 0;
+		chunks.push_back(chunk);
+	}
+
+	Chunk& chunk = chunks.back();
+	uint32_t row = chunk.count++;
+	getEntities(chunk)[row] = entity;
+	return {0, static_cast<uint32_t>(chunks.size() - 1), row};
+}
+
+Entity Archetype::remove(uint32_t chunkIndex, uint32_t row)
+{
+	Chunk& chunk = chunks[chunkIndex];
+	Chunk& last = chunks.back();
+	uint32_t lastRow = last.count - 1;
+	Entity moved = getEntities(chunk)[row];
+
+	if (&chunk != &last || row != lastRow) {
+		moved = getEntities(last)[lastRow];
+		copyRow(static_cast<uint32_t>(chunks.size() - 1), lastRow, *this, chunkIndex, row);
+		getEntities(chunk)[row] = moved;
+	}
+
+	last.count--;
+	if (last.count == 0) {
+		::operator delete(last.data, std::align_val_t(CHUNK_ALIGNMENT));
+		chunks.pop_back();
+	}
+	return moved;
+}
+
+void Archetype::readComponent(uint32_t chunkIndex, uint32_t row, uint32_t componentId, void* destination)
+{
+	// A tightly packed struct is the same as a column of one entity with a lane stride of one float
+	copyElement(componentId, getColumn(chunks[chunkIndex], componentId), row, laneStride,
+		static_cast<std::byte*>(destination), 0, sizeof(float));
+}
+
+void Archetype::writeComponent(uint32_t chunkIndex, uint32_t row, uint32_t componentId, const void* source)
+{
+	copyElement(componentId, static_cast<const std::byte*>(source), 0, sizeof(float),
+		getColumn(chunks[chunkIndex], componentId), row, laneStride);
+}
+
+void Archetype::copyRow(uint32_t chunkIndex, uint32_t row, Archetype& destination, uint32_t destinationChunk, uint32_t destinationRow)
+{
+	ComponentMask shared = mask & destination.mask;
+	for (uint32_t id = 0; id < MAX_COMPONENTS; id++) {
+		if (shared & (ComponentMask{1} << id)) {
+			copyElement(id, getColumn(chunks[chunkIndex], id), row, laneStride,
+				destination.getColumn(destination.chunks[destinationChunk], id), destinationRow, destination.laneStride);
+		}
+	}
+}
+
+void Archetype::copyElement(uint32_t componentId, const std::byte* sourceColumn, uint32_t sourceRow,
+	size_t sourceLaneStride, std::byte* destinationColumn, uint32_t destinationRow, size_t destinationLaneStride)
+{
+	const ComponentInfo& info = ComponentRegistry::getInfo(componentId);
+	if (info.lanes == 0) {
+		std::memcpy(destinationColumn + static_cast<size_t>(info.size) * destinationRow,
+			sourceColumn + static_cast<size_t>(info.size) * sourceRow, info.size);
+		return;
+	}
+
+	for (uint32_t lane = 0; lane < info.lanes; lane++) {
+		std::memcpy(destinationColumn + lane * destinationLaneStride + sizeof(float) * destinationRow,
+			sourceColumn + lane * sourceLaneStride + sizeof(float) * sourceRow, sizeof(float));
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Component.h"
+#include "Entity.h"
+
+// A fixed size block holding up to Archetype::getCapacity() entities. Every column
+// (the entity handles, each struct component and each lane of an SoA component) is contiguous
+// and starts on a 64 byte boundary.
+struct Chunk
+{
+	std::byte* data;
+	uint32_t count;
+};
+
+// Where an entity's components are stored
+struct EntityLocation
+{
+	uint32_t archetype;
+	uint32_t chunk;
+	uint32_t row;
+};
+
+// Stores every entity that has exactly the same set of components
+class Archetype
+{
+public:
+	static constexpr size_t CHUNK_SIZE = 16 * 1024;
+	static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+	/**
+	 * @brief Computes the chunk layout for the components in the mask
+	 */
+	explicit Archetype(ComponentMask mask);
+
+	/**
+	 * @brief Frees every chunk
+	 */
+	~Archetype();
+
+	Archetype(const Archetype&) = delete;
+	Archetype& operator=(const Archetype&) = delete;
+
+	ComponentMask getMask();
+
+	/**
+	 * @brief Returns how many entities fit in one chunk
+	 */
+	uint32_t getCapacity();
+
+	uint32_t getChunkCount();
+
+	Chunk& getChunk(uint32_t index);
+
+	/**
+	 * @brief Returns the number of entities in every chunk combined
+	 */
+	uint32_t getEntityCount();
+
+	/**
+	 * @brief Returns the entity handles of a chunk
+	 */
+	Entity* getEntities(Chunk& chunk);
+
+	/**
+	 * @brief Returns the start of a component's column in a chunk.
+	 * For SoA components lane i starts at getColumn(...) + i * getLaneStride().
+	 */
+	std::byte* getColumn(Chunk& chunk, uint32_t componentId);
+
+	/**
+	 * @brief Returns the distance in bytes between the lanes of an SoA component
+	 */
+	size_t getLaneStride();
+
+	/**
+	 * @brief Appends an entity with uninitialized components
+	 * 
+	 * @return chunk and row of the new entity, the archetype index is left for the caller
+	 */
+	EntityLocation allocate(Entity entity);
+
+	/**
+	 * @brief Removes an entity by moving the last entity of the archetype into its row.
+	 * 
+	 * @return the entity that was moved into the row, or the removed entity if nothing moved
+	 */
+	Entity remove(uint32_t chunkIndex, uint32_t row);
+
+	/**
+	 * @brief Copies one component of an entity from or to a tightly packed struct
+	 */
+	void readComponent(uint32_t chunkIndex, uint32_t row, uint32_t componentId, void* destination);
+	void writeComponent(uint32_t chunkIndex, uint32_t row, uint32_t componentId, const void* source);
+
+	/**
+	 * @brief Copies every component both archetypes have from a row of this archetype to a row of another
+	 */
+	void copyRow(uint32_t chunkIndex, uint32_t row, Archetype& destination, uint32_t destinationChunk, uint32_t destinationRow);
+
+private:
+	ComponentMask mask;
+	uint32_t capacity;
+	size_t chunkBytes;
+	size_t laneStride;
+	// Column offset of each component id, only valid for ids in the mask
+	size_t columnOffsets[MAX_COMPONENTS];
+	std::vector<Chunk> chunks;
+
+	void copyElement(uint32_t componentId, const std::byte* sourceColumn, uint32_t sourceRow,
+		size_t sourceLaneStride, std::byte* destinationColumn, uint32_t destinationRow, size_t destinationLaneStride);
+};
@@ -0,0 +1,28 @@
+#include "Component.h"
+
+#include <array>
+#include <atomic>
+#include <stdexcept>
+
+namespace
+{
+	// Fixed storage so ids can be looked up without a lock while other threads register
+	std::array<ComponentInfo, MAX_COMPONENTS> infos;
+	std::atomic<uint32_t> infoCount{0};
+}
+
+const ComponentInfo& ComponentRegistry::getInfo(uint32_t id)
+{
+	return infos[id];
+}
+
+uint32_t ComponentRegistry::registerComponent(ComponentInfo info)
+{
+	// Only called from the static initializer in getId, which the compiler already serializes per type
+	uint32_t id = infoCount.fetch_add(1);
+	if (id >= MAX_COMPONENTS) {
+		throw std::runtime_error("too many component types, increase MAX_COMPONENTS");
+	}
+	infos[id] = info;
+	return id;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+// Bit i is set when the component with id i is present
+using ComponentMask = uint64_t;
+
+constexpr uint32_t MAX_COMPONENTS = 64;
+
+// Components declaring `static constexpr bool soa = true;` must only hold floats.
+// They are stored as one float array per field (a lane) instead of one struct per entity.
+template<typename T, typename = void>
+struct IsSoA : std::false_type {};
+
+template<typename T>
+struct IsSoA<T, std::void_t<decltype(T::soa)>> : std::bool_constant<T::soa> {};
+
+struct ComponentInfo
+{
+	uint32_t size;
+	uint32_t alignment;
+	// Number of float lanes for SoA components, 0 for components stored as structs
+	uint32_t lanes;
+};
+
+class ComponentRegistry
+{
+public:
+	/**
+	 * @brief Returns the id of a component type, registering it on first use.
+	 * Components are copied with memcpy so they must be trivially copyable.
+	 */
+	template<typename T>
+	static uint32_t getId();
+
+	/**
+	 * @brief Returns the size and layout information of a registered component
+	 */
+	static const ComponentInfo& getInfo(uint32_t id);
+
+private:
+	static uint32_t registerComponent(ComponentInfo info);
+};
+
+template<typename T>
+uint32_t ComponentRegistry::getId()
+{
+	static_assert(std::is_trivially_copyable_v<T>, "components must be trivially copyable");
+	static_assert(!IsSoA<T>::value || sizeof(T) % sizeof(float) == 0, "SoA components must only hold floats");
+
+	static const uint32_t id = registerComponent({
+		static_cast<uint32_t>(sizeof(T)),
+		static_cast<uint32_t>(alignof(T)),
+		IsSoA<T>::value ? static_cast<uint32_t>(sizeof(T) / sizeof(float)) : 0});
+	return id;
+}
+
+template<typename... Ts>
+ComponentMask makeComponentMask()
+{
+	return (ComponentMask{0} | ... | (ComponentMask{1} << ComponentRegistry::getId<Ts>()));
+}
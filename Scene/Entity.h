@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Handle to an entity in a World. The generation changes when an index is reused,
+// so handles to destroyed entities are never mistaken for new ones.
+struct Entity
+{
+	uint32_t index;
+	uint32_t generation;
+
+	bool operator==(const Entity& other) const
+	{
+		return index == other.index && generation == other.generation;
+	}
+
+	bool operator!=(const Entity& other) const
+	{
+		return !(*this == other);
+	}
+};
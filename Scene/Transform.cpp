@@ -0,0 +1,55 @@
+#include "Transform.h"
+
+namespace
+{
+	void updateChunk(ChunkView& view)
+	{
+		using Lane = LocalTransform::Lane;
+		const float* px = view.getLane<LocalTransform>(Lane::POSITION_X);
+		const float* py = view.getLane<LocalTransform>(Lane::POSITION_Y);
+		const float* pz = view.getLane<LocalTransform>(Lane::POSITION_Z);
+		const float* qx = view.getLane<LocalTransform>(Lane::ROTATION_X);
+		const float* qy = view.getLane<LocalTransform>(Lane::ROTATION_Y);
+		const float* qz = view.getLane<LocalTransform>(Lane::ROTATION_Z);
+		const float* qw = view.getLane<LocalTransform>(Lane::ROTATION_W);
+		const float* sx = view.getLane<LocalTransform>(Lane::SCALE_X);
+		const float* sy = view.getLane<LocalTransform>(Lane::SCALE_Y);
+		const float* sz = view.getLane<LocalTransform>(Lane::SCALE_Z);
+		WorldMatrix* matrices = view.get<WorldMatrix>();
+
+		// Every lane is read with unit stride, which lets the compiler vectorize the loop
+		uint32_t count = view.size();
+		for (uint32_t i = 0; i < count; i++) {
+			float xx = qx[i] * qx[i], yy = qy[i] * qy[i], zz = qz[i] * qz[i];
+			float xy = qx[i] * qy[i], xz = qx[i] * qz[i], yz = qy[i] * qz[i];
+			float wx = qw[i] * qx[i], wy = qw[i] * qy[i], wz = qw[i] * qz[i];
+
+			float* m = matrices[i].m;
+			m[0] = (1.0f - 2.0f * (yy + zz)) * sx[i];
+			m[1] = 2.0f * (xy + wz) * sx[i];
+			m[2] = 2.0f * (xz - wy) * sx[i];
+			m[3] = 0.0f;
+			m[4] = 2.0f * (xy - wz) * sy[i];
+			m[5] = (1.0f - 2.0f * (xx + zz)) * sy[i];
+			m[6] = 2.0f * (yz + wx) * sy[i];
+			m[7] = 0.0f;
+			m[8] = 2.0f * (xz + wy) * sz[i];
+			m[9] = 2.0f * (yz - wx) * sz[i];
+			m[10] = (1.0f - 2.0f * (xx + yy)) * sz[i];
+			m[11] = 0.0f;
+			m[12] = px[i];
+			m[13] = py[i];
+			m[14] = pz[i];
+			m[15] = 1.0f;
+		}
+	}
+}
+
+void updateWorldMatrices(World& world, ThreadPool* pool)
+{
+	if (pool) {
+		world.parallelForEachChunk<LocalTransform, WorldMatrix>(*pool, updateChunk);
+	} else {
+		world.forEachChunk<LocalTransform, WorldMatrix>(updateChunk);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "World.h"
+
+// Position, rotation and scale relative to the world. Stored as one float array per field
+// so transform updates can work on several entities per instruction.
+struct LocalTransform
+{
+	float position[3];
+	// Unit quaternion x, y, z, w
+	float rotation[4];
+	float scale[3];
+
+	static constexpr bool soa = true;
+
+	// Lane indices for ChunkView::getLane
+	enum Lane : uint32_t
+	{
+		POSITION_X, POSITION_Y, POSITION_Z,
+		ROTATION_X, ROTATION_Y, ROTATION_Z, ROTATION_W,
+		SCALE_X, SCALE_Y, SCALE_Z
+	};
+};
+
+// Column major model matrix, laid out like a GLSL mat4 so a chunk's column can be copied
+// straight into an instance buffer
+struct WorldMatrix
+{
+	float m[16];
+};
+
+/**
+ * @brief Recomputes the WorldMatrix of every entity that has a LocalTransform and a WorldMatrix.
+ * 
+ * @param world - the world holding the entities
+ * @param pool - spreads chunks over its threads if provided
+ */
+void updateWorldMatrices(World& world, ThreadPool* pool = nullptr);
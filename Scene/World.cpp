@@ -0,0 +1,138 @@
+#include "World.h"
+
+#include <stdexcept>
+
+ChunkView::ChunkView(Archetype& _archetype, Chunk& _chunk) :
+	archetype(_archetype),
+	chunk(_chunk)
+{
+}
+
+uint32_t ChunkView::size()
+{
+	return chunk.count;
+}
+
+const Entity* ChunkView::getEntities()
+{
+	return archetype.getEntities(chunk);
+}
+
+World::World() :
+	archetypes{},
+	archetypeIndices{},
+	records{},
+	freeIndices{},
+	entityCount(0)
+{
+}
+
+void World::destroy(Entity entity)
+{
+	if (!isAlive(entity)) {
+		return;
+	}
+
+	EntityRecord& record = getRecord(entity);
+	removeRow(record.location);
+	record.alive = false;
+	record.generation++;
+	freeIndices.push_back(entity.index);
+	entityCount--;
+}
+
+bool World::isAlive(Entity entity)
+{
+	return entity.index < records.size()
+		&& records[entity.index].alive
+		&& records[entity.index].generation == entity.generation;
+}
+
+uint32_t World::getEntityCount()
+{
+	return entityCount;
+}
+
+uint32_t World::getArchetype(ComponentMask mask)
+{
+	auto found = archetypeIndices.find(mask);
+	if (found != archetypeIndices.end()) {
+		return found->second;
+	}
+
+	uint32_t index = static_cast<uint32_t>(archetypes.size());
+	archetypes.push_back(std::make_unique<Archetype>(mask));
+	archetypeIndices[mask] = index;
+	return index;
+}
+
+Entity World::createEntity(ComponentMask mask)
+{
+	Entity entity{};
+	if (!freeIndices.empty()) {
+		entity.index = freeIndices.back();
+		freeIndices.pop_back();
+	} else {
+		entity.index = static_cast<uint32_t>(records.size());
+		records.push_back({{0, 0, 0}, 0, false});
+	}
+
+	EntityRecord& record = records[entity.index];
+	entity.generation = record.generation;
+	uint32_t archetypeIndex = getArchetype(mask);
+	record.location = archetypes[archetypeIndex]->allocate(entity);
+	record.location.archetype = archetypeIndex;
+	record.alive = true;
+	entityCount++;
+	return entity;
+}
+
+World::EntityRecord& World::getRecord(Entity entity)
+{
+	if (!isAlive(entity)) {
+		throw std::runtime_error("entity was destroyed");
+	}
+	return records[entity.index];
+}
+
+void World::moveEntity(Entity entity, ComponentMask mask)
+{
+	EntityRecord& record = getRecord(entity);
+	EntityLocation oldLocation = record.location;
+	if (archetypes[oldLocation.archetype]->getMask() == mask) {
+		return;
+	}
+
+	uint32_t archetypeIndex = getArchetype(mask);
+	// getArchetype may add an archetype, so references are only taken afterwards
+	Archetype& source = *archetypes[oldLocation.archetype];
+	Archetype& destination = *archetypes[archetypeIndex];
+
+	EntityLocation newLocation = destination.allocate(entity);
+	newLocation.archetype = archetypeIndex;
+	source.copyRow(oldLocation.chunk, oldLocation.row, destination, newLocation.chunk, newLocation.row);
+	removeRow(oldLocation);
+	record.location = newLocation;
+}
+
+void World::removeRow(EntityLocation location)
+{
+	Entity moved = archetypes[location.archetype]->remove(location.chunk, location.row);
+	EntityRecord& movedRecord = records[moved.index];
+	if (movedRecord.location.archetype == location.archetype
+		&& (movedRecord.location.chunk != location.chunk || movedRecord.location.row != location.row)) {
+		movedRecord.location = location;
+	}
+}
+
+void World::collectChunks(ComponentMask mask, std::vector<std::pair<Archetype*, Chunk*>>& chunks)
+{
+	for (auto& archetype : archetypes) {
+		if ((archetype->getMask() & mask) != mask) {
+			continue;
+		}
+		for (uint32_t i = 0; i < archetype->getChunkCount(); i++) {
+			chunks.emplace_back(archetype.get(), &archetype->getChunk(i));
+		}
+	}
+}
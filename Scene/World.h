@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "Component.h"
+#include "Entity.h"
+#include "Archetype.h"
+
+// Access to the components of the entities in one chunk
+class ChunkView
+{
+public:
+	ChunkView(Archetype& archetype, Chunk& chunk);
+
+	/**
+	 * @brief Returns the number of entities in the chunk
+	 */
+	uint32_t size();
+
+	const Entity* getEntities();
+
+	/**
+	 * @brief Returns the column of a struct component, one element per entity
+	 */
+	template<typename T>
+	T* get();
+
+	/**
+	 * @brief Returns one field of an SoA component for every entity,
+	 * lane i is the i-th float in the component's struct
+	 */
+	template<typename T>
+	float* getLane(uint32_t lane);
+
+private:
+	Archetype& archetype;
+	Chunk& chunk;
+};
+
+// Owns every entity and its components, stored in archetype chunks
+class World
+{
+public:
+	World();
+
+	/**
+	 * @brief Creates an entity with the specified components
+	 */
+	template<typename... Ts>
+	Entity create(const Ts&... components);
+
+	/**
+	 * @brief Destroys an entity and its components. Does nothing if the entity is already destroyed.
+	 */
+	void destroy(Entity entity);
+
+	/**
+	 * @brief Returns whether the entity hasn't been destroyed
+	 */
+	bool isAlive(Entity entity);
+
+	template<typename T>
+	bool has(Entity entity);
+
+	/**
+	 * @brief Returns a copy of an entity's component. The entity must have the component.
+	 */
+	template<typename T>
+	T get(Entity entity);
+
+	/**
+	 * @brief Overwrites a component the entity already has
+	 */
+	template<typename T>
+	void set(Entity entity, const T& component);
+
+	/**
+	 * @brief Adds a component to an entity, moving it to another archetype.
+	 * Overwrites the component if the entity already has it.
+	 */
+	template<typename T>
+	void add(Entity entity, const T& component);
+
+	/**
+	 * @brief Removes a component from an entity, moving it to another archetype
+	 */
+	template<typename T>
+	void remove(Entity entity);
+
+	/**
+	 * @brief Calls func(ChunkView&) for every chunk whose entities have all the specified components
+	 */
+	template<typename... Ts, typename F>
+	void forEachChunk(F&& func);
+
+	/**
+	 * @brief Same as forEachChunk but chunks are spread over the pool's threads.
+	 * Entities must not be created, destroyed or change components during the call.
+	 */
+	template<typename... Ts, typename F>
+	void parallelForEachChunk(ThreadPool& pool, F&& func);
+
+	/**
+	 * @brief Copies a struct component of every entity that has it into tightly packed memory,
+	 * such as a mapped instance buffer. Each chunk's column is copied with a single memcpy.
+	 * 
+	 * @param destination - memory with room for maxCount components
+	 * @param maxCount - number of components that fit in destination
+	 * 
+	 * @return number of components copied
+	 */
+	template<typename T>
+	uint32_t copyComponents(void* destination, uint32_t maxCount);
+
+	/**
+	 * @brief Returns the number of alive entities
+	 */
+	uint32_t getEntityCount();
+
+private:
+	struct EntityRecord
+	{
+		EntityLocation location;
+		uint32_t generation;
+		bool alive;
+	};
+
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	std::unordered_map<ComponentMask, uint32_t> archetypeIndices;
+	std::vector<EntityRecord> records;
+	std::vector<uint32_t> freeIndices;
+	uint32_t entityCount;
+
+	uint32_t getArchetype(ComponentMask mask);
+	Entity createEntity(ComponentMask mask);
+	EntityRecord& getRecord(Entity entity);
+
+	// Moves an entity to the archetype with the specified mask, keeping the components both have
+	void moveEntity(Entity entity, ComponentMask mask);
+
+	// Removes the row of a record from its archetype and fixes the record of the entity moved into it
+	void removeRow(EntityLocation location);
+
+	void collectChunks(ComponentMask mask, std::vector<std::pair<Archetype*, Chunk*>>& chunks);
+};
+
+template<typename T>
+T* ChunkView::get()
+{
+	static_assert(!IsSoA<T>::value, "SoA components are accessed with getLane");
+	return reinterpret_cast<T*>(archetype.getColumn(chunk, ComponentRegistry::getId<T>()));
+}
+
+template<typename T>
+float* ChunkView::getLane(uint32_t lane)
+{
+	static_assert(IsSoA<T>::value, "struct components are accessed with get");
+	return reinterpret_cast<float*>(archetype.getColumn(chunk, ComponentRegistry::getId<T>()) + lane * archetype.getLaneStride());
+}
+
+template<typename... Ts>
+Entity World::create(const Ts&... components)
+{
+	Entity entity = createEntity(makeComponentMask<Ts...>());
+	EntityLocation location = getRecord(entity).location;
+	Archetype& archetype = *archetypes[location.archetype];
+	(archetype.writeComponent(location.chunk, location.row, ComponentRegistry::getId<Ts>(), &components), ...);
+	return entity;
+}
+
+template<typename T>
+bool World::has(Entity entity)
+{
+	return isAlive(entity)
+		&& (archetypes[getRecord(entity).location.archetype]->getMask() & makeComponentMask<T>()) != 0;
+}
+
+template<typename T>
+T World::get(Entity entity)
+{
+	EntityLocation location = getRecord(entity).location;
+	T component;
+	archetypes[location.archetype]->readComponent(location.chunk, location.row, ComponentRegistry::getId<T>(), &component);
+	return component;
+}
+
+template<typename T>
+void World::set(Entity entity, const T& component)
+{
+	EntityLocation location = getRecord(entity).location;
+	archetypes[location.archetype]->writeComponent(location.chunk, location.row, ComponentRegistry::getId<T>(), &component);
+}
+
+template<typename T>
+void World::add(Entity entity, const T& component)
+{
+	ComponentMask mask = archetypes[getRecord(entity).location.archetype]->getMask();
+	moveEntity(entity, mask | makeComponentMask<T>());
+	set(entity, component);
+}
+
+template<typename T>
+void World::remove(Entity entity)
+{
+	ComponentMask mask = archetypes[getRecord(entity).location.archetype]->getMask();
+	moveEntity(entity, mask & ~makeComponentMask<T>());
+}
+
+template<typename... Ts, typename F>
+void World::forEachChunk(F&& func)
+{
+	std::vector<std::pair<Archetype*, Chunk*>> chunks;
+	collectChunks(makeComponentMask<Ts...>(), chunks);
+	for (auto& [archetype, chunk] : chunks) {
+		ChunkView view(*archetype, *chunk);
+		func(view);
+	}
+}
+
+template<typename... Ts, typename F>
+void World::parallelForEachChunk(ThreadPool& pool, F&& func)
+{
+	std::vector<std::pair<Archetype*, Chunk*>> chunks;
+	collectChunks(makeComponentMask<Ts...>(), chunks);
+	pool.parallelFor(static_cast<uint32_t>(chunks.size()), [&](uint32_t i) {
+		ChunkView view(*chunks[i].first, *chunks[i].second);
+		func(view);
+	});
+}
+
+template<typename T>
+uint32_t World::copyComponents(void* destination, uint32_t maxCount)
+{
+	static_assert(!IsSoA<T>::value, "only struct components are stored contiguously");
+
+	uint32_t copied = 0;
+	forEachChunk<T>([&](ChunkView& view) {
+		uint32_t count = view.size();
+		if (count > maxCount - copied) {
+			count = maxCount - copied;
+		}
+		std::memcpy(static_cast<T*>(destination) + copied, view.get<T>(), sizeof(T) * count);
+		copied += count;
+	});
+	return copied;
+}
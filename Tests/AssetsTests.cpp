@@ -0,0 +1,429 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "AsyncFileReader.h"
+#include "MeshFile.h"
+#include "Buffer.h"
+#include "AssetLoader.h"
+#include "TestDevice.h"
+
+namespace
+{
+	constexpr uint32_t FILE_SIZE = 1024 * 1024 + 123;
+
+	// File in the temporary directory holding a byte pattern that differs at every offset modulo 251,
+	// removed again by the destructor
+	struct TempFile
+	{
+		std::string path;
+		std::vector<std::byte> data;
+
+		TempFile(const std::string& name, uint32_t size) :
+			path((std::filesystem::temp_directory_path() / name).string()),
+			data(size)
+		{
+			for (uint32_t i = 0; i < size; i++) {
+				data[i] = static_cast<std::byte>(i % 251);
+			}
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		}
+
+		~TempFile()
+		{
+			std::error_code error;
+			std::filesystem::remove(path, error);
+		}
+	};
+
+	// Parameter is whether io_uring is allowed, it still falls back to pread where the kernel doesn't allow it
+	class AsyncFileReaderTest : public ::testing::TestWithParam<bool>
+	{
+	protected:
+		ThreadPool threadPool;
+		std::unique_ptr<TempFile> file;
+		FileHandle handle{};
+
+		void SetUp() override
+		{
+			threadPool.init(4);
+			file = std::make_unique<TempFile>("AssetsTests_reader_" + std::to_string(GetParam()), FILE_SIZE);
+			uint64_t size = 0;
+			handle = AsyncFileReader::openFile(file->path, size);
+			ASSERT_EQ(size, FILE_SIZE);
+		}
+
+		void TearDown() override
+		{
+			if (file) {
+				AsyncFileReader::closeFile(handle);
+			}
+		}
+
+		// Polls until no read is in flight, returns every completion
+		static std::vector<ReadCompletion> drain(AsyncFileReader& reader)
+		{
+			std::vector<ReadCompletion> completions;
+			while (reader.getInFlightCount() > 0) {
+				reader.poll(completions, true);
+			}
+			return completions;
+		}
+	};
+
+	TEST_P(AsyncFileReaderTest, ReadsWholeFileInChunks)
+	{
+		constexpr uint32_t CHUNK = 4096;
+		AsyncFileReader reader;
+		reader.init(threadPool, 8, GetParam());
+		std::vector<std::byte> result(FILE_SIZE);
+
+		// Keeps the queue full until every chunk was queued, the last chunk is short
+		uint32_t chunkCount = (FILE_SIZE + CHUNK - 1) / CHUNK;
+		uint32_t next = 0;
+		std::vector<ReadCompletion> completions;
+		while (next < chunkCount || reader.getInFlightCount() > 0) {
+			while (next < chunkCount && reader.queueRead(handle, uint64_t(next) * CHUNK, CHUNK, result.data() + uint64_t(next) * CHUNK, next)) {
+				next++;
+			}
+			reader.poll(completions, true);
+		}
+
+		ASSERT_EQ(completions.size(), chunkCount);
+		for (const ReadCompletion& completion : completions) {
+			uint32_t expected = std::min(CHUNK, FILE_SIZE - static_cast<uint32_t>(completion.userData) * CHUNK);
+			ASSERT_EQ(completion.result, expected) << "chunk " << completion.userData;
+		}
+		ASSERT_TRUE(result == file->data);
+	}
+
+	TEST_P(AsyncFileReaderTest, ReadsAtTheEndAreShort)
+	{
+		AsyncFileReader reader;
+		reader.init(threadPool, 4, GetParam());
+		std::vector<std::byte> result(100);
+		ASSERT_TRUE(reader.queueRead(handle, FILE_SIZE - 10, 100, result.data(), 0));
+		ASSERT_TRUE(reader.queueRead(handle, FILE_SIZE + 10, 100, result.data() + 50, 1));
+
+		std::vector<ReadCompletion> completions = drain(reader);
+		ASSERT_EQ(completions.size(), 2u);
+		for (const ReadCompletion& completion : completions) {
+			ASSERT_EQ(completion.result, completion.userData == 0 ? 10 : 0);
+		}
+		ASSERT_EQ(std::memcmp(result.data(), file->data.data() + FILE_SIZE - 10, 10), 0);
+	}
+
+	TEST_P(AsyncFileReaderTest, RefusesReadsPastQueueDepth)
+	{
+		AsyncFileReader reader;
+		reader.init(threadPool, 2, GetParam());
+		std::vector<std::byte> result(3 * 16);
+		ASSERT_TRUE(reader.queueRead(handle, 0, 16, result.data(), 0));
+		ASSERT_TRUE(reader.queueRead(handle, 16, 16, result.data() + 16, 1));
+		ASSERT_FALSE(reader.queueRead(handle, 32, 16, result.data() + 32, 2));
+		ASSERT_EQ(reader.getInFlightCount(), 2u);
+
+		ASSERT_EQ(drain(reader).size(), 2u);
+		ASSERT_TRUE(reader.queueRead(handle, 32, 16, result.data() + 32, 2));
+		ASSERT_EQ(drain(reader).size(), 1u);
+	}
+
+	TEST_P(AsyncFileReaderTest, CancelledReadsAreReported)
+	{
+		AsyncFileReader reader;
+		reader.init(threadPool, 4, GetParam());
+		std::vector<std::byte> result(FILE_SIZE);
+		ASSERT_TRUE(reader.queueRead(handle, 0, FILE_SIZE, result.data(), 7));
+		reader.cancel(7);
+
+		std::vector<ReadCompletion> completions = drain(reader);
+		ASSERT_EQ(completions.size(), 1u);
+		ASSERT_EQ(completions[0].userData, 7u);
+		// The read may have finished before the cancel reached it
+		ASSERT_TRUE(completions[0].result == -ECANCELED || completions[0].result == FILE_SIZE) << completions[0].result;
+	}
+
+	// Cancels take submission entries without counting as reads, so enough of them fill both rings while nobody
+	// polls. Kernels that refuse submissions while the completion queue overflows need queueing to reap
+	// completions to make progress, newer ones keep the overflow and there this checks that none are lost.
+	TEST_P(AsyncFileReaderTest, ManyCancelsDontStallTheQueue)
+	{
+		AsyncFileReader reader;
+		reader.init(threadPool, 4, GetParam());
+		std::vector<std::byte> result(4 * 4096);
+		for (uint32_t i = 0; i < 4; i++) {
+			ASSERT_TRUE(reader.queueRead(handle, uint64_t(i) * 4096, 4096, result.data() + i * 4096, i));
+		}
+		for (uint32_t i = 0; i < 1000; i++) {
+			reader.cancel(1000 + i);
+		}
+
+		std::vector<ReadCompletion> completions = drain(reader);
+		ASSERT_EQ(completions.size(), 4u);
+		for (const ReadCompletion& completion : completions) {
+			ASSERT_EQ(completion.result, 4096);
+		}
+		ASSERT_EQ(std::memcmp(result.data(), file->data.data(), result.size()), 0);
+	}
+
+	INSTANTIATE_TEST_SUITE_P(Readers, AsyncFileReaderTest, ::testing::Values(false, true),
+		[](const ::testing::TestParamInfo<bool>& parameter) { return parameter.param ? "IoUring" : "Fallback"; });
+
+	// Written mesh with a few indices, the stride of the index section is patched to the size of a uint16_t
+	// so it looks like a file whose indices were written with a different type
+	TEST(MeshFileTest, RejectsSectionsOfADifferentElementSize)
+	{
+		std::string path = (std::filesystem::temp_directory_path() / "AssetsTests_mesh.amesh").string();
+		MeshData mesh;
+		mesh.vertices.resize(3);
+		mesh.indices = {0, 1, 2, 2, 1, 0};
+		MeshFile::write(path, mesh);
+
+		{
+			MeshFile file;
+			file.init(path);
+			uint32_t count = 0;
+			const uint32_t* indices = file.getIndices(count);
+			ASSERT_EQ(count, mesh.indices.size());
+			ASSERT_TRUE(std::equal(indices, indices + count, mesh.indices.begin()));
+		}
+
+		{
+			std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+			MeshFileHeader header{};
+			stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+			for (uint32_t i = 0; i < header.sectionCount; i++) {
+				std::streamoff position = static_cast<std::streamoff>(sizeof(MeshFileHeader) + i * sizeof(MeshSectionEntry));
+				MeshSectionEntry entry{};
+				stream.seekg(position);
+				stream.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+				if (entry.type == static_cast<uint32_t>(MeshSection::INDICES)) {
+					entry.stride = sizeof(uint16_t);
+					stream.seekp(position);
+					stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+				}
+			}
+		}
+
+		{
+			MeshFile file;
+			file.init(path);
+			uint32_t count = 0;
+			ASSERT_THROW(file.getIndices(count), std::runtime_error);
+			// Sections that still match are read as before
+			ASSERT_NE(file.getVertices(count), nullptr);
+			ASSERT_EQ(count, mesh.vertices.size());
+		}
+		std::filesystem::remove(path);
+	}
+
+	class AssetLoaderTest : public DeviceTest<>
+	{
+	protected:
+		ThreadPool threadPool;
+		std::unique_ptr<TempFile> file;
+		std::vector<LoadResult> results;
+		// Copies of the loaded bytes, LoadResult::data is only valid during the callback
+		std::vector<std::vector<std::byte>> loaded;
+
+		void SetUp() override
+		{
+			DeviceTest::SetUp();
+			if (IsSkipped() || HasFatalFailure()) {
+				return;
+			}
+			threadPool.init(4);
+			file = std::make_unique<TempFile>("AssetsTests_loader", FILE_SIZE);
+		}
+
+		// Small reads so every load is split into many
+		static AssetLoaderSettings getSettings()
+		{
+			AssetLoaderSettings settings;
+			settings.readSize = 64 * 1024;
+			settings.stagingSize = 256 * 1024;
+			return settings;
+		}
+
+		// Host visible buffer the file fits in at offset 16
+		void initDestination(Buffer& destination)
+		{
+			LogicalDevice& device = shared->device;
+			std::vector<uint32_t> queueFamilies = {device.getGraphicsFamilyIndex()};
+			if (device.getTransferFamilyIndex() != device.getGraphicsFamilyIndex()) {
+				queueFamilies.push_back(device.getTransferFamilyIndex());
+			}
+			destination.init(device, FILE_SIZE + 16, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, queueFamilies);
+		}
+
+		LoadRequest makeRequest(uint64_t offset = 0, uint64_t size = 0)
+		{
+			LoadRequest request;
+			request.path = file->path;
+			request.offset = offset;
+			request.size = size;
+			request.callback = [this](const LoadResult& result) {
+				results.push_back(result);
+				results.back().data = nullptr;
+				loaded.emplace_back(result.data, result.data + (result.data != nullptr ? result.size : 0));
+			};
+			return request;
+		}
+	};
+
+	TEST_F(AssetLoaderTest, LoadsFilesAndRanges)
+	{
+		AssetLoader loader;
+		loader.init(shared->device, shared->scheduler, threadPool, getSettings());
+		uint64_t whole = loader.load(makeRequest());
+		uint64_t range = loader.load(makeRequest(1000, 300000));
+		loader.waitIdle();
+
+		ASSERT_EQ(results.size(), 2u);
+		for (size_t i = 0; i < results.size(); i++) {
+			ASSERT_EQ(results[i].status, LoadStatus::COMPLETE) << results[i].error;
+			uint64_t offset = results[i].id == whole ? 0 : 1000;
+			uint64_t size = results[i].id == whole ? FILE_SIZE : 300000;
+			ASSERT_TRUE(results[i].id == whole || results[i].id == range);
+			ASSERT_EQ(results[i].size, size);
+			ASSERT_TRUE(std::equal(loaded[i].begin(), loaded[i].end(), file->data.begin() + offset));
+		}
+		ASSERT_TRUE(loader.isIdle());
+		ASSERT_EQ(loader.getStats().completedLoads, 2u);
+		ASSERT_EQ(loader.getStats().inFlightBytes, 0u);
+	}
+
+	TEST_F(AssetLoaderTest, ReportsFailures)
+	{
+		AssetLoader loader;
+		loader.init(shared->device, shared->scheduler, threadPool, getSettings());
+		LoadRequest missing = makeRequest();
+		missing.path = file->path + ".missing";
+		loader.load(std::move(missing));
+		loader.load(makeRequest(FILE_SIZE - 10, 100));
+		loader.waitIdle();
+
+		ASSERT_EQ(results.size(), 2u);
+		for (const LoadResult& result : results) {
+			ASSERT_EQ(result.status, LoadStatus::FAILED);
+			ASSERT_FALSE(result.error.empty());
+		}
+		ASSERT_EQ(loader.getStats().failedLoads, 2u);
+	}
+
+	TEST_F(AssetLoaderTest, CancelsLoads)
+	{
+		AssetLoader loader;
+		loader.init(shared->device, shared->scheduler, threadPool, getSettings());
+		uint64_t queued = loader.load(makeRequest());
+		ASSERT_TRUE(loader.cancel(queued));
+		uint64_t started = loader.load(makeRequest());
+		loader.update();
+		bool cancelled = loader.cancel(started);
+		loader.waitIdle();
+
+		ASSERT_EQ(results.size(), 2u);
+		ASSERT_EQ(results[0].id, queued);
+		ASSERT_EQ(results[0].status, LoadStatus::CANCELLED);
+		// The second load may already have finished within the update
+		ASSERT_EQ(results[1].status, cancelled ? LoadStatus::CANCELLED : LoadStatus::COMPLETE);
+		ASSERT_FALSE(loader.cancel(started));
+	}
+
+	// With a budget of a single load, loads run one at a time in priority order, and a load bigger
+	// than the whole budget still runs once nothing else is in flight
+	TEST_F(AssetLoaderTest, KeepsToPriorityAndBudget)
+	{
+		AssetLoaderSettings settings = getSettings();
+		settings.memoryBudget = 200000;
+		AssetLoader loader;
+		loader.init(shared->device, shared->scheduler, threadPool, settings);
+		LoadRequest low = makeRequest(0, 200000);
+		low.priority = LoadPriority::LOW;
+		LoadRequest high = makeRequest(0, 200000);
+		high.priority = LoadPriority::HIGH;
+		LoadRequest large = makeRequest();
+		large.priority = LoadPriority::LOW;
+		uint64_t lowId = loader.load(std::move(low));
+		uint64_t highId = loader.load(std::move(high));
+		uint64_t largeId = loader.load(std::move(large));
+		loader.waitIdle();
+
+		ASSERT_EQ(results.size(), 3u);
+		ASSERT_EQ(results[0].id, highId);
+		ASSERT_EQ(results[1].id, lowId);
+		ASSERT_EQ(results[2].id, largeId);
+		for (const LoadResult& result : results) {
+			ASSERT_EQ(result.status, LoadStatus::COMPLETE) << result.error;
+		}
+		ASSERT_EQ(loader.getStats().peakInFlightBytes, FILE_SIZE);
+	}
+
+	TEST_F(AssetLoaderTest, UploadsToBuffers)
+	{
+		Buffer destination;
+		initDestination(destination);
+
+		// Larger than the staging buffer, so the upload is split too
+		AssetLoader loader;
+		loader.init(shared->device, shared->scheduler, threadPool, getSettings());
+		LoadRequest request = makeRequest();
+		request.destination = destination.getHandle();
+		request.destinationOffset = 16;
+		loader.load(std::move(request));
+		loader.waitIdle();
+
+		ASSERT_EQ(results.size(), 1u);
+		ASSERT_EQ(results[0].status, LoadStatus::COMPLETE) << results[0].error;
+		ASSERT_TRUE(loaded[0].empty());
+		const std::byte* uploaded = static_cast<const std::byte*>(destination.getMapped()) + 16;
+		ASSERT_TRUE(std::equal(file->data.begin(), file->data.end(), uploaded));
+		ASSERT_EQ(loader.getStats().bytesUploaded, FILE_SIZE);
+	}
+
+	// Chunks submitted before the cancel keep copying into the destination, so the callback may only come
+	// once they finished. It copies the destination when called, which has to hold every submitted chunk.
+	TEST_F(AssetLoaderTest, CancelledUploadsWaitForSubmittedChunks)
+	{
+		Buffer destination;
+		initDestination(destination);
+		const std::byte* uploaded = static_cast<const std::byte*>(destination.getMapped()) + 16;
+
+		AssetLoader loader;
+		loader.init(shared->device, shared->scheduler, threadPool, getSettings());
+		LoadRequest request = makeRequest();
+		request.destination = destination.getHandle();
+		request.destinationOffset = 16;
+		std::vector<std::byte> atCallback;
+		request.callback = [this, uploaded, &atCallback](const LoadResult& result) {
+			results.push_back(result);
+			atCallback.assign(uploaded, uploaded + FILE_SIZE);
+		};
+		uint64_t id = loader.load(std::move(request));
+		while (loader.getStats().bytesUploaded == 0) {
+			ASSERT_TRUE(results.empty());
+			loader.update();
+		}
+		uint64_t submitted = loader.getStats().bytesUploaded;
+		ASSERT_LT(submitted, FILE_SIZE);
+		ASSERT_TRUE(loader.cancel(id));
+		loader.waitIdle();
+
+		ASSERT_EQ(results.size(), 1u);
+		ASSERT_EQ(results[0].status, LoadStatus::CANCELLED);
+		ASSERT_TRUE(std::equal(file->data.begin(), file->data.begin() + submitted, atCallback.begin()));
+	}
+}
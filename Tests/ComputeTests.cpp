@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Buffer.h"
+#include "DebugMessenger.h"
+#include "ParallelPrimitives.h"
+#include "TestDevice.h"
+
+namespace
+{
+	// Sizes that aren't multiples of BLOCK_SIZE, and 1024 * 1024 + 1 which needs three scan levels
+	const uint32_t SIZES[] = {1, 1000, ParallelPrimitives::BLOCK_SIZE, 1025, 5000, 1024 * 1024 + 1};
+
+	class ParallelPrimitivesTest : public DeviceTest<::testing::TestWithParam<uint32_t>>
+	{
+	protected:
+		uint32_t count = GetParam();
+		VkDeviceSize size = sizeof(uint32_t) * count;
+		VkCommandPool commandPool = nullptr;
+		VkCommandBuffer commandBuffer = nullptr;
+		ParallelPrimitives primitives;
+
+		void SetUp() override
+		{
+			DeviceTest::SetUp();
+			if (IsSkipped() || HasFatalFailure()) {
+				return;
+			}
+			LogicalDevice& device = shared->device;
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = device.getComputeFamilyIndex();
+			VK_CHECK(device.getDispatch().vkCreateCommandPool(device.getHandle(), &poolInfo, device.getAllocator(), &commandPool));
+			VkCommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.commandPool = commandPool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocateInfo.commandBufferCount = 1;
+			VK_CHECK(device.getDispatch().vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &commandBuffer));
+			primitives.init(device, count);
+		}
+
+		void TearDown() override
+		{
+			if (commandPool != nullptr) {
+				LogicalDevice& device = shared->device;
+				device.getDispatch().vkDestroyCommandPool(device.getHandle(), commandPool, device.getAllocator());
+			}
+		}
+
+		// Host visible buffer of count elements, filled with data if it isn't empty
+		void initBuffer(Buffer& buffer, const std::vector<uint32_t>& data)
+		{
+			buffer.init(shared->device, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (!data.empty()) {
+				std::memcpy(buffer.getMapped(), data.data(), size);
+			}
+		}
+
+		void begin()
+		{
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VK_CHECK(shared->device.getDispatch().vkBeginCommandBuffer(commandBuffer, &beginInfo));
+		}
+
+		// Makes the results visible to the host, submits and waits
+		void submit()
+		{
+			const DeviceDispatch& dispatch = shared->device.getDispatch();
+			VkMemoryBarrier hostBarrier{};
+			hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			hostBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+				0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+			VK_CHECK(dispatch.vkEndCommandBuffer(commandBuffer));
+
+			VkQueue queue = shared->device.getComputeQueue();
+			SubmitBatch batch;
+			batch.commandBuffers = {commandBuffer};
+			shared->scheduler.wait(queue, shared->scheduler.enqueue(queue, std::move(batch)));
+		}
+
+		// Small elements for the scan and the sum so the comparison isn't about wrapping
+		std::vector<uint32_t> makeInput(uint32_t modulo)
+		{
+			std::mt19937 random(count);
+			std::vector<uint32_t> input(count);
+			for (uint32_t& value : input) {
+				value = modulo != 0 ? static_cast<uint32_t>(random() % modulo) : static_cast<uint32_t>(random());
+			}
+			return input;
+		}
+
+		static const uint32_t* getData(Buffer& buffer)
+		{
+			return static_cast<const uint32_t*>(buffer.getMapped());
+		}
+	};
+
+	TEST_P(ParallelPrimitivesTest, ExclusiveScan)
+	{
+		std::vector<uint32_t> input = makeInput(1024);
+		Buffer source;
+		initBuffer(source, input);
+		Buffer result;
+		initBuffer(result, {});
+
+		begin();
+		primitives.recordExclusiveScan(commandBuffer, source.getHandle(), result.getHandle(), count);
+		submit();
+
+		std::vector<uint32_t> expected(count);
+		std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+		std::vector<uint32_t> actual(getData(result), getData(result) + count);
+		ASSERT_EQ(actual, expected);
+	}
+
+	TEST_P(ParallelPrimitivesTest, ExclusiveScanInPlace)
+	{
+		std::vector<uint32_t> input = makeInput(1024);
+		Buffer data;
+		initBuffer(data, input);
+
+		begin();
+		primitives.recordExclusiveScan(commandBuffer, data.getHandle(), data.getHandle(), count);
+		submit();
+
+		std::vector<uint32_t> expected(count);
+		std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+		std::vector<uint32_t> actual(getData(data), getData(data) + count);
+		ASSERT_EQ(actual, expected);
+	}
+
+	TEST_P(ParallelPrimitivesTest, Reduce)
+	{
+		std::vector<uint32_t> input = makeInput(1024);
+		Buffer source;
+		initBuffer(source, input);
+		Buffer result;
+		initBuffer(result, {});
+
+		begin();
+		primitives.recordReduce(commandBuffer, source.getHandle(), result.getHandle(), count);
+		submit();
+
+		ASSERT_EQ(getData(result)[0], std::accumulate(input.begin(), input.end(), 0u));
+	}
+
+	TEST_P(ParallelPrimitivesTest, RadixSort)
+	{
+		// Few distinct keys so the stability of equal keys is tested too
+		std::vector<uint32_t> input = makeInput(count / 4 + 1);
+		std::vector<uint32_t> indices(count);
+		std::iota(indices.begin(), indices.end(), 0u);
+		Buffer keys;
+		initBuffer(keys, input);
+		Buffer values;
+		initBuffer(values, indices);
+
+		begin();
+		primitives.recordRadixSort(commandBuffer, keys.getHandle(), values.getHandle(), count);
+		submit();
+
+		// values holds the original index of every key, so a stable sort of them by key is the expected order
+		std::stable_sort(indices.begin(), indices.end(), [&input](uint32_t a, uint32_t b) { return input[a] < input[b]; });
+		for (uint32_t i = 0; i < count; i++) {
+			ASSERT_EQ(getData(keys)[i], input[indices[i]]) << "key at " << i;
+			ASSERT_EQ(getData(values)[i], indices[i]) << "value at " << i;
+		}
+	}
+
+	TEST_P(ParallelPrimitivesTest, RadixSortKeysOnly)
+	{
+		// Full 32 bit keys so every pass moves elements
+		std::vector<uint32_t> input = makeInput(0);
+		Buffer keys;
+		initBuffer(keys, input);
+
+		begin();
+		primitives.recordRadixSort(commandBuffer, keys.getHandle(), VK_NULL_HANDLE, count);
+		submit();
+
+		std::sort(input.begin(), input.end());
+		std::vector<uint32_t> actual(getData(keys), getData(keys) + count);
+		ASSERT_EQ(actual, input);
+	}
+
+	INSTANTIATE_TEST_SUITE_P(Sizes, ParallelPrimitivesTest, ::testing::ValuesIn(SIZES));
+}
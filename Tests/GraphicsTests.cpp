@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "TextureStreamer.h"
+#include "TestDevice.h"
+
+namespace
+{
+	// Square RGBA8 texture whose texels hold their mip level, remembers which levels were read
+	class MipSource : public TextureSource
+	{
+	public:
+		StreamedTextureInfo info;
+		std::vector<uint32_t> reads;
+
+		explicit MipSource(uint32_t size)
+		{
+			info.extent = {size, size};
+			info.format = VK_FORMAT_R8G8B8A8_UNORM;
+			info.texelSize = 4;
+			info.mipLevels = 1;
+			while ((size >> info.mipLevels) != 0) {
+				info.mipLevels++;
+			}
+			info.source = this;
+		}
+
+		void readMip(uint32_t mip, void* destination) override
+		{
+			uint32_t side = std::max(info.extent.width >> mip, 1u);
+			std::memset(destination, static_cast<int>(mip), static_cast<size_t>(side) * side * info.texelSize);
+			reads.push_back(mip);
+		}
+
+		bool wasRead(uint32_t mip) const
+		{
+			return std::find(reads.begin(), reads.end(), mip) != reads.end();
+		}
+	};
+
+	// Byte counts below are for RGBA8 chains without sparse residency, where an upload holds every mip from
+	// its target on: a 64x64 chain is 21844 bytes and its chain from mip 1 is 5460, a 128x128 chain from mip 1
+	// is 21844 and a 256x256 chain from mip 1 is 87380.
+	class TextureStreamerTest : public DeviceTest<>
+	{
+	protected:
+		TextureStreamer streamer;
+
+		static StreamingSettings getSettings(VkDeviceSize stagingSize)
+		{
+			StreamingSettings settings;
+			settings.budget = 64 * 1024 * 1024;
+			settings.residentTailSize = 16;
+			settings.stagingSize = stagingSize;
+			settings.maxTextures = 16;
+			settings.useSparse = false;
+			return settings;
+		}
+
+		// One update whose uploads are finished before returning, they land in the next update
+		void updateAndWait()
+		{
+			streamer.update();
+			LogicalDevice& device = shared->device;
+			device.getDispatch().vkDeviceWaitIdle(device.getHandle());
+		}
+
+		void updateUntilIdle()
+		{
+			for (uint32_t i = 0; i < 100; i++) {
+				updateAndWait();
+				if (streamer.getStats().pendingTextures == 0) {
+					return;
+				}
+			}
+			FAIL() << "uploads are still pending after 100 updates";
+		}
+	};
+
+	// The 256x256 chain can't ever fit in the 64 KiB staging buffer and must neither stall nor hold back
+	// the texture after it
+	TEST_F(TextureStreamerTest, ClampsChainsBiggerThanStaging)
+	{
+		streamer.init(shared->device, shared->scheduler, getSettings(64 * 1024));
+		MipSource big(256), small(64);
+		TextureHandle bigTexture = streamer.addTexture(big.info);
+		TextureHandle smallTexture = streamer.addTexture(small.info);
+
+		streamer.requestMip(bigTexture, 0);
+		streamer.requestMip(smallTexture, 0);
+		updateUntilIdle();
+
+		ASSERT_EQ(streamer.getResidentMip(smallTexture), 0u);
+		ASSERT_EQ(streamer.getResidentMip(bigTexture), 2u);
+		ASSERT_FALSE(big.wasRead(0));
+		ASSERT_FALSE(big.wasRead(1));
+	}
+
+	// The first two uploads leave 5464 of 49152 bytes, enough for the third texture's chain from mip 1 but not
+	// for its whole chain, so it's uploaded in two steps
+	TEST_F(TextureStreamerTest, SplitsUploadsWhenStagingIsFull)
+	{
+		streamer.init(shared->device, shared->scheduler, getSettings(48 * 1024));
+		MipSource first(128), second(64), third(64);
+		TextureHandle handles[] = {streamer.addTexture(first.info), streamer.addTexture(second.info), streamer.addTexture(third.info)};
+		for (TextureHandle handle : handles) {
+			streamer.requestMip(handle, 0);
+		}
+
+		updateAndWait();
+		ASSERT_EQ(streamer.getStats().pendingTextures, 3u);
+		updateAndWait();
+		ASSERT_EQ(streamer.getResidentMip(handles[0]), 1u);
+		ASSERT_EQ(streamer.getResidentMip(handles[1]), 0u);
+		ASSERT_EQ(streamer.getResidentMip(handles[2]), 1u);
+		ASSERT_EQ(streamer.getStats().pendingTextures, 1u);
+
+		updateUntilIdle();
+		ASSERT_EQ(streamer.getResidentMip(handles[2]), 0u);
+	}
+}
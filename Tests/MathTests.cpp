@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "MathBatch.h"
+
+// Found by GoogleTest through the namespace of SimdLevel, names the level in test output
+void PrintTo(SimdLevel level, std::ostream* stream)
+{
+	*stream << getSimdLevelName(level);
+}
+
+namespace
+{
+	// Sizes around the widths of the vector kernels, so the tail loops run too
+	const size_t SIZES[] = {0, 1, 7, 9, 1023};
+
+	// Written past the last output, the kernels must leave it untouched
+	constexpr size_t GUARD = 8;
+	constexpr uint8_t GUARD_BYTE = 0xCD;
+
+	struct MathInputs
+	{
+		std::vector<Mat4> a, b;
+		std::vector<Vec3> points;
+		std::vector<float> x, y, z, radius;
+		std::vector<float> maxX, maxY, maxZ;
+		Frustum frustum;
+
+		explicit MathInputs(size_t count) : a(count), b(count), points(count), x(count), y(count), z(count), radius(count),
+			maxX(count), maxY(count), maxZ(count)
+		{
+			std::mt19937 random(static_cast<uint32_t>(count) + 1);
+			// Wide enough that some objects are outside of the frustum on every side
+			std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+			std::uniform_real_distribution<float> size(0.1f, 5.0f);
+			std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+			for (size_t i = 0; i < count; i++) {
+				Vec3 translation{position(random), position(random), position(random)};
+				float half = angle(random) * 0.5f;
+				Quat rotation{0.0f, std::sin(half), 0.0f, std::cos(half)};
+				a[i] = composeTransform(translation, rotation, Vec3{1.0f, 2.0f, 1.0f});
+				b[i] = composeTransform(Vec3{position(random), 0.0f, position(random)}, rotation, Vec3{size(random), 1.0f, 1.0f});
+				points[i] = Vec3{position(random), position(random), position(random)};
+				x[i] = position(random);
+				y[i] = position(random);
+				z[i] = position(random);
+				radius[i] = size(random);
+				maxX[i] = x[i] + size(random);
+				maxY[i] = y[i] + size(random);
+				maxZ[i] = z[i] + size(random);
+			}
+			Mat4 view = lookAt(Vec3{0.0f, 10.0f, -50.0f}, Vec3{0.0f, 0.0f, 0.0f}, Vec3{0.0f, 1.0f, 0.0f});
+			frustum = makeFrustum(perspective(1.0f, 16.0f / 9.0f, 0.1f, 200.0f) * view);
+		}
+	};
+
+	::testing::AssertionResult isNear(float expected, float actual)
+	{
+		if (std::fabs(expected - actual) <= 1e-4f * std::fmax(1.0f, std::fabs(expected))) {
+			return ::testing::AssertionSuccess();
+		}
+		return ::testing::AssertionFailure() << actual << " instead of " << expected;
+	}
+
+	::testing::AssertionResult isNear(Vec3 expected, Vec3 actual)
+	{
+		for (float Vec3::*field : {&Vec3::x, &Vec3::y, &Vec3::z}) {
+			::testing::AssertionResult result = isNear(expected.*field, actual.*field);
+			if (!result) {
+				return result;
+			}
+		}
+		return ::testing::AssertionSuccess();
+	}
+
+	::testing::AssertionResult isNear(const Mat4& expected, const Mat4& actual)
+	{
+		for (int column = 0; column < 4; column++) {
+			for (float Vec4::*field : {&Vec4::x, &Vec4::y, &Vec4::z, &Vec4::w}) {
+				::testing::AssertionResult result = isNear(expected.columns[column].*field, actual.columns[column].*field);
+				if (!result) {
+					return result << " in column " << column;
+				}
+			}
+		}
+		return ::testing::AssertionSuccess();
+	}
+
+	::testing::AssertionResult isNear(uint8_t expected, uint8_t actual)
+	{
+		if (expected == actual) {
+			return ::testing::AssertionSuccess();
+		}
+		return ::testing::AssertionFailure() << int(actual) << " instead of " << int(expected);
+	}
+
+	// Output with GUARD extra elements after count, filled with a byte pattern
+	template<typename Output>
+	std::vector<Output> makeOutput(size_t count)
+	{
+		std::vector<Output> out(count + GUARD);
+		std::memset(static_cast<void*>(out.data()), GUARD_BYTE, out.size() * sizeof(Output));
+		return out;
+	}
+
+	template<typename Output>
+	void expectGuardIntact(const std::vector<Output>& out, size_t count)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(out.data() + count);
+		for (size_t i = 0; i < GUARD * sizeof(Output); i++) {
+			ASSERT_EQ(bytes[i], GUARD_BYTE) << "written past the last element";
+		}
+	}
+
+	template<typename Output>
+	void expectAllNear(const std::vector<Output>& expected, const std::vector<Output>& out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			ASSERT_TRUE(isNear(expected[i], out[i])) << "at element " << i;
+		}
+		expectGuardIntact(out, count);
+	}
+
+	// Every kernel at every level against the inline functions of Matrix.h and Frustum.h.
+	// Levels the CPU or build doesn't support are skipped.
+	class MathBatchTest : public ::testing::TestWithParam<std::tuple<SimdLevel, size_t>>
+	{
+	protected:
+		SimdLevel startLevel = getSimdLevel();
+		size_t count = std::get<1>(GetParam());
+		MathInputs inputs{count};
+
+		void SetUp() override
+		{
+			SimdLevel level = std::get<0>(GetParam());
+			if (setSimdLevel(level) != level) {
+				GTEST_SKIP() << getSimdLevelName(level) << " isn't supported";
+			}
+		}
+
+		void TearDown() override
+		{
+			setSimdLevel(startLevel);
+		}
+	};
+
+	TEST_P(MathBatchTest, MultiplyMatrices)
+	{
+		std::vector<Mat4> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			expected[i] = inputs.a[i] * inputs.b[i];
+		}
+		std::vector<Mat4> out = makeOutput<Mat4>(count);
+		multiplyMatrices(inputs.a.data(), inputs.b.data(), out.data(), count);
+		expectAllNear(expected, out, count);
+	}
+
+	TEST_P(MathBatchTest, MultiplyMatricesInPlace)
+	{
+		std::vector<Mat4> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			expected[i] = inputs.a[i] * inputs.b[i];
+		}
+		multiplyMatrices(inputs.a.data(), inputs.b.data(), inputs.a.data(), count);
+		for (size_t i = 0; i < count; i++) {
+			ASSERT_TRUE(isNear(expected[i], inputs.a[i])) << "at element " << i;
+		}
+	}
+
+	TEST_P(MathBatchTest, MultiplyMatricesByParent)
+	{
+		Mat4 parent = composeTransform(Vec3{3.0f, -2.0f, 7.0f}, Quat{0.0f, 0.6f, 0.0f, 0.8f}, Vec3{2.0f, 1.0f, 0.5f});
+		std::vector<Mat4> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			expected[i] = parent * inputs.b[i];
+		}
+		std::vector<Mat4> out = makeOutput<Mat4>(count);
+		multiplyMatrices(parent, inputs.b.data(), out.data(), count);
+		expectAllNear(expected, out, count);
+	}
+
+	TEST_P(MathBatchTest, MultiplyMatricesByParentInPlace)
+	{
+		Mat4 parent = composeTransform(Vec3{3.0f, -2.0f, 7.0f}, Quat{0.0f, 0.6f, 0.0f, 0.8f}, Vec3{2.0f, 1.0f, 0.5f});
+		std::vector<Mat4> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			expected[i] = parent * inputs.b[i];
+		}
+		multiplyMatrices(parent, inputs.b.data(), inputs.b.data(), count);
+		for (size_t i = 0; i < count; i++) {
+			ASSERT_TRUE(isNear(expected[i], inputs.b[i])) << "at element " << i;
+		}
+	}
+
+	TEST_P(MathBatchTest, TransformPoints)
+	{
+		Mat4 matrix = composeTransform(Vec3{3.0f, -2.0f, 7.0f}, Quat{0.0f, 0.6f, 0.0f, 0.8f}, Vec3{2.0f, 1.0f, 0.5f});
+		std::vector<Vec3> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			expected[i] = transformPoint(matrix, inputs.points[i]);
+		}
+		std::vector<Vec3> out = makeOutput<Vec3>(count);
+		transformPoints(matrix, inputs.points.data(), out.data(), count);
+		expectAllNear(expected, out, count);
+	}
+
+	TEST_P(MathBatchTest, CullSpheres)
+	{
+		std::vector<uint8_t> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			Vec3 center{inputs.x[i], inputs.y[i], inputs.z[i]};
+			expected[i] = isSphereVisible(inputs.frustum, center, inputs.radius[i]) ? 1 : 0;
+		}
+		std::vector<uint8_t> out = makeOutput<uint8_t>(count);
+		SphereArrays spheres{inputs.x.data(), inputs.y.data(), inputs.z.data(), inputs.radius.data()};
+		cullSpheres(inputs.frustum, spheres, out.data(), count);
+		expectAllNear(expected, out, count);
+	}
+
+	TEST_P(MathBatchTest, CullAABBs)
+	{
+		std::vector<uint8_t> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			Vec3 min{inputs.x[i], inputs.y[i], inputs.z[i]};
+			Vec3 max{inputs.maxX[i], inputs.maxY[i], inputs.maxZ[i]};
+			expected[i] = isAABBVisible(inputs.frustum, min, max) ? 1 : 0;
+		}
+		std::vector<uint8_t> out = makeOutput<uint8_t>(count);
+		AABBArrays boxes{inputs.x.data(), inputs.y.data(), inputs.z.data(), inputs.maxX.data(), inputs.maxY.data(), inputs.maxZ.data()};
+		cullAABBs(inputs.frustum, boxes, out.data(), count);
+		expectAllNear(expected, out, count);
+	}
+
+	std::string getTestName(const ::testing::TestParamInfo<MathBatchTest::ParamType>& info)
+	{
+		return std::string(getSimdLevelName(std::get<0>(info.param))) + "_" + std::to_string(std::get<1>(info.param));
+	}
+
+	INSTANTIATE_TEST_SUITE_P(Levels, MathBatchTest,
+		::testing::Combine(::testing::Values(SimdLevel::SCALAR, SimdLevel::SSE4, SimdLevel::AVX2), ::testing::ValuesIn(SIZES)),
+		getTestName);
+
+	TEST(MathBatch, SetSimdLevelFallsBack)
+	{
+		SimdLevel startLevel = getSimdLevel();
+		EXPECT_EQ(setSimdLevel(SimdLevel::SCALAR), SimdLevel::SCALAR);
+		EXPECT_EQ(getSimdLevel(), SimdLevel::SCALAR);
+		SimdLevel best = setSimdLevel(SimdLevel::AVX2);
+		EXPECT_EQ(getSimdLevel(), best);
+		setSimdLevel(startLevel);
+	}
+}
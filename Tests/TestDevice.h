@@ -0,0 +1,74 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "VulkanInstance.h"
+#include "Surface.h"
+#include "LogicalDevice.h"
+#include "SubmissionScheduler.h"
+
+// Headless instance, device and scheduler for tests of the vulkan modules.
+// VK_DRIVER_FILES can select lavapipe on machines without a GPU.
+struct TestDevice
+{
+	VulkanInstance instance;
+	Surface surface;
+	LogicalDevice device;
+	SubmissionScheduler scheduler;
+
+	TestDevice()
+	{
+		instance.init("ApparatusTests", nullptr, true);
+		surface.initHeadless(instance);
+		device.init(LogicalDevice::findSuitablePhysicalDevice(instance, surface), surface, instance.getAllocator());
+		scheduler.init(device);
+	}
+
+	~TestDevice()
+	{
+		scheduler.cleanup();
+		device.getDispatch().vkDeviceWaitIdle(device.getHandle());
+	}
+};
+
+// Base of fixtures that need a device, which is created once per test suite and shared by its tests.
+// Tests skip themselves when it couldn't be created, such as without a vulkan driver, unless APPARATUS_REQUIRE_VULKAN
+// is set in the environment as on CI. Fixtures overriding SetUp call DeviceTest::SetUp first and return if
+// IsSkipped() or HasFatalFailure().
+template<typename Base = ::testing::Test>
+class DeviceTest : public Base
+{
+protected:
+	inline static std::unique_ptr<TestDevice> shared;
+	inline static std::string sharedError;
+
+	static void SetUpTestSuite()
+	{
+		try {
+			shared = std::make_unique<TestDevice>();
+		} catch (const std::exception& e) {
+			sharedError = e.what();
+			shared.reset();
+		}
+	}
+
+	static void TearDownTestSuite()
+	{
+		shared.reset();
+	}
+
+	void SetUp() override
+	{
+		if (!shared) {
+			if (std::getenv("APPARATUS_REQUIRE_VULKAN") != nullptr) {
+				FAIL() << "no vulkan device: " << sharedError;
+			}
+			GTEST_SKIP() << "no vulkan device: " << sharedError;
+		}
+	}
+};
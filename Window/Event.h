@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+enum class EventType : uint32_t
+{
+	KEY,
+	MOUSE_BUTTON,
+	CURSOR_MOVE,
+	SCROLL,
+	// Framebuffer size changed, in pixels
+	RESIZE,
+	FOCUS,
+	CLOSE
+};
+
+// key, scancode, action and mods use the GLFW values
+struct KeyEvent
+{
+	int key;
+	int scancode;
+	int action;
+	int mods;
+};
+
+struct MouseButtonEvent
+{
+	int button;
+	int action;
+	int mods;
+};
+
+// Cursor position in screen coordinates relative to the window, or scroll offsets
+struct CursorEvent
+{
+	double x;
+	double y;
+};
+
+struct ResizeEvent
+{
+	int width;
+	int height;
+};
+
+struct FocusEvent
+{
+	bool focused;
+};
+
+struct Event
+{
+	EventType type;
+	// Seconds from glfwGetTime when GLFW reported the event
+	double time;
+	union
+	{
+		KeyEvent key;
+		MouseButtonEvent mouseButton;
+		CursorEvent cursor;
+		CursorEvent scroll;
+		ResizeEvent resize;
+		FocusEvent focus;
+	};
+};
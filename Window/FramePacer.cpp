@@ -0,0 +1,177 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "Profiler.h"
+
+namespace
+{
+	// Seconds to sleep at a time while minimized or waiting for an on demand redraw
+	constexpr double IDLE_WAIT = 0.25;
+}
+
+FramePacer::FramePacer() :
+	windows{},
+	targetFps(60.0),
+	backgroundFps(10.0),
+	onDemand(false),
+	redrawRequested(true),
+	spinMargin(0.001),
+	lastEventCounts{},
+	lastFrame(),
+	frameTime(0.0),
+	jitter(0.0)
+{
+}
+
+void FramePacer::init(Window& window, double _targetFps)
+{
+	init(std::vector<Window*>{&window}, _targetFps);
+}
+
+void FramePacer::init(const std::vector<Window*>& _windows, double _targetFps)
+{
+	windows = _windows;
+	targetFps = _targetFps;
+	updateEventCounts();
+	lastFrame = Clock::now() - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(getInterval()));
+}
+
+void FramePacer::setTargetFps(double fps)
+{
+	targetFps = fps;
+}
+
+void FramePacer::setBackgroundFps(double fps)
+{
+	backgroundFps = fps;
+}
+
+void FramePacer::setOnDemand(bool _onDemand)
+{
+	onDemand = _onDemand;
+}
+
+void FramePacer::requestRedraw()
+{
+	redrawRequested.store(true, std::memory_order_relaxed);
+	windows.front()->wake();
+}
+
+void FramePacer::setSpinMargin(double seconds)
+{
+	spinMargin = seconds;
+}
+
+bool FramePacer::beginFrame()
+{
+	// Everything since the last call was the previous frame
+	PROFILE_FRAME();
+	PROFILE_ZONE_NAMED("Frame pacing");
+	while (running()) {
+		// Nothing is visible, sleep until a window is restored
+		if (minimized()) {
+			pumpEvents(IDLE_WAIT);
+			continue;
+		}
+
+		if (onDemand && !needsRedraw()) {
+			// Events and requestRedraw both wake the wait up
+			pumpEvents(IDLE_WAIT);
+			continue;
+		}
+
+		double interval = getInterval();
+		Clock::time_point deadline = lastFrame + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+		double remaining = std::chrono::duration<double>(deadline - Clock::now()).count();
+		if (remaining > spinMargin) {
+			// Sleeping wakes up late by an amount the OS decides, so stop early and spin the rest
+			pumpEvents(remaining - spinMargin);
+			continue;
+		}
+		while (Clock::now() < deadline) {
+			std::this_thread::yield();
+		}
+		pumpEvents(0.0);
+
+		Clock::time_point now = Clock::now();
+		frameTime = std::chrono::duration<double>(now - lastFrame).count();
+		if (interval > 0.0 && frameTime < 2.0 * interval) {
+			jitter += (std::abs(frameTime - interval) - jitter) * 0.1;
+		}
+		// Frames keep to the deadline cadence unless they fell a whole interval behind
+		lastFrame = now - deadline > std::chrono::duration<double>(interval) ? now : deadline;
+		updateEventCounts();
+		PROFILE_PLOT("Frame time (ms)", frameTime * 1000.0);
+		redrawRequested.store(false, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+double FramePacer::getFrameTime()
+{
+	return frameTime;
+}
+
+double FramePacer::getJitter()
+{
+	return jitter;
+}
+
+double FramePacer::getInterval()
+{
+	bool focused = std::any_of(windows.begin(), windows.end(), [](Window* window) {
+		return glfwGetWindowAttrib(window->getHandle(), GLFW_FOCUSED) != 0;
+	});
+	double fps = targetFps;
+	if (backgroundFps > 0.0 && !focused) {
+		fps = fps > 0.0 ? std::min(fps, backgroundFps) : backgroundFps;
+	}
+	return fps > 0.0 ? 1.0 / fps : 0.0;
+}
+
+bool FramePacer::needsRedraw()
+{
+	if (redrawRequested.load(std::memory_order_relaxed)) {
+		return true;
+	}
+	for (size_t i = 0; i < windows.size(); i++) {
+		if (windows[i]->getEventCount() != lastEventCounts[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FramePacer::running()
+{
+	return std::all_of(windows.begin(), windows.end(), [](Window* window) { return window->running(); });
+}
+
+bool FramePacer::minimized()
+{
+	return std::all_of(windows.begin(), windows.end(), [](Window* window) {
+		return glfwGetWindowAttrib(window->getHandle(), GLFW_ICONIFIED) != 0;
+	});
+}
+
+void FramePacer::updateEventCounts()
+{
+	lastEventCounts.resize(windows.size());
+	for (size_t i = 0; i < windows.size(); i++) {
+		lastEventCounts[i] = windows[i]->getEventCount();
+	}
+}
+
+void FramePacer::pumpEvents(double timeout)
+{
+	// The caller's timeout is put back, it's only the pacer's while it pumps
+	Window& window = *windows.front();
+	double previous = window.getEventWaitTimeout();
+	window.setEventWaitTimeout(timeout);
+	window.pumpEvents();
+	window.setEventWaitTimeout(previous);
+}
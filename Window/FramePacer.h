@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "Window.h"
+
+class FramePacer
+{
+public:
+	/**
+	 * @brief Pacer is not attached to a window, must call init.
+	 */
+	FramePacer();
+
+	/**
+	 * @brief Attaches the pacer to a window. The first frame starts right away.
+	 *
+	 * @param window - window whose events are pumped and whose state decides throttling
+	 * @param targetFps - frames per second while focused, 0 for uncapped
+	 */
+	void init(Window& window, double targetFps = 60.0);
+
+	/**
+	 * @brief Attaches the pacer to several windows sharing the frame loop. Frames are throttled once none of them
+	 * has focus and stop while all of them are minimized, and events of any of them trigger on demand redraws.
+	 *
+	 * @param _windows - windows whose events are pumped, at least one. beginFrame returns false once any should close
+	 * @param targetFps - frames per second while one of them is focused, 0 for uncapped
+	 */
+	void init(const std::vector<Window*>& _windows, double targetFps = 60.0);
+
+	/**
+	 * @brief Sets the frame rate while the window is focused, 0 for uncapped.
+	 */
+	void setTargetFps(double fps);
+
+	/**
+	 * @brief Sets the frame rate while the window doesn't have focus, 0 to use the target fps.
+	 */
+	void setBackgroundFps(double fps);
+
+	/**
+	 * @brief Only render frames after an event arrived or requestRedraw was called,
+	 * still limited by the frame rate.
+	 */
+	void setOnDemand(bool onDemand);
+
+	/**
+	 * @brief Makes the next beginFrame render in on demand mode. Safe to call from any thread.
+	 */
+	void requestRedraw();
+
+	/**
+	 * @brief Sets how long before a frame's deadline the pacer stops sleeping and spins,
+	 * trading CPU time for lower jitter.
+	 *
+	 * @param seconds - 0 to only sleep
+	 */
+	void setSpinMargin(double seconds);
+
+	/**
+	 * @brief Pumps window events through Window::pumpEvents until the next frame should start. Sleeps while waiting,
+	 * and doesn't start frames at all while the window is minimized. Main thread only.
+	 *
+	 * @return true if a frame should be rendered; false if the window should close
+	 */
+	bool beginFrame();
+
+	/**
+	 * @brief Returns the seconds between the starts of the last two frames
+	 */
+	double getFrameTime();
+
+	/**
+	 * @brief Returns the average difference in seconds between frame times and the frame interval
+	 */
+	double getJitter();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<Window*> windows;
+	double targetFps;
+	double backgroundFps;
+	bool onDemand;
+	std::atomic<bool> redrawRequested;
+	double spinMargin;
+	// Event count of every window at the last frame
+	std::vector<uint64_t> lastEventCounts;
+	Clock::time_point lastFrame;
+	double frameTime;
+	double jitter;
+
+	// Seconds between frames right now, 0 for uncapped
+	double getInterval();
+	bool needsRedraw();
+	bool running();
+	bool minimized();
+	void updateEventCounts();
+	// Pumps events of every window through the first one's pumpEvents, waiting up to timeout seconds or polling at 0.
+	// GLFW processes the events of all windows in one pump, each window's callbacks queue its own.
+	void pumpEvents(double timeout);
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Lock free queue for exactly one producer thread and one consumer thread
+template<typename T>
+class SpscQueue
+{
+public:
+	/**
+	 * @brief Queue has no storage, must call init.
+	 */
+	SpscQueue() :
+		buffer(nullptr),
+		mask(0),
+		head(0),
+		cachedTail(0),
+		tail(0),
+		cachedHead(0)
+	{
+	}
+
+	/**
+	 * @brief Allocates the storage. Neither thread may use the queue during init.
+	 *
+	 * @param capacity - rounded up to a power of two
+	 */
+	void init(size_t capacity)
+	{
+		size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		buffer = std::make_unique<T[]>(size);
+		mask = size - 1;
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+		cachedHead = 0;
+		cachedTail = 0;
+	}
+
+	/**
+	 * @brief Adds an element. Producer thread only.
+	 *
+	 * @return false if the queue is full
+	 */
+	bool push(const T& value)
+	{
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail - cachedHead > mask) {
+			// Only look at the consumer's index when the cached one says the queue is full
+			cachedHead = head.load(std::memory_order_acquire);
+			if (currentTail - cachedHead > mask) {
+				return false;
+			}
+		}
+		buffer[currentTail & mask] = value;
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Removes the oldest element. Consumer thread only.
+	 *
+	 * @return false if the queue is empty
+	 */
+	bool pop(T& value)
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead == cachedTail) {
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (currentHead == cachedTail) {
+				return false;
+			}
+		}
+		value = buffer[currentHead & mask];
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Removes every element that was pushed so far, calling function on each in order.
+	 * Consumer thread only.
+	 *
+	 * @return number of elements removed
+	 */
+	template<typename F>
+	size_t popAll(F&& function)
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		cachedTail = tail.load(std::memory_order_acquire);
+		size_t count = cachedTail - currentHead;
+		for (size_t i = currentHead; i != cachedTail; i++) {
+			function(buffer[i & mask]);
+		}
+		// Slots are handed back in one store for the whole batch
+		head.store(cachedTail, std::memory_order_release);
+		return count;
+	}
+
+private:
+	std::unique_ptr<T[]> buffer;
+	size_t mask;
+
+	// Each index shares a cache line only with the copy of the other index its owner keeps
+	alignas(64) std::atomic<size_t> head;
+	size_t cachedTail;
+	alignas(64) std::atomic<size_t> tail;
+	size_t cachedHead;
+};
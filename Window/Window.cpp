@@ -1,15 +1,32 @@
 #include "Window.h"
 
+#include "Profiler.h"
+
 Window::Window() :
-	handle(nullptr)
+	handle(nullptr),
+	events(),
+	waitTimeout(0.0),
+	droppedEvents(0),
+	eventCount(0)
 {
 }
 
-void Window::init(int width, int height, const char* title)
+void Window::init(int width, int height, const char* title, size_t eventCapacity)
 {
+	PROFILE_ZONE();
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 	handle = glfwCreateWindow(width, height, title, nullptr, nullptr);
 	// TODO error handling
+
+	events.init(eventCapacity);
+	glfwSetWindowUserPointer(handle, this);
+	glfwSetKeyCallback(handle, keyCallback);
+	glfwSetMouseButtonCallback(handle, mouseButtonCallback);
+	glfwSetCursorPosCallback(handle, cursorPosCallback);
+	glfwSetScrollCallback(handle, scrollCallback);
+	glfwSetFramebufferSizeCallback(handle, framebufferSizeCallback);
+	glfwSetWindowFocusCallback(handle, focusCallback);
+	glfwSetWindowCloseCallback(handle, closeCallback);
 }
 
 Window::~Window()
@@ -33,4 +50,110 @@ bool Window::running()
 GLFWwindow* Window::getHandle()
 {
 	return handle;
-}
\ No newline at end of file
+}
+
+void Window::pumpEvents()
+{
+	PROFILE_ZONE();
+	if (waitTimeout > 0.0) {
+		glfwWaitEventsTimeout(waitTimeout);
+	} else {
+		glfwPollEvents();
+	}
+}
+
+void Window::setEventWaitTimeout(double timeout)
+{
+	waitTimeout = timeout;
+}
+
+double Window::getEventWaitTimeout()
+{
+	return waitTimeout;
+}
+
+void Window::wake()
+{
+	glfwPostEmptyEvent();
+}
+
+size_t Window::popEvents(std::vector<Event>& _events)
+{
+	return events.popAll([&](const Event& event) {
+		_events.push_back(event);
+	});
+}
+
+uint64_t Window::getDroppedEventCount()
+{
+	return droppedEvents.load(std::memory_order_relaxed);
+}
+
+uint64_t Window::getEventCount()
+{
+	return eventCount.load(std::memory_order_relaxed);
+}
+
+void Window::pushEvent(Event& event)
+{
+	event.time = glfwGetTime();
+	eventCount.fetch_add(1, std::memory_order_relaxed);
+	if (!events.push(event)) {
+		droppedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void Window::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	Event event{};
+	event.type = EventType::KEY;
+	event.key = {key, scancode, action, mods};
+	static_cast<Window*>(glfwGetWindowUserPointer(window))->pushEvent(event);
+}
+
+void Window::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+	Event event{};
+	event.type = EventType::MOUSE_BUTTON;
+	event.mouseButton = {button, action, mods};
+	static_cast<Window*>(glfwGetWindowUserPointer(window))->pushEvent(event);
+}
+
+void Window::cursorPosCallback(GLFWwindow* window, double x, double y)
+{
+	Event event{};
+	event.type = EventType::CURSOR_MOVE;
+	event.cursor = {x, y};
+	static_cast<Window*>(glfwGetWindowUserPointer(window))->pushEvent(event);
+}
+
+void Window::scrollCallback(GLFWwindow* window, double x, double y)
+{
+	Event event{};
+	event.type = EventType::SCROLL;
+	event.scroll = {x, y};
+	static_cast<Window*>(glfwGetWindowUserPointer(window))->pushEvent(event);
+}
+
+void Window::framebufferSizeCallback(GLFWwindow* window, int width, int height)
+{
+	Event event{};
+	event.type = EventType::RESIZE;
+	event.resize = {width, height};
+	static_cast<Window*>(glfwGetWindowUserPointer(window))->pushEvent(event);
+}
+
+void Window::focusCallback(GLFWwindow* window, int focused)
+{
+	Event event{};
+	event.type = EventType::FOCUS;
+	event.focus = {focused == GLFW_TRUE};
+	static_cast<Window*>(glfwGetWindowUserPointer(window))->pushEvent(event);
+}
+
+void Window::closeCallback(GLFWwindow* window)
+{
+	Event event{};
+	event.type = EventType::CLOSE;
+	static_cast<Window*>(glfwGetWindowUserPointer(window))->pushEvent(event);
+}
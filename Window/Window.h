@@ -5,6 +5,12 @@
 #endif
 #include <GLFW/glfw3.h>
 
+#include <atomic>
+#include <vector>
+
+#include "Event.h"
+#include "SpscQueue.h"
+
 class Window
 {
 public:
@@ -19,8 +25,9 @@ public:
 	 * @param width - width in screen coordinates of the window
 	 * @param height - height in screen coordinates of the window
 	 * @param title - The title of the window
+	 * @param eventCapacity - Events that can be waiting to be popped, more are dropped
 	 */
-	void init(int width, int height, const char* title);
+	void init(int width, int height, const char* title, size_t eventCapacity = 4096);
 
 	/**
 	 * @brief Calls cleanup on destruction. Closes window if one is created.
@@ -48,6 +55,63 @@ public:
 	 */
 	GLFWwindow* getHandle();
 
+	/**
+	 * @brief Processes pending GLFW events, pushing them into the event queue.
+	 * Polls unless setEventWaitTimeout was given a timeout. Main thread only.
+	 */
+	void pumpEvents();
+
+	/**
+	 * @brief Makes pumpEvents block until an event arrives or the timeout passes,
+	 * so the thread pumping events sleeps instead of spinning.
+	 *
+	 * @param timeout - seconds to wait at most, 0 to poll
+	 */
+	void setEventWaitTimeout(double timeout);
+
+	/**
+	 * @brief Returns the timeout given to setEventWaitTimeout, 0 if pumpEvents polls
+	 */
+	double getEventWaitTimeout();
+
+	/**
+	 * @brief Wakes up a pumpEvents call that is waiting. Safe to call from any thread.
+	 */
+	void wake();
+
+	/**
+	 * @brief Appends every queued event to events, oldest first.
+	 * Only one thread may pop events, it doesn't have to be the main thread.
+	 *
+	 * @return number of events appended
+	 */
+	size_t popEvents(std::vector<Event>& events);
+
+	/**
+	 * @brief Returns how many events were dropped because the queue was full
+	 */
+	uint64_t getDroppedEventCount();
+
+	/**
+	 * @brief Returns how many events GLFW reported since init, dropped ones included.
+	 * Changes whenever something happened to the window.
+	 */
+	uint64_t getEventCount();
+
 private:
 	GLFWwindow* handle;
+	SpscQueue<Event> events;
+	double waitTimeout;
+	std::atomic<uint64_t> droppedEvents;
+	std::atomic<uint64_t> eventCount;
+
+	void pushEvent(Event& event);
+
+	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+	static void cursorPosCallback(GLFWwindow* window, double x, double y);
+	static void scrollCallback(GLFWwindow* window, double x, double y);
+	static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+	static void focusCallback(GLFWwindow* window, int focused);
+	static void closeCallback(GLFWwindow* window);
 };
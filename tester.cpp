@@ -1,9 +1,11 @@
 #include <iostream>
+#include <vector>
 
 #include <Config.h>
 
 #ifdef USE_WINDOW
 #include "Window.h"
+#include "FramePacer.h"
 #endif
 
 #ifdef USE_GRAPHICS
@@ -11,6 +13,10 @@
 #include "DebugMessenger.h"
 #include "Surface.h"
 #include "LogicalDevice.h"
+#include "Swapchain.h"
+#include "HostAllocator.h"
+#include "SubmissionScheduler.h"
+#include "GpuProfiler.h"
 #endif
 
 int main()
@@ -23,8 +29,17 @@ int main()
 	
 	Window window;
 	window.init(500, 500, "tester");
-	while (window.running()) {
-		glfwPollEvents();
+	FramePacer pacer;
+	pacer.init(window, 60.0);
+	std::vector<Event> events;
+	while (pacer.beginFrame()) {
+		events.clear();
+		window.popEvents(events);
+		for (const Event& event : events) {
+			if (event.type == EventType::KEY && event.key.key == GLFW_KEY_ESCAPE && event.key.action == GLFW_PRESS) {
+				glfwSetWindowShouldClose(window.getHandle(), GLFW_TRUE);
+			}
+		}
 	}
 	window.cleanup();
 
@@ -34,26 +49,90 @@ int main()
 	#ifdef USE_GRAPHICS
 	try {
 		glfwInit();
-		Window window;
+		Window window, secondWindow;
 		window.init(500, 500, "tester");
+		secondWindow.init(300, 300, "tester 2");
 
+		HostAllocator hostAllocator;
+		hostAllocator.init();
 		VulkanInstance instance;
-		instance.init("Test");
+		instance.init("Test", hostAllocator.getCallbacks());
 		DebugMessenger debugMessenger;
 		debugMessenger.init(instance);
-		Surface surface;
+		Surface surface, secondSurface;
 		surface.init(instance, window);
+		secondSurface.init(instance, secondWindow);
+		std::vector<Surface*> surfaces{&surface, &secondSurface};
 		LogicalDevice device;
-		device.init(LogicalDevice::findSuitablePhysicalDevice(instance, surface), surface);
+		device.init(LogicalDevice::findSuitablePhysicalDevice(instance, surfaces), surfaces, instance.getAllocator());
+		Swapchain swapchain, secondSwapchain;
+		swapchain.init(device, surface, window);
+		secondSwapchain.init(device, secondSurface, secondWindow);
+
+		SubmissionScheduler scheduler;
+		scheduler.init(device);
+		VkQueue graphicsQueue = device.getGraphicsQueue();
+		GpuProfiler profiler;
+		profiler.init(device, scheduler, graphicsQueue, device.getGraphicsFamilyIndex(), "Graphics");
+
+		const DeviceDispatch& dispatch = device.getDispatch();
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = device.getGraphicsFamilyIndex();
+		VkCommandPool commandPool = nullptr;
+		VkResult result = dispatch.vkCreateCommandPool(device.getHandle(), &poolInfo, device.getAllocator(), &commandPool); VK_CHECK(result);
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+		VkCommandBuffer commandBuffer = nullptr;
+		result = dispatch.vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &commandBuffer); VK_CHECK(result);
+
+		FramePacer pacer;
+		pacer.init({&window, &secondWindow}, 60.0);
+		pacer.setOnDemand(true);
+		uint64_t frameSerial = 0;
+		while (pacer.beginFrame()) {
+			// beginFrame marked the CPU frame, the GPU zones of the frames that finished are collected along with it
+			if (frameSerial != 0) {
+				scheduler.wait(graphicsQueue, frameSerial);
+			}
+			scheduler.beginFrame();
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			result = dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo); VK_CHECK(result);
+			profiler.recordCollect(commandBuffer);
+			result = dispatch.vkEndCommandBuffer(commandBuffer); VK_CHECK(result);
+			SubmitBatch batch;
+			batch.commandBuffers = {commandBuffer};
+			batch.label = "Frame";
+			scheduler.enqueue(graphicsQueue, std::move(batch));
+			frameSerial = scheduler.flush(graphicsQueue);
+		}
+		if (frameSerial != 0) {
+			scheduler.wait(graphicsQueue, frameSerial);
+		}
+		dispatch.vkDestroyCommandPool(device.getHandle(), commandPool, device.getAllocator());
+		profiler.cleanup();
+		scheduler.cleanup();
 
-		while (window.running()) {
-			glfwPollEvents();
+		HostAllocationStats hostStats = hostAllocator.getStats();
+		for (uint32_t scope = 0; scope < HOST_ALLOCATION_SCOPE_COUNT; scope++) {
+			std::cout << "driver " << HostAllocator::getScopeName(static_cast<VkSystemAllocationScope>(scope)) << " memory: "
+				<< hostStats.bytes[scope] << " bytes, peak " << hostStats.peakBytes[scope] << " bytes\n";
 		}
 
+		secondSwapchain.cleanup();
+		swapchain.cleanup();
 		device.cleanup();
+		secondSurface.cleanup();
 		surface.cleanup();
 		debugMessenger.cleanup();
 		instance.cleanup();
+		secondWindow.cleanup();
 		window.cleanup();
 	} catch (std::exception& e) {
 		std::cout << e.what() << '\n';